@@ -81,6 +81,43 @@ linux{
     }
 }
 
+FFMpegBackend{
+    contains(CONFIG, libbass)|contains(CONFIG, libVLC){
+        error("You can't enable more than one backend at the same time.")
+    }
+    #The sound device sinks are only written for Linux.
+    !linux{
+        error("The FFMpeg backend is only available on Linux.")
+    }
+    CONFIG += FFMpeg
+    DEFINES += ENABLE_FFMPEG_BACKEND
+    LIBS += -lswresample -lavformat -lavcodec -lavutil \
+            -lpulse-simple -lpulse -lasound
+    SOURCES += plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegpulsesink.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegalsasink.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegringbuffer.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegnullsink.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegwavsink.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegsource.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegdecoder.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegoutput.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicbackendffmpegthread.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicbackendffmpeg.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegaudiodecoder.cpp
+    HEADERS += plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegpulsesink.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegalsasink.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegringbuffer.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegsink.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegnullsink.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegwavsink.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegsource.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegdecoder.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegoutput.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicbackendffmpegthread.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicbackendffmpeg.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendffmpeg/knmusicffmpegaudiodecoder.h
+}
+
 FFMpeg{
     DEFINES += ENABLE_FFMPEG
     SOURCES += plugin/sdk/knffmpegglobal.cpp \
@@ -110,11 +147,13 @@ libbass{
     SOURCES += plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbassglobal.cpp \
                plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbackendbass.cpp \
                plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbassanalysiser.cpp \
-               plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbackendbassthread.cpp
+               plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbackendbassthread.cpp \
+               plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbassaudiodecoder.cpp
     HEADERS += plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbassglobal.h \
                plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbackendbass.h \
                plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbassanalysiser.h \
-               plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbackendbassthread.h
+               plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbackendbassthread.h \
+               plugin/module/knmusicplugin/plugin/knmusicbackendbass/knmusicbassaudiodecoder.h
 }
 
 #Add translations
@@ -181,6 +220,8 @@ SOURCES += \
     plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusicheaderlyrics.cpp \
     plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusiclyricsmanager.cpp \
     plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusiclrcparser.cpp \
+    plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusiclyricsindex.cpp \
+    plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusiclyricscache.cpp \
     plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/knmusicplaylistmanager.cpp \
     plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylisttab.cpp \
     plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistdisplay.cpp \
@@ -200,6 +241,12 @@ SOURCES += \
     plugin/module/knmusicplugin/sdk/knmusicsearcher.cpp \
     plugin/sdk/knfilesearcher.cpp \
     plugin/module/knmusicplugin/sdk/knmusicmodelassist.cpp \
+    plugin/module/knmusicplugin/sdk/knmusicstringpool.cpp \
+    plugin/module/knmusicplugin/sdk/knmusicseekindex.cpp \
+    plugin/module/knmusicplugin/sdk/knmusicloudnessmeter.cpp \
+    plugin/module/knmusicplugin/sdk/knmusicwaveformmanager.cpp \
+    plugin/module/knmusicplugin/sdk/knmusicspectrumanalyser.cpp \
+    plugin/module/knmusicplugin/sdk/knmusicequalizer.cpp \
     plugin/module/knmusicplugin/sdk/knmusicanalysiscache.cpp \
     plugin/sdk/knpreferencewidgetspanel.cpp \
     plugin/sdk/knvwidgetswitcher.cpp \
@@ -225,6 +272,8 @@ SOURCES += \
     plugin/module/knmusicplugin/plugin/knmusiccueparser/knmusiccueparser.cpp \
     plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistlistassistant.cpp \
     plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistloader.cpp \
+    plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistsaver.cpp \
+    plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistwriter.cpp \
     plugin/sdk/knmessagebox.cpp \
     plugin/sdk/messagebox/knmessageboxconfigure.cpp \
     plugin/sdk/messagebox/knmessagecontent.cpp \
@@ -278,6 +327,7 @@ SOURCES += \
     plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusicalbumtitle.cpp \
     plugin/sdk/knjsondatabase.cpp \
     plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusiclibrarydatabase.cpp \
+    plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusiclibraryloudnessscanner.cpp \
     plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusiclibraryimagemanager.cpp \
     plugin/sdk/knngnlbutton.cpp \
     plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusiclibraryemptyhint.cpp \
@@ -296,6 +346,7 @@ SOURCES += \
     plugin/sdk/sao/knsaostyle.cpp \
     plugin/sdk/sao/knsaosubmenu.cpp \
     plugin/module/knmusicplugin/plugin/knmusicheaderplayer/knmusicheaderplayerappendmenu.cpp \
+    plugin/module/knmusicplugin/plugin/knmusicheaderplayer/knmusicheaderspectrum.cpp \
     plugin/module/knmusicplugin/sdk/knmusiccategorytabwidget.cpp \
     plugin/sdk/preference/knpreferenceitemfont.cpp \
     plugin/sdk/knfontdialog.cpp \
@@ -370,6 +421,9 @@ HEADERS += \
     plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusicheaderlyrics.h \
     plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusiclyricsmanager.h \
     plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusiclrcparser.h \
+    plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusiclyricsdata.h \
+    plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusiclyricsindex.h \
+    plugin/module/knmusicplugin/plugin/knmusicheaderlyrics/knmusiclyricscache.h \
     plugin/module/knmusicplugin/sdk/knmusictab.h \
     plugin/module/knmusicplugin/sdk/knmusicplaylistmanagerbase.h \
     plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/knmusicplaylistmanager.h \
@@ -391,6 +445,13 @@ HEADERS += \
     plugin/module/knmusicplugin/sdk/knmusicsearcher.h \
     plugin/sdk/knfilesearcher.h \
     plugin/module/knmusicplugin/sdk/knmusicmodelassist.h \
+    plugin/module/knmusicplugin/sdk/knmusicstringpool.h \
+    plugin/module/knmusicplugin/sdk/knmusicseekindex.h \
+    plugin/module/knmusicplugin/sdk/knmusicloudnessmeter.h \
+    plugin/module/knmusicplugin/sdk/knmusicaudiodecoder.h \
+    plugin/module/knmusicplugin/sdk/knmusicwaveformmanager.h \
+    plugin/module/knmusicplugin/sdk/knmusicspectrumanalyser.h \
+    plugin/module/knmusicplugin/sdk/knmusicequalizer.h \
     plugin/module/knmusicplugin/sdk/knmusicanalysiscache.h \
     plugin/sdk/preference/knpreferenceitembase.h \
     plugin/sdk/knpreferencewidgetspanel.h \
@@ -419,6 +480,8 @@ HEADERS += \
     plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistlistassistant.h \
     plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistparser.h \
     plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistloader.h \
+    plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistsaver.h \
+    plugin/module/knmusicplugin/plugin/knmusicplaylistmanager/sdk/knmusicplaylistwriter.h \
     plugin/sdk/knmessagebox.h \
     plugin/sdk/messagebox/knmessageboxconfigure.h \
     plugin/sdk/messagebox/knmessagecontent.h \
@@ -477,6 +540,7 @@ HEADERS += \
     plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusicalbumtitle.h \
     plugin/sdk/knjsondatabase.h \
     plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusiclibrarydatabase.h \
+    plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusiclibraryloudnessscanner.h \
     plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusiclibraryimagemanager.h \
     plugin/sdk/knngnlbutton.h \
     plugin/module/knmusicplugin/plugin/knmusiclibrary/sdk/knmusiclibraryemptyhint.h \
@@ -496,6 +560,7 @@ HEADERS += \
     plugin/sdk/sao/knsaostyle.h \
     plugin/sdk/sao/knsaosubmenu.h \
     plugin/module/knmusicplugin/plugin/knmusicheaderplayer/knmusicheaderplayerappendmenu.h \
+    plugin/module/knmusicplugin/plugin/knmusicheaderplayer/knmusicheaderspectrum.h \
     plugin/module/knmusicplugin/sdk/knmusiccategorytabwidget.h \
     plugin/sdk/preference/knpreferenceitemfont.h \
     plugin/sdk/knfontdialog.h \
@@ -24,6 +24,9 @@
 //Ports
 #include "knmusicbackend.h"
 #include "knmusicparser.h"
+#include "knmusicseekindex.h"
+#include "knmusicwaveformmanager.h"
+#include "knmusicequalizer.h"
 #include "knmusicsearchbase.h"
 #include "knmusicsolomenubase.h"
 #include "knmusicdetaildialogbase.h"
@@ -46,6 +49,9 @@
 #ifdef ENABLE_LIBVLC
 #include "plugin/knmusicbackendvlc/knmusicbackendvlc.h"
 #endif
+#ifdef ENABLE_FFMPEG_BACKEND
+#include "plugin/knmusicbackendffmpeg/knmusicbackendffmpeg.h"
+#endif
 #include "plugin/knmusictagid3v1/knmusictagid3v1.h"
 #include "plugin/knmusictagflac/knmusictagflac.h"
 #include "plugin/knmusictagid3v2/knmusictagid3v2.h"
@@ -61,6 +67,7 @@
 #include "plugin/knmusicsolomenu/knmusicsolomenu.h"
 #include "plugin/knmusicmultimenu/knmusicmultimenu.h"
 #include "plugin/knmusicheaderlyrics/knmusicheaderlyrics.h"
+#include "plugin/knmusicheaderlyrics/knmusiclyricsmanager.h"
 #include "plugin/knmusicnowplaying/knmusicnowplaying.h"
 #include "plugin/knmusiclibrary/knmusiclibrary.h"
 #include "plugin/knmusicplaylistmanager/knmusicplaylistmanager.h"
@@ -88,6 +95,16 @@ KNMusicPlugin::KNMusicPlugin(QObject *parent) :
     loadDetailInfo(new KNMusicDetailDialog);
     //Initial parser.
     initialParser();
+    //Load the seek index of the analysised files.
+    KNMusicSeekIndex::instance()->setCacheFilePath(
+                KNGlobal::ensurePathAvaliable(KNMusicGlobal::musicLibraryPath())+
+                "/SeekIndex.db");
+    //The waveform overviews are saved next to the library artworks.
+    KNMusicWaveformManager::instance()->setCacheFolderPath(
+                KNGlobal::ensurePathAvaliable(KNMusicGlobal::musicLibraryPath()+
+                                              "/Library/Waveforms"));
+    //Restore the equalizer before the backend is loaded.
+    loadEqualizer();
     //Initial menus.
     initialSoloMenu(new KNMusicSoloMenu);
     initialMultiMenu(new KNMusicMultiMenu);
@@ -99,6 +116,9 @@ KNMusicPlugin::KNMusicPlugin(QObject *parent) :
 #endif
 #ifdef ENABLE_LIBVLC
     loadBackend(new KNMusicBackendVLC);
+#endif
+#ifdef ENABLE_FFMPEG_BACKEND
+    loadBackend(new KNMusicBackendFFMpeg);
 #endif
     loadDetailTooptip(new KNMusicDetailTooltip);
     loadNowPlaying(new KNMusicNowPlaying);
@@ -118,8 +138,11 @@ KNMusicPlugin::~KNMusicPlugin()
     //Stop threads.
     m_parserThread.quit();
     m_parserThread.wait();
+    //Save the seek index.
+    KNMusicSeekIndex::instance()->saveCache();
     //Ask to save the configure.
     emit requireSaveConfigure();
+    saveEqualizer();
     //Delete all the plugins.
     while(!m_pluginList.isEmpty())
     {
@@ -130,6 +153,10 @@ KNMusicPlugin::~KNMusicPlugin()
             delete currentPlugin;
         }
     }
+    //The backend is deleted, no one is using the equalizer.
+    delete m_equalizer;
+    //The lyrics manager is deleted in the lyrics thread.
+    KNMusicLyricsManager::destroyInstance();
 }
 
 QString KNMusicPlugin::caption()
@@ -197,6 +224,8 @@ inline void KNMusicPlugin::loadBackend(KNMusicBackend *plugin)
     if(m_backend==nullptr)
     {
         m_backend=plugin;
+        //Set the equalizer.
+        m_backend->setEqualizer(m_equalizer);
         //Add plugin to the list.
         m_pluginList.append(m_backend);
     }
@@ -285,6 +314,8 @@ inline void KNMusicPlugin::loadNowPlaying(KNMusicNowPlayingBase *plugin)
 inline void KNMusicPlugin::loadLibrary(KNMusicLibraryBase *plugin)
 {
     m_pluginList.append(plugin);
+    //Set the global library, the playlists refer to the songs in it.
+    KNMusicGlobal::setLibrary(plugin);
     //Add tabs.
     addMusicTab(plugin->songTab());
     addMusicTab(plugin->artistTab());
@@ -292,6 +323,8 @@ inline void KNMusicPlugin::loadLibrary(KNMusicLibraryBase *plugin)
     addMusicTab(plugin->genreTab());
     //Set the player.
     plugin->setHeaderPlayer(m_headerPlayer);
+    //Set the backend, it decodes the files for measuring.
+    plugin->setBackend(m_backend);
 }
 
 inline void KNMusicPlugin::loadPlaylistManager(KNMusicPlaylistManagerBase *plugin)
@@ -449,6 +482,57 @@ inline void KNMusicPlugin::initialParser()
     KNMusicGlobal::setParser(parser);
 }
 
+inline void KNMusicPlugin::loadEqualizer()
+{
+    m_equalizer=new KNMusicEqualizer;
+    m_equalizer->setEnabled(
+                m_musicGlobal->configureData("EqualizerEnabled",
+                                             false).toBool());
+    m_equalizer->setPreamp(
+                m_musicGlobal->configureData("EqualizerPreamp",
+                                             0.0).toDouble());
+    //The gains of a preset are used when a preset is selected. The custom
+    //presets are saved as "Name=gain,gain,...;Name=gain,gain,...".
+    QString presetName=
+            m_musicGlobal->configureData("EqualizerPreset", "").toString();
+    QVector<qreal> gains=KNMusicEqualizer::presetGains(presetName);
+    if(gains.isEmpty() && !presetName.isEmpty())
+    {
+        QStringList customPresets=
+                m_musicGlobal->configureData("EqualizerPresets",
+                                             "").toString().split(';');
+        for(QStringList::const_iterator i=customPresets.constBegin();
+            i!=customPresets.constEnd();
+            ++i)
+        {
+            int nameEnd=(*i).indexOf('=');
+            if(nameEnd>0 && (*i).left(nameEnd)==presetName)
+            {
+                gains=KNMusicEqualizer::gainsFromString((*i).mid(nameEnd+1));
+                break;
+            }
+        }
+    }
+    if(gains.isEmpty())
+    {
+        gains=KNMusicEqualizer::gainsFromString(
+                    m_musicGlobal->configureData("EqualizerGains",
+                                                 "").toString());
+    }
+    m_equalizer->setGains(gains);
+}
+
+inline void KNMusicPlugin::saveEqualizer()
+{
+    m_musicGlobal->setConfigureData("EqualizerEnabled",
+                                    m_equalizer->isEnabled());
+    m_musicGlobal->setConfigureData("EqualizerPreamp",
+                                    m_equalizer->preamp());
+    m_musicGlobal->setConfigureData(
+                "EqualizerGains",
+                KNMusicEqualizer::gainsToString(m_equalizer->gains()));
+}
+
 inline void KNMusicPlugin::initialSoloMenu(KNMusicSoloMenuBase *soloMenu)
 {
     //Add this to plugin list.
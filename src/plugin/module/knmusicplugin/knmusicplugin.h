@@ -28,6 +28,7 @@ class KNMouseDetectHeader;
 class KNMusicTab;
 class KNMusicCategoryTabWidget;
 class KNMusicBackend;
+class KNMusicEqualizer;
 class KNMusicGlobal;
 class KNMusicParser;
 class KNMusicSearchBase;
@@ -92,6 +93,8 @@ private slots:
 private:
     inline void initialInfrastructure();
     inline void initialParser();
+    inline void loadEqualizer();
+    inline void saveEqualizer();
     inline void initialSoloMenu(KNMusicSoloMenuBase *soloMenu);
     inline void initialMultiMenu(KNMusicMultiMenuBase *multiMenu);
     inline void addMusicTab(KNMusicTab *musicTab);
@@ -113,6 +116,7 @@ private:
     KNMusicGlobal *m_musicGlobal;
 
     KNMusicBackend *m_backend=nullptr;
+    KNMusicEqualizer *m_equalizer=nullptr;
     KNMusicNowPlayingBase *m_nowPlaying=nullptr;
     KNMusicHeaderPlayerBase *m_headerPlayer=nullptr;
     KNMusicMainPlayerBase *m_mainPlayer=nullptr;
@@ -20,6 +20,7 @@
 
 #include "knglobal.h"
 #include "knmusicbassglobal.h"
+#include "knmusicbassaudiodecoder.h"
 #include "knmusicbackendbassthread.h"
 
 #include "knmusicbackendbass.h"
@@ -81,6 +82,11 @@ int KNMusicBackendBass::volumeMaximum()
     return 10000;
 }
 
+KNMusicAudioDecoder *KNMusicBackendBass::createAudioDecoder()
+{
+    return m_available?new KNMusicBassAudioDecoder:nullptr;
+}
+
 bool KNMusicBackendBass::initialBass()
 {
     //Check the bass version.
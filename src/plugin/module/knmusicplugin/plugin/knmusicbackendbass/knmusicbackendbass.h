@@ -49,6 +49,8 @@ public:
     int volumeMinimal();
     int volumeMaximum();
 
+    KNMusicAudioDecoder *createAudioDecoder();
+
 signals:
 
 public slots:
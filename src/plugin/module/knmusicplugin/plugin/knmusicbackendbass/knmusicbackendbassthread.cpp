@@ -16,8 +16,12 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 #include <QTimer>
+#include <qmath.h>
 
 #include "knmusicbassglobal.h"
+#include "knmusicseekindex.h"
+#include "knmusicspectrumanalyser.h"
+#include "knmusicequalizer.h"
 
 #include "knmusicbackendbassthread.h"
 
@@ -26,14 +30,26 @@
 KNMusicBackendBassThread::KNMusicBackendBassThread(QObject *parent) :
     KNMusicBackendThread(parent)
 {
+    m_seekIndex=KNMusicSeekIndex::instance();
     //Initial position updater.
     m_positionUpdater=new QTimer;
-    m_positionUpdater->setInterval(5);
+    m_positionUpdater->setInterval(m_positionUpdateInterval);
     connect(m_positionUpdater, &QTimer::timeout,
             this, &KNMusicBackendBassThread::onActionPositionCheck);
 
     connect(this, &KNMusicBackendBassThread::requireStopped,
             this, &KNMusicBackendBassThread::stop);
+    //The switch requests are sent from the threads of bass, they should be
+    //handled after the output is unlocked.
+    connect(this, &KNMusicBackendBassThread::requireScheduleSwitch,
+            this, &KNMusicBackendBassThread::onActionScheduleSwitch,
+            Qt::QueuedConnection);
+    connect(this, &KNMusicBackendBassThread::requireFinishSwitch,
+            this, &KNMusicBackendBassThread::onActionFinishSwitch,
+            Qt::QueuedConnection);
+    connect(this, &KNMusicBackendBassThread::requireFreeFadedChannels,
+            this, &KNMusicBackendBassThread::onActionFreeFadedChannels,
+            Qt::QueuedConnection);
 }
 
 KNMusicBackendBassThread::~KNMusicBackendBassThread()
@@ -47,8 +63,8 @@ void KNMusicBackendBassThread::loadFromFile(const QString &filePath)
     stop();
     //Stop the position updater.
     m_positionUpdater->stop();
-    //Release all the sync handle.
-    releaseSyncHandle();
+    //The prepared section won't be played.
+    clearNextSection();
     //Load the file to thread.
     //Check is the file the current file.
     if(filePath==m_filePath)
@@ -56,45 +72,55 @@ void KNMusicBackendBassThread::loadFromFile(const QString &filePath)
         resetState();
         return;
     }
+    //Release all the sync handle.
+    releaseSyncHandle();
+    //Free the output and the channel of the previous file.
+    BASS_StreamFree(m_output);
+    m_output=0;
+    m_equalizerDsp=0;
+    m_spectrumDsp=0;
+    stopFade();
+    onActionFreeFadedChannels();
+    freeChannel(m_channel);
+    m_decodeChannel=0;
     //Backup the file path.
     m_filePath=filePath;
     //Emit file path changed signal.
     emit filePathChanged(m_filePath);
     //Load the file.
-#ifdef Q_OS_WIN32
-    std::wstring uniPath=m_filePath.toStdWString();
-    if(!(m_channel=BASS_StreamCreateFile(FALSE,
-                                         uniPath.data(),
-                                         0,
-                                         0,
-                                         BASS_UNICODE |
-                                           KNMusicBassGlobal::fdps()))
-           && !(m_channel=BASS_MusicLoad(FALSE,
-                                         uniPath.data(),
-                                         0,
-                                         0,
-                                         BASS_UNICODE |
-                                           BASS_MUSIC_RAMPS |
-                                           KNMusicBassGlobal::fdps(),1)))
-#endif
-#ifdef Q_OS_UNIX
-    std::string uniPath=m_filePath.toStdString();
-    if(!(m_channel=BASS_StreamCreateFile(FALSE,
-                                         uniPath.data(),
-                                         0,
-                                         0,
-                                         KNMusicBassGlobal::fdps()))
-            && !(m_channel=BASS_MusicLoad(FALSE,
-                                          uniPath.data(),
-                                          0,
-                                          0,
-                                          BASS_MUSIC_RAMPS |
-                                          KNMusicBassGlobal::fdps(),1)))
-#endif
+    m_channel=loadChannel(m_filePath);
+    if(!m_channel)
     {
         emit cannotLoadFile();
         return;
     }
+    //Create the output for the channel, it plays the data of the channel
+    //and the channels of the next sections which have the same format.
+    BASS_CHANNELINFO channelInfo;
+    BASS_ChannelGetInfo(m_channel, &channelInfo);
+    m_output=BASS_StreamCreate(channelInfo.freq,
+                               channelInfo.chans,
+                               KNMusicBassGlobal::fdps(),
+                               outputProc,
+                               this);
+    if(!m_output)
+    {
+        freeChannel(m_channel);
+        emit cannotLoadFile();
+        return;
+    }
+    //Equalize the output samples and write them to the analyser.
+    m_outputChannels=channelInfo.chans;
+    m_outputFrequency=channelInfo.freq;
+    installDsps();
+    //Decode the channel from the very beginning.
+    m_decodeChannel=m_channel;
+    m_channelStart=0.0;
+    m_channelEnd=0;
+    m_decodeEnd=0;
+    m_outputWritten=0;
+    m_segmentOutputStart=0;
+    m_segmentStart=0;
     //Establish sync handle.
     establishSyncHandle();
     //When loading the file complete, set the channel info to the thread.
@@ -107,9 +133,19 @@ void KNMusicBackendBassThread::loadFromFile(const QString &filePath)
 
 void KNMusicBackendBassThread::clear()
 {
+    //Clear the prepared section.
+    clearNextSection();
     //Clear channel datas.
-    BASS_MusicFree(m_channel);
-    BASS_StreamFree(m_channel);
+    releaseSyncHandle();
+    BASS_StreamFree(m_output);
+    m_output=0;
+    m_equalizerDsp=0;
+    m_spectrumDsp=0;
+    stopFade();
+    onActionFreeFadedChannels();
+    freeChannel(m_channel);
+    m_decodeChannel=0;
+    m_channelStart=0.0;
     //Reset thread.
     m_filePath.clear();
     //Reset the durations.
@@ -128,12 +164,9 @@ void KNMusicBackendBassThread::resetState()
 {
     //Set stop flag.
     m_stoppedState=true;
-    //Get the duration
-    m_duration=m_totalDuration;
-    //Set the start position at the very beginning.
-    m_startPosition=0;
-    //Set default end position as the whole file.
-    m_endPosition=m_duration;
+    //Set the whole file as the section.
+    updateSection(-1, -1);
+    setChannelEnd(0);
 }
 
 void KNMusicBackendBassThread::stop()
@@ -141,7 +174,7 @@ void KNMusicBackendBassThread::stop()
     if(m_playingState!=StoppedState)
     {
         //Stop the channel, here is what the specific thing.
-        BASS_ChannelStop(m_channel);
+        BASS_ChannelStop(m_output);
         //Stop position updater.
         m_positionUpdater->stop();
         //Reset position.
@@ -157,7 +190,7 @@ void KNMusicBackendBassThread::pause()
     if(m_playingState!=PausedState)
     {
         //Pause that thread.
-        BASS_ChannelPause(m_channel);
+        BASS_ChannelPause(m_output);
         //Stop the updater.
         m_positionUpdater->stop();
         //Reset the state.
@@ -169,8 +202,11 @@ void KNMusicBackendBassThread::play()
 {
     if(m_playingState!=PlayingState)
     {
-        //Start the position updater first.
-        m_positionUpdater->start();
+        //Start the position updater first, if anyone is watching.
+        if(m_positionUpdateInterval>0)
+        {
+            m_positionUpdater->start();
+        }
         //Check whether is now is playing or not.
         if(m_stoppedState)
         {
@@ -180,10 +216,10 @@ void KNMusicBackendBassThread::play()
             setPosition(0);
             //Set the volume to the last volume, because of the reset, the
             //volume is back to 1.0.
-            BASS_ChannelSetAttribute(m_channel, BASS_ATTRIB_VOL, m_lastVolume);
+            BASS_ChannelSetAttribute(m_output, BASS_ATTRIB_VOL, m_lastVolume);
         }
         //Play the thread.
-        BASS_ChannelPlay(m_channel, FALSE);
+        BASS_ChannelPlay(m_output, FALSE);
         //Reset the state.
         setState(PlayingState);
     }
@@ -192,7 +228,7 @@ void KNMusicBackendBassThread::play()
 int KNMusicBackendBassThread::volume()
 {
     float channelVolume;
-    BASS_ChannelGetAttribute(m_channel,
+    BASS_ChannelGetAttribute(m_output,
                              BASS_ATTRIB_VOL,
                              &channelVolume);
     return (int)channelVolume*100;
@@ -205,30 +241,30 @@ qint64 KNMusicBackendBassThread::duration()
 
 qint64 KNMusicBackendBassThread::position()
 {
-    return (qint64)(BASS_ChannelBytes2Seconds(m_channel,
-                                             BASS_ChannelGetPosition(m_channel, BASS_POS_BYTE))
+    if(!m_output)
+    {
+        return 0;
+    }
+    //The position of the output is the position which is heard, change it to
+    //the position of the channel.
+    QWORD outputPosition=BASS_ChannelGetPosition(m_output, BASS_POS_BYTE),
+          channelPosition=m_segmentStart+
+                (outputPosition>m_segmentOutputStart?
+                     outputPosition-m_segmentOutputStart:0);
+    return (qint64)((m_channelStart+
+                     BASS_ChannelBytes2Seconds(m_channel, channelPosition))
                     *1000)-m_startPosition;
 }
 
 void KNMusicBackendBassThread::setPlaySection(const qint64 &sectionStart,
                                               const qint64 &sectionDuration)
 {
-    //Check the start position and duration is still in the duration.
-    //If it's available, set the start position.
-    if(sectionStart!=-1 && sectionStart<m_duration)
+    //Update the section.
+    updateSection(sectionStart, sectionDuration);
+    //Stop decoding the channel at the end of the section.
+    if(sectionStart!=-1 && sectionStart<m_totalDuration)
     {
-        m_startPosition=sectionStart;
-        //Update the duration.
-        if(m_startPosition!=-1 && m_startPosition+sectionDuration<m_duration)
-        {
-            m_duration=sectionDuration;
-        }
-        else
-        {
-            m_duration=m_duration-m_startPosition;
-        }
-        //Update the end position.
-        m_endPosition=m_startPosition+m_duration;
+        setChannelEnd(channelBytes(m_endPosition));
     }
     //Update the duration like playing file.
     emit durationChanged(duration());
@@ -243,10 +279,188 @@ void KNMusicBackendBassThread::playSection(const qint64 &sectionStart,
     play();
 }
 
+void KNMusicBackendBassThread::prepareNextSection(const QString &filePath,
+                                                  const qint64 &sectionStart,
+                                                  const qint64 &sectionDuration)
+{
+    //Remove the previous prepared section.
+    clearNextSection();
+    //Check the output is available.
+    if(!m_output)
+    {
+        return;
+    }
+    DWORD nextChannel;
+    //If the next section is in the current file (e.g. the next track of a cue
+    //image), the output will keep reading the current channel. The channel
+    //which is opened from a seek point can't read the data before the point.
+    if(filePath==m_filePath &&
+            (sectionStart==-1?0:sectionStart)>=m_channelStart*1000)
+    {
+        nextChannel=m_channel;
+    }
+    else
+    {
+        //Open the file now, when the current section is finished, the output
+        //can read the next section without opening the file.
+        nextChannel=loadChannel(filePath);
+        if(!nextChannel)
+        {
+            return;
+        }
+        //The output can only play the channel which has the same format.
+        BASS_CHANNELINFO outputInfo, nextInfo;
+        BASS_ChannelGetInfo(m_output, &outputInfo);
+        BASS_ChannelGetInfo(nextChannel, &nextInfo);
+        if(outputInfo.freq!=nextInfo.freq || outputInfo.chans!=nextInfo.chans)
+        {
+            freeChannel(nextChannel);
+            return;
+        }
+    }
+    //Calculate the section in bytes. The new channel is moved to the start of
+    //the section now, the current channel will be moved when the output
+    //reaches the end of the current section.
+    QWORD startBytes=0, endBytes=0;
+    if(sectionStart!=-1)
+    {
+        if(nextChannel==m_channel)
+        {
+            startBytes=channelBytes(sectionStart);
+            if(sectionDuration!=-1)
+            {
+                endBytes=channelBytes(sectionStart+sectionDuration);
+            }
+        }
+        else
+        {
+            startBytes=msecondToBytes(nextChannel, sectionStart);
+            BASS_ChannelSetPosition(nextChannel, startBytes, BASS_POS_BYTE);
+            if(sectionDuration!=-1)
+            {
+                endBytes=msecondToBytes(nextChannel,
+                                        sectionStart+sectionDuration);
+            }
+        }
+    }
+    //Save the section.
+    m_nextFilePath=filePath;
+    m_nextStartPosition=sectionStart;
+    m_nextDuration=sectionDuration;
+    //Give the channel to the output. The sections of the same file are always
+    //played gapless.
+    BASS_ChannelLock(m_output, TRUE);
+    m_nextChannel=nextChannel;
+    m_nextStartBytes=startBytes;
+    m_nextEndBytes=endBytes;
+    m_nextFadeBytes=
+            (m_nextCrossfadeMode==CrossfadeOff || nextChannel==m_channel)?
+                0:
+                BASS_ChannelSeconds2Bytes(m_output,
+                                          (double)m_nextCrossfadeDuration/1000.0);
+    BASS_ChannelLock(m_output, FALSE);
+}
+
+void KNMusicBackendBassThread::clearNextSection()
+{
+    //If the output has already read the next section, go back to the position
+    //which is being heard, the data of the next section will be dropped.
+    if(m_switchPending)
+    {
+        setPosition(position());
+    }
+    //Take the next channel from the output.
+    BASS_ChannelLock(m_output, TRUE);
+    DWORD nextChannel=m_nextChannel;
+    m_nextChannel=0;
+    BASS_ChannelLock(m_output, FALSE);
+    //Free the channel, if it's not the current one.
+    if(nextChannel!=m_channel)
+    {
+        freeChannel(nextChannel);
+    }
+    m_nextFilePath.clear();
+}
+
+void KNMusicBackendBassThread::setPositionUpdateInterval(const int &interval)
+{
+    //Save the interval.
+    m_positionUpdateInterval=interval;
+    //Pause the updater when the position is not displayed.
+    if(m_positionUpdateInterval<1)
+    {
+        m_positionUpdater->stop();
+        return;
+    }
+    m_positionUpdater->setInterval(m_positionUpdateInterval);
+    //Resume the updater if it's playing, and update the position now.
+    if(m_playingState==PlayingState)
+    {
+        m_positionUpdater->start();
+    }
+    onActionPositionCheck();
+}
+
+void KNMusicBackendBassThread::setGain(const qreal &gain)
+{
+    BASS_ChannelLock(m_output, TRUE);
+    m_gain=gain;
+    //If the output has read the next section, the gain will be used when the
+    //switch is cancelled.
+    if(!m_switchPending)
+    {
+        m_decodeGain=m_gain;
+    }
+    BASS_ChannelLock(m_output, FALSE);
+}
+
+void KNMusicBackendBassThread::setNextSectionGain(const qreal &gain)
+{
+    BASS_ChannelLock(m_output, TRUE);
+    m_nextGain=gain;
+    if(m_switchPending)
+    {
+        m_decodeGain=m_nextGain;
+    }
+    BASS_ChannelLock(m_output, FALSE);
+}
+
+void KNMusicBackendBassThread::setNextSectionCrossfade(const int &mode,
+                                                       const int &duration)
+{
+    //The crossfade is used when the next section is prepared.
+    m_nextCrossfadeMode=duration>0?mode:CrossfadeOff;
+    m_nextCrossfadeDuration=duration;
+}
+
+void KNMusicBackendBassThread::setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser)
+{
+    //Remove the DSP of the previous analyser first, it won't be called after
+    //it's removed.
+    if(m_spectrumDsp)
+    {
+        BASS_ChannelRemoveDSP(m_output, m_spectrumDsp);
+        m_spectrumDsp=0;
+    }
+    m_spectrumAnalyser=analyser;
+    installDsps();
+}
+
+void KNMusicBackendBassThread::setEqualizer(KNMusicEqualizer *equalizer)
+{
+    if(m_equalizerDsp)
+    {
+        BASS_ChannelRemoveDSP(m_output, m_equalizerDsp);
+        m_equalizerDsp=0;
+    }
+    m_equalizer=equalizer;
+    installDsps();
+}
+
 void KNMusicBackendBassThread::setVolume(const int &volumeSize)
 {
     float channelVolume=(float)volumeSize/100;
-    BASS_ChannelSetAttribute(m_channel, BASS_ATTRIB_VOL, channelVolume);
+    BASS_ChannelSetAttribute(m_output, BASS_ATTRIB_VOL, channelVolume);
     //Backup the volume
     m_lastVolume=channelVolume;
 }
@@ -254,37 +468,200 @@ void KNMusicBackendBassThread::setVolume(const int &volumeSize)
 void KNMusicBackendBassThread::setPosition(const qint64 &position)
 {
     //If no media, ignore.
-    if(m_filePath.isEmpty())
+    if(m_filePath.isEmpty() || !m_output)
     {
         return;
     }
-    //Change the position into second.
+    qint64 targetPosition=m_startPosition+position;
+    //Seeking a VBR file without a table of contents is only an estimation.
+    //If the file is in the seek index, open a new channel from the frame
+    //right before the position, and decode to the exact position from there.
+    //The channel which is opened from a seek point has to be reopened from
+    //the start of the file to seek back over the point.
+    DWORD seekChannel=0, previousChannel=0;
+    quint32 seekOffset=0;
+    double seekChannelStart=0.0;
+    if(m_seekIndex->findPoint(m_filePath,
+                              targetPosition,
+                              seekOffset,
+                              seekChannelStart))
+    {
+        seekChannel=loadChannel(m_filePath, seekOffset);
+    }
+    if(!seekChannel && m_channelStart>0)
+    {
+        seekChannelStart=0.0;
+        seekChannel=loadChannel(m_filePath);
+    }
+    BASS_ChannelLock(m_output, TRUE);
+    //If the output has read the next section, give it back. The section which
+    //is fading out won't be heard any more.
+    cancelSwitch();
+    stopFade();
+    //The next section of the same file reads the current channel, keep the
+    //channel if the new channel can't reach the start of it.
+    if(seekChannel && m_nextChannel==m_channel &&
+            (m_nextStartPosition==-1?0:m_nextStartPosition)<
+            seekChannelStart*1000)
+    {
+        previousChannel=seekChannel;
+        seekChannel=0;
+    }
+    if(seekChannel)
+    {
+        //Replace the current channel.
+        previousChannel=m_channel;
+        m_channel=seekChannel;
+        m_decodeChannel=seekChannel;
+        m_channelStart=seekChannelStart;
+        //Update the bytes of the section end and the next section.
+        if(m_channelEnd>0)
+        {
+            m_channelEnd=channelBytes(m_endPosition);
+            m_decodeEnd=m_channelEnd;
+        }
+        if(m_nextChannel==previousChannel)
+        {
+            m_nextChannel=m_channel;
+            m_nextStartBytes=channelBytes(m_nextStartPosition);
+            m_nextEndBytes=m_nextDuration==-1?
+                        0:channelBytes(m_nextStartPosition+m_nextDuration);
+        }
+    }
+    //Set the position of the channel. The new channel decodes the frames to
+    //the position instead of estimating it.
+    QWORD channelPosition=channelBytes(targetPosition);
     BASS_ChannelSetPosition(m_channel,
-                            BASS_ChannelSeconds2Bytes(m_channel,
-                                                      (double)(m_startPosition+position)/1000.0),
-                            BASS_POS_BYTE);
+                            channelPosition,
+                            seekChannel?
+                                BASS_POS_BYTE | BASS_POS_DECODETO :
+                                BASS_POS_BYTE);
+    //Reset the output to drop the data in its buffer.
+    BASS_ChannelSetPosition(m_output, 0, BASS_POS_BYTE);
+    m_outputWritten=0;
+    m_segmentOutputStart=0;
+    m_segmentStart=channelPosition;
+    BASS_ChannelLock(m_output, FALSE);
+    //Free the channels which are not used any more.
+    freeChannel(previousChannel);
+    onActionFreeFadedChannels();
     //Do the position check.
     onActionPositionCheck();
 }
 
 void KNMusicBackendBassThread::onActionPositionCheck()
 {
-    qint64 currentPosition=position();
-    emit positionChanged(currentPosition);
-    /*
-     * - Q: Why we still need to do this?
-     * - A: When cue is playing, it may not stopped at the end of the file.
-     *      The callback is only used to solve the position won't reach the end
-     *   bug, the track duration stopped will still process here.
-     */
-    if(currentPosition>=m_duration)
+    //The end of the section is checked when the output reads the channel, the
+    //output will be ended at the exact position, here we only need to update
+    //the position.
+    emit positionChanged(position());
+}
+
+void KNMusicBackendBassThread::onActionScheduleSwitch()
+{
+    BASS_ChannelLock(m_output, TRUE);
+    //Check whether the switch is still needed, and it's not scheduled.
+    if(!m_switchPending || m_switchSync)
+    {
+        BASS_ChannelLock(m_output, FALSE);
+        return;
+    }
+    QWORD switchPosition=m_switchOutputPosition;
+    //Finish the switch when the output plays the first byte of the next
+    //section.
+    m_switchSync=BASS_ChannelSetSync(m_output,
+                                     BASS_SYNC_POS | BASS_SYNC_ONETIME,
+                                     switchPosition,
+                                     onActionSwitch,
+                                     this);
+    BASS_ChannelLock(m_output, FALSE);
+    //The output may have already played over the position.
+    if(BASS_ChannelGetPosition(m_output, BASS_POS_BYTE)>=switchPosition)
+    {
+        onActionFinishSwitch();
+    }
+}
+
+void KNMusicBackendBassThread::onActionFinishSwitch()
+{
+    BASS_ChannelLock(m_output, TRUE);
+    //Ignore the switch which is cancelled or not heard yet.
+    if(!m_switchPending ||
+            BASS_ChannelGetPosition(m_output, BASS_POS_BYTE)<
+            m_switchOutputPosition)
+    {
+        BASS_ChannelLock(m_output, FALSE);
+        return;
+    }
+    //Remove the sync.
+    BASS_ChannelRemoveSync(m_output, m_switchSync);
+    m_switchSync=0;
+    m_switchPending=false;
+    //The next section is heard now.
+    DWORD previousChannel=m_channel;
+    m_channel=m_decodeChannel;
+    m_channelEnd=m_decodeEnd;
+    m_segmentOutputStart=m_switchOutputPosition;
+    m_segmentStart=m_nextStartBytes;
+    m_gain=m_nextGain;
+    //The channel which is fading out will be freed after the fade.
+    bool fading=(previousChannel==m_fadeChannel);
+    BASS_ChannelLock(m_output, FALSE);
+    //Free the previous channel, if it's not still be used.
+    if(previousChannel!=m_channel && !fading)
+    {
+        freeChannel(previousChannel);
+    }
+    //Update the file path.
+    if(m_filePath!=m_nextFilePath)
+    {
+        m_filePath=m_nextFilePath;
+        emit filePathChanged(m_filePath);
+    }
+    m_nextFilePath.clear();
+    //Update the durations. The length of the channel which is opened from a
+    //seek point is not the length of the file, the duration of the same file
+    //is kept.
+    if(previousChannel!=m_channel)
+    {
+        m_channelStart=0.0;
+        m_totalDuration=BASS_ChannelBytes2Seconds(m_channel,
+                                                  BASS_ChannelGetLength(m_channel, BASS_POS_BYTE))*1000;
+    }
+    updateSection(m_nextStartPosition, m_nextDuration);
+    emit durationChanged(duration());
+    //Ask to prepare the section after this one.
+    emit nextSectionStarted();
+    //Update the position.
+    onActionPositionCheck();
+}
+
+void KNMusicBackendBassThread::onActionFreeFadedChannels()
+{
+    //Take the channels from the output, and free them.
+    BASS_ChannelLock(m_output, TRUE);
+    QList<DWORD> fadedChannels=m_fadedChannels;
+    m_fadedChannels.clear();
+    BASS_ChannelLock(m_output, FALSE);
+    while(!fadedChannels.isEmpty())
     {
-        stop();
-        m_stoppedState=true;
-        emit finished();
+        DWORD channel=fadedChannels.takeLast();
+        freeChannel(channel);
     }
 }
 
+DWORD KNMusicBackendBassThread::outputProc(HSTREAM handle,
+                                           void *buffer,
+                                           DWORD length,
+                                           void *user)
+{
+    Q_UNUSED(handle)
+    //Transform the user pointer to channel pointer.
+    KNMusicBackendBassThread *bassThread=(KNMusicBackendBassThread *)user;
+    //Fill the buffer with the data of the sources.
+    return bassThread->readSource(buffer, length);
+}
+
 void KNMusicBackendBassThread::onActionEnd(HSYNC handle,
                                            DWORD channel,
                                            DWORD data,
@@ -304,9 +681,466 @@ void KNMusicBackendBassThread::onActionEnd(HSYNC handle,
     bassThread->finished();
 }
 
+void KNMusicBackendBassThread::onActionSwitch(HSYNC handle,
+                                              DWORD channel,
+                                              DWORD data,
+                                              void *user)
+{
+    Q_UNUSED(handle)
+    Q_UNUSED(channel)
+    Q_UNUSED(data)
+
+    //Transform the user pointer to channel pointer.
+    KNMusicBackendBassThread *bassThread=(KNMusicBackendBassThread *)user;
+    //Finish the switch in the thread of the object.
+    bassThread->requireFinishSwitch();
+}
+
+void KNMusicBackendBassThread::equalizerProc(HDSP handle,
+                                             DWORD channel,
+                                             void *buffer,
+                                             DWORD length,
+                                             void *user)
+{
+    Q_UNUSED(handle)
+    Q_UNUSED(channel)
+    //Transform the user pointer to channel pointer.
+    KNMusicBackendBassThread *bassThread=(KNMusicBackendBassThread *)user;
+    bassThread->m_equalizer->process(
+                (float *)buffer,
+                length/(sizeof(float)*bassThread->m_outputChannels),
+                bassThread->m_outputChannels,
+                bassThread->m_outputFrequency);
+}
+
+void KNMusicBackendBassThread::spectrumProc(HDSP handle,
+                                            DWORD channel,
+                                            void *buffer,
+                                            DWORD length,
+                                            void *user)
+{
+    Q_UNUSED(handle)
+    Q_UNUSED(channel)
+    //Transform the user pointer to channel pointer.
+    KNMusicBackendBassThread *bassThread=(KNMusicBackendBassThread *)user;
+    //The floating-point DSP is enabled, the samples are always float.
+    bassThread->m_spectrumAnalyser->writeSamples(
+                (const float *)buffer,
+                length/(sizeof(float)*bassThread->m_outputChannels),
+                bassThread->m_outputChannels,
+                bassThread->m_outputFrequency);
+}
+
+inline DWORD KNMusicBackendBassThread::loadChannel(const QString &filePath,
+                                                   const QWORD &offset)
+{
+    DWORD channel;
+    //The file is loaded as a decoding channel, the data is played by output.
+#ifdef Q_OS_WIN32
+    std::wstring uniPath=filePath.toStdWString();
+    if(!(channel=BASS_StreamCreateFile(FALSE,
+                                       uniPath.data(),
+                                       offset,
+                                       0,
+                                       BASS_UNICODE |
+                                         BASS_STREAM_DECODE |
+                                         KNMusicBassGlobal::fdps()))
+           && !(channel=BASS_MusicLoad(FALSE,
+                                       uniPath.data(),
+                                       0,
+                                       0,
+                                       BASS_UNICODE |
+                                         BASS_MUSIC_RAMPS |
+                                         BASS_MUSIC_DECODE |
+                                         KNMusicBassGlobal::fdps(),1)))
+#endif
+#ifdef Q_OS_UNIX
+    std::string uniPath=filePath.toStdString();
+    if(!(channel=BASS_StreamCreateFile(FALSE,
+                                       uniPath.data(),
+                                       offset,
+                                       0,
+                                       BASS_STREAM_DECODE |
+                                       KNMusicBassGlobal::fdps()))
+            && !(channel=BASS_MusicLoad(FALSE,
+                                        uniPath.data(),
+                                        0,
+                                        0,
+                                        BASS_MUSIC_RAMPS |
+                                        BASS_MUSIC_DECODE |
+                                        KNMusicBassGlobal::fdps(),1)))
+#endif
+    {
+        return 0;
+    }
+    return channel;
+}
+
+inline void KNMusicBackendBassThread::freeChannel(DWORD &channel)
+{
+    if(channel)
+    {
+        //The channel is either a stream or a music.
+        BASS_StreamFree(channel);
+        BASS_MusicFree(channel);
+        channel=0;
+    }
+}
+
+inline QWORD KNMusicBackendBassThread::msecondToBytes(const DWORD &channel,
+                                                      const qint64 &msecond)
+{
+    return BASS_ChannelSeconds2Bytes(channel, (double)msecond/1000.0);
+}
+
+inline QWORD KNMusicBackendBassThread::channelBytes(const qint64 &msecond)
+{
+    //Change the position of the file to the position of the current channel.
+    double second=(double)msecond/1000.0-m_channelStart;
+    return second>0?BASS_ChannelSeconds2Bytes(m_channel, second):0;
+}
+
+inline void KNMusicBackendBassThread::updateSection(const qint64 &sectionStart,
+                                                    const qint64 &sectionDuration)
+{
+    //Set the whole file as the section.
+    m_duration=m_totalDuration;
+    m_startPosition=0;
+    m_endPosition=m_duration;
+    //Check the start position and duration is still in the duration.
+    //If it's available, set the start position.
+    if(sectionStart!=-1 && sectionStart<m_duration)
+    {
+        m_startPosition=sectionStart;
+        //Update the duration.
+        if(sectionDuration!=-1 && m_startPosition+sectionDuration<m_duration)
+        {
+            m_duration=sectionDuration;
+        }
+        else
+        {
+            m_duration=m_duration-m_startPosition;
+        }
+        //Update the end position.
+        m_endPosition=m_startPosition+m_duration;
+    }
+}
+
+inline void KNMusicBackendBassThread::setChannelEnd(const QWORD &channelEnd)
+{
+    BASS_ChannelLock(m_output, TRUE);
+    m_channelEnd=channelEnd;
+    //If the output is reading the section, stop at the new end.
+    if(!m_switchPending)
+    {
+        m_decodeEnd=m_channelEnd;
+    }
+    BASS_ChannelLock(m_output, FALSE);
+}
+
+inline QWORD KNMusicBackendBassThread::decodeRemain()
+{
+    //Get the bytes to the end of the section which is being decoded, the length
+    //of the channel may be unknown, e.g. a music.
+    QWORD decodeEnd=m_decodeEnd;
+    if(decodeEnd==0)
+    {
+        decodeEnd=BASS_ChannelGetLength(m_decodeChannel, BASS_POS_BYTE);
+        if(decodeEnd==(QWORD)-1)
+        {
+            return (QWORD)-1;
+        }
+    }
+    QWORD decodePosition=BASS_ChannelGetPosition(m_decodeChannel,
+                                                 BASS_POS_BYTE);
+    return decodePosition<decodeEnd?decodeEnd-decodePosition:0;
+}
+
+inline void KNMusicBackendBassThread::applyGain(void *buffer,
+                                                const DWORD &length,
+                                                const float &gain)
+{
+    if(gain==1.0)
+    {
+        return;
+    }
+    //The data of the decoding channels is float if it's supported.
+    if(KNMusicBassGlobal::fdps())
+    {
+        float *samples=(float *)buffer;
+        for(DWORD i=0, count=length/sizeof(float); i<count; i++)
+        {
+            samples[i]*=gain;
+        }
+        return;
+    }
+    short *samples=(short *)buffer;
+    for(DWORD i=0, count=length/sizeof(short); i<count; i++)
+    {
+        samples[i]=(short)qBound(-32768.0f, samples[i]*gain, 32767.0f);
+    }
+}
+
+inline bool KNMusicBackendBassThread::isSilent(const void *buffer,
+                                               const DWORD &length)
+{
+    //The data under -48 dBFS is treated as silence.
+    if(KNMusicBassGlobal::fdps())
+    {
+        const float *samples=(const float *)buffer;
+        float peak=0.0f;
+        for(DWORD i=0, count=length/sizeof(float); i<count; i++)
+        {
+            peak=qMax(peak, qAbs(samples[i]));
+        }
+        return peak<0.004f;
+    }
+    const short *samples=(const short *)buffer;
+    int peak=0;
+    for(DWORD i=0, count=length/sizeof(short); i<count; i++)
+    {
+        peak=qMax(peak, qAbs((int)samples[i]));
+    }
+    return peak<131;
+}
+
+inline void KNMusicBackendBassThread::mixFade(void *buffer,
+                                              const DWORD &length)
+{
+    //Read the same length of data from the fade channel. If the channel is
+    //ended before the fade, the rest of it is silence, the next section still
+    //fades in until the end of the fade.
+    DWORD mixLength=(DWORD)qMin((QWORD)length, m_fadeLength-m_fadePosition);
+    if((DWORD)m_fadeBuffer.size()<mixLength)
+    {
+        m_fadeBuffer.resize(mixLength);
+    }
+    char *fadeData=m_fadeBuffer.data();
+    DWORD received=BASS_ChannelGetData(m_fadeChannel, fadeData, mixLength);
+    if(received==(DWORD)-1)
+    {
+        received=0;
+    }
+    memset(fadeData+received, 0, mixLength-received);
+    applyGain(fadeData, received, m_fadeGain);
+    //Mix the sections with the equal-power curves, the sum of the power is
+    //kept during the fade.
+    bool floatSamples=KNMusicBassGlobal::fdps();
+    DWORD frameSize=(floatSamples?sizeof(float):sizeof(short))*
+                        m_outputChannels,
+          frames=mixLength/frameSize;
+    double step=M_PI_2*frameSize/m_fadeLength,
+           angle=M_PI_2*m_fadePosition/m_fadeLength;
+    for(DWORD i=0; i<frames; i++, angle+=step)
+    {
+        float fadeIn=qSin(angle), fadeOut=qCos(angle);
+        DWORD offset=i*m_outputChannels;
+        if(floatSamples)
+        {
+            float *samples=(float *)buffer+offset,
+                  *fadeSamples=(float *)fadeData+offset;
+            for(int j=0; j<m_outputChannels; j++)
+            {
+                samples[j]=samples[j]*fadeIn+fadeSamples[j]*fadeOut;
+            }
+            continue;
+        }
+        short *samples=(short *)buffer+offset,
+              *fadeSamples=(short *)fadeData+offset;
+        for(int j=0; j<m_outputChannels; j++)
+        {
+            samples[j]=(short)qBound(-32768.0f,
+                                     samples[j]*fadeIn+fadeSamples[j]*fadeOut,
+                                     32767.0f);
+        }
+    }
+    m_fadePosition+=mixLength;
+    if(m_fadePosition>=m_fadeLength)
+    {
+        stopFade();
+    }
+}
+
+inline void KNMusicBackendBassThread::stopFade()
+{
+    //This should be called when the output is locked. If the switch to the
+    //next section is not heard, the fade channel is still the current channel,
+    //it will be freed when the switch is finished.
+    if(!m_fadeChannel)
+    {
+        return;
+    }
+    if(m_fadeChannel!=m_channel)
+    {
+        m_fadedChannels.append(m_fadeChannel);
+        emit requireFreeFadedChannels();
+    }
+    m_fadeChannel=0;
+}
+
+inline void KNMusicBackendBassThread::installDsps()
+{
+    if(!m_output)
+    {
+        return;
+    }
+    //The DSP with the higher priority is called first, the analyser gets the
+    //equalized samples.
+    if(m_equalizer!=nullptr && !m_equalizerDsp)
+    {
+        m_equalizerDsp=BASS_ChannelSetDSP(m_output, equalizerProc, this, 1);
+    }
+    if(m_spectrumAnalyser!=nullptr && !m_spectrumDsp)
+    {
+        m_spectrumDsp=BASS_ChannelSetDSP(m_output, spectrumProc, this, 0);
+        //The samples are heard after the playback buffer.
+        m_spectrumAnalyser->setLatency(BASS_GetConfig(BASS_CONFIG_BUFFER));
+    }
+}
+
+DWORD KNMusicBackendBassThread::readSource(void *buffer, DWORD length)
+{
+    //This is called when the output is locked, the channels won't be changed
+    //until it returns.
+    char *data=(char *)buffer;
+    DWORD filled=0;
+    while(filled<length && m_decodeChannel)
+    {
+        //Don't read over the end of the section.
+        DWORD request=length-filled;
+        QWORD remain=decodeRemain();
+        if(m_decodeEnd>0 && remain<request)
+        {
+            request=(DWORD)remain;
+        }
+        //Check whether the crossfade to the next section can be started, only
+        //one section can be faded out at the same time.
+        bool crossfade=m_nextChannel && m_nextFadeBytes>0 && !m_fadeChannel &&
+                remain!=(QWORD)-1;
+        if(crossfade && m_nextCrossfadeMode==CrossfadeTime && remain>0)
+        {
+            //Start the fade when the rest of the section fits in it, otherwise
+            //read to the start of the fade.
+            if(remain<=m_nextFadeBytes)
+            {
+                switchSection(m_outputWritten+filled, remain);
+                continue;
+            }
+            if(remain-request<m_nextFadeBytes)
+            {
+                request=(DWORD)(remain-m_nextFadeBytes);
+            }
+        }
+        if(request>0)
+        {
+            DWORD received=BASS_ChannelGetData(m_decodeChannel,
+                                               data+filled,
+                                               request);
+            if(received!=(DWORD)-1)
+            {
+                //Apply the gain of the section to the data, and mix the
+                //section which is fading out.
+                applyGain(data+filled, received, m_decodeGain);
+                if(m_fadeChannel)
+                {
+                    mixFade(data+filled, received);
+                }
+                filled+=received;
+                //In the silence mode, the fade starts when the end of the
+                //section is silent.
+                if(crossfade && m_nextCrossfadeMode==CrossfadeSilence &&
+                        received>0 && remain<=m_nextFadeBytes &&
+                        isSilent(data+filled-received, received))
+                {
+                    switchSection(m_outputWritten+filled,
+                                  remain>received?remain-received:0);
+                    continue;
+                }
+                if(received==request)
+                {
+                    continue;
+                }
+            }
+            //If the channel isn't ended, it only can't give more data now.
+            if(BASS_ChannelIsActive(m_decodeChannel)!=BASS_ACTIVE_STOPPED)
+            {
+                break;
+            }
+        }
+        //The section is finished, if there's no next section, end the output.
+        if(!m_nextChannel)
+        {
+            m_outputWritten+=filled;
+            return filled | BASS_STREAMPROC_END;
+        }
+        switchSection(m_outputWritten+filled, 0);
+    }
+    m_outputWritten+=filled;
+    return filled;
+}
+
+void KNMusicBackendBassThread::switchSection(const QWORD &outputPosition,
+                                             const QWORD &fadeLength)
+{
+    //This should be called when the output is locked. Read the next section
+    //from here, the switch will be finished when the output plays this
+    //position.
+    m_switchOutputPosition=outputPosition;
+    //Keep decoding the current section for the fade.
+    if(fadeLength>0)
+    {
+        m_fadeChannel=m_decodeChannel;
+        m_fadeGain=m_decodeGain;
+        m_fadeLength=fadeLength;
+        m_fadePosition=0;
+    }
+    m_decodeChannel=m_nextChannel;
+    m_decodeEnd=m_nextEndBytes;
+    m_decodeGain=m_nextGain;
+    m_nextChannel=0;
+    m_switchPending=true;
+    //The section in the same channel may not start right after the current
+    //one, move to the start of it.
+    if(BASS_ChannelGetPosition(m_decodeChannel, BASS_POS_BYTE)!=
+            m_nextStartBytes)
+    {
+        BASS_ChannelSetPosition(m_decodeChannel,
+                                m_nextStartBytes,
+                                BASS_POS_BYTE);
+    }
+    emit requireScheduleSwitch();
+}
+
+void KNMusicBackendBassThread::cancelSwitch()
+{
+    //This should be called when the output is locked.
+    if(!m_switchPending)
+    {
+        return;
+    }
+    m_switchPending=false;
+    //The fading section is the current section, it will be read again.
+    stopFade();
+    //Remove the sync of the switch.
+    if(m_switchSync)
+    {
+        BASS_ChannelRemoveSync(m_output, m_switchSync);
+        m_switchSync=0;
+    }
+    //Rewind the next channel, and prepare it again. If it's the current
+    //channel, it will be moved to the new position later.
+    BASS_ChannelSetPosition(m_decodeChannel, m_nextStartBytes, BASS_POS_BYTE);
+    m_nextChannel=m_decodeChannel;
+    m_nextEndBytes=m_decodeEnd;
+    //Read the current channel.
+    m_decodeChannel=m_channel;
+    m_decodeEnd=m_channelEnd;
+    m_decodeGain=m_gain;
+}
+
 void KNMusicBackendBassThread::establishSyncHandle()
 {
-    HSYNC handle=BASS_ChannelSetSync(m_channel,
+    HSYNC handle=BASS_ChannelSetSync(m_output,
                                      BASS_SYNC_END,
                                      0,
                                      onActionEnd,
@@ -319,7 +1153,7 @@ void KNMusicBackendBassThread::releaseSyncHandle()
     //Remove all the sync in the list.
     while(!m_syncHandles.isEmpty())
     {
-        BASS_ChannelRemoveSync(m_channel,
+        BASS_ChannelRemoveSync(m_output,
                                m_syncHandles.takeLast());
     }
 }
@@ -26,6 +26,7 @@
 
 using namespace KNMusic;
 
+class KNMusicSeekIndex;
 class KNMusicBackendBassThread : public KNMusicBackendThread
 {
     Q_OBJECT
@@ -45,6 +46,16 @@ public:
                         const qint64 &sectionDuration=-1);
     void playSection(const qint64 &sectionStart=-1,
                      const qint64 &sectionDuration=-1);
+    void prepareNextSection(const QString &filePath,
+                            const qint64 &sectionStart=-1,
+                            const qint64 &sectionDuration=-1);
+    void clearNextSection();
+    void setPositionUpdateInterval(const int &interval);
+    void setGain(const qreal &gain);
+    void setNextSectionGain(const qreal &gain);
+    void setNextSectionCrossfade(const int &mode, const int &duration);
+    void setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser);
+    void setEqualizer(KNMusicEqualizer *equalizer);
 
     bool stoppedState() const;
     void setStoppedState(bool stoppedState);
@@ -52,6 +63,9 @@ public:
 
 signals:
     void requireStopped();
+    void requireScheduleSwitch();
+    void requireFinishSwitch();
+    void requireFreeFadedChannels();
 
 public slots:
     void setVolume(const int &volumeSize);
@@ -59,12 +73,49 @@ public slots:
 
 private slots:
     void onActionPositionCheck();
+    void onActionScheduleSwitch();
+    void onActionFinishSwitch();
+    void onActionFreeFadedChannels();
 
 private:
+    static DWORD CALLBACK outputProc(HSTREAM handle,
+                                     void *buffer,
+                                     DWORD length,
+                                     void *user);
     static void CALLBACK onActionEnd(HSYNC handle,
                                      DWORD channel,
                                      DWORD data,
                                      void *user);
+    static void CALLBACK onActionSwitch(HSYNC handle,
+                                        DWORD channel,
+                                        DWORD data,
+                                        void *user);
+    static void CALLBACK equalizerProc(HDSP handle,
+                                       DWORD channel,
+                                       void *buffer,
+                                       DWORD length,
+                                       void *user);
+    static void CALLBACK spectrumProc(HDSP handle,
+                                      DWORD channel,
+                                      void *buffer,
+                                      DWORD length,
+                                      void *user);
+    inline DWORD loadChannel(const QString &filePath, const QWORD &offset=0);
+    inline void freeChannel(DWORD &channel);
+    inline QWORD msecondToBytes(const DWORD &channel, const qint64 &msecond);
+    inline QWORD channelBytes(const qint64 &msecond);
+    inline void updateSection(const qint64 &sectionStart,
+                              const qint64 &sectionDuration);
+    inline void setChannelEnd(const QWORD &channelEnd);
+    inline QWORD decodeRemain();
+    inline void applyGain(void *buffer, const DWORD &length, const float &gain);
+    inline bool isSilent(const void *buffer, const DWORD &length);
+    inline void mixFade(void *buffer, const DWORD &length);
+    inline void stopFade();
+    inline void installDsps();
+    DWORD readSource(void *buffer, DWORD length);
+    void switchSection(const QWORD &outputPosition, const QWORD &fadeLength);
+    void cancelSwitch();
     void establishSyncHandle();
     void releaseSyncHandle();
     void setState(const int &state);
@@ -77,8 +128,52 @@ private:
     qint64 m_duration;        //Unit: millisecond
     qint64 m_totalDuration;   //Unit: millisecond
     QTimer *m_positionUpdater=nullptr;
+    int m_positionUpdateInterval=16;    //Unit: millisecond, 0 means paused.
     QList<HSYNC> m_syncHandles;
-    DWORD m_channel;
+    //The decoded data of the sources is written to the output stream. The
+    //output may still be playing the current channel while it's reading the
+    //next one, so the channel which is heard and the channel which is being
+    //decoded are saved separately.
+    HSTREAM m_output=0;
+    DWORD m_channel=0, m_decodeChannel=0;
+    //When the channel is opened from a frame in the seek index, the first
+    //byte of it is not the start of the file.
+    double m_channelStart=0.0;                 //Unit: second
+    KNMusicSeekIndex *m_seekIndex;
+    QWORD m_channelEnd=0, m_decodeEnd=0;     //Unit: byte, 0 means file end.
+    QWORD m_outputWritten=0;                 //Unit: byte
+    //The output position where the current channel is heard from, and the
+    //channel position at that time.
+    QWORD m_segmentOutputStart=0, m_segmentStart=0;
+    //The prepared next section. When it's in the same file, the channel of
+    //the current file is used.
+    QString m_nextFilePath;
+    DWORD m_nextChannel=0;
+    QWORD m_nextStartBytes=0, m_nextEndBytes=0;
+    qint64 m_nextStartPosition=-1, m_nextDuration=-1;
+    QWORD m_switchOutputPosition=0;
+    HSYNC m_switchSync=0;
+    bool m_switchPending=false;
+    //The gain of the current section, the next section, and the section which
+    //is being decoded.
+    float m_gain=1.0, m_nextGain=1.0, m_decodeGain=1.0;
+    //The crossfade to the next section. When it starts, the channel of the
+    //current section is moved to the fade channel, it's decoded with the next
+    //section and mixed to the output until the end of the fade.
+    int m_nextCrossfadeMode=CrossfadeOff, m_nextCrossfadeDuration=0;
+    QWORD m_nextFadeBytes=0;                  //Unit: byte, 0 means gapless.
+    DWORD m_fadeChannel=0;
+    QWORD m_fadeLength=0, m_fadePosition=0;  //Unit: byte
+    float m_fadeGain=1.0;
+    QByteArray m_fadeBuffer;
+    QList<DWORD> m_fadedChannels;
+    //The DSPs of the output which equalize the samples and write them to the
+    //spectrum analyser, they are only set when there's an equalizer or an
+    //analyser.
+    KNMusicEqualizer *m_equalizer=nullptr;
+    KNMusicSpectrumAnalyser *m_spectrumAnalyser=nullptr;
+    HDSP m_equalizerDsp=0, m_spectrumDsp=0;
+    int m_outputChannels=0, m_outputFrequency=0;
 };
 
 #endif // KNMUSICBACKENDBASSTHREAD_H
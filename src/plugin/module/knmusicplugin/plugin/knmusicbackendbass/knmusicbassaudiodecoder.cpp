@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "knmusicbassaudiodecoder.h"
+
+KNMusicBassAudioDecoder::KNMusicBassAudioDecoder()
+{
+}
+
+KNMusicBassAudioDecoder::~KNMusicBassAudioDecoder()
+{
+    close();
+}
+
+bool KNMusicBassAudioDecoder::open(const QString &filePath,
+                                   const qint64 &start,
+                                   const qint64 &duration)
+{
+    close();
+    //The decoding channels can always give out float data. Scan the file to
+    //make sure the seeking in the VBR file is exact.
+#ifdef Q_OS_WIN32
+    m_channel=BASS_StreamCreateFile(FALSE,
+                                    filePath.toStdWString().data(),
+                                    0,
+                                    0,
+                                    BASS_UNICODE |
+                                    BASS_STREAM_DECODE |
+                                    BASS_STREAM_PRESCAN |
+                                    BASS_SAMPLE_FLOAT);
+#endif
+#ifdef Q_OS_UNIX
+    m_channel=BASS_StreamCreateFile(FALSE,
+                                    filePath.toStdString().data(),
+                                    0,
+                                    0,
+                                    BASS_STREAM_DECODE |
+                                    BASS_STREAM_PRESCAN |
+                                    BASS_SAMPLE_FLOAT);
+#endif
+    if(!m_channel)
+    {
+        return false;
+    }
+    BASS_CHANNELINFO channelInfo;
+    BASS_ChannelGetInfo(m_channel, &channelInfo);
+    m_sampleRate=channelInfo.freq;
+    m_channels=channelInfo.chans;
+    //Move to the section.
+    if(start>0)
+    {
+        BASS_ChannelSetPosition(m_channel,
+                                BASS_ChannelSeconds2Bytes(m_channel,
+                                                          (double)start/1000.0),
+                                BASS_POS_BYTE);
+    }
+    m_limited=(duration>0);
+    if(m_limited)
+    {
+        m_remainBytes=BASS_ChannelSeconds2Bytes(m_channel,
+                                                (double)duration/1000.0);
+    }
+    return true;
+}
+
+int KNMusicBassAudioDecoder::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+int KNMusicBassAudioDecoder::channels() const
+{
+    return m_channels;
+}
+
+int KNMusicBassAudioDecoder::decode(float *buffer, const int &frameCount)
+{
+    if(!m_channel)
+    {
+        return 0;
+    }
+    DWORD frameSize=m_channels*sizeof(float),
+          request=frameCount*frameSize;
+    //Don't read over the end of the section.
+    if(m_limited && m_remainBytes<request)
+    {
+        request=(DWORD)m_remainBytes;
+    }
+    if(request==0)
+    {
+        return 0;
+    }
+    DWORD received=BASS_ChannelGetData(m_channel, buffer, request);
+    if(received==(DWORD)-1)
+    {
+        return 0;
+    }
+    if(m_limited)
+    {
+        m_remainBytes-=received;
+    }
+    return received/frameSize;
+}
+
+void KNMusicBassAudioDecoder::close()
+{
+    if(m_channel)
+    {
+        BASS_StreamFree(m_channel);
+        m_channel=0;
+    }
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICBASSAUDIODECODER_H
+#define KNMUSICBASSAUDIODECODER_H
+
+#include "bass.h"
+
+#include "knmusicaudiodecoder.h"
+
+class KNMusicBassAudioDecoder : public KNMusicAudioDecoder
+{
+public:
+    KNMusicBassAudioDecoder();
+    ~KNMusicBassAudioDecoder();
+    bool open(const QString &filePath,
+              const qint64 &start=-1,
+              const qint64 &duration=-1);
+    int sampleRate() const;
+    int channels() const;
+    int decode(float *buffer, const int &frameCount);
+
+private:
+    void close();
+    HSTREAM m_channel=0;
+    QWORD m_remainBytes=0;  //Unit: byte, 0 means the file end.
+    bool m_limited=false;
+    int m_sampleRate=0, m_channels=0;
+};
+
+#endif // KNMUSICBASSAUDIODECODER_H
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "knmusicglobal.h"
+#include "knmusicffmpegnullsink.h"
+#include "knmusicffmpegwavsink.h"
+#ifdef Q_OS_LINUX
+#include "knmusicffmpegpulsesink.h"
+#include "knmusicffmpegalsasink.h"
+#endif
+#include "knmusicffmpegaudiodecoder.h"
+#include "knmusicbackendffmpegthread.h"
+
+#include "knmusicbackendffmpeg.h"
+
+KNMusicBackendFFMpeg::KNMusicBackendFFMpeg(QObject *parent) :
+    KNMusicStandardBackend(parent)
+{
+    //Get the sink from the configure.
+    KNMusicGlobal *musicGlobal=KNMusicGlobal::instance();
+    QString sinkName=musicGlobal->configureData("OutputSink",
+                                                "PulseAudio").toString();
+    KNMusicFFMpegSink *mainSink=
+            createSink(sinkName,
+                       musicGlobal->configureData("OutputFile").toString());
+    //Drop the data when the sink is not available.
+    if(mainSink==nullptr)
+    {
+        mainSink=new KNMusicFFMpegNullSink;
+    }
+    //Initial the main and preview thread. The preview of the file sinks goes
+    //nowhere, or it will overwrite the main file.
+    m_main=new KNMusicBackendFFMpegThread(mainSink, this);
+    setMainThread(m_main);
+
+    KNMusicFFMpegSink *previewSink=
+            createSink(sinkName=="Wav"?"Null":sinkName);
+    if(previewSink==nullptr)
+    {
+        previewSink=new KNMusicFFMpegNullSink;
+    }
+    m_preview=new KNMusicBackendFFMpegThread(previewSink, this);
+    setPreviewThread(m_preview);
+}
+
+bool KNMusicBackendFFMpeg::available()
+{
+    return m_main!=nullptr;
+}
+
+int KNMusicBackendFFMpeg::volume() const
+{
+    return m_main->volume();
+}
+
+void KNMusicBackendFFMpeg::loadUrl(const QString &url)
+{
+    Q_UNUSED(url)
+}
+
+int KNMusicBackendFFMpeg::volumeMinimal()
+{
+    return 0;
+}
+
+int KNMusicBackendFFMpeg::volumeMaximum()
+{
+    return 100;
+}
+
+KNMusicAudioDecoder *KNMusicBackendFFMpeg::createAudioDecoder()
+{
+    return new KNMusicFFMpegAudioDecoder;
+}
+
+KNMusicFFMpegSink *KNMusicBackendFFMpeg::createSink(const QString &sinkName,
+                                                    const QString &filePath)
+{
+    if(sinkName=="Null")
+    {
+        return new KNMusicFFMpegNullSink;
+    }
+    if(sinkName=="Wav")
+    {
+        return filePath.isEmpty()?nullptr:new KNMusicFFMpegWavSink(filePath);
+    }
+#ifdef Q_OS_LINUX
+    if(sinkName=="ALSA")
+    {
+        return new KNMusicFFMpegAlsaSink;
+    }
+    return new KNMusicFFMpegPulseSink;
+#else
+    return nullptr;
+#endif
+}
+
+void KNMusicBackendFFMpeg::changeVolume(const int &volumeSize)
+{
+    m_main->setVolume(volumeSize);
+}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICBACKENDFFMPEG_H
+#define KNMUSICBACKENDFFMPEG_H
+
+/*
+ * The FFMpeg backend decodes the files with libavcodec and plays them through
+ * a sink. It needs no proprietary library. The sink is chosen by the
+ * configure "OutputSink":
+ *  - "PulseAudio" and "ALSA" play the sound on Linux.
+ *  - "Null" drops all the data as fast as it's decoded.
+ *  - "Wav" writes all the data to the file of "OutputFile".
+ * The last two can be used to measure the decoding speed, the seeking latency
+ * and check the gapless playing without a sound card.
+ */
+
+#include "knmusicstandardbackend.h"
+
+class KNMusicFFMpegSink;
+class KNMusicBackendFFMpegThread;
+class KNMusicBackendFFMpeg : public KNMusicStandardBackend
+{
+    Q_OBJECT
+public:
+    explicit KNMusicBackendFFMpeg(QObject *parent = 0);
+    bool available();
+    int volume() const;
+
+    void loadUrl(const QString &url);
+
+    int volumeMinimal();
+    int volumeMaximum();
+
+    KNMusicAudioDecoder *createAudioDecoder();
+
+    static KNMusicFFMpegSink *createSink(const QString &sinkName,
+                                         const QString &filePath=QString());
+
+signals:
+
+public slots:
+
+protected:
+    void changeVolume(const int &volumeSize);
+
+private:
+    KNMusicBackendFFMpegThread *m_main=nullptr, *m_preview=nullptr;
+};
+
+#endif // KNMUSICBACKENDFFMPEG_H
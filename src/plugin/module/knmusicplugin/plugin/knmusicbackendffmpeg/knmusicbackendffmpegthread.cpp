@@ -0,0 +1,509 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <QTimer>
+
+#include "knmusicffmpegsink.h"
+#include "knmusicffmpegsource.h"
+#include "knmusicffmpegringbuffer.h"
+#include "knmusicffmpegdecoder.h"
+#include "knmusicffmpegoutput.h"
+
+#include "knmusicbackendffmpegthread.h"
+
+#include <QDebug>
+
+KNMusicBackendFFMpegThread::KNMusicBackendFFMpegThread(KNMusicFFMpegSink *sink,
+                                                       QObject *parent) :
+    KNMusicBackendThread(parent),
+    m_sink(sink)
+{
+    //Initial the buffer and the workers.
+    m_buffer=new KNMusicFFMpegRingBuffer;
+    m_decoder=new KNMusicFFMpegDecoder(m_buffer, this);
+    m_output=new KNMusicFFMpegOutput(m_buffer, m_decoder, this);
+    m_output->setSink(m_sink);
+    connect(m_output, &KNMusicFFMpegOutput::switchReached,
+            this, &KNMusicBackendFFMpegThread::onActionSwitchReached);
+    connect(m_output, &KNMusicFFMpegOutput::finished,
+            this, &KNMusicBackendFFMpegThread::onActionOutputFinished);
+
+    //Initial position updater.
+    m_positionUpdater=new QTimer(this);
+    m_positionUpdater->setInterval(m_positionUpdateInterval);
+    connect(m_positionUpdater, &QTimer::timeout,
+            this, &KNMusicBackendFFMpegThread::onActionPositionCheck);
+}
+
+KNMusicBackendFFMpegThread::~KNMusicBackendFFMpegThread()
+{
+    //Stop the workers before the buffer and the sink is freed.
+    m_output->stopOutput();
+    m_decoder->stopDecoding();
+    delete m_output;
+    delete m_decoder;
+    delete m_buffer;
+    m_sink->close();
+    delete m_sink;
+}
+
+void KNMusicBackendFFMpegThread::loadFromFile(const QString &filePath)
+{
+    //Stop the thread first.
+    stop();
+    //Stop the position updater.
+    m_positionUpdater->stop();
+    //The prepared section won't be played.
+    clearNextSection();
+    //Check is the file the current file.
+    if(filePath==m_filePath)
+    {
+        resetState();
+        return;
+    }
+    //Backup the file path.
+    m_filePath=filePath;
+    //Emit file path changed signal.
+    emit filePathChanged(m_filePath);
+    //Open the file.
+    KNMusicFFMpegSource *source=new KNMusicFFMpegSource;
+    if(!source->open(m_filePath))
+    {
+        delete source;
+        m_decoder->setSource(nullptr);
+        emit cannotLoadFile();
+        return;
+    }
+    source->setGain(m_gain);
+    m_decoder->setSource(source);
+    //Prepare the sink for the format of the file.
+    if(!openSink(source->sampleRate(), source->channels()))
+    {
+        m_decoder->setSource(nullptr);
+        emit cannotLoadFile();
+        return;
+    }
+    //Get the duration.
+    m_totalDuration=source->duration();
+    //Reset the thread.
+    resetState();
+}
+
+void KNMusicBackendFFMpegThread::clear()
+{
+    //Stop the workers.
+    stopWorkers();
+    m_positionUpdater->stop();
+    //Clear the sources.
+    clearNextSection();
+    m_decoder->setSource(nullptr);
+    //Close the sink.
+    m_sink->close();
+    m_sampleRate=0;
+    m_channels=0;
+    //Reset thread.
+    m_filePath.clear();
+    m_totalDuration=0;
+    resetState();
+    //Reset the state to stopped.
+    setState(StoppedState);
+}
+
+void KNMusicBackendFFMpegThread::resetState()
+{
+    //Set stop flag.
+    m_stoppedState=true;
+    m_pausedPosition=0;
+    //Set the whole file as the section.
+    updateSection(-1, -1);
+}
+
+void KNMusicBackendFFMpegThread::stop()
+{
+    if(m_playingState!=StoppedState)
+    {
+        //Stop the workers.
+        stopWorkers();
+        //Stop position updater.
+        m_positionUpdater->stop();
+        //Reset position.
+        m_pausedPosition=0;
+        //Reset the state.
+        setState(StoppedState);
+        emit stopped();
+        onActionPositionCheck();
+    }
+}
+
+void KNMusicBackendFFMpegThread::pause()
+{
+    if(m_playingState==PlayingState)
+    {
+        //Stop the workers, and save the position which is heard.
+        stopWorkers();
+        m_pausedPosition=position();
+        //Stop the updater.
+        m_positionUpdater->stop();
+        //Reset the state.
+        setState(PausedState);
+    }
+}
+
+void KNMusicBackendFFMpegThread::play()
+{
+    if(m_playingState!=PlayingState && m_decoder->source()!=nullptr)
+    {
+        //Play from the start when the file is just loaded.
+        if(m_stoppedState)
+        {
+            m_stoppedState=false;
+            m_pausedPosition=0;
+        }
+        //Start the workers from the position.
+        startWorkers(m_pausedPosition);
+        //Start the position updater, if anyone is watching.
+        if(m_positionUpdateInterval>0)
+        {
+            m_positionUpdater->start();
+        }
+        //Reset the state.
+        setState(PlayingState);
+    }
+}
+
+int KNMusicBackendFFMpegThread::volume()
+{
+    return m_volume;
+}
+
+qint64 KNMusicBackendFFMpegThread::duration()
+{
+    return m_duration;
+}
+
+qint64 KNMusicBackendFFMpegThread::position()
+{
+    if(m_playingState!=PlayingState)
+    {
+        return m_pausedPosition;
+    }
+    return m_basePosition+
+            bytesToMsecond(m_output->playedBytes()-m_baseBytes)-
+            m_startPosition;
+}
+
+void KNMusicBackendFFMpegThread::setPlaySection(const qint64 &sectionStart,
+                                                const qint64 &sectionDuration)
+{
+    //Update the section.
+    updateSection(sectionStart, sectionDuration);
+    //Update the duration like playing file.
+    emit durationChanged(duration());
+}
+
+void KNMusicBackendFFMpegThread::playSection(const qint64 &sectionStart,
+                                             const qint64 &sectionDuration)
+{
+    //Set the section.
+    setPlaySection(sectionStart, sectionDuration);
+    //Play the main thread.
+    play();
+}
+
+void KNMusicBackendFFMpegThread::prepareNextSection(const QString &filePath,
+                                                    const qint64 &sectionStart,
+                                                    const qint64 &sectionDuration)
+{
+    //Remove the previous prepared section.
+    clearNextSection();
+    //Check the sink is ready.
+    if(m_decoder->source()==nullptr || m_sampleRate==0)
+    {
+        return;
+    }
+    //Open the file now, it's converted to the format of the sink, so it can
+    //always be played right after the current section.
+    KNMusicFFMpegSource *nextSource=new KNMusicFFMpegSource;
+    if(!nextSource->open(filePath, m_sampleRate, m_channels))
+    {
+        delete nextSource;
+        return;
+    }
+    //Set the section.
+    nextSource->setEnd(sectionStart!=-1 && sectionDuration!=-1?
+                           sectionStart+sectionDuration:-1);
+    nextSource->seek(sectionStart==-1?0:sectionStart);
+    nextSource->setGain(m_nextGain);
+    //Save the section.
+    m_nextFilePath=filePath;
+    m_nextStartPosition=sectionStart;
+    m_nextDuration=sectionDuration;
+    //Give the source to the decoder.
+    m_decoder->setNextSource(nextSource);
+}
+
+void KNMusicBackendFFMpegThread::clearNextSection()
+{
+    //If the decoder has already decoded the next section, go back to the
+    //position which is being heard, the data of the next section will be
+    //dropped.
+    if(m_playingState==PlayingState && m_decoder->isSwitched())
+    {
+        stopWorkers();
+        qint64 currentPosition=position();
+        m_decoder->setNextSource(nullptr);
+        startWorkers(currentPosition);
+    }
+    m_decoder->setNextSource(nullptr);
+    m_nextFilePath.clear();
+}
+
+void KNMusicBackendFFMpegThread::setGain(const qreal &gain)
+{
+    m_gain=gain;
+    //The data which is already in the buffer is not changed.
+    if(m_decoder->source()!=nullptr)
+    {
+        m_decoder->source()->setGain(m_gain);
+    }
+}
+
+void KNMusicBackendFFMpegThread::setNextSectionGain(const qreal &gain)
+{
+    m_nextGain=gain;
+    if(m_decoder->nextSource()!=nullptr)
+    {
+        m_decoder->nextSource()->setGain(m_nextGain);
+    }
+}
+
+void KNMusicBackendFFMpegThread::setNextSectionCrossfade(const int &mode,
+                                                         const int &duration)
+{
+    //The decoder writes only one source to the output, the next section is
+    //always played gapless.
+    Q_UNUSED(mode)
+    Q_UNUSED(duration)
+}
+
+void KNMusicBackendFFMpegThread::setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser)
+{
+    //The output writes the samples which are sent to the sink.
+    m_output->setSpectrumAnalyser(analyser);
+}
+
+void KNMusicBackendFFMpegThread::setEqualizer(KNMusicEqualizer *equalizer)
+{
+    m_output->setEqualizer(equalizer);
+}
+
+void KNMusicBackendFFMpegThread::setPositionUpdateInterval(const int &interval)
+{
+    //Save the interval.
+    m_positionUpdateInterval=interval;
+    //Pause the updater when the position is not displayed.
+    if(m_positionUpdateInterval<1)
+    {
+        m_positionUpdater->stop();
+        return;
+    }
+    m_positionUpdater->setInterval(m_positionUpdateInterval);
+    //Resume the updater if it's playing, and update the position now.
+    if(m_playingState==PlayingState)
+    {
+        m_positionUpdater->start();
+    }
+    onActionPositionCheck();
+}
+
+void KNMusicBackendFFMpegThread::setVolume(const int &volumeSize)
+{
+    m_volume=volumeSize;
+    m_output->setVolume(m_volume);
+}
+
+void KNMusicBackendFFMpegThread::setPosition(const qint64 &position)
+{
+    //If no media, ignore.
+    if(m_decoder->source()==nullptr)
+    {
+        return;
+    }
+    if(m_playingState==PlayingState)
+    {
+        //Restart the workers from the new position.
+        stopWorkers();
+        startWorkers(position);
+    }
+    else
+    {
+        //Play from the position next time.
+        m_stoppedState=false;
+        m_pausedPosition=position;
+    }
+    //Do the position check.
+    onActionPositionCheck();
+}
+
+void KNMusicBackendFFMpegThread::onActionPositionCheck()
+{
+    emit positionChanged(position());
+}
+
+void KNMusicBackendFFMpegThread::onActionSwitchReached()
+{
+    //Check whether the switch is cancelled.
+    if(!m_decoder->isSwitched())
+    {
+        return;
+    }
+    //The next section is heard now.
+    m_baseBytes=m_decoder->switchPosition();
+    m_basePosition=m_nextStartPosition==-1?0:m_nextStartPosition;
+    m_decoder->finishSwitch();
+    m_output->resetSwitchReport();
+    m_gain=m_nextGain;
+    //Update the file path.
+    if(m_filePath!=m_nextFilePath)
+    {
+        m_filePath=m_nextFilePath;
+        emit filePathChanged(m_filePath);
+    }
+    m_nextFilePath.clear();
+    //Update the durations.
+    m_totalDuration=m_decoder->source()->duration();
+    updateSection(m_nextStartPosition, m_nextDuration);
+    emit durationChanged(duration());
+    //Ask to prepare the section after this one.
+    emit nextSectionStarted();
+    //Update the position.
+    onActionPositionCheck();
+}
+
+void KNMusicBackendFFMpegThread::onActionOutputFinished()
+{
+    //Ignore the output which is stopped by us.
+    if(!m_output->isDrained() || m_playingState!=PlayingState)
+    {
+        return;
+    }
+    //The section is finished.
+    stop();
+    m_stoppedState=true;
+    emit finished();
+}
+
+inline bool KNMusicBackendFFMpegThread::openSink(const int &sampleRate,
+                                                 const int &channels)
+{
+    //Reopen the sink only when the format is changed.
+    if(sampleRate==m_sampleRate && channels==m_channels)
+    {
+        return true;
+    }
+    m_sink->close();
+    if(!m_sink->open(sampleRate, channels))
+    {
+        m_sampleRate=0;
+        m_channels=0;
+        return false;
+    }
+    m_sampleRate=sampleRate;
+    m_channels=channels;
+    return true;
+}
+
+inline qint64 KNMusicBackendFFMpegThread::bytesToMsecond(const qint64 &bytes)
+{
+    return m_sampleRate==0?0:bytes*1000/(m_sampleRate*m_channels*2);
+}
+
+inline void KNMusicBackendFFMpegThread::updateSection(const qint64 &sectionStart,
+                                                      const qint64 &sectionDuration)
+{
+    //Set the whole file as the section.
+    m_duration=m_totalDuration;
+    m_startPosition=0;
+    m_endPosition=-1;
+    //Check the start position and duration is still in the duration.
+    //If it's available, set the start position.
+    if(sectionStart!=-1 && sectionStart<m_duration)
+    {
+        m_startPosition=sectionStart;
+        //Update the duration.
+        if(sectionDuration!=-1 && m_startPosition+sectionDuration<m_duration)
+        {
+            m_duration=sectionDuration;
+        }
+        else
+        {
+            m_duration=m_duration-m_startPosition;
+        }
+        //Update the end position.
+        m_endPosition=m_startPosition+m_duration;
+    }
+}
+
+void KNMusicBackendFFMpegThread::startWorkers(const qint64 &position)
+{
+    KNMusicFFMpegSource *source=m_decoder->source();
+    //Move the source to the position.
+    source->setEnd(m_endPosition);
+    source->seek(m_startPosition+position);
+    //Start from an empty buffer.
+    m_buffer->clear();
+    m_basePosition=m_startPosition+position;
+    m_baseBytes=0;
+    //Start the workers.
+    m_decoder->startDecoding();
+    m_output->startOutput(m_sampleRate, m_channels);
+}
+
+void KNMusicBackendFFMpegThread::stopWorkers()
+{
+    //Stop the workers, and drop the data which is not played.
+    m_decoder->stopDecoding();
+    m_output->stopOutput();
+    m_sink->drop();
+    //Check whether the next section is decoded.
+    if(m_decoder->isSwitched())
+    {
+        if(m_output->playedBytes()>=m_decoder->switchPosition())
+        {
+            //It's heard, finish the switch.
+            onActionSwitchReached();
+        }
+        else
+        {
+            //Move the next section back to its start.
+            m_decoder->cancelSwitch();
+            m_decoder->nextSource()->seek(m_nextStartPosition==-1?
+                                              0:m_nextStartPosition);
+        }
+    }
+}
+
+void KNMusicBackendFFMpegThread::setState(const int &state)
+{
+    //If the state is really different, we are going to emit playing state
+    //changed signal.
+    if(state!=m_playingState)
+    {
+        m_playingState=state;
+        emit stateChanged(m_playingState);
+    }
+}
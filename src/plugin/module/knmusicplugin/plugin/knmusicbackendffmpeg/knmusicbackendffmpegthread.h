@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICBACKENDFFMPEGTHREAD_H
+#define KNMUSICBACKENDFFMPEGTHREAD_H
+
+#include "knmusicglobal.h"
+
+#include "knmusicbackendthread.h"
+
+using namespace KNMusic;
+
+class QTimer;
+class KNMusicFFMpegSink;
+class KNMusicFFMpegRingBuffer;
+class KNMusicFFMpegDecoder;
+class KNMusicFFMpegOutput;
+class KNMusicBackendFFMpegThread : public KNMusicBackendThread
+{
+    Q_OBJECT
+public:
+    explicit KNMusicBackendFFMpegThread(KNMusicFFMpegSink *sink,
+                                        QObject *parent = 0);
+    ~KNMusicBackendFFMpegThread();
+    void loadFromFile(const QString &filePath);
+    void clear();
+    void resetState();
+    void stop();
+    void pause();
+    void play();
+    int volume();
+    qint64 duration();
+    qint64 position();
+    void setPlaySection(const qint64 &sectionStart=-1,
+                        const qint64 &sectionDuration=-1);
+    void playSection(const qint64 &sectionStart=-1,
+                     const qint64 &sectionDuration=-1);
+    void prepareNextSection(const QString &filePath,
+                            const qint64 &sectionStart=-1,
+                            const qint64 &sectionDuration=-1);
+    void clearNextSection();
+    void setPositionUpdateInterval(const int &interval);
+    void setGain(const qreal &gain);
+    void setNextSectionGain(const qreal &gain);
+    void setNextSectionCrossfade(const int &mode, const int &duration);
+    void setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser);
+    void setEqualizer(KNMusicEqualizer *equalizer);
+
+signals:
+
+public slots:
+    void setVolume(const int &volumeSize);
+    void setPosition(const qint64 &position);
+
+private slots:
+    void onActionPositionCheck();
+    void onActionSwitchReached();
+    void onActionOutputFinished();
+
+private:
+    inline bool openSink(const int &sampleRate, const int &channels);
+    inline qint64 bytesToMsecond(const qint64 &bytes);
+    inline void updateSection(const qint64 &sectionStart,
+                              const qint64 &sectionDuration);
+    void startWorkers(const qint64 &position);
+    void stopWorkers();
+    void setState(const int &state);
+    KNMusicFFMpegSink *m_sink;
+    KNMusicFFMpegRingBuffer *m_buffer;
+    KNMusicFFMpegDecoder *m_decoder;
+    KNMusicFFMpegOutput *m_output;
+    QTimer *m_positionUpdater;
+    int m_positionUpdateInterval=16;    //Unit: millisecond, 0 means paused.
+    int m_playingState=StoppedState, m_volume=100;
+    int m_sampleRate=0, m_channels=0;
+    QString m_filePath;
+    bool m_stoppedState=true;
+    qint64 m_startPosition=0;    //Unit: millisecond
+    qint64 m_endPosition=-1;     //Unit: millisecond, -1 means file end.
+    qint64 m_duration=0;         //Unit: millisecond
+    qint64 m_totalDuration=0;    //Unit: millisecond
+    qint64 m_pausedPosition=0;   //Unit: millisecond
+    //The position of the source when the output starts to play it, and the
+    //played bytes of the output at that time.
+    qint64 m_basePosition=0, m_baseBytes=0;
+    //The prepared next section.
+    QString m_nextFilePath;
+    qint64 m_nextStartPosition=-1, m_nextDuration=-1;
+    qreal m_gain=1.0, m_nextGain=1.0;
+};
+
+#endif // KNMUSICBACKENDFFMPEGTHREAD_H
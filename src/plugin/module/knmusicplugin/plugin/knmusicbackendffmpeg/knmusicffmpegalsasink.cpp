@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "knmusicffmpegalsasink.h"
+
+KNMusicFFMpegAlsaSink::KNMusicFFMpegAlsaSink() :
+    KNMusicFFMpegSink()
+{
+}
+
+KNMusicFFMpegAlsaSink::~KNMusicFFMpegAlsaSink()
+{
+    close();
+}
+
+bool KNMusicFFMpegAlsaSink::open(const int &sampleRate, const int &channels)
+{
+    close();
+    //Open the default device.
+    if(snd_pcm_open(&m_pcm, "default", SND_PCM_STREAM_PLAYBACK, 0)<0)
+    {
+        m_pcm=nullptr;
+        return false;
+    }
+    //Set the format, 100ms latency.
+    if(snd_pcm_set_params(m_pcm,
+                          SND_PCM_FORMAT_S16_LE,
+                          SND_PCM_ACCESS_RW_INTERLEAVED,
+                          channels,
+                          sampleRate,
+                          1,
+                          100000)<0)
+    {
+        close();
+        return false;
+    }
+    m_sampleRate=sampleRate;
+    m_frameSize=channels*2;
+    return true;
+}
+
+void KNMusicFFMpegAlsaSink::close()
+{
+    if(m_pcm!=nullptr)
+    {
+        snd_pcm_close(m_pcm);
+        m_pcm=nullptr;
+    }
+}
+
+bool KNMusicFFMpegAlsaSink::write(const char *data, const int &size)
+{
+    if(m_pcm==nullptr)
+    {
+        return false;
+    }
+    snd_pcm_uframes_t frames=size/m_frameSize;
+    while(frames>0)
+    {
+        snd_pcm_sframes_t written=snd_pcm_writei(m_pcm, data, frames);
+        if(written<0)
+        {
+            //Recover from the underrun.
+            if(snd_pcm_recover(m_pcm, written, 1)<0)
+            {
+                return false;
+            }
+            continue;
+        }
+        data+=written*m_frameSize;
+        frames-=written;
+    }
+    return true;
+}
+
+void KNMusicFFMpegAlsaSink::drop()
+{
+    if(m_pcm!=nullptr)
+    {
+        snd_pcm_drop(m_pcm);
+        snd_pcm_prepare(m_pcm);
+    }
+}
+
+void KNMusicFFMpegAlsaSink::drain()
+{
+    if(m_pcm!=nullptr)
+    {
+        snd_pcm_drain(m_pcm);
+        snd_pcm_prepare(m_pcm);
+    }
+}
+
+qint64 KNMusicFFMpegAlsaSink::latency()
+{
+    snd_pcm_sframes_t delay;
+    if(m_pcm==nullptr || snd_pcm_delay(m_pcm, &delay)<0 || delay<0)
+    {
+        return 0;
+    }
+    return (qint64)delay*1000000/m_sampleRate;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <cstring>
+
+#include "knmusicffmpegaudiodecoder.h"
+
+KNMusicFFMpegAudioDecoder::KNMusicFFMpegAudioDecoder()
+{
+}
+
+bool KNMusicFFMpegAudioDecoder::open(const QString &filePath,
+                                     const qint64 &start,
+                                     const qint64 &duration)
+{
+    m_pending.clear();
+    //Decode the file in its own sample rate and channel layout, the float
+    //samples are not clipped, so the true peak over 0 dBFS is kept.
+    if(!m_source.open(filePath, -1, -1, AV_SAMPLE_FMT_FLT))
+    {
+        return false;
+    }
+    //Set the section.
+    if(start>0)
+    {
+        m_source.setEnd(duration>0?start+duration:-1);
+        m_source.seek(start);
+    }
+    else if(duration>0)
+    {
+        m_source.setEnd(duration);
+    }
+    return true;
+}
+
+int KNMusicFFMpegAudioDecoder::sampleRate() const
+{
+    return m_source.sampleRate();
+}
+
+int KNMusicFFMpegAudioDecoder::channels() const
+{
+    return m_source.channels();
+}
+
+QVector<int> KNMusicFFMpegAudioDecoder::channelPositions() const
+{
+    qint64 layout=m_source.channelLayout();
+    //The side channels are the surround channels. The back channels are the
+    //surround channels only when there's no side channel, e.g. 5.1(back),
+    //otherwise they are weighted as the front channels in BS.1770.
+    bool hasSide=(layout & (AV_CH_SIDE_LEFT | AV_CH_SIDE_RIGHT))!=0;
+    QVector<int> positions;
+    for(int i=0; i<m_source.channels(); i++)
+    {
+        quint64 channel=av_channel_layout_extract_channel(layout, i);
+        switch(channel)
+        {
+        case AV_CH_LOW_FREQUENCY:
+        case AV_CH_LOW_FREQUENCY_2:
+            positions.append(LowFrequencyChannel);
+            break;
+        case AV_CH_SIDE_LEFT:
+        case AV_CH_SIDE_RIGHT:
+            positions.append(SurroundChannel);
+            break;
+        case AV_CH_BACK_LEFT:
+        case AV_CH_BACK_RIGHT:
+            positions.append(hasSide?FrontChannel:SurroundChannel);
+            break;
+        default:
+            positions.append(FrontChannel);
+        }
+    }
+    return positions;
+}
+
+int KNMusicFFMpegAudioDecoder::decode(float *buffer, const int &frameCount)
+{
+    int frameSize=m_source.channels()*sizeof(float),
+        requestSize=frameCount*frameSize;
+    //Decode until there's enough data, or the source is ended.
+    while(m_pending.size()<requestSize && m_source.decode(m_pending)>0)
+    {
+        ;
+    }
+    //The source has already converted the samples to float.
+    int frames=qMin(m_pending.size(), requestSize)/frameSize;
+    memcpy(buffer, m_pending.constData(), frames*frameSize);
+    m_pending.remove(0, frames*frameSize);
+    return frames;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICFFMPEGAUDIODECODER_H
+#define KNMUSICFFMPEGAUDIODECODER_H
+
+#include "knmusicffmpegsource.h"
+
+#include "knmusicaudiodecoder.h"
+
+class KNMusicFFMpegAudioDecoder : public KNMusicAudioDecoder
+{
+public:
+    KNMusicFFMpegAudioDecoder();
+    bool open(const QString &filePath,
+              const qint64 &start=-1,
+              const qint64 &duration=-1);
+    int sampleRate() const;
+    int channels() const;
+    QVector<int> channelPositions() const;
+    int decode(float *buffer, const int &frameCount);
+
+private:
+    KNMusicFFMpegSource m_source;
+    QByteArray m_pending;
+};
+
+#endif // KNMUSICFFMPEGAUDIODECODER_H
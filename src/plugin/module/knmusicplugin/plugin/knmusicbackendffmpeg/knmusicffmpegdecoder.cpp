@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "knmusicffmpegsource.h"
+#include "knmusicffmpegringbuffer.h"
+
+#include "knmusicffmpegdecoder.h"
+
+KNMusicFFMpegDecoder::KNMusicFFMpegDecoder(KNMusicFFMpegRingBuffer *buffer,
+                                           QObject *parent) :
+    QThread(parent),
+    m_buffer(buffer),
+    m_running(0),
+    m_ended(0)
+{
+}
+
+KNMusicFFMpegDecoder::~KNMusicFFMpegDecoder()
+{
+    stopDecoding();
+    delete m_source;
+    delete m_nextSource;
+}
+
+KNMusicFFMpegSource *KNMusicFFMpegDecoder::source()
+{
+    return m_source;
+}
+
+void KNMusicFFMpegDecoder::setSource(KNMusicFFMpegSource *source)
+{
+    //This should be called when the decoder is stopped.
+    delete m_source;
+    m_source=source;
+    m_switched=false;
+}
+
+KNMusicFFMpegSource *KNMusicFFMpegDecoder::nextSource()
+{
+    return m_nextSource;
+}
+
+void KNMusicFFMpegDecoder::setNextSource(KNMusicFFMpegSource *source)
+{
+    QMutexLocker locker(&m_sourceLock);
+    //The next source which is being decoded can't be replaced.
+    if(m_switched)
+    {
+        delete source;
+        return;
+    }
+    delete m_nextSource;
+    m_nextSource=source;
+}
+
+bool KNMusicFFMpegDecoder::isSwitched()
+{
+    QMutexLocker locker(&m_sourceLock);
+    return m_switched;
+}
+
+qint64 KNMusicFFMpegDecoder::switchPosition()
+{
+    QMutexLocker locker(&m_sourceLock);
+    return m_switchPosition;
+}
+
+void KNMusicFFMpegDecoder::finishSwitch()
+{
+    QMutexLocker locker(&m_sourceLock);
+    if(!m_switched)
+    {
+        return;
+    }
+    //The next source is heard, the previous one is useless.
+    delete m_source;
+    m_source=m_nextSource;
+    m_nextSource=nullptr;
+    m_switched=false;
+}
+
+void KNMusicFFMpegDecoder::cancelSwitch()
+{
+    //This should be called when the decoder is stopped, the next source will
+    //be moved to its start by the caller.
+    m_switched=false;
+}
+
+bool KNMusicFFMpegDecoder::isEnded() const
+{
+    return m_ended.loadAcquire();
+}
+
+void KNMusicFFMpegDecoder::startDecoding()
+{
+    //Reset the states.
+    m_pending.clear();
+    m_written=0;
+    m_ended.storeRelease(0);
+    m_running.storeRelease(1);
+    start();
+}
+
+void KNMusicFFMpegDecoder::stopDecoding()
+{
+    m_running.storeRelease(0);
+    wait();
+    m_pending.clear();
+}
+
+void KNMusicFFMpegDecoder::run()
+{
+    while(m_running.loadAcquire())
+    {
+        //Decode more data when all the data is written.
+        if(m_pending.isEmpty())
+        {
+            //Only pick the source with the lock. The decoding source is never
+            //deleted when it's being decoded: the current source is only
+            //replaced after the switch, and the next source can't be replaced
+            //after the switch.
+            m_sourceLock.lock();
+            KNMusicFFMpegSource *decodingSource=
+                    m_switched?m_nextSource:m_source;
+            m_sourceLock.unlock();
+            if(decodingSource==nullptr || decodingSource->decode(m_pending)==0)
+            {
+                //Continue with the next source.
+                QMutexLocker locker(&m_sourceLock);
+                if(!m_switched && m_nextSource!=nullptr)
+                {
+                    m_switched=true;
+                    m_switchPosition=m_written;
+                    continue;
+                }
+                //No more data.
+                m_ended.storeRelease(1);
+                return;
+            }
+        }
+        //Write the data to the buffer.
+        int writtenSize=m_buffer->write(m_pending.constData(),
+                                        m_pending.size());
+        if(writtenSize==0)
+        {
+            //The buffer is full, wait for the output.
+            msleep(5);
+            continue;
+        }
+        m_pending.remove(0, writtenSize);
+        m_written+=writtenSize;
+    }
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICFFMPEGDECODER_H
+#define KNMUSICFFMPEGDECODER_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThread>
+
+class KNMusicFFMpegSource;
+class KNMusicFFMpegRingBuffer;
+/*
+ * The decoder thread fills the ring buffer with the data of the source. When
+ * the source is finished, it continues with the next source in the same
+ * buffer, and remembers the byte position where the next source starts.
+ */
+class KNMusicFFMpegDecoder : public QThread
+{
+    Q_OBJECT
+public:
+    explicit KNMusicFFMpegDecoder(KNMusicFFMpegRingBuffer *buffer,
+                                  QObject *parent = 0);
+    ~KNMusicFFMpegDecoder();
+    KNMusicFFMpegSource *source();
+    void setSource(KNMusicFFMpegSource *source);
+    KNMusicFFMpegSource *nextSource();
+    void setNextSource(KNMusicFFMpegSource *source);
+    bool isSwitched();
+    qint64 switchPosition();
+    void finishSwitch();
+    void cancelSwitch();
+    bool isEnded() const;
+    void startDecoding();
+    void stopDecoding();
+
+protected:
+    void run();
+
+private:
+    KNMusicFFMpegRingBuffer *m_buffer;
+    QMutex m_sourceLock;
+    KNMusicFFMpegSource *m_source=nullptr, *m_nextSource=nullptr;
+    QByteArray m_pending;
+    qint64 m_written=0, m_switchPosition=0;     //Unit: byte
+    bool m_switched=false;
+    QAtomicInt m_running, m_ended;
+};
+
+#endif // KNMUSICFFMPEGDECODER_H
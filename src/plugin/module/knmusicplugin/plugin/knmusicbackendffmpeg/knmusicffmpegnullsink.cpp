@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <QThread>
+
+#include "knmusicffmpegnullsink.h"
+
+//The null sink could be late for a while, e.g. the sleep is longer than it's
+//asked, unit: microsecond.
+#define MaximumLag 100000
+
+KNMusicFFMpegNullSink::KNMusicFFMpegNullSink() :
+    KNMusicFFMpegSink()
+{
+}
+
+bool KNMusicFFMpegNullSink::open(const int &sampleRate, const int &channels)
+{
+    m_writtenBytes=0;
+    m_pacedBytes=0;
+    m_bytesPerSecond=(qint64)sampleRate*channels*sizeof(qint16);
+    m_clock.start();
+    return true;
+}
+
+void KNMusicFFMpegNullSink::close()
+{
+    ;
+}
+
+bool KNMusicFFMpegNullSink::write(const char *data, const int &size)
+{
+    Q_UNUSED(data)
+    m_writtenBytes+=size;
+    if(m_bytesPerSecond==0)
+    {
+        return true;
+    }
+    //Wait until the data should have been played. When the output is paused or
+    //waiting for the decoder, the clock is restarted instead of catching up.
+    qint64 passedTime=m_clock.nsecsElapsed()/1000;
+    if(passedTime-m_pacedBytes*1000000/m_bytesPerSecond>MaximumLag)
+    {
+        m_clock.restart();
+        m_pacedBytes=0;
+        passedTime=0;
+    }
+    m_pacedBytes+=size;
+    qint64 playedTime=m_pacedBytes*1000000/m_bytesPerSecond;
+    if(playedTime>passedTime)
+    {
+        QThread::usleep(playedTime-passedTime);
+    }
+    return true;
+}
+
+void KNMusicFFMpegNullSink::drop()
+{
+    m_clock.restart();
+    m_pacedBytes=0;
+}
+
+qint64 KNMusicFFMpegNullSink::writtenBytes() const
+{
+    return m_writtenBytes;
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICFFMPEGNULLSINK_H
+#define KNMUSICFFMPEGNULLSINK_H
+
+#include <QElapsedTimer>
+
+#include "knmusicffmpegsink.h"
+
+/*
+ * The null sink drops the data, but it accepts the data at the speed of playing,
+ * so the position and the next song work as the same as a sound card. It's
+ * used when there's no sound card, and to measure the seeking latency.
+ */
+class KNMusicFFMpegNullSink : public KNMusicFFMpegSink
+{
+public:
+    KNMusicFFMpegNullSink();
+    bool open(const int &sampleRate, const int &channels);
+    void close();
+    bool write(const char *data, const int &size);
+    void drop();
+    qint64 writtenBytes() const;
+
+private:
+    QElapsedTimer m_clock;
+    //The data written since the clock is started, unit: byte.
+    qint64 m_writtenBytes=0, m_pacedBytes=0, m_bytesPerSecond=0;
+};
+
+#endif // KNMUSICFFMPEGNULLSINK_H
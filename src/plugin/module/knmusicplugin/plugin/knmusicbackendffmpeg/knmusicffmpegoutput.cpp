@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "knmusicffmpegsink.h"
+#include "knmusicffmpegdecoder.h"
+#include "knmusicffmpegringbuffer.h"
+#include "knmusicspectrumanalyser.h"
+#include "knmusicequalizer.h"
+
+#include "knmusicffmpegoutput.h"
+
+KNMusicFFMpegOutput::KNMusicFFMpegOutput(KNMusicFFMpegRingBuffer *buffer,
+                                         KNMusicFFMpegDecoder *decoder,
+                                         QObject *parent) :
+    QThread(parent),
+    m_buffer(buffer),
+    m_decoder(decoder),
+    m_running(0),
+    m_drained(0),
+    m_switchReported(0),
+    m_volume(100)
+{
+}
+
+KNMusicFFMpegOutput::~KNMusicFFMpegOutput()
+{
+    stopOutput();
+}
+
+void KNMusicFFMpegOutput::setSink(KNMusicFFMpegSink *sink)
+{
+    m_sink=sink;
+}
+
+void KNMusicFFMpegOutput::setVolume(const int &volume)
+{
+    m_volume.storeRelease(volume);
+}
+
+void KNMusicFFMpegOutput::setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser)
+{
+    //Wait for the writing of the previous analyser.
+    QMutexLocker locker(&m_dspLock);
+    m_spectrumAnalyser=analyser;
+}
+
+void KNMusicFFMpegOutput::setEqualizer(KNMusicEqualizer *equalizer)
+{
+    QMutexLocker locker(&m_dspLock);
+    m_equalizer=equalizer;
+}
+
+qint64 KNMusicFFMpegOutput::playedBytes()
+{
+    QMutexLocker locker(&m_counterLock);
+    return m_written>m_latency?m_written-m_latency:0;
+}
+
+bool KNMusicFFMpegOutput::isDrained() const
+{
+    return m_drained.loadAcquire();
+}
+
+void KNMusicFFMpegOutput::resetSwitchReport()
+{
+    m_switchReported.storeRelease(0);
+}
+
+void KNMusicFFMpegOutput::startOutput(const int &sampleRate,
+                                      const int &channels)
+{
+    //Reset the states.
+    m_sampleRate=sampleRate;
+    m_channels=channels;
+    m_bytesPerSecond=sampleRate*channels*2;
+    m_written=0;
+    m_latency=0;
+    m_drained.storeRelease(0);
+    m_switchReported.storeRelease(0);
+    m_running.storeRelease(1);
+    start();
+}
+
+void KNMusicFFMpegOutput::stopOutput()
+{
+    m_running.storeRelease(0);
+    wait();
+}
+
+void KNMusicFFMpegOutput::run()
+{
+    //Write 20ms each time, aligned to the frame of stereo 16-bit data.
+    QByteArray chunk((m_bytesPerSecond/50)&~3, 0);
+    while(m_running.loadAcquire())
+    {
+        int size=m_buffer->read(chunk.data(), chunk.size());
+        if(size==0)
+        {
+            //Check whether the decoder finished.
+            if(m_decoder->isEnded() && m_buffer->readAvailable()==0)
+            {
+                m_sink->drain();
+                //The next source may be shorter than the latency.
+                if(!m_switchReported.loadAcquire() && m_decoder->isSwitched())
+                {
+                    m_switchReported.storeRelease(1);
+                    emit switchReached();
+                }
+                m_drained.storeRelease(1);
+                return;
+            }
+            //Wait for the decoder.
+            msleep(2);
+            continue;
+        }
+        //The samples are equalized, and the analyser gets them before the
+        //volume is applied.
+        qint64 latency=m_sink->latency();
+        m_dspLock.lock();
+        if(m_equalizer!=nullptr)
+        {
+            m_equalizer->process((qint16 *)chunk.data(),
+                                 size/(m_channels<<1),
+                                 m_channels,
+                                 m_sampleRate);
+        }
+        if(m_spectrumAnalyser!=nullptr)
+        {
+            m_spectrumAnalyser->setLatency(latency/1000);
+            m_spectrumAnalyser->writeSamples((const qint16 *)chunk.constData(),
+                                             size/(m_channels<<1),
+                                             m_channels,
+                                             m_sampleRate);
+        }
+        m_dspLock.unlock();
+        applyVolume(chunk.data(), size);
+        m_sink->write(chunk.constData(), size);
+        //Update the counter.
+        qint64 latencyBytes=latency*m_bytesPerSecond/1000000;
+        m_counterLock.lock();
+        m_written+=size;
+        m_latency=latencyBytes;
+        m_counterLock.unlock();
+        //Check whether the next source is heard.
+        if(!m_switchReported.loadAcquire() && m_decoder->isSwitched() &&
+                playedBytes()>=m_decoder->switchPosition())
+        {
+            m_switchReported.storeRelease(1);
+            emit switchReached();
+        }
+    }
+}
+
+inline void KNMusicFFMpegOutput::applyVolume(char *data, const int &size)
+{
+    int volume=m_volume.loadAcquire();
+    if(volume>=100)
+    {
+        return;
+    }
+    qint16 *samples=(qint16 *)data;
+    for(int i=size>>1; i>0; --i, ++samples)
+    {
+        *samples=(qint16)((int)(*samples)*volume/100);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICFFMPEGOUTPUT_H
+#define KNMUSICFFMPEGOUTPUT_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThread>
+
+class KNMusicSpectrumAnalyser;
+class KNMusicEqualizer;
+class KNMusicFFMpegSink;
+class KNMusicFFMpegDecoder;
+class KNMusicFFMpegRingBuffer;
+/*
+ * The output thread moves the data from the ring buffer to the sink. It counts
+ * the bytes which is played, the position is calculated from it.
+ */
+class KNMusicFFMpegOutput : public QThread
+{
+    Q_OBJECT
+public:
+    explicit KNMusicFFMpegOutput(KNMusicFFMpegRingBuffer *buffer,
+                                 KNMusicFFMpegDecoder *decoder,
+                                 QObject *parent = 0);
+    ~KNMusicFFMpegOutput();
+    void setSink(KNMusicFFMpegSink *sink);
+    void setVolume(const int &volume);
+    void setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser);
+    void setEqualizer(KNMusicEqualizer *equalizer);
+    qint64 playedBytes();
+    bool isDrained() const;
+    void resetSwitchReport();
+    void startOutput(const int &sampleRate, const int &channels);
+    void stopOutput();
+
+signals:
+    void switchReached();
+
+protected:
+    void run();
+
+private:
+    inline void applyVolume(char *data, const int &size);
+    KNMusicFFMpegRingBuffer *m_buffer;
+    KNMusicFFMpegDecoder *m_decoder;
+    KNMusicFFMpegSink *m_sink=nullptr;
+    //The DSP lock protects the analyser and the equalizer.
+    QMutex m_counterLock, m_dspLock;
+    KNMusicSpectrumAnalyser *m_spectrumAnalyser=nullptr;
+    KNMusicEqualizer *m_equalizer=nullptr;
+    qint64 m_written=0, m_latency=0;    //Unit: byte
+    int m_bytesPerSecond=0, m_sampleRate=0, m_channels=0;
+    QAtomicInt m_running, m_drained, m_switchReported, m_volume;
+};
+
+#endif // KNMUSICFFMPEGOUTPUT_H
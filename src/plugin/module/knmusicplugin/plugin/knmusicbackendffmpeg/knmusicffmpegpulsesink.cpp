@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include "knmusicffmpegpulsesink.h"
+
+KNMusicFFMpegPulseSink::KNMusicFFMpegPulseSink() :
+    KNMusicFFMpegSink()
+{
+}
+
+KNMusicFFMpegPulseSink::~KNMusicFFMpegPulseSink()
+{
+    close();
+}
+
+bool KNMusicFFMpegPulseSink::open(const int &sampleRate, const int &channels)
+{
+    close();
+    //Generate the sample spec.
+    pa_sample_spec sampleSpec;
+    sampleSpec.format=PA_SAMPLE_S16LE;
+    sampleSpec.rate=sampleRate;
+    sampleSpec.channels=channels;
+    //Connect to the server.
+    int error;
+    m_stream=pa_simple_new(NULL,
+                           "Mu",
+                           PA_STREAM_PLAYBACK,
+                           NULL,
+                           "Music",
+                           &sampleSpec,
+                           NULL,
+                           NULL,
+                           &error);
+    return m_stream!=nullptr;
+}
+
+void KNMusicFFMpegPulseSink::close()
+{
+    if(m_stream!=nullptr)
+    {
+        pa_simple_free(m_stream);
+        m_stream=nullptr;
+    }
+}
+
+bool KNMusicFFMpegPulseSink::write(const char *data, const int &size)
+{
+    int error;
+    return m_stream!=nullptr &&
+            pa_simple_write(m_stream, data, size, &error)==0;
+}
+
+void KNMusicFFMpegPulseSink::drop()
+{
+    if(m_stream!=nullptr)
+    {
+        int error;
+        pa_simple_flush(m_stream, &error);
+    }
+}
+
+void KNMusicFFMpegPulseSink::drain()
+{
+    if(m_stream!=nullptr)
+    {
+        int error;
+        pa_simple_drain(m_stream, &error);
+    }
+}
+
+qint64 KNMusicFFMpegPulseSink::latency()
+{
+    if(m_stream==nullptr)
+    {
+        return 0;
+    }
+    int error;
+    pa_usec_t streamLatency=pa_simple_get_latency(m_stream, &error);
+    return streamLatency==(pa_usec_t)-1?0:streamLatency;
+}
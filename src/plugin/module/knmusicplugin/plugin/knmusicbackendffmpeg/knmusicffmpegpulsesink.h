@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICFFMPEGPULSESINK_H
+#define KNMUSICFFMPEGPULSESINK_H
+
+#include <pulse/simple.h>
+
+#include "knmusicffmpegsink.h"
+
+class KNMusicFFMpegPulseSink : public KNMusicFFMpegSink
+{
+public:
+    KNMusicFFMpegPulseSink();
+    ~KNMusicFFMpegPulseSink();
+    bool open(const int &sampleRate, const int &channels);
+    void close();
+    bool write(const char *data, const int &size);
+    void drop();
+    void drain();
+    qint64 latency();
+
+private:
+    pa_simple *m_stream=nullptr;
+};
+
+#endif // KNMUSICFFMPEGPULSESINK_H
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <cstring>
+
+#include "knmusicffmpegringbuffer.h"
+
+KNMusicFFMpegRingBuffer::KNMusicFFMpegRingBuffer(const int &capacity) :
+    m_data(new char[capacity]),
+    m_capacity(capacity),
+    m_readPosition(0),
+    m_writePosition(0)
+{
+}
+
+KNMusicFFMpegRingBuffer::~KNMusicFFMpegRingBuffer()
+{
+    delete[] m_data;
+}
+
+int KNMusicFFMpegRingBuffer::capacity() const
+{
+    return m_capacity;
+}
+
+int KNMusicFFMpegRingBuffer::readAvailable() const
+{
+    return usedSize(m_readPosition.loadAcquire(),
+                    m_writePosition.loadAcquire());
+}
+
+int KNMusicFFMpegRingBuffer::writeAvailable() const
+{
+    return m_capacity-readAvailable();
+}
+
+int KNMusicFFMpegRingBuffer::write(const char *data, int size)
+{
+    //Only the writer changes the write position.
+    int writePosition=m_writePosition.load(),
+        freeSize=m_capacity-usedSize(m_readPosition.loadAcquire(),
+                                     writePosition);
+    if(size>freeSize)
+    {
+        size=freeSize;
+    }
+    if(size<=0)
+    {
+        return 0;
+    }
+    //Copy the data, it might be splitted into two parts.
+    int offset=writePosition%m_capacity,
+        firstPart=qMin(size, m_capacity-offset);
+    memcpy(m_data+offset, data, firstPart);
+    memcpy(m_data, data+firstPart, size-firstPart);
+    //Publish the data to the reader.
+    m_writePosition.storeRelease((writePosition+size)%(m_capacity<<1));
+    return size;
+}
+
+int KNMusicFFMpegRingBuffer::read(char *data, int size)
+{
+    //Only the reader changes the read position.
+    int readPosition=m_readPosition.load(),
+        availableSize=usedSize(readPosition,
+                               m_writePosition.loadAcquire());
+    if(size>availableSize)
+    {
+        size=availableSize;
+    }
+    if(size<=0)
+    {
+        return 0;
+    }
+    //Copy the data, it might be splitted into two parts.
+    int offset=readPosition%m_capacity,
+        firstPart=qMin(size, m_capacity-offset);
+    memcpy(data, m_data+offset, firstPart);
+    memcpy(data+firstPart, m_data, size-firstPart);
+    //Give the space back to the writer.
+    m_readPosition.storeRelease((readPosition+size)%(m_capacity<<1));
+    return size;
+}
+
+void KNMusicFFMpegRingBuffer::clear()
+{
+    //This can only be called when neither the reader nor the writer is
+    //working.
+    m_readPosition.storeRelease(0);
+    m_writePosition.storeRelease(0);
+}
+
+inline int KNMusicFFMpegRingBuffer::usedSize(const int &readPosition,
+                                             const int &writePosition) const
+{
+    int doubleCapacity=m_capacity<<1;
+    return (writePosition-readPosition+doubleCapacity)%doubleCapacity;
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICFFMPEGRINGBUFFER_H
+#define KNMUSICFFMPEGRINGBUFFER_H
+
+#include <QAtomicInt>
+
+/*
+ * The ring buffer between the decoder and the output. There's only one thread
+ * writes to it and only one thread reads from it, so the positions are atomic
+ * values instead of a lock. The positions are in range [0, 2*capacity), so a
+ * full buffer and an empty buffer can be told apart.
+ */
+class KNMusicFFMpegRingBuffer
+{
+public:
+    explicit KNMusicFFMpegRingBuffer(const int &capacity=262144);
+    ~KNMusicFFMpegRingBuffer();
+    int capacity() const;
+    int readAvailable() const;
+    int writeAvailable() const;
+    int write(const char *data, int size);
+    int read(char *data, int size);
+    void clear();
+
+private:
+    inline int usedSize(const int &readPosition,
+                        const int &writePosition) const;
+    char *m_data;
+    int m_capacity;
+    QAtomicInt m_readPosition, m_writePosition;
+};
+
+#endif // KNMUSICFFMPEGRINGBUFFER_H
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICFFMPEGSINK_H
+#define KNMUSICFFMPEGSINK_H
+
+#include <QtGlobal>
+
+/*
+ * The sink is where the decoded data goes. The data is always 16-bit signed
+ * interleaved PCM. write() should block until the device accept the data, the
+ * output thread is paced by it.
+ */
+class KNMusicFFMpegSink
+{
+public:
+    KNMusicFFMpegSink(){}
+    virtual ~KNMusicFFMpegSink(){}
+    virtual bool open(const int &sampleRate, const int &channels)=0;
+    virtual void close()=0;
+    virtual bool write(const char *data, const int &size)=0;
+    //Drop all the data which is not played.
+    virtual void drop(){}
+    //Wait until all the data is played.
+    virtual void drain(){}
+    //The data which is written but not played yet, unit: microsecond.
+    virtual qint64 latency(){return 0;}
+};
+
+#endif // KNMUSICFFMPEGSINK_H
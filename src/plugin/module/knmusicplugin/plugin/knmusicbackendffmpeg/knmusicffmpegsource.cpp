@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <cmath>
+#include <cstring>
+
+#include <QDir>
+
+#include "knmusicseekindex.h"
+
+#include "knmusicffmpegsource.h"
+
+//The unit of the gain, it's 1.0.
+#define GainUnit 65536
+
+KNMusicFFMpegSource::KNMusicFFMpegSource() :
+    m_gain(GainUnit)
+{
+    //Initial the global to make sure the FFMpeg has been instanced.
+    KNFFMpegGlobal::instance();
+}
+
+KNMusicFFMpegSource::~KNMusicFFMpegSource()
+{
+    close();
+}
+
+bool KNMusicFFMpegSource::open(const QString &filePath,
+                               const int &sampleRate,
+                               const int &channels,
+                               const AVSampleFormat &sampleFormat)
+{
+    close();
+    //Open the file with ffmpeg.
+    if(avformat_open_input(&m_formatContext,
+                           QDir::toNativeSeparators(filePath).toLocal8Bit().data(),
+                           NULL,
+                           NULL)!=0)
+    {
+        m_formatContext=nullptr;
+        return false;
+    }
+    //Find the audio stream.
+    if(avformat_find_stream_info(m_formatContext, NULL)<0 ||
+            (m_audioStream=av_find_best_stream(m_formatContext,
+                                               AVMEDIA_TYPE_AUDIO,
+                                               -1,
+                                               -1,
+                                               NULL,
+                                               0))<0)
+    {
+        close();
+        return false;
+    }
+    //Open the codec.
+    m_codecContext=m_formatContext->streams[m_audioStream]->codec;
+    AVCodec *codec=avcodec_find_decoder(m_codecContext->codec_id);
+    if(codec==NULL || avcodec_open2(m_codecContext, codec, NULL)<0 ||
+            m_codecContext->sample_rate<=0)
+    {
+        m_codecContext=nullptr;
+        close();
+        return false;
+    }
+    //Decide the output format, use the format of the file if it's not given.
+    //Only mono and stereo is played, the float data for analysis keeps all the
+    //channels of the file in its own layout.
+    m_inputSampleRate=m_codecContext->sample_rate;
+    m_sampleRate=sampleRate==-1?m_inputSampleRate:sampleRate;
+    m_sampleFormat=sampleFormat;
+    int64_t inputLayout=m_codecContext->channel_layout==0?
+                av_get_default_channel_layout(m_codecContext->channels):
+                m_codecContext->channel_layout;
+    if(channels==-1 && m_sampleFormat==AV_SAMPLE_FMT_FLT)
+    {
+        m_channels=m_codecContext->channels;
+        m_channelLayout=inputLayout;
+    }
+    else
+    {
+        m_channels=channels==-1?qMin(m_codecContext->channels, 2):channels;
+        m_channelLayout=av_get_default_channel_layout(m_channels);
+    }
+    m_frameSize=m_channels*av_get_bytes_per_sample(m_sampleFormat);
+    m_resampler=swr_alloc_set_opts(NULL,
+                                   m_channelLayout,
+                                   m_sampleFormat,
+                                   m_sampleRate,
+                                   inputLayout,
+                                   m_codecContext->sample_fmt,
+                                   m_inputSampleRate,
+                                   0,
+                                   NULL);
+    if(m_resampler==NULL || swr_init(m_resampler)<0)
+    {
+        close();
+        return false;
+    }
+    m_frame=av_frame_alloc();
+    //Save the file information.
+    m_filePath=filePath;
+    m_duration=m_formatContext->duration/(AV_TIME_BASE/1000);
+    m_cursor=-1;
+    m_startSample=0;
+    m_endSample=-1;
+    m_ended=false;
+    return true;
+}
+
+void KNMusicFFMpegSource::close()
+{
+    if(m_resampler!=nullptr)
+    {
+        swr_free(&m_resampler);
+    }
+    if(m_frame!=nullptr)
+    {
+        av_frame_free(&m_frame);
+    }
+    if(m_codecContext!=nullptr)
+    {
+        avcodec_close(m_codecContext);
+        m_codecContext=nullptr;
+    }
+    if(m_formatContext!=nullptr)
+    {
+        avformat_close_input(&m_formatContext);
+    }
+    m_audioStream=-1;
+    m_filePath.clear();
+}
+
+QString KNMusicFFMpegSource::filePath() const
+{
+    return m_filePath;
+}
+
+int KNMusicFFMpegSource::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+int KNMusicFFMpegSource::channels() const
+{
+    return m_channels;
+}
+
+qint64 KNMusicFFMpegSource::channelLayout() const
+{
+    return m_channelLayout;
+}
+
+qint64 KNMusicFFMpegSource::duration() const
+{
+    return m_duration;
+}
+
+void KNMusicFFMpegSource::setEnd(const qint64 &endPosition)
+{
+    m_endSample=endPosition==-1?-1:endPosition*m_sampleRate/1000;
+}
+
+bool KNMusicFFMpegSource::seek(const qint64 &position)
+{
+    if(m_formatContext==nullptr)
+    {
+        return false;
+    }
+    //The timestamps of a VBR file without a table of contents are only
+    //estimated. If the file is in the seek index, seek to the frame one
+    //second before the position by its offset, and we know exactly where the
+    //first frame starts.
+    quint32 offset;
+    double pointSecond;
+    if(KNMusicSeekIndex::instance()->findPoint(m_filePath,
+                                               position,
+                                               offset,
+                                               pointSecond) &&
+            av_seek_frame(m_formatContext,
+                          m_audioStream,
+                          offset,
+                          AVSEEK_FLAG_BYTE)>=0)
+    {
+        m_cursor=llround(pointSecond*m_sampleRate);
+    }
+    else
+    {
+        AVStream *stream=m_formatContext->streams[m_audioStream];
+        //Seek to the key frame before the position, the samples before the
+        //position will be dropped when decoding.
+        int64_t timestamp=av_rescale_q(position,
+                                       AVRational{1, 1000},
+                                       stream->time_base);
+        if(stream->start_time!=AV_NOPTS_VALUE)
+        {
+            timestamp+=stream->start_time;
+        }
+        if(av_seek_frame(m_formatContext,
+                         m_audioStream,
+                         timestamp,
+                         AVSEEK_FLAG_BACKWARD)<0)
+        {
+            return false;
+        }
+        m_cursor=-1;
+    }
+    avcodec_flush_buffers(m_codecContext);
+    //Drop the samples left in the resampler.
+    swr_init(m_resampler);
+    m_startSample=position*m_sampleRate/1000;
+    m_ended=false;
+    return true;
+}
+
+void KNMusicFFMpegSource::setGain(const qreal &gain)
+{
+    m_gain.store(qRound(gain*GainUnit));
+}
+
+int KNMusicFFMpegSource::decode(QByteArray &buffer)
+{
+    if(m_formatContext==nullptr)
+    {
+        return 0;
+    }
+    int previousSize=buffer.size();
+    //Decode until there's any data or the source is ended.
+    while(buffer.size()==previousSize && !m_ended)
+    {
+        AVPacket packet;
+        av_init_packet(&packet);
+        packet.data=NULL;
+        packet.size=0;
+        if(av_read_frame(m_formatContext, &packet)<0)
+        {
+            //Reach the end of the file, get the frames left in the decoder and
+            //the resampler.
+            packet.data=NULL;
+            packet.size=0;
+            int gotFrame=1;
+            while(gotFrame &&
+                  avcodec_decode_audio4(m_codecContext,
+                                        m_frame,
+                                        &gotFrame,
+                                        &packet)>=0 &&
+                  gotFrame)
+            {
+                appendFrame(buffer);
+            }
+            if(!m_ended)
+            {
+                appendSamples(buffer, NULL, 0);
+            }
+            m_ended=true;
+            break;
+        }
+        //Ignore the packets of the other streams.
+        if(packet.stream_index==m_audioStream)
+        {
+            AVPacket decodePacket=packet;
+            while(decodePacket.size>0 && !m_ended)
+            {
+                int gotFrame=0,
+                    usedSize=avcodec_decode_audio4(m_codecContext,
+                                                   m_frame,
+                                                   &gotFrame,
+                                                   &decodePacket);
+                //Skip the broken packet.
+                if(usedSize<0 || (usedSize==0 && !gotFrame))
+                {
+                    break;
+                }
+                if(gotFrame)
+                {
+                    appendFrame(buffer);
+                }
+                decodePacket.data+=usedSize;
+                decodePacket.size-=usedSize;
+            }
+        }
+        av_free_packet(&packet);
+    }
+    return buffer.size()-previousSize;
+}
+
+inline void KNMusicFFMpegSource::appendFrame(QByteArray &buffer)
+{
+    //The first frame after seeking tells us where we are.
+    if(m_cursor==-1)
+    {
+        int64_t timestamp=av_frame_get_best_effort_timestamp(m_frame);
+        if(timestamp==AV_NOPTS_VALUE)
+        {
+            m_cursor=m_startSample;
+        }
+        else
+        {
+            AVStream *stream=m_formatContext->streams[m_audioStream];
+            if(stream->start_time!=AV_NOPTS_VALUE)
+            {
+                timestamp-=stream->start_time;
+            }
+            m_cursor=av_rescale_q(timestamp,
+                                  stream->time_base,
+                                  AVRational{1, m_sampleRate});
+        }
+    }
+    appendSamples(buffer,
+                  (const uint8_t **)m_frame->extended_data,
+                  m_frame->nb_samples);
+}
+
+inline void KNMusicFFMpegSource::appendSamples(QByteArray &buffer,
+                                               const uint8_t **data,
+                                               const int &sampleCount)
+{
+    int maximumSamples=av_rescale_rnd(swr_get_delay(m_resampler,
+                                                    m_inputSampleRate)+
+                                      sampleCount,
+                                      m_sampleRate,
+                                      m_inputSampleRate,
+                                      AV_ROUND_UP);
+    if(maximumSamples<=0)
+    {
+        return;
+    }
+    if(m_cursor==-1)
+    {
+        m_cursor=m_startSample;
+    }
+    //Convert the samples right into the buffer.
+    int frameSize=m_frameSize, previousSize=buffer.size();
+    buffer.resize(previousSize+maximumSamples*frameSize);
+    uint8_t *output=(uint8_t *)buffer.data()+previousSize;
+    int samples=swr_convert(m_resampler,
+                            &output,
+                            maximumSamples,
+                            data,
+                            sampleCount);
+    if(samples<0)
+    {
+        samples=0;
+    }
+    //Only keep the samples between the start and the end.
+    qint64 firstSample=m_cursor, lastSample=m_cursor+samples,
+           keepFrom=qMax(firstSample, m_startSample),
+           keepTo=lastSample;
+    m_cursor=lastSample;
+    if(m_endSample!=-1 && lastSample>=m_endSample)
+    {
+        keepTo=m_endSample;
+        m_ended=true;
+    }
+    if(keepTo<=keepFrom)
+    {
+        buffer.resize(previousSize);
+        return;
+    }
+    if(keepFrom>firstSample)
+    {
+        memmove(output,
+                output+(keepFrom-firstSample)*frameSize,
+                (keepTo-keepFrom)*frameSize);
+    }
+    buffer.resize(previousSize+(keepTo-keepFrom)*frameSize);
+    //Apply the gain to the samples.
+    qint64 gain=m_gain.load();
+    if(gain!=GainUnit)
+    {
+        if(m_sampleFormat==AV_SAMPLE_FMT_FLT)
+        {
+            //The float samples are not clipped.
+            float *samples=(float *)(buffer.data()+previousSize),
+                  floatGain=(float)gain/GainUnit;
+            for(qint64 i=0, count=(keepTo-keepFrom)*m_channels; i<count; i++)
+            {
+                samples[i]*=floatGain;
+            }
+            return;
+        }
+        qint16 *samples=(qint16 *)(buffer.data()+previousSize);
+        for(qint64 i=0, count=(keepTo-keepFrom)*m_channels; i<count; i++)
+        {
+            samples[i]=qBound((qint64)-32768,
+                              (samples[i]*gain)/GainUnit,
+                              (qint64)32767);
+        }
+    }
+}
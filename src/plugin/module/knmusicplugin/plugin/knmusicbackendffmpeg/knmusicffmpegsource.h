@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICFFMPEGSOURCE_H
+#define KNMUSICFFMPEGSOURCE_H
+
+extern "C"
+{
+#include <libswresample/swresample.h>
+}
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+
+#include "knffmpegglobal.h"
+
+/*
+ * A source is an opened music file. It decodes the file and converts the data
+ * to interleaved PCM in the output format, 16-bit signed for playing, or
+ * 32-bit float for analysis. The start and the end of a section are cut at the
+ * exact sample.
+ */
+class KNMusicFFMpegSource
+{
+public:
+    KNMusicFFMpegSource();
+    ~KNMusicFFMpegSource();
+    bool open(const QString &filePath,
+              const int &sampleRate=-1,
+              const int &channels=-1,
+              const AVSampleFormat &sampleFormat=AV_SAMPLE_FMT_S16);
+    void close();
+    QString filePath() const;
+    int sampleRate() const;
+    int channels() const;
+    qint64 channelLayout() const;
+    qint64 duration() const;
+    void setEnd(const qint64 &endPosition);
+    bool seek(const qint64 &position);
+    void setGain(const qreal &gain);
+    int decode(QByteArray &buffer);
+
+private:
+    inline void appendFrame(QByteArray &buffer);
+    inline void appendSamples(QByteArray &buffer,
+                              const uint8_t **data,
+                              const int &sampleCount);
+    QString m_filePath;
+    AVFormatContext *m_formatContext=nullptr;
+    AVCodecContext *m_codecContext=nullptr;
+    SwrContext *m_resampler=nullptr;
+    AVFrame *m_frame=nullptr;
+    AVSampleFormat m_sampleFormat=AV_SAMPLE_FMT_S16;
+    int m_audioStream=-1, m_inputSampleRate=0, m_sampleRate=0, m_channels=0,
+        m_frameSize=0;
+    int64_t m_channelLayout=0;
+    qint64 m_duration=0;            //Unit: millisecond
+    //Unit: sample of the output format.
+    qint64 m_cursor=-1, m_startSample=0, m_endSample=-1;
+    bool m_ended=false;
+    //The gain of the samples, 65536 is 1.0. It may be changed when the source
+    //is decoding.
+    QAtomicInt m_gain;
+};
+
+#endif // KNMUSICFFMPEGSOURCE_H
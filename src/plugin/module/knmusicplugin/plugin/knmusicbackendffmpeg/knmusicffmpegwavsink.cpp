@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <cstring>
+
+#include <QtEndian>
+
+#include "knmusicffmpegwavsink.h"
+
+KNMusicFFMpegWavSink::KNMusicFFMpegWavSink(const QString &filePath) :
+    KNMusicFFMpegSink(),
+    m_file(filePath)
+{
+}
+
+KNMusicFFMpegWavSink::~KNMusicFFMpegWavSink()
+{
+    close();
+}
+
+bool KNMusicFFMpegWavSink::open(const int &sampleRate, const int &channels)
+{
+    //Close the previous file, the new format starts a new file.
+    close();
+    if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+    m_sampleRate=sampleRate;
+    m_channels=channels;
+    m_dataSize=0;
+    //Write a header with no data, it will be updated when closing.
+    writeHeader(0);
+    return true;
+}
+
+void KNMusicFFMpegWavSink::close()
+{
+    if(m_file.isOpen())
+    {
+        //Update the size in the header.
+        m_file.seek(0);
+        writeHeader(m_dataSize);
+        m_file.close();
+    }
+}
+
+bool KNMusicFFMpegWavSink::write(const char *data, const int &size)
+{
+    if(m_file.write(data, size)!=size)
+    {
+        return false;
+    }
+    m_dataSize+=size;
+    return true;
+}
+
+inline void KNMusicFFMpegWavSink::writeHeader(const quint32 &dataSize)
+{
+    char header[44];
+    int blockAlign=m_channels*2;
+    //RIFF chunk.
+    memcpy(header, "RIFF", 4);
+    qToLittleEndian<quint32>(36+dataSize, (uchar *)header+4);
+    memcpy(header+8, "WAVE", 4);
+    //Format chunk, 16-bit PCM.
+    memcpy(header+12, "fmt ", 4);
+    qToLittleEndian<quint32>(16, (uchar *)header+16);
+    qToLittleEndian<quint16>(1, (uchar *)header+20);
+    qToLittleEndian<quint16>(m_channels, (uchar *)header+22);
+    qToLittleEndian<quint32>(m_sampleRate, (uchar *)header+24);
+    qToLittleEndian<quint32>(m_sampleRate*blockAlign, (uchar *)header+28);
+    qToLittleEndian<quint16>(blockAlign, (uchar *)header+32);
+    qToLittleEndian<quint16>(16, (uchar *)header+34);
+    //Data chunk.
+    memcpy(header+36, "data", 4);
+    qToLittleEndian<quint32>(dataSize, (uchar *)header+40);
+    m_file.write(header, 44);
+}
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICFFMPEGWAVSINK_H
+#define KNMUSICFFMPEGWAVSINK_H
+
+#include <QFile>
+
+#include "knmusicffmpegsink.h"
+
+/*
+ * The wav sink writes all the data to a wave file, the data can be compared
+ * with the original file to check the seeking and the gapless playing.
+ */
+class KNMusicFFMpegWavSink : public KNMusicFFMpegSink
+{
+public:
+    explicit KNMusicFFMpegWavSink(const QString &filePath);
+    ~KNMusicFFMpegWavSink();
+    bool open(const int &sampleRate, const int &channels);
+    void close();
+    bool write(const char *data, const int &size);
+
+private:
+    inline void writeHeader(const quint32 &dataSize);
+    QFile m_file;
+    int m_sampleRate=0, m_channels=0;
+    quint32 m_dataSize=0;
+};
+
+#endif // KNMUSICFFMPEGWAVSINK_H
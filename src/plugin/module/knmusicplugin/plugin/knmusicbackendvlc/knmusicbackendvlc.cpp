@@ -66,6 +66,12 @@ int KNMusicBackendVLC::volumeMaximum()
     return 100;
 }
 
+KNMusicAudioDecoder *KNMusicBackendVLC::createAudioDecoder()
+{
+    //libvlc only plays the media, it can't give out the decoded data.
+    return nullptr;
+}
+
 void KNMusicBackendVLC::changeVolume(const int &volumeSize)
 {
     m_main->setVolume(volumeSize);
@@ -37,6 +37,8 @@ public:
     int volumeMinimal();
     int volumeMaximum();
 
+    KNMusicAudioDecoder *createAudioDecoder();
+
 signals:
 
 public slots:
@@ -200,10 +200,67 @@ void KNMusicBackendVLCThread::playSection(const qint64 &sectionStart,
     play();
 }
 
+void KNMusicBackendVLCThread::prepareNextSection(const QString &filePath,
+                                                 const qint64 &sectionStart,
+                                                 const qint64 &sectionDuration)
+{
+    //The media player of libvlc can't switch to another media without a gap,
+    //the next section will be loaded when the current one finished.
+    Q_UNUSED(filePath)
+    Q_UNUSED(sectionStart)
+    Q_UNUSED(sectionDuration)
+}
+
+void KNMusicBackendVLCThread::clearNextSection()
+{
+    ;
+}
+
+void KNMusicBackendVLCThread::setPositionUpdateInterval(const int &interval)
+{
+    //The position changed event is sent by libvlc, we can only stop sending
+    //the position when no one is watching.
+    m_positionUpdateInterval=interval;
+}
+
+void KNMusicBackendVLCThread::setGain(const qreal &gain)
+{
+    //libvlc only has the volume of the player, which is the volume the user
+    //sets.
+    Q_UNUSED(gain)
+}
+
+void KNMusicBackendVLCThread::setNextSectionGain(const qreal &gain)
+{
+    Q_UNUSED(gain)
+}
+
+void KNMusicBackendVLCThread::setNextSectionCrossfade(const int &mode,
+                                                      const int &duration)
+{
+    //The next section is not prepared, there's nothing to fade.
+    Q_UNUSED(mode)
+    Q_UNUSED(duration)
+}
+
+void KNMusicBackendVLCThread::setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser)
+{
+    //The samples are not available without the audio callbacks of libvlc.
+    Q_UNUSED(analyser)
+}
+
+void KNMusicBackendVLCThread::setEqualizer(KNMusicEqualizer *equalizer)
+{
+    Q_UNUSED(equalizer)
+}
+
 void KNMusicBackendVLCThread::positionCheck()
 {
     qint64 currentPosition=position();
-    emit positionChanged(currentPosition);
+    if(m_positionUpdateInterval>0)
+    {
+        emit positionChanged(currentPosition);
+    }
     /*
      * - Q: Why we still need to do this?
      * - A: When cue is playing, it may not stopped at the end of the file.
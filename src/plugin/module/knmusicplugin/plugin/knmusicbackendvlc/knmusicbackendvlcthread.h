@@ -52,6 +52,16 @@ public:
                         const qint64 &sectionDuration=-1);
     void playSection(const qint64 &sectionStart=-1,
                      const qint64 &sectionDuration=-1);
+    void prepareNextSection(const QString &filePath,
+                            const qint64 &sectionStart=-1,
+                            const qint64 &sectionDuration=-1);
+    void clearNextSection();
+    void setPositionUpdateInterval(const int &interval);
+    void setGain(const qreal &gain);
+    void setNextSectionGain(const qreal &gain);
+    void setNextSectionCrossfade(const int &mode, const int &duration);
+    void setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser);
+    void setEqualizer(KNMusicEqualizer *equalizer);
 
     void positionCheck();
 
@@ -74,6 +84,7 @@ private:
     libvlc_media_player_t *m_player=nullptr;
     libvlc_media_t *m_media=nullptr;
     int m_playingState=StoppedState;
+    int m_positionUpdateInterval=1;
 
     qint64 m_startPosition;   //Unit: millisecond
     qint64 m_endPosition;     //Unit: millisecond
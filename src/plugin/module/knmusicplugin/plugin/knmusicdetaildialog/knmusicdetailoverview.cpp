@@ -23,6 +23,7 @@
 #include "knfilepathlabel.h"
 #include "knmusicglobal.h"
 #include "knmusicparser.h"
+#include "knmusicmodelassist.h"
 
 #include "knmusicdetailoverview.h"
 
@@ -126,11 +127,14 @@ void KNMusicDetailOverview::setFilePath(const QString &filePath)
     m_detailInfo[DetailYear]->setText(currentInfo.textLists[Year]);
     m_detailInfo[DetailGenre]->setText(currentInfo.textLists[Genre]);
     m_detailInfo[DetailKind]->setText(currentInfo.textLists[Kind]);
-    m_detailInfo[DetailSize]->setText(currentInfo.textLists[Size]);
-    m_detailInfo[DetailBitRate]->setText(currentInfo.textLists[BitRate]);
-    m_detailInfo[DetailSampleRate]->setText(currentInfo.textLists[SampleRate]);
+    m_detailInfo[DetailSize]->setText(
+                KNMusicModelAssist::derivedText(Size, currentInfo.size));
+    m_detailInfo[DetailBitRate]->setText(
+                KNMusicParser::bitRateText(currentInfo.bitRate));
+    m_detailInfo[DetailSampleRate]->setText(
+                KNMusicParser::sampleRateText(currentInfo.samplingRate));
     m_detailInfo[DetailDateModified]->setText(
-                currentInfo.textLists[DateModified]);
+                KNMusicModelAssist::dateTimeToString(currentInfo.dateModified));
     m_filePathDataField->setText(currentInfo.filePath);
     m_filePathDataField->setFilePath(currentInfo.filePath);
 }
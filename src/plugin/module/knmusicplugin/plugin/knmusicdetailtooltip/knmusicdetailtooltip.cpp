@@ -178,7 +178,8 @@ void KNMusicDetailTooltip::setPreviewIndex(KNMusicModel *musicModel,
         setEliedText(m_labels[ItemTitle], detailInfo.textLists[Name]);
         setEliedText(m_fileName, tr("In file: %1").arg(detailInfo.fileName));
         m_fileName->setFilePath(detailInfo.filePath);
-        setEliedText(m_labels[ItemTime], detailInfo.textLists[Time]);
+        setEliedText(m_labels[ItemTime],
+                     KNMusicGlobal::msecondToString(detailInfo.duration));
         setEliedText(m_labels[ItemArtist], detailInfo.textLists[Artist]);
     }
     //Set the position.
@@ -36,7 +36,17 @@ KNMusicHeaderLyrics::KNMusicHeaderLyrics(QWidget *parent) :
     m_musicGlobal=KNMusicGlobal::instance();
     //Initial the lyrics manager.
     m_lyricsManager=KNMusicLyricsManager::instance();
+    //Keep a copy of the settings, the manager uses them in the lyrics thread,
+    //they are only changed through the queued signals.
+    m_lyricsFolderPath=m_lyricsManager->lyricsFolderPath();
+    m_downloadLyrics=m_lyricsManager->downloadLyrics();
     m_lyricsManager->moveToThread(m_musicGlobal->lyricsThread());
+    connect(m_lyricsManager, &KNMusicLyricsManager::lyricsLoaded,
+            this, &KNMusicHeaderLyrics::onActionLyricsLoaded);
+    connect(this, &KNMusicHeaderLyrics::requireSetLyricsFolderPath,
+            m_lyricsManager, &KNMusicLyricsManager::setLyricsFolderPath);
+    connect(this, &KNMusicHeaderLyrics::requireSetDownloadLyrics,
+            m_lyricsManager, &KNMusicLyricsManager::setDownloadLyrics);
     //Link the library changed request.
     connect(m_musicGlobal, &KNMusicGlobal::musicLibraryMoved,
             this, &KNMusicHeaderLyrics::onActionMusicLibraryMoved);
@@ -64,17 +74,15 @@ KNMusicHeaderLyrics::KNMusicHeaderLyrics(QWidget *parent) :
     retranslate();
 }
 
-KNMusicHeaderLyrics::~KNMusicHeaderLyrics()
-{
-    delete m_lyricsManager;
-}
-
 void KNMusicHeaderLyrics::setHeaderPlayer(KNMusicHeaderPlayerBase *player)
 {
     connect(player, &KNMusicHeaderPlayerBase::playerReset,
             this, &KNMusicHeaderLyrics::resetStatus);
     connect(player, &KNMusicHeaderPlayerBase::requireLoadLyrics,
             this, &KNMusicHeaderLyrics::loadLyricsForMusic);
+    //The lyrics of the next song is prefetched in the lyrics thread.
+    connect(player, &KNMusicHeaderPlayerBase::requirePrefetchLyrics,
+            m_lyricsManager, &KNMusicLyricsManager::prefetchLyrics);
     connect(player, &KNMusicHeaderPlayerBase::positionChanged,
             this, &KNMusicHeaderLyrics::onActionPositionChange);
 }
@@ -95,8 +103,11 @@ void KNMusicHeaderLyrics::resetStatus()
     m_lyricsLines=0;
     //Reset lines.
     m_currentLyricsLine=-1;
-    //Clear lyrics manager.
-    m_lyricsManager->clear();
+    //Clear the lyrics, and stop loading the lyrics.
+    m_lyrics=KNMusicLyricsData();
+    updateLineLayouts();
+    updateWordPositions();
+    m_lyricsManager->cancelLyrics();
     //Update the viewport.
     update();
 }
@@ -105,80 +116,84 @@ void KNMusicHeaderLyrics::loadLyricsForMusic(const KNMusicDetailInfo &detailInfo
 {
     //Reset the lyrics viewer.
     resetStatus();
-    //Clear the current lyrics.
-    m_lyricsManager->clear();
-    //Update the widget first.
-    update();
-    //Load the lyrics.
-    if(m_lyricsManager->loadLyricsForFile(detailInfo))
+    //Ask the manager to load the lyrics in the lyrics thread, the lyrics will
+    //be displayed when it's loaded.
+    m_lyricsJob=m_lyricsManager->requestLyrics(detailInfo);
+}
+
+void KNMusicHeaderLyrics::onActionLyricsLoaded(int jobId,
+                                               KNMusicLyricsData lyrics)
+{
+    //Ignore the lyrics of the previous music.
+    if(jobId!=m_lyricsJob || lyrics.isEmpty())
     {
-        //Update parameters.
-        //Get the lyrics lines.
-        m_lyricsLines=m_lyricsManager->lines();
-        //Check is there lyrics.
-        if(!m_lyricsManager->isEmpty())
-        {
-            //Initial the current line to the first line.
-            m_currentLyricsLine=0;
-            //Move the first line to center.
-            onActionLyricsMoved(0);
-        }
-        //Update the viewer.
-        update();
+        return;
     }
+    //Save the lyrics.
+    m_lyrics=lyrics;
+    m_lyricsLines=m_lyrics.lines();
+    //Layout all the lines.
+    updateLineLayouts();
+    //Initial the current line to the first line.
+    m_currentLyricsLine=0;
+    updateWordPositions();
+    //Move the first line to center.
+    onActionLyricsMoved(0);
 }
 
 void KNMusicHeaderLyrics::onActionPositionChange(const qint64 &position)
 {
     //If no lyrics, do nothing.
-    if(m_lyricsManager->isEmpty())
+    if(m_lyrics.isEmpty())
     {
         return;
     }
-    //If there's lines but current line is -1, or we reach the very end,
-    //Find from very beginning.
-    if(m_currentLyricsLine<0 || m_currentLyricsLine>=m_lyricsLines)
+    //Find the line of the position, show the first line before the lyrics
+    //starts.
+    int currentLine=qMax(m_lyrics.lineAt(position), 0);
+    if(currentLine==m_currentLyricsLine)
     {
-        //Find current line from the beginning.
-        m_currentLyricsLine=0;
-        while(m_currentLyricsLine<m_lyricsLines &&
-              position<m_lyricsManager->positionAt(m_currentLyricsLine))
+        //Update the highlight part of the words, only repaint the changed
+        //part of the current line.
+        int highlightX=highlightPosition(position);
+        if(highlightX!=m_highlightX)
         {
-            m_currentLyricsLine++;
+            int lineTop=(height()>>1)+m_currentLineOffsetY-
+                    lineCenter(m_currentLyricsLine)+
+                    m_lineTops.at(m_currentLyricsLine);
+            update(m_leftSpacing+qMin(highlightX, m_highlightX),
+                   lineTop,
+                   qAbs(highlightX-m_highlightX)+1,
+                   m_lineTops.at(m_currentLyricsLine+1)-
+                   m_lineTops.at(m_currentLyricsLine));
+            m_highlightX=highlightX;
         }
-        update();
         return;
     }
-    int yOffset=0;
-    //Check the position is previous than the current yet.
-    if(position<m_lyricsManager->positionAt(m_currentLyricsLine) &&
-            m_currentLyricsLine!=0)
+    //If there's no current line, jump to the line.
+    if(m_currentLyricsLine<0 || m_currentLyricsLine>=m_lyricsLines)
     {
-        //Find the matching lyrics.
-        while(m_currentLyricsLine>-1 &&
-              m_lyricsManager->positionAt(m_currentLyricsLine)>position)
-        {
-            yOffset-=lyricsSize(m_lyricsManager->lyricsAt(m_currentLyricsLine)).height();
-            m_currentLyricsLine--;
-        }
+        m_currentLyricsLine=currentLine;
+        updateWordPositions();
+        m_highlightX=highlightPosition(position);
         update();
-        //Start animation.
-        startMovingAnime((lyricsLineDuration(m_currentLyricsLine)>>2),
-                         yOffset);
         return;
     }
-    //Find the next specific position.
-    while(m_currentLyricsLine<m_lyricsLines-2 &&
-          m_lyricsManager->positionAt(m_currentLyricsLine+1)<position)
-    {
-        yOffset+=lyricsSize(m_lyricsManager->lyricsAt(m_currentLyricsLine)).height();
-        m_currentLyricsLine++;
-    }
-    if(yOffset>0)
+    //Move from the center of the current line to the center of the new line,
+    //when it's too far, jump to the line without animation.
+    int yOffset=lineCenter(currentLine)-lineCenter(m_currentLyricsLine);
+    m_currentLyricsLine=currentLine;
+    updateWordPositions();
+    m_highlightX=highlightPosition(position);
+    if(qAbs(yOffset)>height())
     {
-        startMovingAnime((lyricsLineDuration(m_currentLyricsLine)>>2),
-                         yOffset);
+        m_moveToCurrent->stop();
+        onActionLyricsMoved(0);
+        return;
     }
+    //Start animation.
+    startMovingAnime((lyricsLineDuration(m_currentLyricsLine)>>2),
+                     yOffset);
 }
 
 void KNMusicHeaderLyrics::paintEvent(QPaintEvent *event)
@@ -186,7 +201,7 @@ void KNMusicHeaderLyrics::paintEvent(QPaintEvent *event)
     //Paint other things.
     QWidget::paintEvent(event);
     //Check is current line available, if not means no lyrics.
-    if(m_lyricsManager->isEmpty() ||
+    if(m_lyrics.isEmpty() ||
             m_currentLyricsLine<0 ||
             m_currentLyricsLine>=m_lyricsLines)
     {
@@ -198,71 +213,72 @@ void KNMusicHeaderLyrics::paintEvent(QPaintEvent *event)
                            QPainter::TextAntialiasing |
                            QPainter::SmoothPixmapTransform,
                            true);
-    QSize currentSize;
-    QString currentText;
-    int centerY=(height()>>1)+m_currentLineOffsetY;
-    //Draw the current line.
-    painter.setPen(m_highlightColor);
-    currentText=m_lyricsManager->lyricsAt(m_currentLyricsLine);
-    currentSize=lyricsSize(currentText);
-    centerY-=(currentSize.height()>>1);
-    painter.drawText(m_leftSpacing,
-                     centerY,
-                     width(),
-                     currentSize.height(),
-                     Qt::AlignLeft,
-                     currentText);
-    //Draw other lyrics.
-    painter.setPen(m_normalText);
-    //Draw down lines.
-    int lineTop=centerY+currentSize.height()+m_lineSpacing,
-        paintLine=m_currentLyricsLine+1;
-    while(lineTop<height() && paintLine<m_lyricsLines)
+    //The layouts of the lines are cached, only translate them to the place of
+    //the current line.
+    int originY=(height()>>1)+m_currentLineOffsetY-
+            lineCenter(m_currentLyricsLine);
+    //Find the first visible line from the current line.
+    int paintLine=m_currentLyricsLine;
+    while(paintLine>0 && originY+m_lineTops.at(paintLine)>0)
     {
-        //Draw the line.
-        currentText=m_lyricsManager->lyricsAt(paintLine);
-        currentSize=lyricsSize(currentText);
-        painter.drawText(m_leftSpacing,
-                         lineTop,
-                         width(),
-                         currentSize.height(),
-                         Qt::AlignLeft,
-                         currentText);
-        //To the next line.
-        paintLine++;
-        lineTop+=currentSize.height()+m_lineSpacing;
+        paintLine--;
     }
-    //Draw up lines.
-    int lineBottom=centerY;
-    paintLine=m_currentLyricsLine-1;
-    while(lineBottom>0 && paintLine>-1)
+    //Draw the lines until the bottom of the widget.
+    painter.setPen(m_normalText);
+    while(paintLine<m_lyricsLines &&
+          originY+m_lineTops.at(paintLine)<height())
     {
-        //Draw the line.
-        currentText=m_lyricsManager->lyricsAt(paintLine);
-        currentSize=lyricsSize(currentText);
-        //MAGIC: the line bottom is current line's top, so calculate here.
-        lineBottom-=currentSize.height()+m_lineSpacing;
-        painter.drawText(m_leftSpacing,
-                         lineBottom,
-                         width(),
-                         currentSize.height(),
-                         Qt::AlignLeft,
-                         currentText);
-        //To the previous line.
-        paintLine--;
+        if(paintLine==m_currentLyricsLine)
+        {
+            if(m_highlightX<0)
+            {
+                painter.setPen(m_highlightColor);
+                painter.drawStaticText(m_leftSpacing,
+                                       originY+m_lineTops.at(paintLine),
+                                       m_lineTexts.at(paintLine));
+                painter.setPen(m_normalText);
+            }
+            else
+            {
+                //Draw the words which are sung with the highlight color.
+                painter.drawStaticText(m_leftSpacing,
+                                       originY+m_lineTops.at(paintLine),
+                                       m_lineTexts.at(paintLine));
+                painter.save();
+                painter.setClipRect(m_leftSpacing,
+                                    originY+m_lineTops.at(paintLine),
+                                    m_highlightX,
+                                    m_lineTops.at(paintLine+1)-
+                                    m_lineTops.at(paintLine));
+                painter.setPen(m_highlightColor);
+                painter.drawStaticText(m_leftSpacing,
+                                       originY+m_lineTops.at(paintLine),
+                                       m_lineTexts.at(paintLine));
+                painter.restore();
+            }
+        }
+        else
+        {
+            painter.drawStaticText(m_leftSpacing,
+                                   originY+m_lineTops.at(paintLine),
+                                   m_lineTexts.at(paintLine));
+        }
+        paintLine++;
     }
 }
 
 void KNMusicHeaderLyrics::applyPreference()
 {
     //Update the lyrics folder.
-    m_lyricsManager->setLyricsFolderPath(
-                m_musicGlobal->configureData("LyricsFolder",
-                                             m_lyricsManager->lyricsFolderPath()).toString());
+    m_lyricsFolderPath=
+            m_musicGlobal->configureData("LyricsFolder",
+                                         m_lyricsFolderPath).toString();
+    emit requireSetLyricsFolderPath(m_lyricsFolderPath);
     //Update the download info.
-    m_lyricsManager->setDownloadLyrics(
-                m_musicGlobal->configureData("DownloadLyrics",
-                                             m_lyricsManager->downloadLyrics()).toBool());
+    m_downloadLyrics=
+            m_musicGlobal->configureData("DownloadLyrics",
+                                         m_downloadLyrics).toBool();
+    emit requireSetDownloadLyrics(m_downloadLyrics);
     //Update the spacing.
     m_lineSpacing=
                 m_musicGlobal->configureData("TextSpacing",
@@ -270,6 +286,8 @@ void KNMusicHeaderLyrics::applyPreference()
     //Update the font.
     setFont(m_musicGlobal->configureData("LyricsFont", font()).value<QFont>());
     //Update the lyrics.
+    updateLineLayouts();
+    updateWordPositions();
     update();
 }
 
@@ -277,13 +295,13 @@ void KNMusicHeaderLyrics::onActionMusicLibraryMoved(const QString &originalPath,
                                                     const QString &currentPath)
 {
     //Check if lyrics manager's folder path is in the orginal path.
-    QString managerFolderPath=m_lyricsManager->lyricsFolderPath();
-    if(managerFolderPath.left(originalPath.size())==originalPath)
+    if(m_lyricsFolderPath.left(originalPath.size())==originalPath)
     {
         //Set the lyrics manager to the new path.
         QString currentFolderPath=
-                currentPath+managerFolderPath.mid(originalPath.size());
-        m_lyricsManager->setLyricsFolderPath(currentFolderPath);
+                currentPath+m_lyricsFolderPath.mid(originalPath.size());
+        m_lyricsFolderPath=currentFolderPath;
+        emit requireSetLyricsFolderPath(currentFolderPath);
         m_musicGlobal->setConfigureData("LyricsFolder",
                                         currentFolderPath);
         //Update the lyrics path value.
@@ -313,11 +331,11 @@ inline void KNMusicHeaderLyrics::generateTitleAndItemInfo(KNPreferenceTitleInfo
     list.append(KNPreferenceItemGlobal::generateInfo(PathEdit,
                                                      tr("Lyrics Folder"),
                                                      "LyricsFolder",
-                                                     m_lyricsManager->lyricsFolderPath()));
+                                                     m_lyricsFolderPath));
     list.append(KNPreferenceItemGlobal::generateInfo(Switcher,
                                                      tr("Download Lyrics"),
                                                      "DownloadLyrics",
-                                                     m_lyricsManager->downloadLyrics()));
+                                                     m_downloadLyrics));
     list.append(KNPreferenceItemGlobal::generateInfo(Font,
                                                      tr("Lyrics Font"),
                                                      "LyricsFont",
@@ -333,6 +351,113 @@ inline void KNMusicHeaderLyrics::generateTitleAndItemInfo(KNPreferenceTitleInfo
     list.append(currentInfo);
 }
 
+inline void KNMusicHeaderLyrics::updateLineLayouts()
+{
+    //Layout the text of all the lines once, and save the top of the lines.
+    //The top of the line after the last line is the height of all the lines.
+    m_lineTexts.clear();
+    m_lineTops.clear();
+    if(m_lyrics.isEmpty())
+    {
+        return;
+    }
+    m_lineTexts.reserve(m_lyrics.lines());
+    m_lineTops.reserve(m_lyrics.lines()+1);
+    int lineTop=0;
+    for(int i=0; i<m_lyrics.lines(); i++)
+    {
+        //Use line separator for the combined lines.
+        QStaticText lineText(m_lyrics.lyricsAt(i).replace('\n',
+                                                          QChar::LineSeparator));
+        lineText.setTextFormat(Qt::PlainText);
+        lineText.prepare(QTransform(), font());
+        m_lineTexts.append(lineText);
+        m_lineTops.append(lineTop);
+        lineTop+=qMax((int)lineText.size().height(),
+                      fontMetrics().height())+m_lineSpacing;
+    }
+    m_lineTops.append(lineTop);
+}
+
+inline int KNMusicHeaderLyrics::lineCenter(const int &index)
+{
+    return (m_lineTops.at(index)+m_lineTops.at(index+1)-m_lineSpacing)>>1;
+}
+
+inline void KNMusicHeaderLyrics::updateWordPositions()
+{
+    //Calculate the x of the words of the current line once when the line is
+    //changed, the last one is the end of the line.
+    m_wordPositions.clear();
+    m_highlightX=-1;
+    if(m_currentLyricsLine<0 || m_currentLyricsLine>=m_lyricsLines)
+    {
+        return;
+    }
+    int words=m_lyrics.wordsAt(m_currentLyricsLine);
+    if(words==0)
+    {
+        return;
+    }
+    //Only the first row of a combined line has the word timings.
+    QString lineText=m_lyrics.lyricsAt(m_currentLyricsLine);
+    int rowEnd=lineText.indexOf('\n');
+    if(rowEnd!=-1)
+    {
+        lineText.truncate(rowEnd);
+    }
+    QFontMetrics metrics=fontMetrics();
+    m_wordPositions.reserve(words+1);
+    for(int i=0; i<words; i++)
+    {
+        m_wordPositions.append(metrics.width(
+                    lineText.left(m_lyrics.wordOffsetAt(m_currentLyricsLine,
+                                                        i))));
+    }
+    m_wordPositions.append(metrics.width(lineText));
+    m_highlightX=0;
+}
+
+inline int KNMusicHeaderLyrics::highlightPosition(const qint64 &position)
+{
+    //Lines without word timings are highlighted as a whole.
+    if(m_wordPositions.isEmpty())
+    {
+        return -1;
+    }
+    //Find the word which is being sung.
+    int words=m_wordPositions.size()-1, currentWord=-1;
+    while(currentWord+1<words &&
+          m_lyrics.wordPositionAt(m_currentLyricsLine, currentWord+1)<=position)
+    {
+        currentWord++;
+    }
+    if(currentWord==-1)
+    {
+        return 0;
+    }
+    //The last word ends at the next line.
+    qint64 wordStart=m_lyrics.wordPositionAt(m_currentLyricsLine, currentWord),
+           wordEnd=wordStart;
+    if(currentWord+1<words)
+    {
+        wordEnd=m_lyrics.wordPositionAt(m_currentLyricsLine, currentWord+1);
+    }
+    else if(m_currentLyricsLine+1<m_lyricsLines)
+    {
+        wordEnd=m_lyrics.positionAt(m_currentLyricsLine+1);
+    }
+    int startX=m_wordPositions.at(currentWord),
+        endX=m_wordPositions.at(currentWord+1);
+    if(wordEnd<=wordStart)
+    {
+        return endX;
+    }
+    //Move the highlight through the word with the playing position.
+    return startX+(endX-startX)*qMin(position-wordStart, wordEnd-wordStart)/
+            (wordEnd-wordStart);
+}
+
 inline int KNMusicHeaderLyrics::lyricsLineDuration(const int &index)
 {
     if(index==-1)
@@ -341,8 +466,8 @@ inline int KNMusicHeaderLyrics::lyricsLineDuration(const int &index)
     }
     if(index<m_lyricsLines-1)
     {
-        return m_lyricsManager->positionAt(index+1)-
-                m_lyricsManager->positionAt(index);
+        return m_lyrics.positionAt(index+1)-
+                m_lyrics.positionAt(index);
     }
     return m_animationDuration<<2;
 }
@@ -18,10 +18,14 @@
 #ifndef KNMUSICHEADERLYRICS_H
 #define KNMUSICHEADERLYRICS_H
 
+#include <QStaticText>
+
 #include "preference/knpreferenceitemglobal.h"
 
 #include "knmusicheaderlyricsbase.h"
 
+#include "knmusiclyricsdata.h"
+
 class QLabel;
 class QTimeLine;
 class KNPreferenceItemGlobal;
@@ -32,10 +36,11 @@ class KNMusicHeaderLyrics : public KNMusicHeaderLyricsBase
     Q_OBJECT
 public:
     explicit KNMusicHeaderLyrics(QWidget *parent = 0);
-    ~KNMusicHeaderLyrics();
     void setHeaderPlayer(KNMusicHeaderPlayerBase *player);
 
 signals:
+    void requireSetLyricsFolderPath(const QString &lyricsFolderPath);
+    void requireSetDownloadLyrics(bool downloadLyrics);
 
 public slots:
     void retranslate();
@@ -51,22 +56,31 @@ private slots:
     void onActionMusicLibraryMoved(const QString &originalPath,
                                    const QString &currentPath);
     void onActionLyricsMoved(const int &frame);
+    void onActionLyricsLoaded(int jobId, KNMusicLyricsData lyrics);
 
 private:
-    inline QSize lyricsSize(const QString &lyricsText)
-    {
-        return fontMetrics().size(Qt::TextExpandTabs, lyricsText);
-    }
     inline void generateTitleAndItemInfo(KNPreferenceTitleInfo &listTitle,
                                          QList<KNPreferenceItemInfo> &list);
+    inline void updateLineLayouts();
+    inline int lineCenter(const int &index);
+    inline void updateWordPositions();
+    inline int highlightPosition(const qint64 &position);
     inline int lyricsLineDuration(const int &index);
     inline void startMovingAnime(const int &durationOffset,
                                  const int &yOffset);
     KNMusicLyricsManager *m_lyricsManager;
     KNMusicGlobal *m_musicGlobal;
+    KNMusicLyricsData m_lyrics;
+    QString m_lyricsFolderPath;
+    bool m_downloadLyrics;
+    QVector<QStaticText> m_lineTexts;
+    QVector<int> m_lineTops;
+    QVector<int> m_wordPositions;
+    int m_lyricsJob=0;
 
     QTimeLine *m_moveToCurrent;
     int m_currentLyricsLine=-1, m_lyricsLines=0, m_currentLineOffsetY=0,
+        m_highlightX=-1,
         m_leftSpacing=15, m_animationDuration=200, m_lineSpacing=2;
     QColor m_normalText=QColor(100,100,100),
            m_highlightColor=QColor(0xf7, 0xcf, 0x3d);
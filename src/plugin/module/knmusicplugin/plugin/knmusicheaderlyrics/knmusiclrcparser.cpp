@@ -16,12 +16,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 #include <QFile>
-#include <QTextStream>
 #include <QTextCodec>
-#include <QStringList>
-#include <QLinkedList>
-#include <QRegularExpressionMatch>
-#include <QRegularExpressionMatchIterator>
 
 #include "knglobal.h"
 
@@ -32,13 +27,12 @@
 KNMusicLRCParser::KNMusicLRCParser(QObject *parent) :
     QObject(parent)
 {
-    //Set frame catch regexp.
-    m_frameCatch.setPattern("\\[[^\\]]*\\]");
-    //Set the header text.
+    //Set the header text, the index is the property.
     m_headerText.append("ti");
     m_headerText.append("ar");
     m_headerText.append("al");
     m_headerText.append("by");
+    m_headerText.append("offset");
     //Get the codec.
     m_utf8Codec=QTextCodec::codecForName("UTF-8");
     m_localeCodec=KNGlobal::localeDefaultCodec();
@@ -46,14 +40,15 @@ KNMusicLRCParser::KNMusicLRCParser(QObject *parent) :
 
 void KNMusicLRCParser::parseFile(const QString &filePath,
                                  QMap<int, QString> &properties,
-                                 QList<qint64> &positions,
-                                 QStringList &lyricsText)
+                                 QVector<KNMusicLyricsLine> &lines,
+                                 QVector<KNMusicLyricsWord> &words,
+                                 QString &lyricsText)
 {
     //-------Clear the data---------
-    positions.clear();
+    lines.clear();
+    words.clear();
     lyricsText.clear();
     //-------Read the file---------
-    QStringList lyricsRawData;
     //Open the lyric file.
     QFile lyricsFile(filePath);
     if(!lyricsFile.open(QIODevice::ReadOnly))
@@ -62,123 +57,274 @@ void KNMusicLRCParser::parseFile(const QString &filePath,
     }
     //Read all the raw data of the file.
     QByteArray fileRawData=lyricsFile.readAll();
+    //Close the file.
+    lyricsFile.close();
     //Try to parse it using UTF-8.
     QTextCodec::ConverterState convState;
-    QString fileTextData=m_utf8Codec->toUnicode(fileRawData.constData(),
-                                                fileRawData.size(),
-                                                &convState);
+    lyricsText=m_utf8Codec->toUnicode(fileRawData.constData(),
+                                      fileRawData.size(),
+                                      &convState);
     //If we can't decode it, try to use default codec.
     if(convState.invalidChars>0)
     {
-        fileTextData=m_localeCodec->toUnicode(fileRawData.constData(),
-                                              fileRawData.size(),
-                                              &convState);
-        //If we still cannot decode it, ask user to select a codec.
-        if(convState.invalidChars>0)
-        {
-            ;
-        }
+        lyricsText=m_localeCodec->toUnicode(fileRawData.constData(),
+                                            fileRawData.size(),
+                                            &convState);
     }
-    lyricsRawData=fileTextData.split(QRegularExpression("\n"),
-                                     QString::SkipEmptyParts);
-    //Close the file.
-    lyricsFile.close();
     //-------Parse the file---------
-    //Clear the same line.
-    lyricsRawData.removeDuplicates();
-    //Clear the data.
-    QList<LRCFrame> lyricsData;
-    //Process each line.
-    while(!lyricsRawData.isEmpty())
+    //Scan the text once, the text of the lines are kept in the lyrics text,
+    //only the ranges are saved. The text of the lines which have word timings
+    //are saved without the word tags, it's appended to the lyrics text after
+    //the scan.
+    int textSize=lyricsText.size();
+    QString wordText;
+    const QChar *textData=lyricsText.constData(),
+                *textEnd=textData+lyricsText.size(),
+                *lineData=textData;
+    while(lineData<textEnd)
     {
-        //Take one line and remove all spaces.
-        QString currentLine=lyricsRawData.takeFirst();
-        //Using a linked list to storage all the frames.
-        QLinkedList<QString> currentFrames;
-        //Catch the frame data.
-        QRegularExpressionMatchIterator matchIterator=
-                m_frameCatch.globalMatch(currentLine);
-        int lastPos=0;
-        while(matchIterator.hasNext())
-        {
-            QRegularExpressionMatch match=matchIterator.next();
-            if(match.capturedStart()!=lastPos)
+        //Find the end of the line.
+        const QChar *lineEnd=lineData;
+        while(lineEnd<textEnd && *lineEnd!='\n')
+        {
+            ++lineEnd;
+        }
+        const QChar *nextLine=lineEnd+1;
+        if(lineEnd>lineData && *(lineEnd-1)=='\r')
+        {
+            --lineEnd;
+        }
+        //Parse the tags at the head of the line.
+        int lineStart=lines.size();
+        const QChar *tagData=lineData;
+        while(tagData<lineEnd && *tagData=='[')
+        {
+            const QChar *tagEnd=tagData+1;
+            while(tagEnd<lineEnd && *tagEnd!=']')
             {
-                //Means it's not in the head of the current line.
+                ++tagEnd;
+            }
+            if(tagEnd==lineEnd)
+            {
+                //The tag is not closed, treat it as text.
                 break;
             }
-            currentFrames.append(currentLine.mid(match.capturedStart(),
-                                                 match.capturedLength()));
-            lastPos=match.capturedEnd();
+            KNMusicLyricsLine currentLine;
+            if(parseTime(tagData+1, tagEnd, currentLine.position))
+            {
+                lines.append(currentLine);
+            }
+            else
+            {
+                //Check the header tags.
+                const QChar *colon=tagData+1;
+                while(colon<tagEnd && *colon!=':')
+                {
+                    ++colon;
+                }
+                if(colon<tagEnd)
+                {
+                    int headerIndex=m_headerText.indexOf(
+                                QString(tagData+1, colon-tagData-1).toLower());
+                    if(headerIndex!=-1)
+                    {
+                        properties[headerIndex]=
+                                QString(colon+1, tagEnd-colon-1).trimmed();
+                    }
+                }
+            }
+            tagData=tagEnd+1;
         }
-        //Remove all the frames.
-        currentLine.remove(0, lastPos);
-        //-------Prase the line------
-        while(!currentFrames.isEmpty())
+        //Parse the word timings of the text.
+        int textStart=tagData-textData, textLength=lineEnd-tagData,
+            wordStart=wordText.size(), firstWord=words.size();
+        if(lines.size()>lineStart &&
+                parseWords(tagData, lineEnd, words, wordText))
         {
-            parseFrame(currentFrames.takeFirst(),
-                       currentLine,
-                       lyricsData,
-                       properties);
+            textStart=textSize+wordStart;
+            textLength=wordText.size()-wordStart;
+        }
+        //Set the text of the time tags of the line.
+        for(int i=lineStart; i<lines.size(); i++)
+        {
+            lines[i].start=textStart;
+            lines[i].length=textLength;
+            lines[i].firstWord=firstWord;
+            lines[i].words=words.size()-firstWord;
+        }
+        lineData=nextLine;
+    }
+    if(lines.isEmpty())
+    {
+        return;
+    }
+    lyricsText.append(wordText);
+    //Apply the offset, a positive offset shows the lyrics earlier.
+    qint64 offset=properties.value(LyricsOffset).toLongLong();
+    if(offset!=0)
+    {
+        for(int i=0; i<lines.size(); i++)
+        {
+            lines[i].position=qMax(lines.at(i).position-offset, (qint64)0);
+        }
+        for(int i=0; i<words.size(); i++)
+        {
+            words[i].position=qMax(words.at(i).position-offset, (qint64)0);
         }
     }
     //-----------Sort the lyrics line-----------
     //- Why stable sort?
     //  Because there might be some frames at the same time. Display them.
-    qStableSort(lyricsData.begin(), lyricsData.end(), frameLessThan);
-    //Combine the lyrics.
-    QMap<qint64, QString> lyricsMap;
-    for(int i=0; i<lyricsData.size(); i++)
+    //Most of the files are already in order, don't sort them.
+    for(int i=1; i<lines.size(); i++)
     {
-        lyricsMap[lyricsData[i].position]=
-                (lyricsMap[lyricsData[i].position].isEmpty()?"":lyricsMap[lyricsData[i].position]+'\n')+
-                lyricsData[i].text;
+        if(lines.at(i).position<lines.at(i-1).position)
+        {
+            qStableSort(lines.begin(), lines.end(), lineLessThan);
+            break;
+        }
     }
-    //Export the position and the text.
-    positions=lyricsMap.keys();
-    lyricsText=lyricsMap.values();
+    //Combine the lines at the same time.
+    combineLines(lines, lyricsText);
 }
 
-void KNMusicLRCParser::parseFrame(const QString &frame,
-                                  const QString &lineData,
-                                  QList<LRCFrame> &lyricsData,
-                                  QMap<int, QString> &properties)
+inline bool KNMusicLRCParser::parseTime(const QChar *tagData,
+                                        const QChar *tagEnd,
+                                        qint64 &position)
 {
-    //Remove the first '[' and ']'.
-    QString frameData=frame.mid(1, frame.length()-2);
-    //Get the data before the first colon, judge it's number or not.
-    int colonPos=frameData.indexOf(':');
-    if(colonPos==-1)
+    //The time tag is [mm:ss], [mm:ss.xx] or [mm:ss:xx].
+    qint64 minute=0, second=0, fraction=0;
+    int digits=0;
+    while(tagData<tagEnd && tagData->isDigit())
     {
-        //Cannot find ':', this is frame is obsolete.
-        return;
+        minute=minute*10+tagData->digitValue();
+        ++tagData;
+        ++digits;
     }
-    //Get the data before the first colon.
-    QString testData=frameData.left(colonPos).toLower();
-    //Search header text in header, if has find.
-    int frameIndex=m_headerText.indexOf(testData);
-    if(frameIndex!=-1)
+    if(digits==0 || tagData==tagEnd || *tagData!=':')
     {
-        properties[frameIndex]=frameData.mid(colonPos+1);
-        return;
+        return false;
     }
-    //Judge the test data is number or not.
-    int secondChar=frameData.indexOf(QRegularExpression("[^0-9]"), colonPos+1);
-    //If it's not a number, means it cannot be a time, obsolete.
-    if(secondChar==-1)
+    ++tagData;
+    digits=0;
+    while(tagData<tagEnd && tagData->isDigit())
     {
-        return;
+        second=second*10+tagData->digitValue();
+        ++tagData;
+        ++digits;
+    }
+    if(digits==0)
+    {
+        return false;
+    }
+    if(tagData<tagEnd)
+    {
+        if(*tagData!='.' && *tagData!=':')
+        {
+            return false;
+        }
+        ++tagData;
+        //Only the milliseconds are used.
+        int fractionScale=100;
+        while(tagData<tagEnd && tagData->isDigit())
+        {
+            fraction+=tagData->digitValue()*fractionScale;
+            fractionScale/=10;
+            ++tagData;
+        }
+        if(tagData!=tagEnd)
+        {
+            return false;
+        }
+    }
+    position=minute*60000+second*1000+fraction;
+    return true;
+}
+
+inline bool KNMusicLRCParser::parseWords(const QChar *textData,
+                                         const QChar *textEnd,
+                                         QVector<KNMusicLyricsWord> &words,
+                                         QString &wordText)
+{
+    //The word timing is <mm:ss.xx> before the word, the text without the tags
+    //is appended to the word text only when there's any word timing.
+    int wordStart=wordText.size();
+    const QChar *plainText=textData, *currentChar=textData;
+    bool hasWords=false;
+    while(currentChar<textEnd)
+    {
+        if(*currentChar!='<')
+        {
+            ++currentChar;
+            continue;
+        }
+        const QChar *tagEnd=currentChar+1;
+        while(tagEnd<textEnd && *tagEnd!='>')
+        {
+            ++tagEnd;
+        }
+        KNMusicLyricsWord word;
+        if(tagEnd==textEnd || !parseTime(currentChar+1, tagEnd, word.position))
+        {
+            //It's not a time tag, keep it as text.
+            ++currentChar;
+            continue;
+        }
+        //Save the text before the tag, the word starts from here.
+        wordText.append(plainText, currentChar-plainText);
+        word.offset=wordText.size()-wordStart;
+        words.append(word);
+        hasWords=true;
+        currentChar=tagEnd+1;
+        plainText=currentChar;
+    }
+    if(hasWords)
+    {
+        wordText.append(plainText, textEnd-plainText);
+    }
+    return hasWords;
+}
+
+inline void KNMusicLRCParser::combineLines(QVector<KNMusicLyricsLine> &lines,
+                                           QString &lyricsText)
+{
+    //Combine the lines at the same time into one line, the combined text is
+    //appended to the end of the lyrics text. The combined text starts with the
+    //text of the first line, so the word timings of it are still available.
+    int currentLine=0;
+    for(int i=0; i<lines.size(); )
+    {
+        KNMusicLyricsLine line=lines.at(i);
+        QString combinedText;
+        for(i++; i<lines.size() && lines.at(i).position==line.position; i++)
+        {
+            //Ignore the same line.
+            QStringRef currentText=lyricsText.midRef(lines.at(i).start,
+                                                     lines.at(i).length);
+            if(currentText==lyricsText.midRef(line.start, line.length))
+            {
+                continue;
+            }
+            if(combinedText.isEmpty())
+            {
+                combinedText=lyricsText.mid(line.start, line.length);
+            }
+            combinedText.append('\n');
+            combinedText.append(currentText);
+        }
+        if(!combinedText.isEmpty())
+        {
+            line.start=lyricsText.size();
+            line.length=combinedText.size();
+            lyricsText.append(combinedText);
+        }
+        lines[currentLine++]=line;
     }
-    LRCFrame currentFrame;
-    currentFrame.position=testData.toLongLong()*60000+
-            frameData.mid(colonPos+1, secondChar-colonPos-1).toLongLong()*1000+
-            frameData.mid(secondChar+1).toLongLong()*10;
-    currentFrame.text=lineData;
-    lyricsData.append(currentFrame);
+    lines.resize(currentLine);
 }
 
-bool KNMusicLRCParser::frameLessThan(const LRCFrame &frameLeft,
-                                     const LRCFrame &frameRight)
+bool KNMusicLRCParser::lineLessThan(const KNMusicLyricsLine &lineLeft,
+                                    const KNMusicLyricsLine &lineRight)
 {
-    return frameLeft.position<frameRight.position;
+    return lineLeft.position<lineRight.position;
 }
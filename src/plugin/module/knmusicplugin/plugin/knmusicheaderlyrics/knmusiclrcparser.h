@@ -18,12 +18,14 @@
 #ifndef KNMUSICLRCPARSER_H
 #define KNMUSICLRCPARSER_H
 
-#include <QRegularExpression>
 #include <QMap>
-#include <QList>
+#include <QStringList>
+
+#include "knmusiclyricsdata.h"
 
 #include <QObject>
 
+class QTextCodec;
 namespace KNMusicLRC
 {
 enum Properties
@@ -31,12 +33,8 @@ enum Properties
     LyricsTitle,
     LyricsArtist,
     LyricsAlbum,
-    LyricAuthor
-};
-struct LRCFrame
-{
-    qint64 position;
-    QString text;
+    LyricAuthor,
+    LyricsOffset
 };
 }
 
@@ -47,24 +45,28 @@ class KNMusicLRCParser : public QObject
     Q_OBJECT
 public:
     explicit KNMusicLRCParser(QObject *parent = 0);
-    QList<qint64> positions() const;
 
 signals:
 
 public slots:
     void parseFile(const QString &filePath,
                    QMap<int, QString> &properties,
-                   QList<qint64> &positions,
-                   QStringList &lyricsText);
+                   QVector<KNMusicLyricsLine> &lines,
+                   QVector<KNMusicLyricsWord> &words,
+                   QString &lyricsText);
 
 private:
-    void parseFrame(const QString &frame,
-                    const QString &lineData,
-                    QList<LRCFrame> &lyricsData,
-                    QMap<int, QString> &properties);
-    static bool frameLessThan(const LRCFrame &frameLeft,
-                              const LRCFrame &frameRight);
-    QRegularExpression m_frameCatch;
+    inline bool parseTime(const QChar *tagData,
+                          const QChar *tagEnd,
+                          qint64 &position);
+    inline bool parseWords(const QChar *textData,
+                           const QChar *textEnd,
+                           QVector<KNMusicLyricsWord> &words,
+                           QString &wordText);
+    inline void combineLines(QVector<KNMusicLyricsLine> &lines,
+                             QString &lyricsText);
+    static bool lineLessThan(const KNMusicLyricsLine &lineLeft,
+                             const KNMusicLyricsLine &lineRight);
     QStringList m_headerText;
     QTextCodec *m_utf8Codec, *m_localeCodec;
 };
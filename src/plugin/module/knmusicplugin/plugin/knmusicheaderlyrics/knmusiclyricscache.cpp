@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <cstring>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include "knmusiclyricscache.h"
+
+#define CacheSuffix ".lrcache"
+//The magic number is "KNLC", the version is changed when the layout of the
+//lines or the words is changed.
+#define CacheMagic 0x434C4E4B
+#define CacheVersion 1
+#define MemoryCacheSize 8
+
+KNMusicLyricsCache::KNMusicLyricsCache(QObject *parent) :
+    QObject(parent),
+    m_lyricsCache(MemoryCacheSize)
+{
+}
+
+QString KNMusicLyricsCache::cacheKey(const QString &lyricsPath)
+{
+    QFileInfo lyricsInfo(lyricsPath);
+    QString keySource=lyricsInfo.absoluteFilePath()+"\n"+
+            QString::number(lyricsInfo.size())+"\n"+
+            QString::number(lyricsInfo.lastModified().toMSecsSinceEpoch());
+    return QCryptographicHash::hash(keySource.toUtf8(),
+                                    QCryptographicHash::Md5).toHex();
+}
+
+void KNMusicLyricsCache::setCacheFolderPath(const QString &cacheFolderPath)
+{
+    m_cacheFolderPath=cacheFolderPath;
+    //Reload the cache files when it's used.
+    m_cacheFiles.clear();
+    m_cacheSizes.clear();
+    m_cacheSize=0;
+    m_cacheFilesLoaded=false;
+}
+
+void KNMusicLyricsCache::setMaximumSize(const qint64 &maximumSize)
+{
+    m_maximumSize=maximumSize;
+}
+
+bool KNMusicLyricsCache::loadLyrics(const QString &lyricsPath,
+                                    KNMusicLyricsData &lyrics)
+{
+    QString key=cacheKey(lyricsPath);
+    //Check the memory cache first.
+    KNMusicLyricsData *cachedLyrics=m_lyricsCache.object(key);
+    if(cachedLyrics!=nullptr)
+    {
+        lyrics=*cachedLyrics;
+        return true;
+    }
+    if(m_cacheFolderPath.isEmpty())
+    {
+        return false;
+    }
+    loadCacheFiles();
+    if(!m_cacheSizes.contains(key))
+    {
+        return false;
+    }
+    //Map the cache file and copy the data.
+    QFile cacheFile(cacheFilePath(key));
+    if(!cacheFile.open(QIODevice::ReadOnly))
+    {
+        removeCacheFile(key);
+        return false;
+    }
+    qint64 cacheSize=cacheFile.size();
+    uchar *cacheData=cacheFile.map(0, cacheSize);
+    if(cacheData==nullptr)
+    {
+        cacheFile.close();
+        return false;
+    }
+    bool loaded=readLyrics(cacheData, cacheData+cacheSize, lyricsPath, lyrics);
+    cacheFile.unmap(cacheData);
+    cacheFile.close();
+    if(!loaded)
+    {
+        //The cache file is broken.
+        removeCacheFile(key);
+        return false;
+    }
+    useCacheFile(key, cacheSize);
+    m_lyricsCache.insert(key, new KNMusicLyricsData(lyrics));
+    return true;
+}
+
+void KNMusicLyricsCache::saveLyrics(const KNMusicLyricsData &lyrics)
+{
+    QString key=cacheKey(lyrics.filePath());
+    m_lyricsCache.insert(key, new KNMusicLyricsData(lyrics));
+    if(m_cacheFolderPath.isEmpty())
+    {
+        return;
+    }
+    loadCacheFiles();
+    //Write the header, the properties, and the arrays.
+    QMap<int, QString> properties=lyrics.properties();
+    QVector<KNMusicLyricsLine> lines=lyrics.lineData();
+    QVector<KNMusicLyricsWord> words=lyrics.wordData();
+    QString lyricsText=lyrics.lyricsText();
+    QByteArray cacheData;
+    qint32 header[6]={CacheMagic,
+                      CacheVersion,
+                      properties.size(),
+                      lines.size(),
+                      words.size(),
+                      lyricsText.size()};
+    cacheData.append((const char *)header, sizeof(header));
+    for(QMap<int, QString>::const_iterator i=properties.constBegin();
+        i!=properties.constEnd();
+        ++i)
+    {
+        qint32 property[2]={i.key(), i.value().size()};
+        cacheData.append((const char *)property, sizeof(property));
+        cacheData.append((const char *)i.value().constData(),
+                         i.value().size()*sizeof(QChar));
+    }
+    cacheData.append((const char *)lines.constData(),
+                     lines.size()*sizeof(KNMusicLyricsLine));
+    cacheData.append((const char *)words.constData(),
+                     words.size()*sizeof(KNMusicLyricsWord));
+    cacheData.append((const char *)lyricsText.constData(),
+                     lyricsText.size()*sizeof(QChar));
+    QSaveFile cacheFile(cacheFilePath(key));
+    if(!cacheFile.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+    cacheFile.write(cacheData);
+    if(cacheFile.commit())
+    {
+        useCacheFile(key, cacheData.size());
+    }
+}
+
+void KNMusicLyricsCache::clear()
+{
+    m_lyricsCache.clear();
+    loadCacheFiles();
+    while(!m_cacheFiles.isEmpty())
+    {
+        removeCacheFile(m_cacheFiles.first());
+    }
+}
+
+inline QString KNMusicLyricsCache::cacheFilePath(const QString &key) const
+{
+    return m_cacheFolderPath+"/"+key+CacheSuffix;
+}
+
+inline void KNMusicLyricsCache::loadCacheFiles()
+{
+    if(m_cacheFilesLoaded || m_cacheFolderPath.isEmpty())
+    {
+        return;
+    }
+    m_cacheFilesLoaded=true;
+    //The order of the last session is lost, use the modified time instead.
+    QFileInfoList fileList=
+            QDir(m_cacheFolderPath).entryInfoList(
+                QStringList(QString("*")+CacheSuffix),
+                QDir::Files,
+                QDir::Time | QDir::Reversed);
+    for(QFileInfoList::const_iterator i=fileList.constBegin();
+        i!=fileList.constEnd();
+        ++i)
+    {
+        QString key=(*i).completeBaseName();
+        m_cacheFiles.append(key);
+        m_cacheSizes.insert(key, (*i).size());
+        m_cacheSize+=(*i).size();
+    }
+    //Remove the files out of the limit.
+    while(m_cacheSize>m_maximumSize && !m_cacheFiles.isEmpty())
+    {
+        removeCacheFile(m_cacheFiles.first());
+    }
+}
+
+inline void KNMusicLyricsCache::useCacheFile(const QString &key,
+                                             const qint64 &size)
+{
+    //Move the file to the end of the list.
+    if(m_cacheSizes.contains(key))
+    {
+        m_cacheFiles.removeOne(key);
+        m_cacheSize-=m_cacheSizes.value(key);
+    }
+    m_cacheFiles.append(key);
+    m_cacheSizes.insert(key, size);
+    m_cacheSize+=size;
+    //Remove the least recently used files.
+    while(m_cacheSize>m_maximumSize && m_cacheFiles.size()>1)
+    {
+        removeCacheFile(m_cacheFiles.first());
+    }
+}
+
+inline void KNMusicLyricsCache::removeCacheFile(const QString &key)
+{
+    QFile::remove(cacheFilePath(key));
+    m_cacheFiles.removeOne(key);
+    m_cacheSize-=m_cacheSizes.take(key);
+}
+
+inline bool KNMusicLyricsCache::readLyrics(const uchar *data,
+                                           const uchar *dataEnd,
+                                           const QString &lyricsPath,
+                                           KNMusicLyricsData &lyrics)
+{
+    //Check the header.
+    qint32 header[6];
+    if(!readData(data, dataEnd, header, sizeof(header)) ||
+            header[0]!=CacheMagic || header[1]!=CacheVersion ||
+            header[2]<0 || header[3]<0 || header[4]<0 || header[5]<0)
+    {
+        return false;
+    }
+    //The counts are not trusted, every property takes two integers at least.
+    if((qint64)header[2]*2*(qint64)sizeof(qint32)>dataEnd-data)
+    {
+        return false;
+    }
+    //Read the properties.
+    QMap<int, QString> properties;
+    for(int i=0; i<header[2]; i++)
+    {
+        qint32 property[2];
+        if(!readData(data, dataEnd, property, sizeof(property)) ||
+                property[1]<0)
+        {
+            return false;
+        }
+        QString propertyText(property[1], Qt::Uninitialized);
+        if(!readData(data, dataEnd, propertyText.data(),
+                     property[1]*sizeof(QChar)))
+        {
+            return false;
+        }
+        properties.insert(property[0], propertyText);
+    }
+    //Check the size of the arrays before allocating them.
+    if((qint64)header[3]*(qint64)sizeof(KNMusicLyricsLine)+
+            (qint64)header[4]*(qint64)sizeof(KNMusicLyricsWord)+
+            (qint64)header[5]*(qint64)sizeof(QChar)>dataEnd-data)
+    {
+        return false;
+    }
+    //Copy the arrays.
+    QVector<KNMusicLyricsLine> lines(header[3]);
+    QVector<KNMusicLyricsWord> words(header[4]);
+    QString lyricsText(header[5], Qt::Uninitialized);
+    if(!readData(data, dataEnd, lines.data(),
+                 header[3]*sizeof(KNMusicLyricsLine)) ||
+            !readData(data, dataEnd, words.data(),
+                      header[4]*sizeof(KNMusicLyricsWord)) ||
+            !readData(data, dataEnd, lyricsText.data(),
+                      header[5]*sizeof(QChar)))
+    {
+        return false;
+    }
+    //The lyrics data reads the text and the words of a line with the ranges,
+    //check them all before using the data.
+    for(QVector<KNMusicLyricsLine>::const_iterator i=lines.constBegin();
+        i!=lines.constEnd();
+        ++i)
+    {
+        if((*i).start<0 || (*i).length<0 ||
+                (qint64)(*i).start+(*i).length>header[5] ||
+                (*i).firstWord<0 || (*i).words<0 ||
+                (qint64)(*i).firstWord+(*i).words>header[4])
+        {
+            return false;
+        }
+        for(int j=(*i).firstWord; j<(*i).firstWord+(*i).words; j++)
+        {
+            if(words.at(j).offset<0 || words.at(j).offset>(*i).length)
+            {
+                return false;
+            }
+        }
+    }
+    lyrics=KNMusicLyricsData(lyricsPath,
+                             properties,
+                             lines,
+                             words,
+                             lyricsText);
+    return true;
+}
+
+inline bool KNMusicLyricsCache::readData(const uchar *&data,
+                                         const uchar *dataEnd,
+                                         void *target,
+                                         const qint64 &size)
+{
+    if(dataEnd-data<size)
+    {
+        return false;
+    }
+    memcpy(target, data, size);
+    data+=size;
+    return true;
+}
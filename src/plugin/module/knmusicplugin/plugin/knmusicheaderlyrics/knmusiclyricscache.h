@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICLYRICSCACHE_H
+#define KNMUSICLYRICSCACHE_H
+
+#include <QCache>
+#include <QHash>
+#include <QStringList>
+
+#include "knmusiclyricsdata.h"
+
+#include <QObject>
+
+/*
+ * KNMusicLyricsCache saves the parsed lyrics in the cache folder. The lines,
+ * the words and the decoded text are written as they are in the memory, so a
+ * cached file is loaded by mapping it and copying the arrays, the codec
+ * detection and the parser are skipped. The key is the lyrics file path, the
+ * size and the modified time, a changed file won't use the old cache. The
+ * total size of the cache folder is limited, the least recently used files are
+ * removed first.
+ */
+class KNMusicLyricsCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KNMusicLyricsCache(QObject *parent = 0);
+    static QString cacheKey(const QString &lyricsPath);
+    void setCacheFolderPath(const QString &cacheFolderPath);
+    void setMaximumSize(const qint64 &maximumSize);
+    bool loadLyrics(const QString &lyricsPath, KNMusicLyricsData &lyrics);
+    void saveLyrics(const KNMusicLyricsData &lyrics);
+
+signals:
+
+public slots:
+    void clear();
+
+private:
+    inline QString cacheFilePath(const QString &key) const;
+    inline void loadCacheFiles();
+    inline void useCacheFile(const QString &key, const qint64 &size);
+    inline void removeCacheFile(const QString &key);
+    inline bool readLyrics(const uchar *data,
+                           const uchar *dataEnd,
+                           const QString &lyricsPath,
+                           KNMusicLyricsData &lyrics);
+    static inline bool readData(const uchar *&data,
+                                const uchar *dataEnd,
+                                void *target,
+                                const qint64 &size);
+    QCache<QString, KNMusicLyricsData> m_lyricsCache;
+    //The cache files from the least recently used one to the latest one.
+    QStringList m_cacheFiles;
+    QHash<QString, qint64> m_cacheSizes;
+    QString m_cacheFolderPath;
+    qint64 m_cacheSize=0, m_maximumSize=16<<20;
+    bool m_cacheFilesLoaded=false;
+};
+
+#endif // KNMUSICLYRICSCACHE_H
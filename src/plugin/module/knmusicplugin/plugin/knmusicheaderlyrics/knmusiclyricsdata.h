@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICLYRICSDATA_H
+#define KNMUSICLYRICSDATA_H
+
+#include <QMap>
+#include <QVector>
+#include <QString>
+
+#include <algorithm>
+
+/*
+ * KNMusicLyricsLine is a line of the lyrics, the text of the line is a range
+ * of the text of the whole lyrics. The word timings of the enhanced LRC are a
+ * range of the words of the whole lyrics.
+ */
+struct KNMusicLyricsLine
+{
+    qint64 position;
+    int start;
+    int length;
+    int firstWord;
+    int words;
+};
+
+/*
+ * KNMusicLyricsWord is the time of a word, the offset is the index of the first
+ * character of the word in the text of the line.
+ */
+struct KNMusicLyricsWord
+{
+    qint64 position;
+    int offset;
+};
+
+/*
+ * KNMusicLyricsData is the parsed lyrics of a file. It's created by the lyrics
+ * manager in the lyrics thread and never changed after that, the copies share
+ * the same data, so it can be sent to the widgets without copying the lines.
+ * The lines are sorted by the position.
+ */
+class KNMusicLyricsData
+{
+public:
+    KNMusicLyricsData(){}
+    KNMusicLyricsData(const QString &filePath,
+                      const QMap<int, QString> &properties,
+                      const QVector<KNMusicLyricsLine> &lines,
+                      const QVector<KNMusicLyricsWord> &words,
+                      const QString &lyricsText) :
+        m_filePath(filePath),
+        m_properties(properties),
+        m_lines(lines),
+        m_words(words),
+        m_lyricsText(lyricsText)
+    {
+    }
+    bool isEmpty() const
+    {
+        return m_lines.isEmpty();
+    }
+    int lines() const
+    {
+        return m_lines.size();
+    }
+    qint64 positionAt(const int &index) const
+    {
+        return m_lines.at(index).position;
+    }
+    QString lyricsAt(const int &index) const
+    {
+        const KNMusicLyricsLine &line=m_lines.at(index);
+        return m_lyricsText.mid(line.start, line.length);
+    }
+    int wordsAt(const int &index) const
+    {
+        return m_lines.at(index).words;
+    }
+    qint64 wordPositionAt(const int &index, const int &word) const
+    {
+        return m_words.at(m_lines.at(index).firstWord+word).position;
+    }
+    int wordOffsetAt(const int &index, const int &word) const
+    {
+        return m_words.at(m_lines.at(index).firstWord+word).offset;
+    }
+    int lineAt(const qint64 &position) const
+    {
+        //Find the last line which is started before the position, -1 when the
+        //position is before the first line.
+        return std::upper_bound(m_lines.constBegin(),
+                                m_lines.constEnd(),
+                                position,
+                                [](const qint64 &linePosition,
+                                   const KNMusicLyricsLine &line)
+                                {
+                                    return linePosition<line.position;
+                                })-m_lines.constBegin()-1;
+    }
+    QString property(const int &index) const
+    {
+        return m_properties.value(index);
+    }
+    QString filePath() const
+    {
+        return m_filePath;
+    }
+    //The raw data is used to save the lyrics to the cache.
+    QMap<int, QString> properties() const
+    {
+        return m_properties;
+    }
+    QVector<KNMusicLyricsLine> lineData() const
+    {
+        return m_lines;
+    }
+    QVector<KNMusicLyricsWord> wordData() const
+    {
+        return m_words;
+    }
+    QString lyricsText() const
+    {
+        return m_lyricsText;
+    }
+
+private:
+    QString m_filePath;
+    QMap<int, QString> m_properties;
+    QVector<KNMusicLyricsLine> m_lines;
+    QVector<KNMusicLyricsWord> m_words;
+    QString m_lyricsText;
+};
+
+#endif // KNMUSICLYRICSDATA_H
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <QDir>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+
+#include "knmusiclyricsindex.h"
+
+KNMusicLyricsIndex::KNMusicLyricsIndex(QObject *parent) :
+    QObject(parent)
+{
+    //Initial the watcher.
+    m_watcher=new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged,
+            this, &KNMusicLyricsIndex::onActionDirectoryChanged);
+}
+
+QString KNMusicLyricsIndex::findLyrics(const QString &folderPath,
+                                       const QString &name)
+{
+    if(name.isEmpty())
+    {
+        return QString();
+    }
+    return folderIndex(folderPath).value(normalizeName(name));
+}
+
+QString KNMusicLyricsIndex::normalizeName(const QString &name)
+{
+    //Ignore the case and the spaces, and treat all kinds of dashes as '-'.
+    QString normalizedName;
+    normalizedName.reserve(name.size());
+    for(int i=0; i<name.size(); i++)
+    {
+        QChar currentChar=name.at(i);
+        if(currentChar.isSpace())
+        {
+            continue;
+        }
+        if(currentChar.category()==QChar::Punctuation_Dash)
+        {
+            normalizedName.append('-');
+            continue;
+        }
+        normalizedName.append(currentChar.toLower());
+    }
+    return normalizedName;
+}
+
+void KNMusicLyricsIndex::clear()
+{
+    //Stop watching all the folders.
+    if(!m_recentFolders.isEmpty())
+    {
+        m_watcher->removePaths(m_recentFolders);
+    }
+    m_recentFolders.clear();
+    m_folderIndexes.clear();
+}
+
+void KNMusicLyricsIndex::onActionDirectoryChanged(const QString &path)
+{
+    //Remove the index of the folder, it will be listed again when it's used.
+    m_watcher->removePath(path);
+    m_recentFolders.removeOne(path);
+    m_folderIndexes.remove(path);
+}
+
+inline QHash<QString, QString> KNMusicLyricsIndex::folderIndex(
+        const QString &folderPath)
+{
+    QString cleanPath=QDir::cleanPath(QDir(folderPath).absolutePath());
+    //Check the index of the folder first.
+    if(m_folderIndexes.contains(cleanPath))
+    {
+        //Move the folder to the end of the recent list.
+        m_recentFolders.removeOne(cleanPath);
+        m_recentFolders.append(cleanPath);
+        return m_folderIndexes.value(cleanPath);
+    }
+    //The folder which doesn't exist can't be watched, don't keep it.
+    QDir folder(cleanPath);
+    if(!folder.exists())
+    {
+        return QHash<QString, QString>();
+    }
+    //List the lyrics files in the folder, the first file of the same name is
+    //used.
+    QHash<QString, QString> index;
+    QFileInfoList fileList=folder.entryInfoList(QDir::Files);
+    for(QFileInfoList::const_iterator i=fileList.constBegin();
+        i!=fileList.constEnd();
+        ++i)
+    {
+        if((*i).suffix().toLower()!="lrc")
+        {
+            continue;
+        }
+        QString key=normalizeName((*i).completeBaseName());
+        if(!index.contains(key))
+        {
+            index.insert(key, (*i).absoluteFilePath());
+        }
+    }
+    //Save the index and watch the folder.
+    m_folderIndexes.insert(cleanPath, index);
+    m_recentFolders.append(cleanPath);
+    m_watcher->addPath(cleanPath);
+    //Remove the folder which is not used for the longest time.
+    if(m_recentFolders.size()>m_maximumFolders)
+    {
+        QString removedFolder=m_recentFolders.takeFirst();
+        m_watcher->removePath(removedFolder);
+        m_folderIndexes.remove(removedFolder);
+    }
+    return index;
+}
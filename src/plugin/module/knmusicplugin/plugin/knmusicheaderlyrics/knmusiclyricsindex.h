@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICLYRICSINDEX_H
+#define KNMUSICLYRICSINDEX_H
+
+#include <QHash>
+#include <QStringList>
+
+#include <QObject>
+
+class QFileSystemWatcher;
+/*
+ * KNMusicLyricsIndex keeps the lyrics files of the folders in hash tables, a
+ * folder is listed once when it's searched at the first time, and it's listed
+ * again when the file system watcher reports that it's changed. The file names
+ * are normalized, so the names which are only different in the case, the
+ * spaces or the dashes between the artist, the album and the title will be
+ * found.
+ */
+class KNMusicLyricsIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KNMusicLyricsIndex(QObject *parent = 0);
+    //Return the lyrics file path of the name in the folder, or an empty
+    //string if there's no such file.
+    QString findLyrics(const QString &folderPath, const QString &name);
+    static QString normalizeName(const QString &name);
+
+signals:
+
+public slots:
+    void clear();
+
+private slots:
+    void onActionDirectoryChanged(const QString &path);
+
+private:
+    inline QHash<QString, QString> folderIndex(const QString &folderPath);
+    //The indexes of the recently used folders are kept, the others are removed
+    //to limit the number of the watched folders.
+    QHash<QString, QHash<QString, QString>> m_folderIndexes;
+    QStringList m_recentFolders;
+    QFileSystemWatcher *m_watcher;
+    int m_maximumFolders=64;
+};
+
+#endif // KNMUSICLYRICSINDEX_H
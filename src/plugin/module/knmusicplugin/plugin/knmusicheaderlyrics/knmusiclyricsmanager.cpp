@@ -17,6 +17,9 @@
  */
 #include <QFile>
 #include <QFileInfo>
+#include <QTextStream>
+#include <QThread>
+#include <QNetworkAccessManager>
 
 #include "plugin/knmusicttpodlyrics/knmusicttpodlyrics.h"
 #include "plugin/knmusicxiamilyrics/knmusicxiamilyrics.h"
@@ -24,7 +27,10 @@
 #include "plugin/knmusicbaidulyrics/knmusicbaidulyrics.h"
 #include "plugin/knmusicttplayerlyrics/knmusicttplayerlyrics.h"
 #include "sdk/knmusiclyricsglobal.h"
+#include "knglobal.h"
 #include "knmusiclrcparser.h"
+#include "knmusiclyricsindex.h"
+#include "knmusiclyricscache.h"
 
 #include "knmusiclyricsmanager.h"
 
@@ -37,71 +43,206 @@ KNMusicLyricsManager *KNMusicLyricsManager::instance()
     return m_instance==nullptr?m_instance=new KNMusicLyricsManager:m_instance;
 }
 
-int KNMusicLyricsManager::lines() const
+void KNMusicLyricsManager::destroyInstance()
 {
-    return m_positions.size();
+    if(m_instance==nullptr)
+    {
+        return;
+    }
+    m_instance->cancelLyrics();
+    QThread *lyricsThread=m_instance->thread();
+    if(lyricsThread==QThread::currentThread())
+    {
+        delete m_instance;
+        return;
+    }
+    //The network manager and the downloaders are used in the lyrics thread, the
+    //manager is deleted there before the thread is finished.
+    QMetaObject::invokeMethod(m_instance,
+                              "deleteLater",
+                              Qt::BlockingQueuedConnection);
+    lyricsThread->quit();
+    lyricsThread->wait();
 }
 
-bool KNMusicLyricsManager::isEmpty() const
+KNMusicLyricsManager::~KNMusicLyricsManager()
 {
-    return m_positions.isEmpty();
+    stopDownload();
+    m_instance=nullptr;
 }
 
-qint64 KNMusicLyricsManager::positionAt(const int &index) const
+int KNMusicLyricsManager::requestLyrics(const KNMusicDetailInfo &detailInfo)
 {
-    return m_positions.at(index);
+    //Replace the pending job, the previous one won't be loaded.
+    m_jobLock.lock();
+    int jobId=m_latestJob.fetchAndAddOrdered(1)+1;
+    m_pendingJob=jobId;
+    m_pendingDetailInfo=detailInfo;
+    m_jobLock.unlock();
+    //Stop the job which is downloading now, and process the new one in the
+    //thread of the manager.
+    emit requireAbortDownload();
+    QMetaObject::invokeMethod(this, "onActionProcessJobs", Qt::QueuedConnection);
+    return jobId;
 }
 
-QString KNMusicLyricsManager::lyricsAt(const int &index) const
+void KNMusicLyricsManager::cancelLyrics()
 {
-    return m_lyricsText.at(index);
+    //All the jobs before are not the latest one now.
+    m_latestJob.fetchAndAddOrdered(1);
+    emit requireAbortDownload();
 }
 
-bool KNMusicLyricsManager::loadLyricsForFile(const KNMusicDetailInfo &detailInfo)
+void KNMusicLyricsManager::onActionProcessJobs()
 {
-    //Clear the lyrics.
-    clear();
-    //Find the lyrics.
-    if(!findLyricsForFile(detailInfo))
+    //Take the pending job.
+    m_jobLock.lock();
+    int jobId=m_pendingJob;
+    KNMusicDetailInfo detailInfo=m_pendingDetailInfo;
+    m_pendingJob=0;
+    m_jobLock.unlock();
+    if(jobId==0 || isCancelled(jobId))
     {
-        if(m_downloadLyrics && !downloadLyricsForFile(detailInfo))
-        {
-            return false;
-        }
+        return;
+    }
+    //Stop the download of the previous job.
+    stopDownload();
+    //Find the lyrics, if there's no local lyrics, download it.
+    m_currentLyricsPath.clear();
+    if(findLyricsForFile(detailInfo))
+    {
+        emit lyricsLoaded(jobId, parseLyrics(m_currentLyricsPath));
+        return;
+    }
+    if(m_downloadLyrics)
+    {
+        startDownload(jobId, detailInfo);
     }
-    //Using parser to parse the file.
-    m_lrcParser->parseFile(m_currentLyricsPath,
-                           m_lyricsProperty,
-                           m_positions,
-                           m_lyricsText);
-    return !m_positions.isEmpty();
 }
 
-inline void KNMusicLyricsManager::installDownloaders()
+void KNMusicLyricsManager::onActionAbortDownload()
+{
+    //Stop the download of the cancelled job.
+    if(m_downloadJob!=0 && isCancelled(m_downloadJob))
+    {
+        stopDownload();
+    }
+}
+
+void KNMusicLyricsManager::onActionLyricsDownloaded(const QString &content)
 {
-    ;
-    installLyricsDownloader(new KNMusicQQLyrics);
-    installLyricsDownloader(new KNMusicTTPodLyrics);
-    installLyricsDownloader(new KNMusicXiaMiLyrics);
-    installLyricsDownloader(new KNMusicTTPlayerLyrics);
-    installLyricsDownloader(new KNMusicBaiduLyrics);
+    //Ignore the result after the download is finished.
+    if(m_downloadJob==0)
+    {
+        return;
+    }
+    if(isCancelled(m_downloadJob))
+    {
+        stopDownload();
+        return;
+    }
+    m_downloadRemain--;
+    //Keep the best lyrics, the downloaders which are installed first have the
+    //higher rank.
+    int quality=lyricsQuality(content, m_downloadDetailInfo),
+        rank=m_downloaders.indexOf(
+                static_cast<KNMusicLyricsDownloader *>(sender()));
+    if(quality>m_bestQuality ||
+            (quality==m_bestQuality && quality!=LyricsUnusable &&
+             rank<m_bestRank))
+    {
+        m_bestContent=content;
+        m_bestQuality=quality;
+        m_bestRank=rank;
+    }
+    //Use the first acceptable lyrics, or the best one when all the downloaders
+    //are finished.
+    if(quality==LyricsAcceptable || m_downloadRemain==0)
+    {
+        finishDownload();
+    }
 }
 
-void KNMusicLyricsManager::clear()
+void KNMusicLyricsManager::prefetchLyrics(const KNMusicDetailInfo &detailInfo)
 {
-    //Remove the file path.
+    //Index the folders of the music, the lyrics will be found in the hash
+    //tables when it's played.
     m_currentLyricsPath.clear();
-    //Remove the old properties.
-    m_lyricsProperty.clear();
-    //Remove all the positions and the texts.
-    m_positions.clear();
-    m_lyricsText.clear();
+    if(!findLyricsForFile(detailInfo))
+    {
+        return;
+    }
+    //Don't delay the lyrics which is waiting to be loaded.
+    m_jobLock.lock();
+    bool jobPending=(m_pendingJob!=0);
+    m_jobLock.unlock();
+    if(jobPending)
+    {
+        return;
+    }
+    //Parse the lyrics now, it will be loaded from the lyrics cache when the
+    //song is played.
+    parseLyrics(m_currentLyricsPath);
+}
+
+inline bool KNMusicLyricsManager::isCancelled(const int &jobId)
+{
+    return jobId!=m_latestJob.loadAcquire();
+}
+
+inline KNMusicLyricsData KNMusicLyricsManager::parseLyrics(const QString &lyricsPath)
+{
+    //Load the parsed lyrics from the cache.
+    KNMusicLyricsData lyrics;
+    if(m_lyricsCache->loadLyrics(lyricsPath, lyrics))
+    {
+        return lyrics;
+    }
+    //Using parser to parse the file.
+    QMap<int, QString> properties;
+    QVector<KNMusicLyricsLine> lines;
+    QVector<KNMusicLyricsWord> words;
+    QString lyricsText;
+    m_lrcParser->parseFile(lyricsPath,
+                           properties,
+                           lines,
+                           words,
+                           lyricsText);
+    lyrics=KNMusicLyricsData(lyricsPath,
+                             properties,
+                             lines,
+                             words,
+                             lyricsText);
+    //Save the lyrics to the cache.
+    if(!lyrics.isEmpty())
+    {
+        m_lyricsCache->saveLyrics(lyrics);
+    }
+    return lyrics;
+}
+
+inline void KNMusicLyricsManager::installDownloaders()
+{
+    //The downloaders are moved to the lyrics thread with the manager.
+    installLyricsDownloader(new KNMusicQQLyrics(this));
+    installLyricsDownloader(new KNMusicTTPodLyrics(this));
+    installLyricsDownloader(new KNMusicXiaMiLyrics(this));
+    installLyricsDownloader(new KNMusicTTPlayerLyrics(this));
+    installLyricsDownloader(new KNMusicBaiduLyrics(this));
 }
 
 void KNMusicLyricsManager::installLyricsDownloader(KNMusicLyricsDownloader *downloader)
 {
-    //Add the downloader to linked list.
+    //Add the downloader to the list, it shares the network access manager.
     m_downloaders.append(downloader);
+    downloader->setNetworkManager(m_networkManager);
+    connect(downloader, &KNMusicLyricsDownloader::downloaded,
+            this, &KNMusicLyricsManager::onActionLyricsDownloaded);
+}
+
+QList<KNMusicLyricsDownloader *> KNMusicLyricsManager::downloaders() const
+{
+    return m_downloaders;
 }
 
 inline bool KNMusicLyricsManager::findLyricsForFile(const KNMusicDetailInfo &detailInfo)
@@ -117,8 +258,8 @@ inline bool KNMusicLyricsManager::findLyricsForFile(const KNMusicDetailInfo &det
         switch (m_policyList.at(currentPolicy))
         {
         case SameNameInLyricsDir:
-            if(checkLyricsFile(KNMusicLyricsGlobal::lyricsFolderPath() + "/" +
-                               musicInfo.completeBaseName()+".lrc"))
+            if(checkLyricsFile(KNMusicLyricsGlobal::lyricsFolderPath(),
+                               musicInfo.completeBaseName()))
             {
                 return true;
             }
@@ -130,8 +271,8 @@ inline bool KNMusicLyricsManager::findLyricsForFile(const KNMusicDetailInfo &det
             }
             break;
         case SameNameInMusicDir:
-            if(checkLyricsFile(musicInfo.absolutePath() + "/" +
-                               musicInfo.completeBaseName()+".lrc"))
+            if(checkLyricsFile(musicInfo.absolutePath(),
+                               musicInfo.completeBaseName()))
             {
                 return true;
             }
@@ -150,49 +291,115 @@ inline bool KNMusicLyricsManager::findLyricsForFile(const KNMusicDetailInfo &det
     return false;
 }
 
-inline bool KNMusicLyricsManager::downloadLyricsForFile(const KNMusicDetailInfo &detailInfo)
+inline void KNMusicLyricsManager::startDownload(const int &jobId,
+                                                const KNMusicDetailInfo &detailInfo)
 {
-    //Using the downloader to download the lyrics.
-    for(QLinkedList<KNMusicLyricsDownloader *>::iterator i=m_downloaders.begin();
+    m_downloadJob=jobId;
+    m_downloadDetailInfo=detailInfo;
+    m_downloadRemain=m_downloaders.size();
+    m_bestContent.clear();
+    m_bestQuality=LyricsUnusable;
+    m_bestRank=-1;
+    //Start all the downloaders.
+    for(QList<KNMusicLyricsDownloader *>::iterator i=m_downloaders.begin();
         i!=m_downloaders.end();
         ++i)
     {
-        //Try to download the file from server.
-        QString downloadedFilePath=(*i)->downloadLyrics(detailInfo);
-        //If download success.
-        if(!downloadedFilePath.isEmpty())
+        (*i)->download(detailInfo);
+    }
+}
+
+inline void KNMusicLyricsManager::stopDownload()
+{
+    //Abort the requests which are not finished.
+    m_downloadJob=0;
+    for(QList<KNMusicLyricsDownloader *>::iterator i=m_downloaders.begin();
+        i!=m_downloaders.end();
+        ++i)
+    {
+        (*i)->abort();
+    }
+}
+
+inline void KNMusicLyricsManager::finishDownload()
+{
+    int jobId=m_downloadJob;
+    stopDownload();
+    if(m_bestQuality==LyricsUnusable)
+    {
+        return;
+    }
+    //Save the lyrics to the lyrics folder, and load it.
+    QString lyricsPath=writeLyricsFile(m_downloadDetailInfo, m_bestContent);
+    if(!lyricsPath.isEmpty())
+    {
+        emit lyricsLoaded(jobId, parseLyrics(lyricsPath));
+    }
+}
+
+inline int KNMusicLyricsManager::lyricsQuality(const QString &content,
+                                               const KNMusicDetailInfo &detailInfo)
+{
+    //The lyrics without any time tag can't be displayed.
+    if(!content.contains(m_timeTag))
+    {
+        return LyricsUnusable;
+    }
+    //If the title tag is not the title of the music, it may be the lyrics of
+    //another song.
+    QRegularExpressionMatch titleMatch=m_titleTag.match(content);
+    if(titleMatch.hasMatch())
+    {
+        QString lyricsTitle=titleMatch.captured(1).simplified().toLower(),
+                musicTitle=detailInfo.textLists[Name].simplified().toLower();
+        if(!lyricsTitle.isEmpty() && !musicTitle.isEmpty() &&
+                !lyricsTitle.contains(musicTitle) &&
+                !musicTitle.contains(lyricsTitle))
         {
-            //Load the file.
-            if(checkLyricsFile(downloadedFilePath))
-            {
-                return true;
-            }
-            //Or else, we need to delete this file.
-            QFile removedFile(downloadedFilePath);
-            removedFile.remove();
+            return LyricsMismatched;
         }
     }
-    return false;
+    return LyricsAcceptable;
 }
 
-inline bool KNMusicLyricsManager::checkLyricsFile(const QString &lyricsPath)
+inline QString KNMusicLyricsManager::writeLyricsFile(const KNMusicDetailInfo &detailInfo,
+                                                     const QString &content)
 {
-    QFile testFile(lyricsPath);
-    if(testFile.exists())
+    //Get the complete base file name of the original file.
+    QFileInfo musicFileInfo(detailInfo.filePath);
+    //Generate the lyrics file path
+    QString lyricsFilePath=KNMusicLyricsGlobal::lyricsFolderPath() + "/" +
+            musicFileInfo.completeBaseName() + ".lrc";
+    QFile lyricsFile(lyricsFilePath);
+    //Try to open the file.
+    if(lyricsFile.open(QIODevice::WriteOnly))
     {
-        m_currentLyricsPath=QFileInfo(testFile).absoluteFilePath();
-        return true;
+        //Write the data to the file.
+        QTextStream lyricsStream(&lyricsFile);
+        lyricsStream << content << flush;
+        //Close the file.
+        lyricsFile.close();
+        //Return the file path.
+        return QFileInfo(lyricsFile).absoluteFilePath();
     }
-    return false;
+    return QString();
+}
+
+inline bool KNMusicLyricsManager::checkLyricsFile(const QString &folderPath,
+                                                  const QString &name)
+{
+    //Find the file in the index of the folder instead of checking the file.
+    m_currentLyricsPath=m_lyricsIndex->findLyrics(folderPath, name);
+    return !m_currentLyricsPath.isEmpty();
 }
 
 inline bool KNMusicLyricsManager::findRelateLyrics(const QString &folderPath,
                                             const KNMusicDetailInfo &detailInfo)
 {
     //Find the title, the artist and the title, the album and the title.
-    return checkLyricsFile(folderPath+"/"+detailInfo.textLists[Name]+".lrc") ||
-            checkLyricsFile(folderPath+"/"+detailInfo.textLists[Artist]+" - "+detailInfo.textLists[Name]+".lrc") ||
-            checkLyricsFile(folderPath+"/"+detailInfo.textLists[Album]+" - "+detailInfo.textLists[Name]+".lrc");
+    return checkLyricsFile(folderPath, detailInfo.textLists[Name]) ||
+            checkLyricsFile(folderPath, detailInfo.textLists[Artist]+" - "+detailInfo.textLists[Name]) ||
+            checkLyricsFile(folderPath, detailInfo.textLists[Album]+" - "+detailInfo.textLists[Name]);
 }
 
 KNMusicLyricsManager::KNMusicLyricsManager(QObject *parent) :
@@ -211,6 +418,30 @@ KNMusicLyricsManager::KNMusicLyricsManager(QObject *parent) :
 
     //Initial the LRC file parser.
     m_lrcParser=new KNMusicLRCParser(this);
+    //Initial the index of the lyrics files.
+    m_lyricsIndex=new KNMusicLyricsIndex(this);
+    //Initial the cache of the parsed lyrics.
+    m_lyricsCache=new KNMusicLyricsCache(this);
+    m_lyricsCache->setCacheFolderPath(
+                KNGlobal::ensurePathAvaliable(KNMusicGlobal::musicLibraryPath()+
+                                              "/Library/LyricsCache"));
+    //Initial the lyrics checkers.
+    m_timeTag.setPattern("\\[\\d+:\\d+");
+    m_titleTag.setPattern("\\[ti:([^\\]]*)\\]");
+    m_titleTag.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+    //The abort request is sent from the other threads.
+    connect(this, &KNMusicLyricsManager::requireAbortDownload,
+            this, &KNMusicLyricsManager::onActionAbortDownload,
+            Qt::QueuedConnection);
+
+    //Initial the network access manager, the downloaders download the lyrics
+    //with it. The requests can be sent to a local server for testing.
+    m_networkManager=new QNetworkAccessManager(this);
+    KNMusicLyricsDownloader::setServerOverride(
+                m_musicGlobal->configureData("LyricsServer",
+                                             QString()).toString());
+    //The lyrics are sent to the widgets in the other thread.
+    qRegisterMetaType<KNMusicLyricsData>("KNMusicLyricsData");
 
     //Install the downloaders.
     installDownloaders();
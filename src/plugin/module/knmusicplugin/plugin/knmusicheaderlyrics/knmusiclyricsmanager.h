@@ -20,10 +20,12 @@
 
 #include <QFile>
 #include <QMap>
-#include <QLinkedList>
 #include <QStringList>
+#include <QMutex>
+#include <QRegularExpression>
 
 #include "sdk/knmusiclyricsdownloader.h"
+#include "knmusiclyricsdata.h"
 
 #include "knmusicglobal.h"
 
@@ -38,6 +40,12 @@ enum SearchPolicy
     SameNameInMusicDir,
     RelateNameInMusicDir
 };
+enum LyricsQuality
+{
+    LyricsUnusable,
+    LyricsMismatched,
+    LyricsAcceptable
+};
 }
 
 using namespace KNMusic;
@@ -48,34 +56,58 @@ class KNPreferenceItemBase;
 class KNPreferenceItemGlobal;
 class KNMusicGlobal;
 class KNMusicLRCParser;
+class KNMusicLyricsIndex;
+class KNMusicLyricsCache;
+class QNetworkAccessManager;
 class KNMusicLyricsManager : public QObject
 {
     Q_OBJECT
 public:
     static KNMusicLyricsManager *instance();
-    int lines() const;
-    bool isEmpty() const;
-    qint64 positionAt(const int &index) const;
-    QString lyricsAt(const int &index) const;
+    static void destroyInstance();
+    ~KNMusicLyricsManager();
     QString lyricsFolderPath() const;
-    void setLyricsFolderPath(const QString &lyricsFolderPath);
-    void clear();
     void installLyricsDownloader(KNMusicLyricsDownloader *downloader);
+    QList<KNMusicLyricsDownloader *> downloaders() const;
     bool downloadLyrics() const;
-    void setDownloadLyrics(bool downloadLyrics);
+    //These can be called from any thread. The lyrics are loaded in the thread
+    //of the manager, the request returns the id of the job immediately, the
+    //lyrics will be sent with the id by lyricsLoaded(). A new request cancels
+    //the previous job.
+    int requestLyrics(const KNMusicDetailInfo &detailInfo);
+    void cancelLyrics();
 
 signals:
+    void lyricsLoaded(int jobId, KNMusicLyricsData lyrics);
+    void requireAbortDownload();
 
 public slots:
-    bool loadLyricsForFile(const KNMusicDetailInfo &detailInfo);
+    void prefetchLyrics(const KNMusicDetailInfo &detailInfo);
+    //The settings are used by the jobs, they should be changed in the thread
+    //of the manager, use a queued connection when it's moved to a thread.
+    void setLyricsFolderPath(const QString &lyricsFolderPath);
+    void setDownloadLyrics(bool downloadLyrics);
 
 private slots:
+    void onActionProcessJobs();
+    void onActionAbortDownload();
+    void onActionLyricsDownloaded(const QString &content);
 
 private:
+    inline bool isCancelled(const int &jobId);
+    inline KNMusicLyricsData parseLyrics(const QString &lyricsPath);
     inline void installDownloaders();
     inline bool findLyricsForFile(const KNMusicDetailInfo &detailInfo);
-    inline bool downloadLyricsForFile(const KNMusicDetailInfo &detailInfo);
-    inline bool checkLyricsFile(const QString &lyricsPath);
+    inline void startDownload(const int &jobId,
+                              const KNMusicDetailInfo &detailInfo);
+    inline void stopDownload();
+    inline void finishDownload();
+    inline int lyricsQuality(const QString &content,
+                             const KNMusicDetailInfo &detailInfo);
+    inline QString writeLyricsFile(const KNMusicDetailInfo &detailInfo,
+                                   const QString &content);
+    inline bool checkLyricsFile(const QString &folderPath,
+                                const QString &name);
     inline bool findRelateLyrics(const QString &folderPath,
                                  const KNMusicDetailInfo &detailInfo);
     static KNMusicLyricsManager *m_instance;
@@ -83,14 +115,28 @@ private:
 
     KNMusicGlobal *m_musicGlobal;
     KNMusicLRCParser *m_lrcParser;
+    KNMusicLyricsIndex *m_lyricsIndex;
+    KNMusicLyricsCache *m_lyricsCache;
     QString m_currentLyricsPath;
-    QFile m_lyricsFile;
     QList<int> m_policyList;
+    //All the downloaders download the lyrics at the same time with the same
+    //network access manager. The download is finished when an acceptable
+    //lyrics is downloaded, or all the downloaders are finished, the
+    //downloader installed first wins when the qualities are the same.
+    QList<KNMusicLyricsDownloader *> m_downloaders;
+    QNetworkAccessManager *m_networkManager;
+    QRegularExpression m_timeTag, m_titleTag;
+    KNMusicDetailInfo m_downloadDetailInfo;
+    QString m_bestContent;
+    int m_downloadJob=0, m_downloadRemain=0,
+        m_bestQuality=LyricsUnusable, m_bestRank=-1;
 
-    QList<qint64> m_positions;
-    QStringList m_lyricsText;
-    QMap<int, QString> m_lyricsProperty;
-    QLinkedList<KNMusicLyricsDownloader *> m_downloaders;
+    //Only the latest job is kept, the job which is not the latest one is
+    //cancelled.
+    QMutex m_jobLock;
+    QAtomicInt m_latestJob;
+    int m_pendingJob=0;
+    KNMusicDetailInfo m_pendingDetailInfo;
 
     bool m_downloadLyrics=true;
 };
@@ -29,7 +29,7 @@ KNMusicBaiduLyrics::KNMusicBaiduLyrics(QObject *parent):
     m_gbkCodec=QTextCodec::codecForName("GBK");
 }
 
-QString KNMusicBaiduLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
+void KNMusicBaiduLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
 {
     //Generate the song info base url.
     QString url="http://box.zhangmen.baidu.com/x?title=" +
@@ -37,36 +37,31 @@ QString KNMusicBaiduLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
             "$$" +
             processKeywords(detailInfo.textLists[Artist]).toUtf8().toPercentEncoding() +
             "$$$$&op=12&count=1&format=json";
-    QByteArray responseData;
     //Get the data.
-    get(url, responseData);
-    if(responseData.isEmpty())
+    get(url, [=](const QByteArray &responseData)
     {
-        return QString();
-    }
-
-    //Find lyric id.
-    QString responseText=responseData;
-    QRegularExpression lyricsID("<lrcid>([0-9]*)</lrcid>");
-    QRegularExpressionMatchIterator i=lyricsID.globalMatch(responseText);
-    if(!i.hasNext())
-    {
-        return QString();
-    }
-    //Use the first id.
-    QString currentID=i.next().captured(1),
-            lyricsUrl="http://box.zhangmen.baidu.com/bdlrc/" +
-                      QString::number(currentID.toLongLong()/100) +
-                      "/"+
-                      currentID+
-                      ".lrc";
-    //Get the lyrics!
-    get(lyricsUrl, responseData);
-    if(responseData.isEmpty())
-    {
-        return QString();
-    }
-    //Change the codec from GBK to UTF-8.
-    return writeLyricsFile(detailInfo,
-                           m_gbkCodec->toUnicode(responseData));
+        //Find lyric id.
+        QString responseText=responseData;
+        QRegularExpression lyricsID("<lrcid>([0-9]*)</lrcid>");
+        QRegularExpressionMatchIterator i=lyricsID.globalMatch(responseText);
+        if(!i.hasNext())
+        {
+            finish();
+            return;
+        }
+        //Use the first id.
+        QString currentID=i.next().captured(1),
+                lyricsUrl="http://box.zhangmen.baidu.com/bdlrc/" +
+                          QString::number(currentID.toLongLong()/100) +
+                          "/"+
+                          currentID+
+                          ".lrc";
+        //Get the lyrics!
+        get(lyricsUrl, [=](const QByteArray &lyricsData)
+        {
+            //Change the codec from GBK to UTF-8.
+            finish(lyricsData.isEmpty()?
+                       QString():m_gbkCodec->toUnicode(lyricsData));
+        });
+    });
 }
@@ -29,7 +29,9 @@ public:
     {
         return "Baidu Music";
     }
-    QString downloadLyrics(const KNMusicDetailInfo &detailInfo);
+
+protected:
+    void downloadLyrics(const KNMusicDetailInfo &detailInfo);
 
 private:
     QTextCodec *m_gbkCodec;
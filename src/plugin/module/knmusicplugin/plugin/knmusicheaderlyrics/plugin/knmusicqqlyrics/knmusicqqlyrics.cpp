@@ -30,80 +30,81 @@ KNMusicQQLyrics::KNMusicQQLyrics(QObject *parent) :
     m_gbkCodec=QTextCodec::codecForName("GBK");
 }
 
-QString KNMusicQQLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
+void KNMusicQQLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
 {
     //Generate the url and get the data from the url.
     QString url="http://qqmusic.qq.com/fcgi-bin/qm_getLyricId.fcg?name="+
             processKeywordsToGBK(detailInfo.textLists[Name])+"&singer="+
             processKeywordsToGBK(detailInfo.textLists[Artist])+"&from=qqplayer";
-    QByteArray responseData;
-    get(url, responseData);
-    //Check the response.
-    if(responseData.isEmpty())
+    get(url, [=](const QByteArray &responseData)
     {
-        return QString();
-    }
-    //Tencent use GBK as default codec, translate the data to UTF-8, parse it
-    //with DomDocument.
-    QDomDocument xmlDoc;
-    xmlDoc.setContent(m_gbkCodec->toUnicode(responseData));
-    //To find whether it contains song info.
-    QDomNodeList songInfoList=xmlDoc.elementsByTagName("songinfo");
-    if(songInfoList.isEmpty())
-    {
-        return QString();
-    }
-    //Get the song id from the song info.
-    QStringList songIDList;
-    for(int i=0; i<songInfoList.length(); i++)
-    {
-        //Ensure the song info is available.
-        QDomElement currentSongInfo=songInfoList.at(i).toElement();
-        if(currentSongInfo.isNull())
+        //Check the response.
+        if(responseData.isEmpty())
         {
-            continue;
+            finish();
+            return;
         }
-        //Ensure the id is not empty.
-        QString currentID=currentSongInfo.attribute("id");
-        if(!currentID.isEmpty())
+        //Tencent use GBK as default codec, translate the data to UTF-8, parse
+        //it with DomDocument.
+        QDomDocument xmlDoc;
+        xmlDoc.setContent(m_gbkCodec->toUnicode(responseData));
+        //To find whether it contains song info.
+        QDomNodeList songInfoList=xmlDoc.elementsByTagName("songinfo");
+        //Get the song id from the song info.
+        QStringList songIDList;
+        for(int i=0; i<songInfoList.length(); i++)
         {
-            songIDList.append(currentID);
+            //Ensure the song info is available.
+            QDomElement currentSongInfo=songInfoList.at(i).toElement();
+            if(currentSongInfo.isNull())
+            {
+                continue;
+            }
+            //Ensure the id is not empty.
+            QString currentID=currentSongInfo.attribute("id");
+            if(!currentID.isEmpty())
+            {
+                songIDList.append(currentID);
+            }
         }
-    }
+        //Get the detail data for each song.
+        downloadSongLyrics(songIDList);
+    });
+}
+
+void KNMusicQQLyrics::downloadSongLyrics(QStringList songIDList)
+{
     //Check if the song id is empty.
     if(songIDList.isEmpty())
     {
-        return QString();
+        finish();
+        return;
     }
-    //Get the detail data for each song.
-    for(QStringList::iterator i=songIDList.begin();
-        i!=songIDList.end();
-        ++i)
+    QString songID=songIDList.takeFirst();
+    get(generateRequestString(songID), [=](const QByteArray &responseData)
     {
-        get(generateRequestString(*i), responseData);
         //Check the response data is empty or not.
-        if(responseData.isEmpty())
-        {
-            continue;
-        }
-        //Parse the response data.
-        QString xml_text=m_gbkCodec->toUnicode(responseData);
-        xmlDoc.setContent(xml_text);
-        //Find the lyrics.
-        QDomNodeList lr=xmlDoc.elementsByTagName("lyric");
-        if(lr.isEmpty())
+        if(!responseData.isEmpty())
         {
-            continue;
+            //Parse the response data.
+            QDomDocument xmlDoc;
+            xmlDoc.setContent(m_gbkCodec->toUnicode(responseData));
+            //Find the lyrics.
+            QDomNodeList lr=xmlDoc.elementsByTagName("lyric");
+            if(!lr.isEmpty())
+            {
+                QString lyricsContent=
+                        lr.at(0).childNodes().at(0).toText().data();
+                if(!lyricsContent.isEmpty())
+                {
+                    finish(lyricsContent);
+                    return;
+                }
+            }
         }
-        QString lyricsContent=lr.at(0).childNodes().at(0).toText().data();
-        if(lyricsContent.isEmpty())
-        {
-            continue;
-        }
-        //Write the lyrics and return the file name.
-        return writeLyricsFile(detailInfo, lyricsContent);
-    }
-    return QString();
+        //Try the next song.
+        downloadSongLyrics(songIDList);
+    });
 }
 
 inline QString KNMusicQQLyrics::processKeywordsToGBK(const QString &keywords)
@@ -29,13 +29,16 @@ public:
     {
         return "QQ Music";
     }
-    QString downloadLyrics(const KNMusicDetailInfo &detailInfo);
 
 signals:
 
 public slots:
 
+protected:
+    void downloadLyrics(const KNMusicDetailInfo &detailInfo);
+
 private:
+    void downloadSongLyrics(QStringList songIDList);
     inline QString processKeywordsToGBK(const QString &keywords);
     inline QString generateRequestString(const QString &id);
     QTextCodec *m_gbkCodec;
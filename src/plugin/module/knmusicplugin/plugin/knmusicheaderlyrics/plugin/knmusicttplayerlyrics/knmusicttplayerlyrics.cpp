@@ -34,7 +34,7 @@ KNMusicTTPlayerLyrics::~KNMusicTTPlayerLyrics()
 
 }
 
-QString KNMusicTTPlayerLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
+void KNMusicTTPlayerLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
 {
     //Another address: http://ttlrccnc.qianqian.com
     QString queryUrl="http://ttlrcct.qianqian.com"
@@ -44,49 +44,52 @@ QString KNMusicTTPlayerLyrics::downloadLyrics(const KNMusicDetailInfo &detailInf
                      utf16LEHex(processKeywords(detailInfo.textLists[Name])) +
                      "&Flags=0";
     //Get the xml data from the url.
-    QByteArray responseData;
-    get(queryUrl, responseData);
-    //Found song lyrics info.
-    QDomDocument songInfoDocument;
-    songInfoDocument.setContent(responseData);
-    QDomNodeList lyrics=songInfoDocument.documentElement().elementsByTagName("lrc");
-    if(lyrics.isEmpty())
+    get(queryUrl, [=](const QByteArray &responseData)
     {
-        return QString();
-    }
-    //Save the ids.
-    QList<QHash<QString, QString>> lyricsInfoList;
-    for(int i=0; i<lyrics.size(); i++)
+        //Found song lyrics info.
+        QDomDocument songInfoDocument;
+        songInfoDocument.setContent(responseData);
+        QDomNodeList lyrics=
+                songInfoDocument.documentElement().elementsByTagName("lrc");
+        //Generate the download urls with the ids.
+        QStringList downloadUrlList;
+        for(int i=0; i<lyrics.size(); i++)
+        {
+            QDomElement currentLyrics=lyrics.at(i).toElement();
+            //Generate the lyrics info.
+            QHash<QString, QString> lyricsInfo;
+            lyricsInfo.insert("title", currentLyrics.attribute("title"));
+            lyricsInfo.insert("artist", currentLyrics.attribute("artist"));
+            lyricsInfo.insert("id", currentLyrics.attribute("id"));
+            downloadUrlList.append("http://ttlrcct.qianqian.com"
+                                   "/dll/lyricsvr.dll?dl?Id=" +
+                                   lyricsInfo.value("id") +
+                                   "&Code="+
+                                   generateCode(lyricsInfo));
+        }
+        downloadLyricsFile(downloadUrlList);
+    });
+}
+
+void KNMusicTTPlayerLyrics::downloadLyricsFile(QStringList downloadUrlList)
+{
+    if(downloadUrlList.isEmpty())
     {
-        QDomElement currentLyrics=lyrics.at(i).toElement();
-        //Generate the lyrics info.
-        QHash<QString, QString> lyricsInfo;
-        lyricsInfo.insert("title", currentLyrics.attribute("title"));
-        lyricsInfo.insert("artist", currentLyrics.attribute("artist"));
-        lyricsInfo.insert("id", currentLyrics.attribute("id"));
-        //Add to lyrics info.
-        lyricsInfoList.append(lyricsInfo);
+        finish();
+        return;
     }
-    //Download lyrics.
-    for(QList<QHash<QString, QString>>::iterator i=lyricsInfoList.begin();
-        i!=lyricsInfoList.end();
-        ++i)
+    //Download data.
+    QString downloadUrl=downloadUrlList.takeFirst();
+    get(downloadUrl, [=](const QByteArray &responseData)
     {
-        QString downloadUrl="http://ttlrcct.qianqian.com"
-                            "/dll/lyricsvr.dll?dl?Id=" +
-                            (*i).value("id") +
-                            "&Code="+
-                            generateCode(*i);
-        //Download data.
-        get(downloadUrl, responseData);
-//        qDebug()<<responseData;
         if(!responseData.isEmpty() &&
                 !responseData.contains("errmsg"))
         {
-            return writeLyricsFile(detailInfo, responseData);
+            finish(responseData);
+            return;
         }
-    }
-    return QString();
+        downloadLyricsFile(downloadUrlList);
+    });
 }
 
 inline QString KNMusicTTPlayerLyrics::generateCode(const QHash<QString, QString> &info)
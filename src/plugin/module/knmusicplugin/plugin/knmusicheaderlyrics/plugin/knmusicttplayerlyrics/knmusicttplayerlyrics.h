@@ -30,9 +30,12 @@ public:
     {
         return "TTPlayer";
     }
-    QString downloadLyrics(const KNMusicDetailInfo &detailInfo);
+
+protected:
+    void downloadLyrics(const KNMusicDetailInfo &detailInfo);
 
 private:
+    void downloadLyricsFile(QStringList downloadUrlList);
     struct lrcInfo
     {
         QString id;
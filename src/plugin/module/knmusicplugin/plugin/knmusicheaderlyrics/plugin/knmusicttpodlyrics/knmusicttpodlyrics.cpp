@@ -70,67 +70,59 @@ KNMusicTTPodLyrics::~KNMusicTTPodLyrics()
     ;
 }
 
-QString KNMusicTTPodLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
+void KNMusicTTPodLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
 {
     QString searchUrl="http://so.ard.iyyin.com/search.do?q=" +
                       processKeywords(detailInfo.textLists[Name]) +
                       "+" +
                       processKeywords(detailInfo.textLists[Artist]);
-    QByteArray responseData;
     //Get the response from URL.
-    get(searchUrl, responseData);
-    //Check the response data.
-    if(responseData.isEmpty())
+    get(searchUrl, [=](const QByteArray &responseData)
     {
-        return QString();
-    }
-    //Get the data, and parse the json.
-    QJsonDocument songInfoList=QJsonDocument::fromJson(responseData);
-    if(songInfoList.isNull())
+        //Get the data, and parse the json.
+        QJsonDocument songInfoList=QJsonDocument::fromJson(responseData);
+        //Get the 'data' to from the base object.
+        QJsonArray songListData=songInfoList.object().value("data").toArray();
+        QStringList downloadUrlList;
+        for(QJsonArray::iterator i=songListData.begin();
+            i!=songListData.end();
+            ++i)
+        {
+            QJsonObject currentObject=(*i).toObject();
+            //Generate the URL.
+            downloadUrlList.append("http://lp.music.ttpod.com/lrc/down?artist=" +
+                                   currentObject.value("singerName").toString() +
+                                   "&title=" +
+                                   currentObject.value("songName").toString() +
+                                   "&code=" +
+                                   process_code(currentObject.value("neid").toVariant()));
+        }
+        downloadLyricsFile(downloadUrlList);
+    });
+}
+
+void KNMusicTTPodLyrics::downloadLyricsFile(QStringList downloadUrlList)
+{
+    if(downloadUrlList.isEmpty())
     {
-        return QString();
+        finish();
+        return;
     }
-    //Get the 'data' to from the base object.
-    QJsonArray songListData=songInfoList.object().value("data").toArray();
-    for(QJsonArray::iterator i=songListData.begin();
-        i!=songListData.end();
-        ++i)
+    //Get the data from the download URL.
+    QString downloadUrl=downloadUrlList.takeFirst();
+    get(downloadUrl, [=](const QByteArray &responseData)
     {
-        QJsonObject currentObject=(*i).toObject();
-        //Generate the URL.
-        QString downloadURL="http://lp.music.ttpod.com/lrc/down?artist=" +
-                            currentObject.value("singerName").toString() +
-                            "&title=" +
-                            currentObject.value("songName").toString() +
-                            "&code=" +
-                            process_code(currentObject.value("neid").toVariant());
-        //Get the data from the download URL.
-        get(downloadURL, responseData);
-        //Check the response data.
-        if(!responseData.isEmpty())
+        //Get the lrc in the data object in the lyrics object.
+        QJsonObject dataObject=QJsonDocument::fromJson(responseData).object()
+                .value("data").toObject();
+        QString lrcText=dataObject.value("lrc").toString();
+        if(!lrcText.isEmpty())
         {
-            QJsonDocument lyricsDocument=QJsonDocument::fromJson(responseData);
-            //Get the data object from the document.
-            QJsonObject lyricsObject=lyricsDocument.object();
-            if(lyricsObject.isEmpty())
-            {
-                continue;
-            }
-            //Get the lrc in the data object in the lyrics object.
-            QJsonObject dataObject=lyricsObject.value("data").toObject();
-            if(dataObject.isEmpty())
-            {
-                continue;
-            }
-            QString lrcText=dataObject.value("lrc").toString();
-            if(!lrcText.isEmpty())
-            {
-                return writeLyricsFile(detailInfo,
-                                       lrcText);
-            }
+            finish(lrcText);
+            return;
         }
-    }
-    return QString();
+        downloadLyricsFile(downloadUrlList);
+    });
 }
 
 inline QString KNMusicTTPodLyrics::process_code(const QVariant &str)
@@ -29,9 +29,12 @@ public:
     {
         return "TTPod";
     }
-    QString downloadLyrics(const KNMusicDetailInfo &detailInfo);
+
+protected:
+    void downloadLyrics(const KNMusicDetailInfo &detailInfo);
 
 private:
+    void downloadLyricsFile(QStringList downloadUrlList);
     inline QString process_code(const QVariant &str);
     inline qint32 crc32(const QString &str);
     inline QString utf8HexText(const QString &original);
@@ -28,37 +28,42 @@ KNMusicXiaMiLyrics::KNMusicXiaMiLyrics(QObject *parent) :
 
 }
 
-QString KNMusicXiaMiLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
+void KNMusicXiaMiLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
 {
     //Generate the url.
     QString url="http://www.xiami.com/search/song-lyric?key=" +
                 processKeywords(detailInfo.textLists[Name]);
     //Get the data from url.
-    QByteArray responseData;
-    get(url, responseData);
-    if(responseData.isEmpty())
+    get(url, [=](const QByteArray &responseData)
     {
-        return QString();
-    }
-    QString xmlhttpText=responseData;
-    //Parse the data.
-    QStringList songid;
-    QRegularExpression rex("<a.*?href=\".*?/song/(\\d+).*?><b.*?key_red");
-    QRegularExpressionMatchIterator i=rex.globalMatch(xmlhttpText);
-    while(i.hasNext())
+        QString xmlhttpText=responseData;
+        //Parse the data.
+        QStringList songid;
+        QRegularExpression rex("<a.*?href=\".*?/song/(\\d+).*?><b.*?key_red");
+        QRegularExpressionMatchIterator i=rex.globalMatch(xmlhttpText);
+        while(i.hasNext())
+        {
+            QRegularExpressionMatch match=i.next();
+            songid.append(match.captured(1));
+        }
+        downloadPlaylist(songid);
+    });
+}
+
+void KNMusicXiaMiLyrics::downloadPlaylist(QStringList songIDList)
+{
+    if(songIDList.isEmpty())
     {
-        QRegularExpressionMatch match=i.next();
-        songid.append(match.captured(1));
+        finish();
+        return;
     }
-    for(QStringList::iterator i=songid.begin();
-        i!=songid.end();
-        ++i)
+    QString songID=songIDList.takeFirst();
+    get("http://www.xiami.com/song/playlist/id/"+songID,
+        [=](const QByteArray &responseData)
     {
-        url="http://www.xiami.com/song/playlist/id/"+(*i);
-        get(url, responseData);
+        QStringList lyricsUrlList;
         if(!responseData.isEmpty())
         {
-            QStringList lyricsUrlList;
             //Parse the document.
             QDomDocument lyricsDocument;
             lyricsDocument.setContent(responseData);
@@ -81,22 +86,30 @@ QString KNMusicXiaMiLyrics::downloadLyrics(const KNMusicDetailInfo &detailInfo)
                     }
                 }
             }
-
-            //Try to download the lyrics.
-            for(QStringList::iterator i=lyricsUrlList.begin();
-                i!=lyricsUrlList.end();
-                ++i)
-            {
-                //Get the data from the url.
-                get((*i), responseData);
-                //This is the lyrics file! Write it to the file, return the file name.
-                if(!responseData.isEmpty())
-                {
-                    return writeLyricsFile(detailInfo, responseData);
-                }
-            }
         }
-    }
-    return QString();
+        //Try to download the lyrics.
+        downloadLyricsFile(lyricsUrlList, songIDList);
+    });
 }
 
+void KNMusicXiaMiLyrics::downloadLyricsFile(QStringList lyricsUrlList,
+                                            const QStringList &songIDList)
+{
+    //Try the next song when all the urls of the song are failed.
+    if(lyricsUrlList.isEmpty())
+    {
+        downloadPlaylist(songIDList);
+        return;
+    }
+    QString lyricsUrl=lyricsUrlList.takeFirst();
+    get(lyricsUrl, [=](const QByteArray &responseData)
+    {
+        //This is the lyrics file!
+        if(!responseData.isEmpty())
+        {
+            finish(responseData);
+            return;
+        }
+        downloadLyricsFile(lyricsUrlList, songIDList);
+    });
+}
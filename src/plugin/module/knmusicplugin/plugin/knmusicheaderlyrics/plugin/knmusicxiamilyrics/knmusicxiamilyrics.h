@@ -29,7 +29,14 @@ public:
     {
         return "XiaMi Music";
     }
-    QString downloadLyrics(const KNMusicDetailInfo &detailInfo);
+
+protected:
+    void downloadLyrics(const KNMusicDetailInfo &detailInfo);
+
+private:
+    void downloadPlaylist(QStringList songIDList);
+    void downloadLyricsFile(QStringList lyricsUrlList,
+                            const QStringList &songIDList);
 };
 
 #endif // KNMUSICXIAMILYRICS_H
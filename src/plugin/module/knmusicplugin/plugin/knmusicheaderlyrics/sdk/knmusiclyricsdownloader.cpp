@@ -17,85 +17,166 @@
  */
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
-#include <QEventLoop>
 #include <QTimer>
-#include <QFile>
-#include <QFileInfo>
-#include <QTextStream>
-
-#include "knconnectionhandler.h"
-#include "knmusiclyricsglobal.h"
 
 #include "knmusiclyricsdownloader.h"
 
+QString KNMusicLyricsDownloader::m_serverOverride=QString();
+
 KNMusicLyricsDownloader::KNMusicLyricsDownloader(QObject *parent) :
     QObject(parent)
 {
-    //Initial the network access manager.
-    m_networkManager=new QNetworkAccessManager(this);
-    //Initial the timer.
+    //Initial the timer, the download which is not finished in 5 seconds is
+    //treated as failed.
     m_timeout=new QTimer(this);
     m_timeout->setSingleShot(true);
-    //Waiting for 5 seconds.
     m_timeout->setInterval(5000);
+    connect(m_timeout, &QTimer::timeout,
+            this, &KNMusicLyricsDownloader::onActionTimeout);
+}
+
+void KNMusicLyricsDownloader::download(const KNMusicDetailInfo &detailInfo)
+{
+    //Stop the previous download.
+    abort();
+    if(m_networkManager==nullptr)
+    {
+        emit downloaded(QString());
+        return;
+    }
+    m_downloading=true;
+    m_latency.start();
+    m_timeout->start();
+    downloadLyrics(detailInfo);
+}
+
+bool KNMusicLyricsDownloader::isDownloading() const
+{
+    return m_downloading;
+}
+
+void KNMusicLyricsDownloader::setNetworkManager(QNetworkAccessManager *networkManager)
+{
+    m_networkManager=networkManager;
+}
+
+void KNMusicLyricsDownloader::setTimeout(const int &timeout)
+{
+    m_timeout->setInterval(timeout);
+}
+
+int KNMusicLyricsDownloader::downloadCount() const
+{
+    return m_downloadCount;
+}
+
+int KNMusicLyricsDownloader::hitCount() const
+{
+    return m_hitCount;
+}
+
+qint64 KNMusicLyricsDownloader::averageLatency() const
+{
+    return m_downloadCount==0?0:m_totalLatency/m_downloadCount;
+}
+
+void KNMusicLyricsDownloader::setServerOverride(const QString &server)
+{
+    m_serverOverride=server;
 }
 
-void KNMusicLyricsDownloader::get(const QString &url, QByteArray &responseData)
+void KNMusicLyricsDownloader::abort()
 {
+    //Stop the download without sending the result, the aborted download is
+    //not counted.
+    if(!m_downloading)
+    {
+        return;
+    }
+    m_downloading=false;
     m_timeout->stop();
-    //Clear the data first.
-    responseData.clear();
-    m_networkManager->clearAccessCache();
+    releaseReply();
+}
+
+void KNMusicLyricsDownloader::get(const QString &url, ReplyHandler handler)
+{
+    //Ignore the request after the download is finished.
+    if(!m_downloading)
+    {
+        return;
+    }
+    releaseReply();
     //Generate the request.
-    QNetworkRequest currentRequest;
-    currentRequest.setUrl(QUrl(url));
-    QNetworkReply *currentReply=nullptr;
-    KNConnectionHandler quiterHandle;
-    //Wait for response, using the event loop, generate the loop.
-    QEventLoop stuckWaitingLoop;
-    //Link the finished and timeout counter to quit loop.
-    quiterHandle+=connect(m_networkManager, SIGNAL(finished(QNetworkReply*)),
-                          &stuckWaitingLoop, SLOT(quit()));
-    quiterHandle+=connect(m_timeout, SIGNAL(timeout()),
-                          &stuckWaitingLoop, SLOT(quit()));
-    //Do GET.
-    currentReply=m_networkManager->get(currentRequest);
-    //Start counting.
-    m_timeout->start();
-    //Start loop.
-    stuckWaitingLoop.exec();
-    //Disconnect all the links.
-    quiterHandle.disconnectAll();
-    //Check if there's reply.
-    if(currentReply==nullptr)
+    QUrl requestUrl(url);
+    if(!m_serverOverride.isEmpty())
+    {
+        QUrl serverUrl(m_serverOverride);
+        requestUrl.setScheme(serverUrl.scheme());
+        requestUrl.setHost(serverUrl.host());
+        requestUrl.setPort(serverUrl.port());
+    }
+    //Do GET, the handler will be called when the reply is finished.
+    m_replyHandler=handler;
+    m_reply=m_networkManager->get(QNetworkRequest(requestUrl));
+    connect(m_reply, &QNetworkReply::finished,
+            this, &KNMusicLyricsDownloader::onActionReplyFinished);
+}
+
+void KNMusicLyricsDownloader::finish(const QString &content)
+{
+    if(!m_downloading)
     {
         return;
     }
-    //Get the data.
-    responseData=currentReply->readAll();
-    //Clear the reply.
-    delete currentReply;
+    m_downloading=false;
+    m_timeout->stop();
+    releaseReply();
+    //Record the statistics.
+    m_downloadCount++;
+    m_totalLatency+=m_latency.elapsed();
+    if(!content.isEmpty())
+    {
+        m_hitCount++;
+    }
+    emit downloaded(content);
 }
 
-QString KNMusicLyricsDownloader::writeLyricsFile(const KNMusicDetailInfo &detailInfo,
-                                                 const QString &content)
+void KNMusicLyricsDownloader::onActionReplyFinished()
 {
-    //Get the complete base file name of the original file.
-    QFileInfo musicFileInfo(detailInfo.filePath);
-    //Generate the lyrics file path
-    QString lyricsFilePath=KNMusicLyricsGlobal::lyricsFolderPath() + "/" +
-            musicFileInfo.completeBaseName() + ".lrc";
-    QFile lyricsFile(lyricsFilePath);
-    //Try to open the file.
-    if(lyricsFile.open(QIODevice::WriteOnly))
+    //Take the reply and the handler, the handler may send another request.
+    QNetworkReply *reply=m_reply;
+    ReplyHandler replyHandler=m_replyHandler;
+    m_reply=nullptr;
+    m_replyHandler=nullptr;
+    if(reply==nullptr)
+    {
+        return;
+    }
+    QByteArray responseData;
+    if(reply->error()==QNetworkReply::NoError)
     {
-        //Write the data to the file.
-        QTextStream lyricsStream(&lyricsFile);
-        lyricsStream << content << flush;
-        //Close the file.
-        lyricsFile.close();
-        //Return the file path.
-        return lyricsFilePath;
+        responseData=reply->readAll();
+    }
+    reply->deleteLater();
+    replyHandler(responseData);
+}
+
+void KNMusicLyricsDownloader::onActionTimeout()
+{
+    //Give up the download.
+    finish();
+}
+
+inline void KNMusicLyricsDownloader::releaseReply()
+{
+    m_replyHandler=nullptr;
+    if(m_reply==nullptr)
+    {
+        return;
     }
-    return QString();
+    //Disconnect the reply before abort it, or it will be finished.
+    disconnect(m_reply, 0, this, 0);
+    m_reply->abort();
+    m_reply->deleteLater();
+    m_reply=nullptr;
 }
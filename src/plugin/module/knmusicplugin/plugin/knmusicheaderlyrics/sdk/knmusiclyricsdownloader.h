@@ -18,6 +18,11 @@
 #ifndef KNMUSICLYRICSDOWNLOADER_H
 #define KNMUSICLYRICSDOWNLOADER_H
 
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <functional>
+
 #include "knmusicglobal.h"
 
 #include <QObject>
@@ -33,13 +38,30 @@ class KNMusicLyricsDownloader : public QObject
 public:
     explicit KNMusicLyricsDownloader(QObject *parent = 0);
     virtual QString downloaderName()=0;
-    virtual QString downloadLyrics(const KNMusicDetailInfo &detailInfo)=0;
+    //Start downloading the lyrics of the music, downloaded() will be emitted
+    //when it's finished.
+    void download(const KNMusicDetailInfo &detailInfo);
+    bool isDownloading() const;
+    void setNetworkManager(QNetworkAccessManager *networkManager);
+    void setTimeout(const int &timeout);
+    //The statistics of the downloads which are finished.
+    int downloadCount() const;
+    int hitCount() const;
+    qint64 averageLatency() const;
+    //All the requests are sent to the server instead when it's set, e.g. a
+    //local server for testing.
+    static void setServerOverride(const QString &server);
 
 signals:
+    //The content is empty when the lyrics can't be found.
+    void downloaded(QString content);
 
 public slots:
+    void abort();
 
 protected:
+    typedef std::function<void(const QByteArray &)> ReplyHandler;
+    virtual void downloadLyrics(const KNMusicDetailInfo &detailInfo)=0;
     inline QString processKeywords(QString str)
     {
         //Clear some no used words. I don't know how these regexp works.
@@ -53,13 +75,26 @@ protected:
         str.replace(QRegExp("[-/:-@[-`{-~]+"), " ");
         return str;
     }
-    void get(const QString &url, QByteArray &responseData);
-    QString writeLyricsFile(const KNMusicDetailInfo &detailInfo,
-                            const QString &content);
+    //Send a GET request, the handler is called with the response data, the
+    //data is empty when the request failed.
+    void get(const QString &url, ReplyHandler handler);
+    void finish(const QString &content=QString());
+
+private slots:
+    void onActionReplyFinished();
+    void onActionTimeout();
 
 private:
-    QNetworkAccessManager *m_networkManager;
+    inline void releaseReply();
+    static QString m_serverOverride;
+    QNetworkAccessManager *m_networkManager=nullptr;
+    QNetworkReply *m_reply=nullptr;
+    ReplyHandler m_replyHandler;
     QTimer *m_timeout;
+    QElapsedTimer m_latency;
+    bool m_downloading=false;
+    int m_downloadCount=0, m_hitCount=0;
+    qint64 m_totalLatency=0;
 };
 
 #endif // KNMUSICLYRICSDOWNLOADER_H
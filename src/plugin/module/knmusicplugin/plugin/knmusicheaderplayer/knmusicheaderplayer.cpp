@@ -20,6 +20,9 @@
 #include <QParallelAnimationGroup>
 #include <QPropertyAnimation>
 #include <QGraphicsOpacityEffect>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QWindow>
 
 #include "knhighlightlabel.h"
 #include "knscrolllabel.h"
@@ -30,9 +33,12 @@
 #include "knopacityanimebutton.h"
 
 #include "knmusicheaderplayerappendmenu.h"
+#include "knmusicheaderspectrum.h"
 #include "knmusicdetaildialogbase.h"
 #include "knmusicnowplayingbase.h"
 #include "knmusicbackend.h"
+#include "knmusicwaveformmanager.h"
+#include "knmusicspectrumanalyser.h"
 #include "knmusicglobal.h"
 
 #include "knglobal.h"
@@ -66,6 +72,7 @@ KNMusicHeaderPlayer::KNMusicHeaderPlayer(QWidget *parent) :
 
     //Initial widgets.
     initialAlbumArt();
+    initialSpectrum();
     initialLabels();
     initialProrgess();
     initialControlPanel();
@@ -122,6 +129,15 @@ void KNMusicHeaderPlayer::setBackend(KNMusicBackend *backend)
             {
                 m_volumeIndicator->setIcon(mute?m_muteIcon:m_noMuteIcon);
             });
+    //Set the position update interval.
+    updatePositionInterval();
+    //The waveform manager uses the backend to decode the songs.
+    KNMusicWaveformManager *waveformManager=KNMusicWaveformManager::instance();
+    waveformManager->setBackend(m_backend);
+    connect(waveformManager, &KNMusicWaveformManager::waveformReady,
+            this, &KNMusicHeaderPlayer::onActionWaveformReady);
+    //Give the analyser to the backend if the spectrum could be seen.
+    updateSpectrumState();
 }
 
 void KNMusicHeaderPlayer::setNowPlaying(KNMusicNowPlayingBase *nowPlaying)
@@ -143,6 +159,8 @@ void KNMusicHeaderPlayer::setNowPlaying(KNMusicNowPlayingBase *nowPlaying)
             this, &KNMusicHeaderPlayer::reset);
     connect(m_nowPlaying, &KNMusicNowPlayingBase::requireUpdatePlayerInfo,
             this, &KNMusicHeaderPlayer::updatePlayerInfo);
+    connect(m_nowPlaying, &KNMusicNowPlayingBase::nextSongPrepared,
+            this, &KNMusicHeaderPlayer::onActionNextSongPrepared);
     //Sync the data with now playing.
     onActionLoopStateChanged(m_nowPlaying->loopState());
 }
@@ -156,6 +174,9 @@ void KNMusicHeaderPlayer::reset()
 {
     //Reset file path.
     m_currentFilePath.clear();
+    //Clear the waveform.
+    m_waveformKey.clear();
+    m_progressSlider->clearWaveform();
     //Set text.
     setTitle("");
     m_artist.clear();
@@ -434,6 +455,17 @@ inline void KNMusicHeaderPlayer::initialAlbumArt()
     m_albumArt->setGraphicsEffect(m_albumArtEffect);
 }
 
+inline void KNMusicHeaderPlayer::initialSpectrum()
+{
+    //The spectrum is painted behind the labels.
+    m_spectrum=new KNMusicHeaderSpectrum(this);
+    m_spectrum->setGeometry(82, 5, 208, 40);
+    //The analyser calculates the spectrum in its own thread.
+    m_spectrumAnalyser=new KNMusicSpectrumAnalyser(this);
+    connect(m_spectrumAnalyser, &KNMusicSpectrumAnalyser::spectrumUpdated,
+            m_spectrum, &KNMusicHeaderSpectrum::setSpectrum);
+}
+
 inline void KNMusicHeaderPlayer::initialLabels()
 {
     //Initial the title scroll label.
@@ -784,9 +816,105 @@ inline QRect KNMusicHeaderPlayer::generateInPosition()
                  40);
 }
 
+inline bool KNMusicHeaderPlayer::isPlayerHidden()
+{
+    //A widget is still visible when its window is minimized.
+    return !isVisible() || window()->isMinimized();
+}
+
+inline void KNMusicHeaderPlayer::updatePositionInterval()
+{
+    if(m_backend==nullptr)
+    {
+        return;
+    }
+    //When the player is hidden (e.g. the window is minimized), no one can see
+    //the position, stop updating it.
+    if(isPlayerHidden())
+    {
+        m_backend->setPositionUpdateInterval(0);
+        return;
+    }
+    //Update the position once per frame of the screen.
+    m_backend->setPositionUpdateInterval(frameInterval());
+}
+
+inline int KNMusicHeaderPlayer::frameInterval()
+{
+    QWindow *playerWindow=window()->windowHandle();
+    QScreen *screen=playerWindow==nullptr?
+                QGuiApplication::primaryScreen():playerWindow->screen();
+    qreal refreshRate=screen==nullptr?0.0:screen->refreshRate();
+    return refreshRate<1.0?16:qMax(1, qRound(1000.0/refreshRate));
+}
+
+inline void KNMusicHeaderPlayer::updateSpectrumState()
+{
+    if(m_backend==nullptr)
+    {
+        return;
+    }
+    //When no one could see the spectrum, remove the analyser from the backend
+    //and stop analysing, nothing is calculated.
+    if(isPlayerHidden())
+    {
+        m_backend->setSpectrumAnalyser(nullptr);
+        m_spectrumAnalyser->setEnabled(false);
+        m_spectrum->clearSpectrum();
+        return;
+    }
+    m_spectrumAnalyser->setEnabled(true, frameInterval());
+    m_backend->setSpectrumAnalyser(m_spectrumAnalyser);
+}
+
+void KNMusicHeaderPlayer::showEvent(QShowEvent *event)
+{
+    KNMusicHeaderPlayerBase::showEvent(event);
+    //Watch the window, the player won't get any event when the window is
+    //minimized or restored.
+    if(window()!=this)
+    {
+        window()->installEventFilter(this);
+    }
+    //Resume the position updating and the spectrum.
+    updatePositionInterval();
+    updateSpectrumState();
+}
+
+void KNMusicHeaderPlayer::hideEvent(QHideEvent *event)
+{
+    KNMusicHeaderPlayerBase::hideEvent(event);
+    //Pause the position updating and the spectrum.
+    updatePositionInterval();
+    updateSpectrumState();
+}
+
+bool KNMusicHeaderPlayer::eventFilter(QObject *watched, QEvent *event)
+{
+    //Pause or resume when the window is minimized or restored.
+    if(watched==window() && event->type()==QEvent::WindowStateChange)
+    {
+        updatePositionInterval();
+        updateSpectrumState();
+    }
+    return KNMusicHeaderPlayerBase::eventFilter(watched, event);
+}
+
 void KNMusicHeaderPlayer::updatePlayerInfo(const KNMusicAnalysisItem &analysisItem)
 {
     m_currentDetailInfo=analysisItem.detailInfo;
+    //Show the waveform of the song, the tracks of a cue image have their own
+    //waveforms.
+    QString waveformKey=
+            KNMusicWaveformManager::waveformKey(m_currentDetailInfo);
+    if(waveformKey!=m_waveformKey)
+    {
+        m_waveformKey=waveformKey;
+        m_progressSlider->clearWaveform();
+        KNMusicWaveformManager::instance()->requireWaveform(
+                    m_currentDetailInfo,
+                    KNMusicWaveformManager::PlayingPriority);
+    }
     //Check is the playing file the current file. If it is, do nothing.
     if(m_currentFilePath==m_currentDetailInfo.filePath)
     {
@@ -804,3 +932,23 @@ void KNMusicHeaderPlayer::updatePlayerInfo(const KNMusicAnalysisItem &analysisIt
     //Ask to load lyrics.
     emit requireLoadLyrics(m_currentDetailInfo);
 }
+
+void KNMusicHeaderPlayer::onActionNextSongPrepared(const KNMusicAnalysisItem &analysisItem)
+{
+    //Generate the waveform of the next song before it's played.
+    KNMusicWaveformManager::instance()->requireWaveform(
+                analysisItem.detailInfo,
+                KNMusicWaveformManager::NextPriority);
+    //Find the lyrics of the next song.
+    emit requirePrefetchLyrics(analysisItem.detailInfo);
+}
+
+void KNMusicHeaderPlayer::onActionWaveformReady(const QString &key,
+                                                const QByteArray &peaks)
+{
+    //Only the waveform of the playing song is displayed.
+    if(key==m_waveformKey)
+    {
+        m_progressSlider->setWaveform(peaks);
+    }
+}
@@ -33,6 +33,8 @@ class KNProgressSlider;
 class KNEditableLabel;
 class KNHighlightLabel;
 class KNMusicHeaderPlayerAppendMenu;
+class KNMusicHeaderSpectrum;
+class KNMusicSpectrumAnalyser;
 class KNMusicGlobal;
 class KNMusicHeaderPlayer : public KNMusicHeaderPlayerBase
 {
@@ -54,6 +56,11 @@ public slots:
     void activatePlayer();
     void inactivatePlayer();
 
+protected:
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+    bool eventFilter(QObject *watched, QEvent *event);
+
 private slots:
     void setAlbumArt(const QPixmap &pixmap);
     void setTitle(const QString &title);
@@ -74,9 +81,12 @@ private slots:
 
     void setPosition(const qint64 &position);
     void updatePlayerInfo(const KNMusicAnalysisItem &analysisItem);
+    void onActionNextSongPrepared(const KNMusicAnalysisItem &analysisItem);
+    void onActionWaveformReady(const QString &key, const QByteArray &peaks);
 
 private:
     inline void initialAlbumArt();
+    inline void initialSpectrum();
     inline void initialLabels();
     inline void initialProrgess();
     inline void initialLoopState();
@@ -96,12 +106,17 @@ private:
 
     inline QRect generateOutPosition();
     inline QRect generateInPosition();
+    inline int frameInterval();
+    inline bool isPlayerHidden();
+    inline void updatePositionInterval();
+    inline void updateSpectrumState();
 
 
     //Public classes.
     KNMusicGlobal *m_musicGlobal;
-    KNMusicBackend *m_backend;
+    KNMusicBackend *m_backend=nullptr;
     KNMusicNowPlayingBase *m_nowPlaying;
+    KNMusicSpectrumAnalyser *m_spectrumAnalyser;
     KNGlobal *m_global;
 
     //Animations
@@ -113,6 +128,7 @@ private:
     //Widgets.
     QWidget *m_controlPanel, *m_progressPanel, *m_volumePanel, *m_appendPanel;
     KNHighlightLabel *m_albumArt;
+    KNMusicHeaderSpectrum *m_spectrum;
     KNScrollLabel *m_title, *m_artistAndAlbum;
     QLabel *m_duration;
     KNProgressSlider *m_progressSlider;
@@ -142,7 +158,7 @@ private:
             m_noAlbumArt;
 
     //Datas.
-    QString m_artist, m_album, m_currentFilePath;
+    QString m_artist, m_album, m_currentFilePath, m_waveformKey;
     KNMusicDetailInfo m_currentDetailInfo;
 };
 
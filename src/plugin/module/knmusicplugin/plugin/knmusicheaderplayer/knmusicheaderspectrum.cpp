@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <QPainter>
+
+#include "knmusicheaderspectrum.h"
+
+KNMusicHeaderSpectrum::KNMusicHeaderSpectrum(QWidget *parent) :
+    QWidget(parent)
+{
+    //It's only a background, the mouse events are sent to the player.
+    setAttribute(Qt::WA_TransparentForMouseEvents, true);
+}
+
+void KNMusicHeaderSpectrum::setSpectrum(const QVector<float> &bands,
+                                        const float &level,
+                                        const float &peak)
+{
+    m_bands=bands;
+    m_level=level;
+    m_peak=peak;
+    update();
+}
+
+void KNMusicHeaderSpectrum::clearSpectrum()
+{
+    m_bands.clear();
+    m_level=0.0;
+    m_peak=0.0;
+    update();
+}
+
+void KNMusicHeaderSpectrum::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    if(m_bands.isEmpty())
+    {
+        return;
+    }
+    QPainter painter(this);
+    //Draw the bands above the level meter.
+    int bandHeight=height()-m_levelHeight-m_bandSpacing,
+        bandCount=m_bands.size();
+    qreal bandWidth=(qreal)width()/bandCount;
+    for(int i=0; i<bandCount; i++)
+    {
+        int barHeight=m_bands.at(i)*bandHeight;
+        if(barHeight>0)
+        {
+            painter.fillRect(QRectF(i*bandWidth,
+                                    bandHeight-barHeight,
+                                    bandWidth-m_bandSpacing,
+                                    barHeight),
+                             m_bandColor);
+        }
+    }
+    //Draw the level and the peak.
+    int levelTop=height()-m_levelHeight;
+    painter.fillRect(QRectF(0,
+                            levelTop,
+                            m_level*width(),
+                            m_levelHeight),
+                     m_levelColor);
+    painter.fillRect(QRectF(qMax((qreal)0.0, (qreal)(m_peak*width()-m_levelHeight)),
+                            levelTop,
+                            m_levelHeight,
+                            m_levelHeight),
+                     m_levelColor);
+}
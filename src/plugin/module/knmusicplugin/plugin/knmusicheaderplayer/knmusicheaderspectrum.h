@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICHEADERSPECTRUM_H
+#define KNMUSICHEADERSPECTRUM_H
+
+#include <QVector>
+
+#include <QWidget>
+
+/*
+ * The header spectrum paints the bands and the level which are calculated by
+ * the spectrum analyser. It only paints the data, it never calculates anything.
+ */
+class KNMusicHeaderSpectrum : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit KNMusicHeaderSpectrum(QWidget *parent = 0);
+
+signals:
+
+public slots:
+    void setSpectrum(const QVector<float> &bands,
+                     const float &level,
+                     const float &peak);
+    void clearSpectrum();
+
+protected:
+    void paintEvent(QPaintEvent *event);
+
+private:
+    QVector<float> m_bands;
+    float m_level=0.0, m_peak=0.0;
+    int m_levelHeight=2, m_bandSpacing=1;
+    QColor m_bandColor=QColor(255,255,255,40),
+           m_levelColor=QColor(255,255,255,90);
+};
+
+#endif // KNMUSICHEADERSPECTRUM_H
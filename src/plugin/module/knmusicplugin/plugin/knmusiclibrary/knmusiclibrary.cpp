@@ -29,6 +29,7 @@
 #include "sdk/knmusiclibrarygenretab.h"
 #include "sdk/knmusiclibrarydatabase.h"
 #include "sdk/knmusiclibraryimagemanager.h"
+#include "sdk/knmusiclibraryloudnessscanner.h"
 
 #include "knmusicheaderplayerbase.h"
 #include "knmusicsolomenubase.h"
@@ -56,12 +57,18 @@ KNMusicLibrary::KNMusicLibrary(QObject *parent) :
     m_libraryModel=new KNMusicLibraryModel(this);
     m_libraryModel->setDatabase(m_libraryDatabase);
     m_libraryModel->setImageManager(m_libraryImageManager);
+    //Initial the loudness scanner.
+    m_loudnessScanner=new KNMusicLibraryLoudnessScanner(this);
+    m_loudnessScanner->setLibraryModel(m_libraryModel);
 
     QList<QAction *> showInActionList;
     //Initial the song tab.
     initialSongTab();
     //Set the library model for song tab.
     m_librarySongTab->setLibraryModel(m_libraryModel);
+    //The playlists need to know the songs which are removed.
+    connect(m_libraryModel, &KNMusicLibraryModel::libraryIdsAboutToBeRemoved,
+            this, &KNMusicLibrary::libraryIdsAboutToBeRemoved);
     //Link the load request.
     connect(m_librarySongTab, &KNMusicLibraryTab::requireLoadLibrary,
             this, &KNMusicLibrary::onActionLoadLibrary);
@@ -98,6 +105,8 @@ KNMusicLibrary::KNMusicLibrary(QObject *parent) :
 
 KNMusicLibrary::~KNMusicLibrary()
 {
+    //Stop scanning before the database is written.
+    m_loudnessScanner->stop();
     //Quit the threads.
     m_libraryDatabaseThread->quit();
     m_libraryImageThread->quit();
@@ -143,8 +152,41 @@ void KNMusicLibrary::setHeaderPlayer(KNMusicHeaderPlayerBase *player)
             [=]{m_libraryTabs[TabGenres]->showInTab(player->currentDetailInfo());});
 }
 
+void KNMusicLibrary::setBackend(KNMusicBackend *backend)
+{
+    //The backend decodes the songs for the loudness scanner.
+    m_loudnessScanner->setBackend(backend);
+}
+
+bool KNMusicLibrary::hasLibraryId(const quint32 &libraryId)
+{
+    //Load the library before finding the id.
+    onActionLoadLibrary();
+    return m_libraryModel->rowFromLibraryId(libraryId)!=-1;
+}
+
+bool KNMusicLibrary::detailInfoFromLibraryId(const quint32 &libraryId,
+                                             KNMusicDetailInfo &detailInfo)
+{
+    //Load the library before finding the id.
+    onActionLoadLibrary();
+    int row=m_libraryModel->rowFromLibraryId(libraryId);
+    if(row==-1)
+    {
+        return false;
+    }
+    detailInfo=m_libraryModel->detailInfoFromRow(row);
+    return true;
+}
+
 void KNMusicLibrary::onActionLoadLibrary()
 {
+    //The library is only loaded once.
+    if(m_libraryLoaded)
+    {
+        return;
+    }
+    m_libraryLoaded=true;
     //Disconnect all the links of the music tab.
     disconnect(m_librarySongTab, &KNMusicLibraryTab::requireLoadLibrary,
                this, &KNMusicLibrary::onActionLoadLibrary);
@@ -27,6 +27,7 @@ class KNMusicLibraryModel;
 class KNMusicLibraryTab;
 class KNMusicLibraryImageManager;
 class KNMusicLibraryCategoryTab;
+class KNMusicLibraryLoudnessScanner;
 class KNMusicLibrary : public KNMusicLibraryBase
 {
     Q_OBJECT
@@ -38,6 +39,10 @@ public:
     KNMusicTab *albumTab();
     KNMusicTab *genreTab();
     void setHeaderPlayer(KNMusicHeaderPlayerBase *player);
+    void setBackend(KNMusicBackend *backend);
+    bool hasLibraryId(const quint32 &libraryId);
+    bool detailInfoFromLibraryId(const quint32 &libraryId,
+                                 KNMusicDetailInfo &detailInfo);
 
 signals:
 
@@ -61,10 +66,12 @@ private:
     QThread *m_libraryDatabaseThread,
             *m_libraryImageThread;
     QString m_libraryPath;
+    bool m_libraryLoaded=false;
     KNMusicLibraryDatabase *m_libraryDatabase;
     KNMusicLibraryModel *m_libraryModel;
     KNMusicLibraryTab *m_librarySongTab;
     KNMusicLibraryImageManager *m_libraryImageManager;
+    KNMusicLibraryLoudnessScanner *m_loudnessScanner;
     KNMusicCategoryModel *m_categoryModel[CategoryTabsCount];
     KNMusicLibraryCategoryTab *m_libraryTabs[CategoryTabsCount];
 };
@@ -47,13 +47,8 @@ void KNMusicAlbumModel::onCategoryAdded(const QList<QStandardItem *> &musicRow)
         albumArtist=musicRow.at(Artist)->text();
     }
     //Search the category text.
-    QModelIndexList results=
-            match(index(0,0),
-                  Qt::DisplayRole,
-                  categoryText,
-                  1,
-                  Qt::MatchFixedString | Qt::MatchCaseSensitive);
-    if(results.isEmpty())
+    QModelIndex resultIndex=findCategory(categoryText);
+    if(!resultIndex.isValid())
     {
         //We need to generate a new item for it.
         QStandardItem *item=generateItem(categoryText);
@@ -63,12 +58,12 @@ void KNMusicAlbumModel::onCategoryAdded(const QList<QStandardItem *> &musicRow)
         artistList.insert(albumArtist, 1);
         item->setData(artistList, CategoryArtistList);
         //Add the item to category model.
-        appendRow(item);
+        addCategory(item);
+        resultIndex=item->index();
     }
     else
     {
         //Add the counter of the result.
-        QModelIndex resultIndex=results.first();
         setData(resultIndex,
                 data(resultIndex, CategoryItemSizeRole).toInt()+1,
                 CategoryItemSizeRole);
@@ -91,6 +86,9 @@ void KNMusicAlbumModel::onCategoryAdded(const QList<QStandardItem *> &musicRow)
                 artistList,
                 CategoryArtistList);
     }
+    //Add the artwork of the row as a candidate of the album.
+    addArtworkCandidate(resultIndex,
+                        musicRow.at(Name)->data(ArtworkKeyRole).toString());
 }
 
 void KNMusicAlbumModel::onCategoryRemoved(const QList<QStandardItem *> &musicRow)
@@ -122,18 +120,12 @@ void KNMusicAlbumModel::onCategoryRemoved(const QList<QStandardItem *> &musicRow
         return;
     }
     //Search the category text.
-    QModelIndexList results=
-            match(index(0,0),
-                  Qt::DisplayRole,
-                  categoryText,
-                  1,
-                  Qt::MatchFixedString | Qt::MatchCaseSensitive);
-    if(results.isEmpty())
+    resultIndex=findCategory(categoryText);
+    if(!resultIndex.isValid())
     {
         //Are you kidding me?
         return;
     }
-    resultIndex=results.first();
     int currentCategorySize=resultIndex.data(CategoryItemSizeRole).toInt();
     //If current item is the last item of the category,
     if(currentCategorySize==1)
@@ -141,12 +133,15 @@ void KNMusicAlbumModel::onCategoryRemoved(const QList<QStandardItem *> &musicRow
         //Emit removed signal.
         emit albumRemoved(resultIndex);
         //Remove this category.
-        removeRow(resultIndex.row());
+        removeCategory(resultIndex);
     }
     else
     {
         //Reduce the count.
         setData(resultIndex, currentCategorySize-1, CategoryItemSizeRole);
+        //Remove the artwork of the row from the candidates.
+        removeArtworkCandidate(resultIndex,
+                               musicRow.at(Name)->data(ArtworkKeyRole).toString());
         //Check the artist, and reduce the artist count.
         QHash<QString, QVariant> artistList=data(resultIndex,
                                                  CategoryArtistList).toHash();
@@ -192,30 +187,23 @@ void KNMusicAlbumModel::onCategoryRecover(const QList<QStandardItem *> &musicRow
         albumArtist=musicRow.at(Artist)->text();
     }
     //Search the category text.
-    QModelIndexList results=
-            match(index(0,0),
-                  Qt::DisplayRole,
-                  categoryText,
-                  1,
-                  Qt::MatchFixedString | Qt::MatchCaseSensitive);
-    if(results.isEmpty())
+    QModelIndex resultIndex=findCategory(categoryText);
+    if(!resultIndex.isValid())
     {
         //We need to generate a new item for it.
         QStandardItem *item=generateItem(categoryText);
         item->setData(1, CategoryItemSizeRole);
-        item->setData(musicRow.at(Name)->data(ArtworkKeyRole),
-                      CategoryArtworkKeyRole);
         //Set the album artist.
         QHash<QString, QVariant> artistList;
         artistList.insert(albumArtist, 1);
         item->setData(artistList, CategoryArtistList);
         //Add the item to category model.
-        appendRow(item);
+        addCategory(item);
+        resultIndex=item->index();
     }
     else
     {
         //Add the counter of the result.
-        QModelIndex resultIndex=results.first();
         setData(resultIndex,
                 data(resultIndex, CategoryItemSizeRole).toInt()+1,
                 CategoryItemSizeRole);
@@ -238,4 +226,69 @@ void KNMusicAlbumModel::onCategoryRecover(const QList<QStandardItem *> &musicRow
                 artistList,
                 CategoryArtistList);
     }
+    //Add the artwork of the row as a candidate of the album, the artwork will
+    //be set after all the images are recovered.
+    addArtworkCandidate(resultIndex,
+                        musicRow.at(Name)->data(ArtworkKeyRole).toString());
+}
+
+void KNMusicAlbumModel::reduceCategory(const QModelIndex &categoryIndex,
+                                       const QList<QList<QStandardItem *> > &musicRows)
+{
+    int currentCategorySize=data(categoryIndex, CategoryItemSizeRole).toInt()-
+            musicRows.size();
+    //Check if it's the blank item.
+    if(categoryIndex.row()==0)
+    {
+        if(currentCategorySize<1)
+        {
+            setData(categoryIndex, 0, CategoryItemSizeRole);
+            setData(categoryIndex, 0, CategoryItemVisibleRole);
+            //Emit removed signal, treat it as removed.
+            emit albumRemoved(categoryIndex);
+        }
+        else
+        {
+            setData(categoryIndex, currentCategorySize, CategoryItemSizeRole);
+        }
+        return;
+    }
+    //If all the songs of the album are removed, remove this album.
+    if(currentCategorySize<1)
+    {
+        //Emit removed signal.
+        emit albumRemoved(categoryIndex);
+        //Remove this category.
+        removeCategory(categoryIndex);
+        return;
+    }
+    //Reduce the count.
+    setData(categoryIndex, currentCategorySize, CategoryItemSizeRole);
+    //Reduce the artist count and the artwork candidates of all the rows, set
+    //the artist list only once.
+    QHash<QString, QVariant> artistList=data(categoryIndex,
+                                             CategoryArtistList).toHash();
+    for(QList<QList<QStandardItem *> >::const_iterator i=musicRows.begin();
+        i!=musicRows.end();
+        ++i)
+    {
+        removeArtworkCandidate(categoryIndex,
+                               (*i).at(Name)->data(ArtworkKeyRole).toString());
+        QString songArtist=(*i).at(AlbumArtist)->text();
+        if(artistList.contains(songArtist))
+        {
+            int artistSongCount=artistList.value(songArtist).toInt();
+            //If this is the last song of the artist, remove the artist from the
+            //list.
+            if(artistSongCount==1)
+            {
+                artistList.remove(songArtist);
+            }
+            else
+            {
+                artistList.insert(songArtist, artistSongCount-1);
+            }
+        }
+    }
+    setData(categoryIndex, artistList, CategoryArtistList);
 }
@@ -44,6 +44,10 @@ public slots:
     void onCategoryAdded(const QList<QStandardItem *> &musicRow);
     void onCategoryRemoved(const QList<QStandardItem *> &musicRow);
     void onCategoryRecover(const QList<QStandardItem *> &musicRow);
+
+protected:
+    void reduceCategory(const QModelIndex &categoryIndex,
+                        const QList<QList<QStandardItem *> > &musicRows);
 };
 
 #endif // KNMUSICALBUMMODEL_H
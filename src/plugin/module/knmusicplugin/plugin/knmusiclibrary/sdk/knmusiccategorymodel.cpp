@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 #include "knhashpixmaplist.h"
+#include "knmusicstringpool.h"
 
 #include "knmusiccategorymodel.h"
 
@@ -32,8 +33,10 @@ KNMusicCategoryModel::KNMusicCategoryModel(QObject *parent) :
 
 void KNMusicCategoryModel::resetModel()
 {
-    //Clear the model.
+    //Clear the model, the category items and the artwork candidates.
     clear();
+    m_categoryItems.clear();
+    m_artworkCandidates.clear();
     //Add initial item: the blank item.
     QStandardItem *currentItem=generateItem(m_noCategoryText);
     appendRow(currentItem);
@@ -59,6 +62,22 @@ void KNMusicCategoryModel::changeAlbumArt(const QModelIndex &target,
     emit categoryAlbumArtUpdate(target);
 }
 
+void KNMusicCategoryModel::setPixmapList(KNHashPixmapList *pixmapList)
+{
+    m_pixmapList=pixmapList;
+}
+
+void KNMusicCategoryModel::collectTextIds(QSet<int> &textIds) const
+{
+    //The category items are keyed on these ids, they can't be released.
+    for(QHash<int, QStandardItem *>::const_iterator i=m_categoryItems.begin();
+        i!=m_categoryItems.end();
+        ++i)
+    {
+        textIds.insert(i.key());
+    }
+}
+
 QIcon KNMusicCategoryModel::noAlbumIcon() const
 {
     return m_noAlbumIcon;
@@ -107,27 +126,25 @@ void KNMusicCategoryModel::onCategoryAdded(const QList<QStandardItem *> &musicRo
         return;
     }
     //Search the category text.
-    QModelIndexList results=
-            match(index(1,0),
-                  Qt::DisplayRole,
-                  categoryText,
-                  1,
-                  Qt::MatchFixedString);
-    if(results.isEmpty())
+    QModelIndex resultIndex=findCategory(categoryText);
+    if(!resultIndex.isValid())
     {
         //We need to generate a new item for it.
         QStandardItem *item=generateItem(categoryText);
         item->setData(1, CategoryItemSizeRole);
-        appendRow(item);
+        addCategory(item);
+        resultIndex=item->index();
     }
     else
     {
         //Add the counter of the result.
-        QModelIndex resultIndex=results.first();
         setData(resultIndex,
                 data(resultIndex, CategoryItemSizeRole).toInt()+1,
                 CategoryItemSizeRole);
     }
+    //Add the artwork of the row as a candidate of the category.
+    addArtworkCandidate(resultIndex,
+                        musicRow.at(Name)->data(ArtworkKeyRole).toString());
 }
 
 void KNMusicCategoryModel::onCategoryRemoved(const QList<QStandardItem *> &musicRow)
@@ -157,29 +174,61 @@ void KNMusicCategoryModel::onCategoryRemoved(const QList<QStandardItem *> &music
         return;
     }
     //Search the category text.
-    QModelIndexList results=
-            match(index(1,0),
-                  Qt::DisplayRole,
-                  categoryText,
-                  1,
-                  Qt::MatchFixedString | Qt::MatchCaseSensitive);
-    if(results.isEmpty())
+    resultIndex=findCategory(categoryText);
+    if(!resultIndex.isValid())
     {
         //Are you kidding me?
         return;
     }
-    resultIndex=results.first();
     int currentCategorySize=resultIndex.data(CategoryItemSizeRole).toInt();
     //If current item is the last item of the category,
     if(currentCategorySize==1)
     {
         //Remove this category.
-        removeRow(resultIndex.row());
+        removeCategory(resultIndex);
     }
     else
     {
         //Reduce the count.
         setData(resultIndex, currentCategorySize-1, CategoryItemSizeRole);
+        //Remove the artwork of the row from the candidates.
+        removeArtworkCandidate(resultIndex,
+                               musicRow.at(Name)->data(ArtworkKeyRole).toString());
+    }
+}
+
+void KNMusicCategoryModel::onCategoryRowsRemoved(
+        const QList<QList<QStandardItem *> > &musicRows)
+{
+    //Group the rows by the id of their category text, the blank text is 0.
+    KNMusicStringPool *stringPool=KNMusicStringPool::instance();
+    QHash<int, QList<QList<QStandardItem *> > > categoryRows;
+    for(QList<QList<QStandardItem *> >::const_iterator i=musicRows.begin();
+        i!=musicRows.end();
+        ++i)
+    {
+        categoryRows[stringPool->findId((*i).at(m_categoryIndex)->text())]
+                .append(*i);
+    }
+    //Reduce the categories, the category items are found by the text id, so
+    //removing a category won't affect the other groups.
+    for(QHash<int, QList<QList<QStandardItem *> > >::iterator
+            groupIterator=categoryRows.begin();
+        groupIterator!=categoryRows.end();
+        ++groupIterator)
+    {
+        if(groupIterator.key()==0)
+        {
+            //Reduce the blank item.
+            reduceCategory(index(0,0), *groupIterator);
+            continue;
+        }
+        QStandardItem *categoryItem=
+                m_categoryItems.value(groupIterator.key(), nullptr);
+        if(categoryItem!=nullptr)
+        {
+            reduceCategory(categoryItem->index(), *groupIterator);
+        }
     }
 }
 
@@ -199,60 +248,59 @@ void KNMusicCategoryModel::onCategoryRecover(const QList<QStandardItem *> &music
         return;
     }
     //Search the category text.
-    QModelIndexList results=
-            match(index(1,0),
-                  Qt::DisplayRole,
-                  categoryText,
-                  1,
-                  Qt::MatchFixedString | Qt::MatchCaseSensitive);
-    if(results.isEmpty())
+    QModelIndex resultIndex=findCategory(categoryText);
+    if(!resultIndex.isValid())
     {
         //We need to generate a new item for it.
         QStandardItem *item=generateItem(categoryText);
         item->setData(1, CategoryItemSizeRole);
-        item->setData(musicRow.at(Name)->data(ArtworkKeyRole),
-                      CategoryArtworkKeyRole);
-        appendRow(item);
+        addCategory(item);
+        resultIndex=item->index();
     }
     else
     {
         //Add the counter of the result.
-        QModelIndex resultIndex=results.first();
         setData(resultIndex,
                 data(resultIndex, CategoryItemSizeRole).toInt()+1,
                 CategoryItemSizeRole);
     }
+    //Add the artwork of the row as a candidate of the category, the artwork
+    //will be set after all the images are recovered.
+    addArtworkCandidate(resultIndex,
+                        musicRow.at(Name)->data(ArtworkKeyRole).toString());
 }
 
 void KNMusicCategoryModel::onCoverImageUpdate(const QString &categoryText,
+                                              const QString &previousImageKey,
                                               const QString &imageKey,
                                               const QPixmap &image)
 {
+    Q_UNUSED(image)
     //Check if it need to be add to blank item.
     if(categoryText.isEmpty())
     {
         return;
     }
     //Search the category text.
-    QModelIndexList results=
-            match(index(1,0),
-                  Qt::DisplayRole,
-                  categoryText,
-                  1,
-                  Qt::MatchFixedString | Qt::MatchCaseSensitive);
+    QModelIndex resultIndex=findCategory(categoryText);
     //This result should never be empty.
-    if(results.isEmpty())
+    if(!resultIndex.isValid())
     {
         //Are you kidding me?
         return;
     }
-    //Check is the result index cover image has a key.
-    //If it contains a key, then do nothing.
-    QModelIndex resultIndex=results.first();
-    if(data(resultIndex, CategoryArtworkKeyRole).isNull())
+    //The row doesn't use the previous image any more, remove it from the
+    //candidates first. If the category is showing the previous image, it will
+    //be replaced by another candidate.
+    if(previousImageKey==imageKey)
     {
-        setAlbumArt(resultIndex, imageKey, QIcon(image));
+        return;
     }
+    removeArtworkCandidate(resultIndex, previousImageKey);
+    //Add the image as a candidate, if the category doesn't have an artwork,
+    //the image will be used. The image has already been added to the pixmap
+    //list, so we don't need to use the image here.
+    addArtworkCandidate(resultIndex, imageKey);
 }
 
 void KNMusicCategoryModel::onImageRecoverComplete(KNHashPixmapList *pixmapList)
@@ -274,6 +322,141 @@ void KNMusicCategoryModel::onImageRecoverComplete(KNHashPixmapList *pixmapList)
     }
 }
 
+void KNMusicCategoryModel::reduceCategory(const QModelIndex &categoryIndex,
+                                          const QList<QList<QStandardItem *> > &musicRows)
+{
+    int currentCategorySize=data(categoryIndex, CategoryItemSizeRole).toInt()-
+            musicRows.size();
+    //Check if it's the blank item.
+    if(categoryIndex.row()==0)
+    {
+        if(currentCategorySize<1)
+        {
+            setData(categoryIndex, 0, CategoryItemSizeRole);
+            setData(categoryIndex, 0, CategoryItemVisibleRole);
+        }
+        else
+        {
+            setData(categoryIndex, currentCategorySize, CategoryItemSizeRole);
+        }
+        return;
+    }
+    //If all the items of the category are removed, remove this category.
+    if(currentCategorySize<1)
+    {
+        removeCategory(categoryIndex);
+        return;
+    }
+    //Reduce the count.
+    setData(categoryIndex, currentCategorySize, CategoryItemSizeRole);
+    //Remove the artworks of the rows from the candidates.
+    for(QList<QList<QStandardItem *> >::const_iterator i=musicRows.begin();
+        i!=musicRows.end();
+        ++i)
+    {
+        removeArtworkCandidate(categoryIndex,
+                               (*i).at(Name)->data(ArtworkKeyRole).toString());
+    }
+}
+
+QModelIndex KNMusicCategoryModel::findCategory(const QString &categoryText)
+{
+    //Only the text which is in the string pool could be a category.
+    int textId=KNMusicStringPool::instance()->findId(categoryText);
+    if(textId<1)
+    {
+        return QModelIndex();
+    }
+    QStandardItem *categoryItem=m_categoryItems.value(textId, nullptr);
+    return categoryItem==nullptr?QModelIndex():categoryItem->index();
+}
+
+void KNMusicCategoryModel::addCategory(QStandardItem *categoryItem)
+{
+    //Add the category to the model, and index it with the text id.
+    appendRow(categoryItem);
+    m_categoryItems.insert(
+                KNMusicStringPool::instance()->id(categoryItem->text()),
+                categoryItem);
+}
+
+void KNMusicCategoryModel::removeCategory(const QModelIndex &categoryIndex)
+{
+    //Remove the index of the category.
+    m_categoryItems.remove(KNMusicStringPool::instance()->findId(
+                               data(categoryIndex, Qt::DisplayRole).toString()));
+    //Remove the artwork candidates of the category.
+    m_artworkCandidates.remove(itemFromIndex(categoryIndex));
+    //Remove the category.
+    removeRow(categoryIndex.row());
+}
+
+void KNMusicCategoryModel::addArtworkCandidate(const QModelIndex &categoryIndex,
+                                               const QString &artworkKey)
+{
+    //Ignore the no category item and the row which doesn't have artwork.
+    if(!m_updateAlbumArt || categoryIndex.row()==0 || artworkKey.isEmpty())
+    {
+        return;
+    }
+    //Count the artwork key.
+    QHash<QString, int> &candidates=
+            m_artworkCandidates[itemFromIndex(categoryIndex)];
+    candidates.insert(artworkKey, candidates.value(artworkKey)+1);
+    //If the category doesn't have an artwork, use this one.
+    if(data(categoryIndex, CategoryArtworkKeyRole).toString().isEmpty())
+    {
+        QPixmap artwork=(m_pixmapList==nullptr)?
+                    QPixmap():m_pixmapList->pixmap(artworkKey);
+        setAlbumArt(categoryIndex,
+                    artworkKey,
+                    artwork.isNull()?m_noAlbumIcon:QIcon(artwork));
+    }
+}
+
+void KNMusicCategoryModel::removeArtworkCandidate(const QModelIndex &categoryIndex,
+                                                  const QString &artworkKey)
+{
+    //Ignore the no category item and the row which doesn't have artwork.
+    if(!m_updateAlbumArt || categoryIndex.row()==0 || artworkKey.isEmpty())
+    {
+        return;
+    }
+    QHash<QStandardItem *, QHash<QString, int>>::iterator candidatesIterator=
+            m_artworkCandidates.find(itemFromIndex(categoryIndex));
+    if(candidatesIterator==m_artworkCandidates.end())
+    {
+        return;
+    }
+    QHash<QString, int> &candidates=*candidatesIterator;
+    //Reduce the counter of the key, if there's still other rows use it, done.
+    int keyCount=candidates.value(artworkKey)-1;
+    if(keyCount>0)
+    {
+        candidates.insert(artworkKey, keyCount);
+        return;
+    }
+    candidates.remove(artworkKey);
+    //Check whether the category is using the artwork which is removed.
+    if(data(categoryIndex, CategoryArtworkKeyRole).toString()!=artworkKey)
+    {
+        return;
+    }
+    //Replace the artwork with another candidate, if there's no candidate,
+    //reset to the no album art.
+    if(candidates.isEmpty())
+    {
+        changeAlbumArt(categoryIndex, QString(), m_noAlbumIcon);
+        return;
+    }
+    QString replaceKey=candidates.constBegin().key();
+    changeAlbumArt(categoryIndex,
+                   replaceKey,
+                   m_pixmapList==nullptr?
+                       m_noAlbumIcon:
+                       QIcon(m_pixmapList->pixmap(replaceKey)));
+}
+
 QStandardItem *KNMusicCategoryModel::generateItem(const QString &itemText,
                                                   const QPixmap &itemIcon)
 {
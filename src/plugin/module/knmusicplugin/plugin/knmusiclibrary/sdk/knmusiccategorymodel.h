@@ -18,6 +18,8 @@
 #ifndef KNMUSICCATEGORYMODEL_H
 #define KNMUSICCATEGORYMODEL_H
 
+#include <QHash>
+#include <QSet>
 #include <QStandardItemModel>
 
 #include "knmusicglobal.h"
@@ -41,6 +43,8 @@ public:
     void changeAlbumArt(const QModelIndex &target,
                         const QString &artworkKey,
                         const QIcon &artwork);
+    void setPixmapList(KNHashPixmapList *pixmapList);
+    void collectTextIds(QSet<int> &textIds) const;
 
 signals:
     void categoryAlbumArtUpdate(QModelIndex updatedIndex);
@@ -48,8 +52,10 @@ signals:
 public slots:
     virtual void onCategoryAdded(const QList<QStandardItem *> &musicRow);
     virtual void onCategoryRemoved(const QList<QStandardItem *> &musicRow);
+    void onCategoryRowsRemoved(const QList<QList<QStandardItem *> > &musicRows);
     virtual void onCategoryRecover(const QList<QStandardItem *> &musicRow);
     virtual void onCoverImageUpdate(const QString &categoryText,
+                                    const QString &previousImageKey,
                                     const QString &imageKey,
                                     const QPixmap &image);
     virtual void onImageRecoverComplete(KNHashPixmapList *pixmapList);
@@ -57,6 +63,15 @@ public slots:
 protected:
     virtual QStandardItem *generateItem(const QString &itemText,
                                         const QPixmap &itemIcon=QPixmap());
+    virtual void reduceCategory(const QModelIndex &categoryIndex,
+                                const QList<QList<QStandardItem *> > &musicRows);
+    QModelIndex findCategory(const QString &categoryText);
+    void addCategory(QStandardItem *categoryItem);
+    void removeCategory(const QModelIndex &categoryIndex);
+    void addArtworkCandidate(const QModelIndex &categoryIndex,
+                             const QString &artworkKey);
+    void removeArtworkCandidate(const QModelIndex &categoryIndex,
+                                const QString &artworkKey);
 
 private:
     inline void resetModel();
@@ -69,6 +84,13 @@ private:
         //Update the artwork key.
         setData(target, artworkKey, CategoryArtworkKeyRole);
     }
+    //The category items, keyed on the id of the category text in the string
+    //pool.
+    QHash<int, QStandardItem *> m_categoryItems;
+    //Candidate artwork keys of each category, and the number of the rows which
+    //are using the key.
+    QHash<QStandardItem *, QHash<QString, int>> m_artworkCandidates;
+    KNHashPixmapList *m_pixmapList=nullptr;
     int m_categoryIndex=-1;
     bool m_updateAlbumArt=true;
     QIcon m_noAlbumIcon;
@@ -37,10 +37,12 @@ QIcon KNMusicGenreModel::genreIcon(const QString &genreName)
 }
 
 void KNMusicGenreModel::onCoverImageUpdate(const QString &categoryText,
+                                           const QString &previousImageKey,
                                            const QString &imageKey,
                                            const QPixmap &image)
 {
     Q_UNUSED(categoryText)
+    Q_UNUSED(previousImageKey)
     Q_UNUSED(imageKey)
     Q_UNUSED(image)
     //Do nothing.
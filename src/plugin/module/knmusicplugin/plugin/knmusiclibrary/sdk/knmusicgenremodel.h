@@ -33,6 +33,7 @@ signals:
 
 public slots:
     void onCoverImageUpdate(const QString &categoryText,
+                            const QString &previousImageKey,
                             const QString &imageKey,
                             const QPixmap &image);
     void onCategoryRecover(const QList<QStandardItem *> &musicRow);
@@ -15,8 +15,6 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
-#include "knglobal.h"
-#include "knmusicparser.h"
 #include "knmusicmodelassist.h"
 
 #include "knmusiclibrarydatabase.h"
@@ -26,7 +24,6 @@
 KNMusicLibraryDatabase::KNMusicLibraryDatabase(QObject *parent) :
     KNJSONDatabase(parent)
 {
-    m_global=KNGlobal::instance();
 }
 
 void KNMusicLibraryDatabase::recoverModel()
@@ -81,6 +78,24 @@ void KNMusicLibraryDatabase::removeMusicRow(const int &row)
     removeAt(row);
 }
 
+void KNMusicLibraryDatabase::removeMusicRows(const QList<int> &sortedRows)
+{
+    //Remove all the music rows in one compaction.
+    removeAll(sortedRows);
+}
+
+quint32 KNMusicLibraryDatabase::nextLibraryId() const
+{
+    return (quint32)databaseProperty("NextLibraryId").toDouble();
+}
+
+void KNMusicLibraryDatabase::setNextLibraryId(const quint32 &nextLibraryId)
+{
+    //The ids of the removed rows are never used again, the playlists could
+    //still keep them.
+    setDatabaseProperty("NextLibraryId", (qint64)nextLibraryId);
+}
+
 inline void KNMusicLibraryDatabase::generateObject(const QList<QStandardItem *> &musicRow,
                                                    QJsonObject &musicObject)
 {
@@ -118,12 +133,31 @@ inline void KNMusicLibraryDatabase::generateObject(const QList<QStandardItem *>
     musicObject.insert("TrackCount", musicRow.at(TrackCount)->text());
     musicObject.insert("TrackNumber", musicRow.at(TrackNumber)->text());
     musicObject.insert("Year", musicRow.at(Year)->text());
+    //Write the loudness data, only when it's measured.
+    QVariant loudness=musicRow.at(Loudness)->data(Qt::UserRole);
+    if(loudness.isValid())
+    {
+        musicObject.insert("Loudness", loudness.toDouble());
+        musicObject.insert("TruePeak",
+                           musicRow.at(TruePeak)->data(Qt::UserRole).toDouble());
+    }
+    QVariant albumGain=musicRow.at(AlbumGain)->data(Qt::UserRole);
+    if(albumGain.isValid())
+    {
+        musicObject.insert("AlbumGain", albumGain.toDouble());
+    }
+    if(musicRow.at(Name)->data(LoudnessFailedRole).toBool())
+    {
+        musicObject.insert("LoudnessFailed", true);
+    }
 
     //Write properties.
     QStandardItem *propertyItem=musicRow.at(Name);
     musicObject.insert("FilePath", propertyItem->data(FilePathRole).toString());
     musicObject.insert("FileName", propertyItem->data(FileNameRole).toString());
     musicObject.insert("ArtworkKeyRole", propertyItem->data(ArtworkKeyRole).toString());
+    musicObject.insert("LibraryId",
+                       (qint64)propertyItem->data(LibraryIdRole).toUInt());
     QString trackFilePath=propertyItem->data(TrackFileRole).toString();
     if(!trackFilePath.isEmpty())
     {
@@ -141,6 +175,9 @@ inline void KNMusicLibraryDatabase::generateRow(const QJsonObject &musicObject,
     currentDetail.filePath=musicObject.value("FilePath").toString();
     currentDetail.fileName=musicObject.value("FileName").toString();
     currentDetail.coverImageHash=musicObject.value("ArtworkKeyRole").toString();
+    //The rows saved by the old versions don't have ids, the library model will
+    //allocate them.
+    currentDetail.libraryId=(quint32)musicObject.value("LibraryId").toDouble();
     QString trackFilePath=musicObject.value("TrackFilePath").toString();
     if(!trackFilePath.isEmpty())
     {
@@ -159,30 +196,37 @@ inline void KNMusicLibraryDatabase::generateRow(const QJsonObject &musicObject,
                 musicObject.value("DateModified").toString());
     currentDetail.lastPlayed=KNMusicModelAssist::dataStringToDateTime(
                 musicObject.value("LastPlayed").toString());
-    //Set the text data.
+    //Set the loudness data, the rows without it will be measured again.
+    if(musicObject.contains("Loudness"))
+    {
+        currentDetail.loudnessMeasured=true;
+        currentDetail.loudness=musicObject.value("Loudness").toDouble();
+        currentDetail.truePeak=musicObject.value("TruePeak").toDouble();
+    }
+    if(musicObject.contains("AlbumGain"))
+    {
+        currentDetail.albumGainMeasured=true;
+        currentDetail.albumGain=musicObject.value("AlbumGain").toDouble();
+    }
+    currentDetail.loudnessFailed=musicObject.value("LoudnessFailed").toBool();
+    //Set the text data, the size, date, time and rate texts are formatted by the
+    //model from the native values.
     currentDetail.textLists[Name]=musicObject.value("Name").toString();
     currentDetail.textLists[Album]=musicObject.value("Album").toString();
     currentDetail.textLists[AlbumArtist]=musicObject.value("AlbumArtist").toString();
     currentDetail.textLists[AlbumRating]=musicObject.value("AlbumRating").toString();
     currentDetail.textLists[Artist]=musicObject.value("Artist").toString();
     currentDetail.textLists[BeatsPerMinuate]=musicObject.value("BeatsPerMinuate").toString();
-    currentDetail.textLists[BitRate]=KNMusicParser::bitRateText(currentDetail.bitRate);
     currentDetail.textLists[Category]=musicObject.value("Category").toString();
     currentDetail.textLists[Comments]=musicObject.value("Comments").toString();
     currentDetail.textLists[Composer]=musicObject.value("Composer").toString();
-    currentDetail.textLists[DateAdded]=KNMusicModelAssist::dateTimeToString(currentDetail.dateAdded);
-    currentDetail.textLists[DateModified]=KNMusicModelAssist::dateTimeToString(currentDetail.dateModified);
     currentDetail.textLists[Description]=musicObject.value("Description").toString();
     currentDetail.textLists[DiscCount]=musicObject.value("DiscCount").toString();
     currentDetail.textLists[DiscNumber]=musicObject.value("DiscNumber").toString();
     currentDetail.textLists[Genre]=musicObject.value("Genre").toString();
     currentDetail.textLists[Kind]=musicObject.value("Kind").toString();
-    currentDetail.textLists[LastPlayed]=KNMusicModelAssist::dateTimeToString(currentDetail.lastPlayed);
     currentDetail.textLists[Plays]=musicObject.value("Plays").toString();
     currentDetail.textLists[Rating]=musicObject.value("Rating").toString();
-    currentDetail.textLists[SampleRate]=KNMusicParser::sampleRateText(currentDetail.samplingRate);
-    currentDetail.textLists[Size]=m_global->byteToHigherUnit(currentDetail.size);
-    currentDetail.textLists[Time]=KNMusicGlobal::msecondToString(currentDetail.duration);
     currentDetail.textLists[TrackCount]=musicObject.value("TrackCount").toString();
     currentDetail.textLists[TrackNumber]=musicObject.value("TrackNumber").toString();
     currentDetail.textLists[Year]=musicObject.value("Year").toString();
@@ -27,7 +27,6 @@
 
 using namespace KNMusic;
 
-class KNGlobal;
 class KNMusicLibraryDatabase : public KNJSONDatabase
 {
     Q_OBJECT
@@ -39,6 +38,9 @@ public:
                         const QList<QStandardItem *> &musicRow);
     void updateArtworkKey(const int &row, const QString &artworkKey);
     void removeMusicRow(const int &row);
+    void removeMusicRows(const QList<int> &sortedRows);
+    quint32 nextLibraryId() const;
+    void setNextLibraryId(const quint32 &nextLibraryId);
 
 signals:
     void requireRecoverMusicRow(const QList<QStandardItem *> &musicRow);
@@ -50,7 +52,6 @@ private:
                                QJsonObject &musicObject);
     inline void generateRow(const QJsonObject &musicObject,
                             QList<QStandardItem *> &musicRow);
-    KNGlobal *m_global;
 };
 
 #endif // KNMUSICLIBRARYDATABASE_H
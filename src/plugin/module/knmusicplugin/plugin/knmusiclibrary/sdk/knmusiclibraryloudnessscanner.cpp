@@ -0,0 +1,351 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <cmath>
+
+#include "knmusicbackend.h"
+#include "knmusicaudiodecoder.h"
+#include "knmusicloudnessmeter.h"
+#include "knmusiclibrarymodel.h"
+
+#include "knmusiclibraryloudnessscanner.h"
+
+#include <QDebug>
+
+//The frames which are decoded at a time.
+#define ChunkFrames 4096
+//When it's throttled, sleep after each chunk, it's about 50 times faster than
+//playing.
+#define ThrottleInterval 2
+
+class KNMusicLoudnessScanTask : public QRunnable
+{
+public:
+    KNMusicLoudnessScanTask(KNMusicLibraryLoudnessScanner *scanner,
+                            KNMusicAudioDecoder *decoder,
+                            const quint64 &taskId,
+                            const QString &filePath,
+                            const qint64 &start,
+                            const qint64 &duration) :
+        m_scanner(scanner),
+        m_decoder(decoder),
+        m_filePath(filePath),
+        m_taskId(taskId),
+        m_start(start),
+        m_duration(duration)
+    {
+    }
+
+    ~KNMusicLoudnessScanTask()
+    {
+        delete m_decoder;
+    }
+
+    void run()
+    {
+        //Never compete with the playing stream.
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        bool measured=false;
+        qreal loudness=0.0, truePeak=0.0;
+        if(m_decoder->open(m_filePath, m_start, m_duration) &&
+                m_decoder->channels()>0 && m_decoder->sampleRate()>0)
+        {
+            KNMusicLoudnessMeter meter(m_decoder->sampleRate(),
+                                       m_decoder->channels(),
+                                       m_decoder->channelPositions());
+            QVector<float> buffer(ChunkFrames*m_decoder->channels());
+            int frames=1;
+            while(!m_scanner->isCancelled() && frames>0)
+            {
+                //When it's throttled, only one task could decode a chunk at a
+                //time, and it sleeps before the next task gets the turn.
+                bool throttled=m_scanner->isThrottled();
+                if(throttled)
+                {
+                    m_scanner->throttleLock()->lock();
+                }
+                frames=m_decoder->decode(buffer.data(), ChunkFrames);
+                if(frames>0)
+                {
+                    meter.addFrames(buffer.constData(), frames);
+                }
+                if(throttled)
+                {
+                    QThread::msleep(ThrottleInterval);
+                    m_scanner->throttleLock()->unlock();
+                }
+            }
+            measured=meter.isMeasured();
+            loudness=meter.integratedLoudness();
+            truePeak=meter.truePeak();
+        }
+        if(m_scanner->isCancelled())
+        {
+            return;
+        }
+        //Give the result back to the thread of the scanner.
+        QMetaObject::invokeMethod(m_scanner,
+                                  "onActionMeasured",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(quint64, m_taskId),
+                                  Q_ARG(bool, measured),
+                                  Q_ARG(qreal, loudness),
+                                  Q_ARG(qreal, truePeak));
+    }
+
+private:
+    KNMusicLibraryLoudnessScanner *m_scanner;
+    KNMusicAudioDecoder *m_decoder;
+    QString m_filePath;
+    quint64 m_taskId;
+    qint64 m_start, m_duration;
+};
+
+KNMusicLibraryLoudnessScanner::KNMusicLibraryLoudnessScanner(QObject *parent) :
+    QObject(parent),
+    m_throttled(0),
+    m_cancelled(0)
+{
+    //Leave one core for the interface and the playing.
+    m_maximumTasks=qMax(QThread::idealThreadCount()-1, 1);
+    m_threadPool=new QThreadPool(this);
+    m_threadPool->setMaxThreadCount(m_maximumTasks);
+    //The decoders must be freed before the backend.
+    connect(qApp, &QCoreApplication::aboutToQuit,
+            this, &KNMusicLibraryLoudnessScanner::stop);
+}
+
+KNMusicLibraryLoudnessScanner::~KNMusicLibraryLoudnessScanner()
+{
+    stop();
+}
+
+void KNMusicLibraryLoudnessScanner::setLibraryModel(KNMusicLibraryModel *libraryModel)
+{
+    m_libraryModel=libraryModel;
+    //Scan the rows when they are added or recovered from the database.
+    connect(m_libraryModel, &KNMusicLibraryModel::rowsInserted,
+            this, &KNMusicLibraryLoudnessScanner::onActionRowsInserted);
+}
+
+void KNMusicLibraryLoudnessScanner::setBackend(KNMusicBackend *backend)
+{
+    m_backend=backend;
+    if(m_backend==nullptr)
+    {
+        return;
+    }
+    //Slow down when the backend is playing.
+    connect(m_backend, &KNMusicBackend::playingStateChanged,
+            this, &KNMusicLibraryLoudnessScanner::onActionPlayingStateChanged);
+    startTasks();
+}
+
+bool KNMusicLibraryLoudnessScanner::isThrottled() const
+{
+    return m_throttled.load();
+}
+
+bool KNMusicLibraryLoudnessScanner::isCancelled() const
+{
+    return m_cancelled.load();
+}
+
+QMutex *KNMusicLibraryLoudnessScanner::throttleLock()
+{
+    return &m_throttleLock;
+}
+
+void KNMusicLibraryLoudnessScanner::stop()
+{
+    //Cancel all the tasks, and wait for the running ones.
+    m_cancelled.store(1);
+    m_queue.clear();
+    m_threadPool->clear();
+    m_threadPool->waitForDone();
+    m_runningTasks.clear();
+}
+
+void KNMusicLibraryLoudnessScanner::onActionRowsInserted(const QModelIndex &parent,
+                                                         int first,
+                                                         int last)
+{
+    Q_UNUSED(parent)
+    //Add the rows which are not measured and not failed to the queue.
+    for(int row=first; row<=last; row++)
+    {
+        if(!m_libraryModel->roleData(row, Loudness, Qt::UserRole).isValid() &&
+                !m_libraryModel->rowProperty(row,
+                                             LoudnessFailedRole).toBool())
+        {
+            quint32 libraryId=m_libraryModel->rowProperty(row,
+                                                          LibraryIdRole).toUInt();
+            if(libraryId!=0)
+            {
+                m_queue.append(libraryId);
+            }
+        }
+    }
+    startTasks();
+}
+
+void KNMusicLibraryLoudnessScanner::onActionPlayingStateChanged(int state)
+{
+    m_throttled.store(state==PlayingState);
+    //Don't start more tasks when it's playing. The running tasks check the
+    //flag before each chunk, they take turns to decode from now on.
+    m_threadPool->setMaxThreadCount(m_throttled.load()?1:m_maximumTasks);
+    startTasks();
+}
+
+void KNMusicLibraryLoudnessScanner::onActionMeasured(quint64 taskId,
+                                                     bool measured,
+                                                     qreal loudness,
+                                                     qreal truePeak)
+{
+    //The row may be removed when it's being measured.
+    int row=m_libraryModel->rowFromLibraryId(m_runningTasks.take(taskId));
+    if(row!=-1)
+    {
+        if(measured)
+        {
+            m_libraryModel->setLoudness(row, loudness, truePeak);
+            updateAlbumGain(row);
+        }
+        else
+        {
+            //Save the failure, or the file will be decoded every launch.
+            m_libraryModel->setRowProperty(row, LoudnessFailedRole, true);
+        }
+    }
+    startTasks();
+}
+
+void KNMusicLibraryLoudnessScanner::startTasks()
+{
+    if(m_backend==nullptr || m_cancelled.load())
+    {
+        return;
+    }
+    //Only give the pool the tasks it can run now, the rows in the queue may be
+    //removed before they are scanned.
+    while(!m_queue.isEmpty() &&
+          m_runningTasks.size()<m_threadPool->maxThreadCount())
+    {
+        quint32 libraryId=m_queue.takeFirst();
+        int row=m_libraryModel->rowFromLibraryId(libraryId);
+        if(row==-1)
+        {
+            continue;
+        }
+        KNMusicAudioDecoder *decoder=m_backend->createAudioDecoder();
+        if(decoder==nullptr)
+        {
+            //The backend can't decode the files.
+            m_queue.clear();
+            return;
+        }
+        qint64 start=m_libraryModel->rowProperty(row,
+                                                 StartPositionRole).toLongLong(),
+               duration=start==-1?
+                    -1:m_libraryModel->roleData(row,
+                                                Time,
+                                                Qt::UserRole).toLongLong();
+        m_runningTasks.insert(++m_taskId, libraryId);
+        m_threadPool->start(
+                    new KNMusicLoudnessScanTask(
+                        this,
+                        decoder,
+                        m_taskId,
+                        m_libraryModel->rowProperty(row,
+                                                    FilePathRole).toString(),
+                        start,
+                        duration));
+    }
+}
+
+void KNMusicLibraryLoudnessScanner::updateAlbumGain(const int &row)
+{
+    QString albumText=m_libraryModel->itemText(row, Album);
+    if(albumText.isEmpty())
+    {
+        return;
+    }
+    //The different albums may have the same name, an album is the songs which
+    //have both the same album and album artist.
+    QString albumArtistText=m_libraryModel->itemText(row, AlbumArtist);
+    KNMusicCategoryRows categoryRows=m_libraryModel->categoryRows(Album,
+                                                                  albumText);
+    QList<int> albumRows;
+    for(QSet<QStandardItem *>::const_iterator i=categoryRows->constBegin();
+        i!=categoryRows->constEnd();
+        ++i)
+    {
+        int albumRow=(*i)->row();
+        if(m_libraryModel->itemText(albumRow, AlbumArtist)==albumArtistText)
+        {
+            albumRows.append(albumRow);
+        }
+    }
+    //The album loudness is the power mean of the song loudness, weighted by the
+    //duration. Calculate it when all the songs of the album are measured, the
+    //songs which can't be decoded are skipped.
+    double energy=0.0, totalDuration=0.0;
+    for(QList<int>::const_iterator i=albumRows.constBegin();
+        i!=albumRows.constEnd();
+        ++i)
+    {
+        int albumRow=*i;
+        if(m_libraryModel->rowProperty(albumRow, LoudnessFailedRole).toBool())
+        {
+            continue;
+        }
+        QVariant loudness=m_libraryModel->roleData(albumRow,
+                                                   Loudness,
+                                                   Qt::UserRole);
+        if(!loudness.isValid())
+        {
+            return;
+        }
+        double duration=qMax(m_libraryModel->roleData(albumRow,
+                                                      Time,
+                                                      Qt::UserRole).toLongLong(),
+                             (qint64)1);
+        energy+=duration*pow(10.0, loudness.toDouble()/10.0);
+        totalDuration+=duration;
+    }
+    if(totalDuration==0.0)
+    {
+        return;
+    }
+    qreal albumGain=KNMusicLoudnessMeter::gain(10.0*log10(energy/totalDuration));
+    for(QList<int>::const_iterator i=albumRows.constBegin();
+        i!=albumRows.constEnd();
+        ++i)
+    {
+        if(!m_libraryModel->rowProperty(*i, LoudnessFailedRole).toBool())
+        {
+            m_libraryModel->setAlbumGain(*i, albumGain);
+        }
+    }
+}
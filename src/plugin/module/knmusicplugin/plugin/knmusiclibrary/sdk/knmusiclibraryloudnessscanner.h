@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+#ifndef KNMUSICLIBRARYLOUDNESSSCANNER_H
+#define KNMUSICLIBRARYLOUDNESSSCANNER_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QLinkedList>
+#include <QMutex>
+
+#include <QObject>
+
+class QThreadPool;
+class KNMusicBackend;
+class KNMusicLibraryModel;
+/*
+ * The loudness scanner measures the songs in the library in the background.
+ * The songs are decoded by a thread pool, the loudness and the true peak are
+ * saved to the library, and the album gain is calculated when all the songs
+ * of an album are measured. Only the songs which are not measured are
+ * scanned, so the scanning continues after the library is loaded next time.
+ * When the backend is playing, the running tasks take turns to decode a chunk
+ * and sleep after it, so together they are as slow as one throttled task.
+ * The queue keeps the library ids of the rows, they are found again when the
+ * tasks finish. The files which can't be decoded are marked, and they won't
+ * be scanned again.
+ */
+class KNMusicLibraryLoudnessScanner : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KNMusicLibraryLoudnessScanner(QObject *parent = 0);
+    ~KNMusicLibraryLoudnessScanner();
+    void setLibraryModel(KNMusicLibraryModel *libraryModel);
+    void setBackend(KNMusicBackend *backend);
+    bool isThrottled() const;
+    bool isCancelled() const;
+    QMutex *throttleLock();
+
+signals:
+
+public slots:
+    void stop();
+
+private slots:
+    void onActionRowsInserted(const QModelIndex &parent, int first, int last);
+    void onActionPlayingStateChanged(int state);
+    void onActionMeasured(quint64 taskId,
+                          bool measured,
+                          qreal loudness,
+                          qreal truePeak);
+
+private:
+    void startTasks();
+    void updateAlbumGain(const int &row);
+    QThreadPool *m_threadPool;
+    QLinkedList<quint32> m_queue;
+    QHash<quint64, quint32> m_runningTasks;
+    quint64 m_taskId=0;
+    KNMusicLibraryModel *m_libraryModel=nullptr;
+    KNMusicBackend *m_backend=nullptr;
+    QAtomicInt m_throttled, m_cancelled;
+    QMutex m_throttleLock;
+    int m_maximumTasks;
+};
+
+#endif // KNMUSICLIBRARYLOUDNESSSCANNER_H
@@ -23,6 +23,7 @@
 #include "knmusiclibraryimagemanager.h"
 
 #include "knlocalemanager.h"
+#include "knmusicstringpool.h"
 
 #include "knmusiclibrarymodel.h"
 
@@ -113,6 +114,12 @@ int KNMusicLibraryModel::rowFromDetailInfo(const KNMusicDetailInfo &detailInfo)
     return -1;
 }
 
+int KNMusicLibraryModel::rowFromLibraryId(const quint32 &libraryId)
+{
+    QStandardItem *rowItem=m_libraryIdItems.value(libraryId, nullptr);
+    return rowItem==nullptr?-1:rowItem->row();
+}
+
 int KNMusicLibraryModel::playingItemColumn()
 {
     return BlankData;
@@ -152,9 +159,50 @@ void KNMusicLibraryModel::setItemText(const int &row,
     updateRowInDatabase(row);
 }
 
+void KNMusicLibraryModel::setLoudness(const int &row,
+                                      const qreal &loudness,
+                                      const qreal &truePeak)
+{
+    //Save the measure result, the text of the columns are derived from them.
+    setRoleData(row, Loudness, Qt::UserRole, loudness);
+    setRoleData(row, TruePeak, Qt::UserRole, truePeak);
+    //Update the row in database.
+    updateRowInDatabase(row);
+}
+
+void KNMusicLibraryModel::setAlbumGain(const int &row, const qreal &albumGain)
+{
+    setRoleData(row, AlbumGain, Qt::UserRole, albumGain);
+    //Update the row in database.
+    updateRowInDatabase(row);
+}
+
 void KNMusicLibraryModel::installCategoryModel(KNMusicCategoryModel *model)
 {
     m_categoryModels.append(model);
+    //Category models need the pixmap list to replace their artworks.
+    model->setPixmapList(m_coverImageList);
+}
+
+KNMusicCategoryRows KNMusicLibraryModel::categoryRows(const int &column,
+                                                      const QString &categoryText)
+{
+    Q_ASSERT(column>-1 && column<MusicDataCount);
+    //Only the category column of the installed category models is indexed.
+    //If the category doesn't exist now, generate an empty posting list for it,
+    //the rows added later will still be added to this list.
+    int textId=KNMusicStringPool::instance()->id(categoryText);
+    KNMusicCategoryRows &rows=m_categoryRows[column][textId];
+    if(rows.isNull())
+    {
+        //Use the released list if a proxy model is still holding it.
+        rows=m_releasedCategoryRows[column].take(categoryText).toStrongRef();
+        if(rows.isNull())
+        {
+            rows=KNMusicCategoryRows(new QSet<QStandardItem *>());
+        }
+    }
+    return rows;
 }
 
 void KNMusicLibraryModel::retranslate()
@@ -197,6 +245,13 @@ void KNMusicLibraryModel::addFiles(const QStringList &fileList)
 
 void KNMusicLibraryModel::appendMusicRow(const QList<QStandardItem *> &musicRow)
 {
+    //Add the row to the category posting lists. This must be done before the
+    //row is added, proxy models will check the new row when it's inserted.
+    addCategoryRows(musicRow);
+    //Count the artwork key of the row.
+    retainArtworkKey(musicRow.at(Name)->data(ArtworkKeyRole).toString());
+    //Give the row an id.
+    registerLibraryId(musicRow);
     //Add the row to model.
     KNMusicModel::appendMusicRow(musicRow);
     //Add the row to database.
@@ -213,16 +268,58 @@ void KNMusicLibraryModel::appendMusicRow(const QList<QStandardItem *> &musicRow)
 void KNMusicLibraryModel::updateMusicRow(const int &row,
                                          const KNMusicDetailInfo &detailInfo)
 {
+    //Get the original row.
+    QList<QStandardItem *> currentRow=rowItems(row);
+    //Find out the category models whose category text will be changed.
+    QLinkedList<KNMusicCategoryModel *> changedModels;
+    for(QLinkedList<KNMusicCategoryModel *>::iterator i=m_categoryModels.begin();
+        i!=m_categoryModels.end();
+        ++i)
+    {
+        int categoryColumn=(*i)->categoryIndex();
+        QString originalText=currentRow.at(categoryColumn)->text();
+        if(originalText!=detailInfo.textLists[categoryColumn])
+        {
+            //Remove the row from the original category.
+            (*i)->onCategoryRemoved(currentRow);
+            //Move the row to the new posting list before the text is changed,
+            //proxy models will check the row again when the data changed.
+            removeCategoryRow(currentRow.at(Name),
+                              categoryColumn,
+                              originalText);
+            categoryRows(categoryColumn,
+                         detailInfo.textLists[categoryColumn])->insert(
+                        currentRow.at(Name));
+            changedModels.append(*i);
+        }
+    }
     //Do row udpates operate.
     KNMusicModel::updateMusicRow(row, detailInfo);
     //Update the row in database.
     updateRowInDatabase(row);
+    //Add the row to the new categories, the artwork of the row will be added
+    //to the new categories as well.
+    for(QLinkedList<KNMusicCategoryModel *>::iterator i=changedModels.begin();
+        i!=changedModels.end();
+        ++i)
+    {
+        (*i)->onCategoryAdded(currentRow);
+    }
 }
 
 void KNMusicLibraryModel::updateCoverImage(const int &row,
                                            const KNMusicAnalysisItem &analysisItem)
 {
     const KNMusicDetailInfo &detailInfo=analysisItem.detailInfo;
+    //Update the artwork key counter.
+    QString previousArtworkKey=rowProperty(row, ArtworkKeyRole).toString();
+    retainArtworkKey(detailInfo.coverImageHash);
+    if(releaseArtworkKey(previousArtworkKey))
+    {
+        //Remove the image from the disk and hash list.
+        m_imageManager->removeImage(previousArtworkKey);
+        m_coverImageList->removeImage(previousArtworkKey);
+    }
     //Ask to update the image key in the database.
     m_database->updateArtworkKey(row, detailInfo.coverImageHash);
     //Set the artwork key for the model.
@@ -235,6 +332,7 @@ void KNMusicLibraryModel::updateCoverImage(const int &row,
         ++i)
     {
         (*i)->onCoverImageUpdate(detailInfo.textLists[(*i)->categoryIndex()],
+                                 previousArtworkKey,
                                  detailInfo.coverImageHash,
                                  coverImagePixmap);
     }
@@ -242,15 +340,17 @@ void KNMusicLibraryModel::updateCoverImage(const int &row,
 
 void KNMusicLibraryModel::removeMusicRow(const int &row)
 {
+    //Release the id of the row.
+    removeLibraryIds(QList<int>()<<row);
     //Remove the row from the database.
     m_database->removeMusicRow(row);
     //Quick generate the row, this shouldn't so slow.
-    QList<QStandardItem *> currentRow;
-    for(int i=0; i<columnCount(); i++)
-    {
-        currentRow.append(item(row, i));
-    }
-    //Ask category model to remove this row.
+    QList<QStandardItem *> currentRow=rowItems(row);
+    //Remove the row from the category posting lists.
+    removeCategoryRows(currentRow);
+    //Ask category model to remove this row. The category models track their
+    //own artwork candidates, they will replace their artworks if the artwork
+    //of this row is the last one they use.
     for(QLinkedList<KNMusicCategoryModel *>::iterator i=m_categoryModels.begin();
         i!=m_categoryModels.end();
         ++i)
@@ -261,63 +361,67 @@ void KNMusicLibraryModel::removeMusicRow(const int &row)
     QString currentArtworkKey=rowProperty(row, ArtworkKeyRole).toString();
     //Remove the row.
     KNMusicModel::removeMusicRow(row);
-    //Check the artwork key after remove the row.
     //If no one use this artwork key any more, remove the artwork.
-    if(match(index(0,0),
-             ArtworkKeyRole,
-             currentArtworkKey,
-             1,
-             Qt::MatchFixedString | Qt::MatchCaseSensitive).isEmpty())
+    if(releaseArtworkKey(currentArtworkKey))
     {
         //Remove the image from the disk and hash list.
         m_imageManager->removeImage(currentArtworkKey);
         m_coverImageList->removeImage(currentArtworkKey);
-        //Ask category model to remove the image and replace it.
-        for(QLinkedList<KNMusicCategoryModel *>::iterator i=m_categoryModels.begin();
-            i!=m_categoryModels.end();
-            ++i)
+    }
+    //Check row count before remove row.
+    if(rowCount()==0)
+    {
+        emit libraryEmpty();
+    }
+}
+
+void KNMusicLibraryModel::removeMusicRows(const QList<int> &rows)
+{
+    //Sort the rows, and remove the duplicate rows.
+    QList<int> sortedRows=sortedUniqueRows(rows);
+    if(sortedRows.isEmpty())
+    {
+        return;
+    }
+    //Release the ids of the rows.
+    removeLibraryIds(sortedRows);
+    //Remove all the rows from the database in one compaction.
+    m_database->removeMusicRows(sortedRows);
+    //Collect the removed rows and their artwork keys.
+    QList<QList<QStandardItem *> > removedRows;
+    QStringList removedArtworkKeys;
+    for(QList<int>::const_iterator i=sortedRows.begin();
+        i!=sortedRows.end();
+        ++i)
+    {
+        QList<QStandardItem *> currentRow=rowItems(*i);
+        //Remove the row from the category posting lists.
+        removeCategoryRows(currentRow);
+        removedRows.append(currentRow);
+        removedArtworkKeys.append(rowProperty(*i, ArtworkKeyRole).toString());
+    }
+    //Ask category models to remove all the rows in one pass.
+    for(QLinkedList<KNMusicCategoryModel *>::iterator i=m_categoryModels.begin();
+        i!=m_categoryModels.end();
+        ++i)
+    {
+        (*i)->onCategoryRowsRemoved(removedRows);
+    }
+    //Remove the rows by ranges.
+    KNMusicModel::removeMusicRows(sortedRows);
+    //Remove the artworks which are not used by anyone.
+    for(QStringList::const_iterator i=removedArtworkKeys.begin();
+        i!=removedArtworkKeys.end();
+        ++i)
+    {
+        if(releaseArtworkKey(*i))
         {
-            //If the category model is asking to update album art, update it.
-            if((*i)->updateAlbumArt())
-            {
-                QModelIndexList keyRemovedIndex=
-                        (*i)->match((*i)->index(0,0),
-                                    CategoryArtworkKeyRole,
-                                    currentArtworkKey,
-                                    -1,
-                                    Qt::MatchFixedString);
-                //Replace all the artworks.
-                for(QModelIndexList::iterator j=keyRemovedIndex.begin();
-                    j!=keyRemovedIndex.end();
-                    ++j)
-                {
-                    //Search the category text in model.
-                    QModelIndexList categoryList=match(index(0, (*i)->categoryIndex()),
-                                                       Qt::DisplayRole,
-                                                       (*i)->data(*j).toString(),
-                                                       -1,
-                                                       Qt::MatchExactly);
-                    //Try to find the text.
-                    for(QModelIndexList::iterator k=categoryList.begin();
-                        k!=categoryList.end();
-                        ++k)
-                    {
-                        //Get the artwork from the row property.
-                        QString artworkKey=rowProperty((*k).row(), ArtworkKeyRole).toString();
-                        //Check the artwork key.
-                        if(!artworkKey.isEmpty())
-                        {
-                            (*i)->changeAlbumArt((*j),
-                                                 artworkKey,
-                                                 QIcon(artwork(artworkKey)));
-                            break;
-                        }
-                    }
-                }
-            }
+            //Remove the image from the disk and hash list.
+            m_imageManager->removeImage(*i);
+            m_coverImageList->removeImage(*i);
         }
     }
-    //Check row count before remove row.
+    //Check row count after remove the rows.
     if(rowCount()==0)
     {
         emit libraryEmpty();
@@ -341,8 +445,18 @@ void KNMusicLibraryModel::appendLibraryMusicRow(const QList<QStandardItem *> &mu
 
 void KNMusicLibraryModel::recoverMusicRow(const QList<QStandardItem *> &musicRow)
 {
+    //Add the row to the category posting lists.
+    addCategoryRows(musicRow);
+    //Count the artwork key of the row.
+    retainArtworkKey(musicRow.at(Name)->data(ArtworkKeyRole).toString());
+    //Recover the id of the row, the rows without id get a new one.
+    bool idAllocated=registerLibraryId(musicRow);
     //Add the row to model.
     KNMusicModel::appendMusicRow(musicRow);
+    if(idAllocated)
+    {
+        m_database->updateMusicRow(rowCount()-1, musicRow);
+    }
     //Add the row data to category models.
     for(QLinkedList<KNMusicCategoryModel *>::iterator i=m_categoryModels.begin();
         i!=m_categoryModels.end();
@@ -368,6 +482,56 @@ void KNMusicLibraryModel::imageRecoverComplete()
     }
 }
 
+void KNMusicLibraryModel::compactStringPool()
+{
+    KNMusicStringPool *stringPool=KNMusicStringPool::instance();
+    //Collect the ids which are used as keys.
+    QSet<int> usedIds;
+    for(int column=0; column<MusicDataCount; column++)
+    {
+        //Drop the weak pointers of the lists which no one holds.
+        QHash<QString, QWeakPointer<QSet<QStandardItem *>>>::iterator
+                releasedIterator=m_releasedCategoryRows[column].begin();
+        while(releasedIterator!=m_releasedCategoryRows[column].end())
+        {
+            if((*releasedIterator).isNull())
+            {
+                releasedIterator=
+                        m_releasedCategoryRows[column].erase(releasedIterator);
+                continue;
+            }
+            ++releasedIterator;
+        }
+        //Release the empty posting lists, so their texts could be released.
+        QHash<int, KNMusicCategoryRows>::iterator rowsIterator=
+                m_categoryRows[column].begin();
+        while(rowsIterator!=m_categoryRows[column].end())
+        {
+            if((*rowsIterator)->isEmpty())
+            {
+                //Copy the text, or the key will keep the text in the pool.
+                QString categoryText=stringPool->text(rowsIterator.key());
+                m_releasedCategoryRows[column].insert(
+                            QString(categoryText.constData(),
+                                    categoryText.size()),
+                            (*rowsIterator).toWeakRef());
+                rowsIterator=m_categoryRows[column].erase(rowsIterator);
+                continue;
+            }
+            usedIds.insert(rowsIterator.key());
+            ++rowsIterator;
+        }
+    }
+    for(QLinkedList<KNMusicCategoryModel *>::iterator i=m_categoryModels.begin();
+        i!=m_categoryModels.end();
+        ++i)
+    {
+        (*i)->collectTextIds(usedIds);
+    }
+    //Release the texts which no one is using.
+    stringPool->compact(usedIds);
+}
+
 inline void KNMusicLibraryModel::initialHeader()
 {
     //Using retranslate to update the header text.
@@ -388,6 +552,12 @@ inline void KNMusicLibraryModel::initialHeader()
 }
 
 inline void KNMusicLibraryModel::updateRowInDatabase(const int &row)
+{
+    //Ask to update the row in the database.
+    m_database->updateMusicRow(row, rowItems(row));
+}
+
+inline QList<QStandardItem *> KNMusicLibraryModel::rowItems(const int &row)
 {
     //Quick generate the row, this shouldn't so slow.
     QList<QStandardItem *> currentRow;
@@ -395,8 +565,131 @@ inline void KNMusicLibraryModel::updateRowInDatabase(const int &row)
     {
         currentRow.append(item(row, i));
     }
-    //Ask to update the row in the database.
-    m_database->updateMusicRow(row, currentRow);
+    return currentRow;
+}
+
+inline bool KNMusicLibraryModel::registerLibraryId(
+        const QList<QStandardItem *> &musicRow)
+{
+    QStandardItem *rowItem=musicRow.at(Name);
+    quint32 libraryId=rowItem->data(LibraryIdRole).toUInt();
+    //Keep the id of the row if it's available.
+    if(libraryId!=0 && !m_libraryIdItems.contains(libraryId))
+    {
+        m_libraryIdItems.insert(libraryId, rowItem);
+        m_nextLibraryId=qMax(m_nextLibraryId, libraryId+1);
+        return false;
+    }
+    //Allocate a new id for the row.
+    m_nextLibraryId=qMax(m_nextLibraryId, m_database->nextLibraryId());
+    libraryId=m_nextLibraryId++;
+    saveNextLibraryId();
+    rowItem->setData(libraryId, LibraryIdRole);
+    m_libraryIdItems.insert(libraryId, rowItem);
+    return true;
+}
+
+inline void KNMusicLibraryModel::removeLibraryIds(const QList<int> &sortedRows)
+{
+    QList<quint32> libraryIds;
+    for(QList<int>::const_iterator i=sortedRows.begin();
+        i!=sortedRows.end();
+        ++i)
+    {
+        libraryIds.append(rowProperty(*i, LibraryIdRole).toUInt());
+    }
+    //Let the playlists save the songs before their ids are released, only the
+    //songs in the playlists are read.
+    emit libraryIdsAboutToBeRemoved(libraryIds);
+    for(QList<quint32>::const_iterator i=libraryIds.begin();
+        i!=libraryIds.end();
+        ++i)
+    {
+        m_libraryIdItems.remove(*i);
+    }
+    saveNextLibraryId();
+}
+
+inline void KNMusicLibraryModel::saveNextLibraryId()
+{
+    //The next id is saved in the database, so the id of a removed row won't be
+    //allocated again after restarting, the playlists could still keep it.
+    if(m_database->nextLibraryId()<m_nextLibraryId)
+    {
+        m_database->setNextLibraryId(m_nextLibraryId);
+    }
+}
+
+inline void KNMusicLibraryModel::addCategoryRows(const QList<QStandardItem *> &musicRow)
+{
+    //The first item of the row is used as the row id.
+    for(QLinkedList<KNMusicCategoryModel *>::iterator i=m_categoryModels.begin();
+        i!=m_categoryModels.end();
+        ++i)
+    {
+        int categoryColumn=(*i)->categoryIndex();
+        categoryRows(categoryColumn,
+                     musicRow.at(categoryColumn)->text())->insert(musicRow.at(Name));
+    }
+}
+
+inline void KNMusicLibraryModel::removeCategoryRows(const QList<QStandardItem *> &musicRow)
+{
+    for(QLinkedList<KNMusicCategoryModel *>::iterator i=m_categoryModels.begin();
+        i!=m_categoryModels.end();
+        ++i)
+    {
+        int categoryColumn=(*i)->categoryIndex();
+        removeCategoryRow(musicRow.at(Name),
+                          categoryColumn,
+                          musicRow.at(categoryColumn)->text());
+    }
+}
+
+inline void KNMusicLibraryModel::removeCategoryRow(QStandardItem *rowItem,
+                                                   const int &column,
+                                                   const QString &categoryText)
+{
+    QHash<int, KNMusicCategoryRows>::iterator rowsIterator=
+            m_categoryRows[column].find(
+                KNMusicStringPool::instance()->findId(categoryText));
+    //Check the posting list is exist or not.
+    if(rowsIterator==m_categoryRows[column].end())
+    {
+        return;
+    }
+    //Keep the posting list even when it's empty. The proxy model of an opened
+    //category keeps using the same list, the rows added to the category later
+    //must go to this list. The empty lists are released when compacting the
+    //string pool.
+    (*rowsIterator)->remove(rowItem);
+}
+
+inline void KNMusicLibraryModel::retainArtworkKey(const QString &artworkKey)
+{
+    //Ignore the row which doesn't have an artwork.
+    if(!artworkKey.isEmpty())
+    {
+        m_artworkKeyCount.insert(artworkKey,
+                                 m_artworkKeyCount.value(artworkKey)+1);
+    }
+}
+
+inline bool KNMusicLibraryModel::releaseArtworkKey(const QString &artworkKey)
+{
+    //Find the counter of the key.
+    QHash<QString, int>::iterator keyIterator=m_artworkKeyCount.find(artworkKey);
+    if(keyIterator==m_artworkKeyCount.end())
+    {
+        return false;
+    }
+    //Reduce the counter, if there's no row use the key, remove the key.
+    if((--(*keyIterator))==0)
+    {
+        m_artworkKeyCount.erase(keyIterator);
+        return true;
+    }
+    return false;
 }
 
 KNMusicLibraryImageManager *KNMusicLibraryModel::imageManager() const
@@ -425,4 +718,8 @@ void KNMusicLibraryModel::setDatabase(KNMusicLibraryDatabase *database)
     //Linked request.
     connect(m_database, &KNMusicLibraryDatabase::requireRecoverMusicRow,
             this, &KNMusicLibraryModel::recoverMusicRow);
+    //The texts of the removed rows are released after they are saved.
+    connect(m_database, &KNMusicLibraryDatabase::written,
+            this, &KNMusicLibraryModel::compactStringPool,
+            Qt::QueuedConnection);
 }
@@ -18,6 +18,7 @@
 #ifndef KNMUSICLIBRARYMODEL_H
 #define KNMUSICLIBRARYMODEL_H
 
+#include <QHash>
 #include <QLinkedList>
 
 #include "knmusiccategorymodel.h"
@@ -38,6 +39,7 @@ public:
     QPixmap artwork(const QString &key);
     int rowFromFilePath(const QString &filePath);
     int rowFromDetailInfo(const KNMusicDetailInfo &detailInfo);
+    int rowFromLibraryId(const quint32 &libraryId);
     int playingItemColumn();
     bool dropMimeData(const QMimeData *data,
                       Qt::DropAction action,
@@ -50,7 +52,13 @@ public:
     void setItemText(const int &row,
                      const int &column,
                      const QString &text);
+    void setLoudness(const int &row,
+                     const qreal &loudness,
+                     const qreal &truePeak);
+    void setAlbumGain(const int &row, const qreal &albumGain);
     void installCategoryModel(KNMusicCategoryModel *model);
+    KNMusicCategoryRows categoryRows(const int &column,
+                                     const QString &categoryText);
     KNMusicLibraryDatabase *database() const;
     void setDatabase(KNMusicLibraryDatabase *database);
     KNMusicLibraryImageManager *imageManager() const;
@@ -60,6 +68,7 @@ signals:
     void libraryNotEmpty();
     void libraryEmpty();
     void hashRemoved();
+    void libraryIdsAboutToBeRemoved(QList<quint32> libraryIds);
 
 public slots:
     void retranslate();
@@ -70,16 +79,41 @@ public slots:
     void updateCoverImage(const int &row,
                           const KNMusicAnalysisItem &analysisItem);
     void removeMusicRow(const int &row);
+    void removeMusicRows(const QList<int> &rows);
 
 private slots:
     void appendLibraryMusicRow(const QList<QStandardItem *> &musicRow,
                                const KNMusicAnalysisItem &analysisItem);
     void recoverMusicRow(const QList<QStandardItem *> &musicRow);
     void imageRecoverComplete();
+    void compactStringPool();
 
 private:
     inline void initialHeader();
     inline void updateRowInDatabase(const int &row);
+    inline QList<QStandardItem *> rowItems(const int &row);
+    inline void addCategoryRows(const QList<QStandardItem *> &musicRow);
+    inline void removeCategoryRows(const QList<QStandardItem *> &musicRow);
+    inline void removeCategoryRow(QStandardItem *rowItem,
+                                  const int &column,
+                                  const QString &categoryText);
+    inline bool registerLibraryId(const QList<QStandardItem *> &musicRow);
+    inline void saveNextLibraryId();
+    inline void removeLibraryIds(const QList<int> &sortedRows);
+    inline void retainArtworkKey(const QString &artworkKey);
+    inline bool releaseArtworkKey(const QString &artworkKey);
+    //The posting lists are keyed on the id of the category text in the string
+    //pool.
+    QHash<int, KNMusicCategoryRows> m_categoryRows[MusicDataCount];
+    //The empty posting lists which are removed when compacting the string pool.
+    //A proxy model may still hold one of them, it will be used again when the
+    //category comes back.
+    QHash<QString, QWeakPointer<QSet<QStandardItem *>>>
+        m_releasedCategoryRows[MusicDataCount];
+    QHash<QString, int> m_artworkKeyCount;
+    //The first item of the row of each library id.
+    QHash<quint32, QStandardItem *> m_libraryIdItems;
+    quint32 m_nextLibraryId=1;
     QLinkedList<KNMusicCategoryModel *> m_categoryModels;
     KNMusicLibraryDatabase *m_database;
     KNMusicGlobal *m_musicGlobal;
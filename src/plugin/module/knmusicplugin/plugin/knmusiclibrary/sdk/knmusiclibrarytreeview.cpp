@@ -16,6 +16,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
 #include "knmusicproxymodel.h"
+#include "knmusiclibrarymodel.h"
 #include "knmusicnowplayingbase.h"
 #include "knmusicdetailtooltipbase.h"
 
@@ -69,10 +70,15 @@ void KNMusicLibraryTreeView::setCategoryText(const QString &fixedText)
     {
         KNMusicGlobal::nowPlaying()->shadowPlayingModel();
     }
-    QRegExp nameFilter("^"+
-                       QRegExp::escape(fixedText)+
-                       "$");
-    nameFilter.setPatternSyntax(QRegExp::RegExp);
-    //Change the filter string.
-    proxyModel()->setFilterRegExp(nameFilter);
+    //Check the music model.
+    if(proxyModel()->musicModel()==nullptr)
+    {
+        return;
+    }
+    //Use the posting list of the category as the filter instead of matching
+    //the category text of every row.
+    proxyModel()->setCategoryRows(
+                static_cast<KNMusicLibraryModel *>(proxyModel()->musicModel())->categoryRows(
+                    proxyModel()->filterKeyColumn(),
+                    fixedText));
 }
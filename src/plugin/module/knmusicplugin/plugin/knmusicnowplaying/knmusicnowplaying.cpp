@@ -15,7 +15,10 @@
  * along with this program; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
  */
+#include <cmath>
+
 #include "knmusicsingleplaylistmodel.h"
+#include "knmusicloudnessmeter.h"
 #include "knmusicmodelassist.h"
 #include "knmusicproxymodel.h"
 #include "knmusicglobal.h"
@@ -56,6 +59,8 @@ void KNMusicNowPlaying::setBackend(KNMusicBackend *backend)
                 this, &KNMusicNowPlaying::onActionPlayingFinished);
         connect(m_backend, &KNMusicBackend::cannotLoadFile,
                 this, &KNMusicNowPlaying::onActionCannotPlay);
+        connect(m_backend, &KNMusicBackend::nextSectionStarted,
+                this, &KNMusicNowPlaying::onActionNextSectionStarted);
     }
 }
 
@@ -78,6 +83,18 @@ void KNMusicNowPlaying::restoreConfigure()
 {
     setLoopState(KNMusicGlobal::instance()->configureData("LoopState",
                                                           NoRepeat).toInt());
+    m_normalizationMode=
+            KNMusicGlobal::instance()->configureData("VolumeNormalization",
+                                                     NormalizationTrack).toInt();
+    m_crossfadeMode=
+            KNMusicGlobal::instance()->configureData("Crossfade",
+                                                     CrossfadeOff).toInt();
+    m_crossfadeDuration=
+            KNMusicGlobal::instance()->configureData("CrossfadeDuration",
+                                                     5000).toInt();
+    m_crossfadeAlbums=
+            KNMusicGlobal::instance()->configureData("CrossfadeAlbums",
+                                                     false).toBool();
 }
 
 void KNMusicNowPlaying::playNext()
@@ -154,6 +171,8 @@ void KNMusicNowPlaying::setLoopState(const int &state)
     m_loopMode=state%LoopCount;
     //Emit the loop changed signal.
     emit loopStateChanged(m_loopMode);
+    //The next song might be changed.
+    prepareNextSong();
 }
 
 void KNMusicNowPlaying::playTemporaryFiles(const QStringList &filePaths)
@@ -222,6 +241,8 @@ void KNMusicNowPlaying::playMusic(const int &row)
         //Update the data in proxy model.
         m_playingMusicModel->updateMusicRow(m_currentPlayingIndex.row(),
                                             currentInfo);
+        //Set the normalize gain before the file is loaded.
+        m_backend->setGain(rowGain(m_currentPlayingIndex.row()));
         //Ask backend to play the file.
         if(currentInfo.startPosition==-1)
         {
@@ -235,6 +256,8 @@ void KNMusicNowPlaying::playMusic(const int &row)
         }
         //Update the player's data.
         emit requireUpdatePlayerInfo(currentItem);
+        //Let the backend open the next song before this one is finished.
+        prepareNextSong();
     }
 }
 
@@ -258,6 +281,13 @@ void KNMusicNowPlaying::checkRemovedModel(KNMusicModel *model)
 void KNMusicNowPlaying::saveConfigure()
 {
     KNMusicGlobal::instance()->setConfigureData("LoopState", m_loopMode);
+    KNMusicGlobal::instance()->setConfigureData("VolumeNormalization",
+                                                m_normalizationMode);
+    KNMusicGlobal::instance()->setConfigureData("Crossfade", m_crossfadeMode);
+    KNMusicGlobal::instance()->setConfigureData("CrossfadeDuration",
+                                                m_crossfadeDuration);
+    KNMusicGlobal::instance()->setConfigureData("CrossfadeAlbums",
+                                                m_crossfadeAlbums);
 }
 
 void KNMusicNowPlaying::onActionCannotPlay()
@@ -328,10 +358,105 @@ void KNMusicNowPlaying::playNextSong(bool cannotLoadFile)
     playMusic(currentIndex.row()+1);
 }
 
+void KNMusicNowPlaying::prepareNextSong()
+{
+    //Clear the previous prepared song.
+    m_nextPlayingIndex=QPersistentModelIndex();
+    if(m_backend==nullptr)
+    {
+        return;
+    }
+    m_backend->clearNextSection();
+    //Check the playing model and the current index.
+    if(m_playingModel==nullptr || !m_currentPlayingIndex.isValid())
+    {
+        return;
+    }
+    //Find the row which will be played after the current one, it's the same
+    //as playNextSong().
+    int nextRow=m_playingModel->mapFromSource(m_currentPlayingIndex).row();
+    if(m_loopMode!=RepeatTrack)
+    {
+        nextRow++;
+        if(nextRow==m_playingModel->rowCount())
+        {
+            if(m_loopMode==NoRepeat)
+            {
+                return;
+            }
+            nextRow=0;
+        }
+    }
+    QPersistentModelIndex nextIndex=
+            QPersistentModelIndex(m_playingModel->mapToSource(
+                m_playingModel->index(nextRow,
+                                      m_playingModel->playingItemColumn())));
+    //Parse the next index, if we cannot parse it, it will be played in the
+    //old way.
+    KNMusicAnalysisItem nextItem;
+    if(!KNMusicModelAssist::reanalysisRow(m_playingMusicModel,
+                                          nextIndex,
+                                          nextItem))
+    {
+        return;
+    }
+    //Save the next song.
+    m_nextPlayingIndex=nextIndex;
+    m_nextItem=nextItem;
+    //Ask backend to prepare the file.
+    const KNMusicDetailInfo &nextInfo=m_nextItem.detailInfo;
+    m_backend->setNextSectionGain(rowGain(nextIndex.row()));
+    m_backend->setNextSectionCrossfade(
+                isContinuous(m_currentPlayingIndex.row(), nextIndex.row())?
+                    CrossfadeOff:m_crossfadeMode,
+                m_crossfadeDuration);
+    m_backend->prepareNextSection(nextInfo.filePath,
+                                  nextInfo.startPosition,
+                                  nextInfo.startPosition==-1?
+                                      -1:nextInfo.duration);
+    emit nextSongPrepared(m_nextItem);
+}
+
+void KNMusicNowPlaying::onActionNextSectionStarted()
+{
+    //The current song is finished, add play times.
+    if(m_playingModel!=nullptr && m_currentPlayingIndex.isValid())
+    {
+        m_playingModel->addPlayTimes(m_currentPlayingIndex);
+        //Clear the playing icon.
+        m_playingMusicModel->setData(m_currentPlayingIndex,
+                                     QPixmap(),
+                                     Qt::DecorationRole);
+    }
+    //The prepared song is playing now.
+    m_currentPlayingIndex=m_nextPlayingIndex;
+    if(m_currentPlayingIndex.isValid())
+    {
+        //Set the current playing icon.
+        m_playingMusicModel->setRoleData(m_currentPlayingIndex.row(),
+                                         BlankData,
+                                         Qt::DecorationRole,
+                                         m_playingIcon);
+        //Update the data in proxy model.
+        m_playingMusicModel->updateMusicRow(m_currentPlayingIndex.row(),
+                                            m_nextItem.detailInfo);
+    }
+    //Update the player's data.
+    emit requireUpdatePlayerInfo(m_nextItem);
+    //Prepare the song after it.
+    prepareNextSong();
+}
+
 void KNMusicNowPlaying::resetPlayingItem()
 {
     //No matter what, reset header player first.
     emit requireResetPlayer();
+    //The prepared song won't be played.
+    m_nextPlayingIndex=QPersistentModelIndex();
+    if(m_backend!=nullptr)
+    {
+        m_backend->clearNextSection();
+    }
     //Check is the current item null, if not, clear the playing icon.
     if(m_currentPlayingIndex.isValid())
     {
@@ -356,6 +481,7 @@ void KNMusicNowPlaying::resetPlayingModels()
     m_shadowPlayingModel->setSortRole(-1);
     m_shadowPlayingModel->setFilterFixedString("");
     m_shadowPlayingModel->setFilterRole(-1);
+    m_shadowPlayingModel->setCategoryRows(KNMusicCategoryRows());
     //Clear music model.
     m_playingMusicModel=nullptr;
 }
@@ -387,6 +513,7 @@ void KNMusicNowPlaying::shadowPlayingModel()
         m_shadowPlayingModel->setFilterRole(m_playingModel->filterRole());
         m_shadowPlayingModel->setFilterCaseSensitivity(m_playingModel->filterCaseSensitivity());
         m_shadowPlayingModel->setFilterKeyColumn(m_playingModel->filterKeyColumn());
+        m_shadowPlayingModel->setCategoryRows(m_playingModel->categoryRows());
         //--Copy the source model.
         m_shadowPlayingModel->setSourceModel(m_playingModel->sourceModel());
         //--Copy the sort options.
@@ -414,9 +541,80 @@ void KNMusicNowPlaying::shadowPlayingModel()
     {
         m_playingMusicModel=m_playingModel->musicModel();
     }
+    //The order of the playing model is changed, prepare the next song again.
+    prepareNextSong();
 }
 
 void KNMusicNowPlaying::resetCurrentPlaying()
 {
     resetPlayingItem();
 }
+
+inline qreal KNMusicNowPlaying::rowGain(const int &row)
+{
+    //The loudness is measured by the library, the other models don't have it.
+    QVariant loudness=m_playingMusicModel->roleData(row,
+                                                    Loudness,
+                                                    Qt::UserRole);
+    if(m_normalizationMode==NormalizationOff || !loudness.isValid())
+    {
+        return 1.0;
+    }
+    qreal gain=KNMusicLoudnessMeter::gain(loudness.toReal());
+    if(m_normalizationMode==NormalizationAlbum)
+    {
+        QVariant albumGain=m_playingMusicModel->roleData(row,
+                                                         AlbumGain,
+                                                         Qt::UserRole);
+        if(albumGain.isValid())
+        {
+            gain=albumGain.toReal();
+        }
+    }
+    //Never let the true peak go over 0 dBTP.
+    qreal truePeak=m_playingMusicModel->roleData(row,
+                                                 TruePeak,
+                                                 Qt::UserRole).toReal();
+    return qMin(pow(10.0, gain/20.0), pow(10.0, -truePeak/20.0));
+}
+
+inline bool KNMusicNowPlaying::isContinuous(const int &row, const int &nextRow)
+{
+    //The tracks of a cue image are always continuous.
+    if(m_playingMusicModel->rowProperty(row, FilePathRole)==
+            m_playingMusicModel->rowProperty(nextRow, FilePathRole))
+    {
+        return true;
+    }
+    if(m_crossfadeAlbums)
+    {
+        return false;
+    }
+    //When the next track of the same album is played, the album is played in
+    //order, keep the transition between the tracks.
+    QString album=m_playingMusicModel->roleData(row,
+                                                Album,
+                                                Qt::DisplayRole).toString();
+    return !album.isEmpty() &&
+            album==m_playingMusicModel->roleData(nextRow,
+                                                 Album,
+                                                 Qt::DisplayRole).toString() &&
+            m_playingMusicModel->roleData(row,
+                                          AlbumArtist,
+                                          Qt::DisplayRole)==
+            m_playingMusicModel->roleData(nextRow,
+                                          AlbumArtist,
+                                          Qt::DisplayRole) &&
+            m_playingMusicModel->roleData(row,
+                                          DiscNumber,
+                                          Qt::DisplayRole)==
+            m_playingMusicModel->roleData(nextRow,
+                                          DiscNumber,
+                                          Qt::DisplayRole) &&
+            m_playingMusicModel->roleData(row,
+                                          TrackNumber,
+                                          Qt::DisplayRole).toInt()+1==
+            m_playingMusicModel->roleData(nextRow,
+                                          TrackNumber,
+                                          Qt::DisplayRole).toInt();
+}
@@ -58,22 +58,32 @@ public slots:
     void playMusic(const QModelIndex &index);
     void checkRemovedModel(KNMusicModel *model);
 
+private slots:
+    void onActionNextSectionStarted();
+
 private:
     void saveConfigure();
 
     void playNextSong(bool cannotLoadFile=false);
+    void prepareNextSong();
     void resetPlayingItem();
     void resetPlayingModels();
+    inline qreal rowGain(const int &row);
+    inline bool isContinuous(const int &row, const int &nextRow);
     KNMusicBackend *m_backend=nullptr;
     KNMusicSinglePlaylistModel *m_temporaryModel;
     KNMusicModel *m_playingMusicModel=nullptr;
     KNMusicProxyModel *m_playingModel=nullptr,
                       *m_shadowPlayingModel,
                       *m_temporaryProxyModel;
-    QPersistentModelIndex m_currentPlayingIndex;
+    QPersistentModelIndex m_currentPlayingIndex, m_nextPlayingIndex;
+    KNMusicAnalysisItem m_nextItem;
     QPixmap m_playingIcon, m_cantPlayIcon;
     KNMusicTab *m_currentTab=nullptr;
     int m_loopMode=NoRepeat;
+    int m_normalizationMode=NormalizationTrack;
+    int m_crossfadeMode=CrossfadeOff, m_crossfadeDuration=5000;
+    bool m_crossfadeAlbums=false;
 };
 
 #endif // KNMUSICNOWPLAYING_H
@@ -17,6 +17,8 @@
  */
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QSet>
 
 #include "plugin/knmusicxspfparser/knmusicxspfparser.h"
 #include "plugin/knmusicttplparser/knmusicttplparser.h"
@@ -25,6 +27,7 @@
 #include "plugin/knmusicitunesxmlparser/knmusicitunesxmlparser.h"
 
 #include "sdk/knmusicplaylistloader.h"
+#include "sdk/knmusicplaylistsaver.h"
 #include "sdk/knmusicplaylistlistitem.h"
 #include "sdk/knmusicplaylistlistassistant.h"
 #include "sdk/knmusicplaylisttab.h"
@@ -32,6 +35,7 @@
 #include "sdk/knmusicplaylistmodel.h"
 
 #include "knmusicglobal.h"
+#include "knmusiclibrarybase.h"
 #include "knmusicnowplayingbase.h"
 
 #include "knmusicplaylistmanager.h"
@@ -53,6 +57,10 @@ KNMusicPlaylistManager::KNMusicPlaylistManager(QObject *parent) :
 
     //Initial the playlist loader.
     initialPlaylistLoader();
+    connect(m_playlistLoader, &KNMusicPlaylistLoader::playlistImported,
+            this, &KNMusicPlaylistManager::onActionPlaylistImported);
+    //Initial the playlist saver.
+    m_playlistSaver=new KNMusicPlaylistSaver(this);
     //Initial playlist viewer UI.
     m_playlistTab=new KNMusicPlaylistTab(this);
     //Generate the playlist list.
@@ -86,17 +94,28 @@ KNMusicPlaylistManager::KNMusicPlaylistManager(QObject *parent) :
     //When the data of playlist list has been changed, update the detail.
     connect(m_playlistList, &KNMusicPlaylistList::itemChanged,
             m_playlistTab, &KNMusicPlaylistTab::onActionPlaylistItemChanged);
+    //Save the playlist when the name has been changed.
+    connect(m_playlistList, &KNMusicPlaylistList::itemChanged,
+            m_playlistSaver, &KNMusicPlaylistSaver::onActionPlaylistItemChanged);
     //Connect add to item request.
     connect(m_playlistList, &KNMusicPlaylistList::requireAddToPlaylist,
             this, &KNMusicPlaylistManager::onActionAddToPlaylist);
     connect(m_playlistList, &KNMusicPlaylistList::requireCreatePlaylist,
             this, &KNMusicPlaylistManager::onActionCreatePlaylist);
+    //Keep the songs which are removed from the library in the playlists.
+    KNMusicLibraryBase *library=KNMusicGlobal::library();
+    if(library!=nullptr)
+    {
+        connect(library, &KNMusicLibraryBase::libraryIdsAboutToBeRemoved,
+                this, &KNMusicPlaylistManager::onActionLibraryIdsAboutToBeRemoved);
+    }
 }
 
 KNMusicPlaylistManager::~KNMusicPlaylistManager()
 {
-    //Save all the playlist changes first.
-    saveChangedPlaylist();
+    //Save all the playlist changes first, the saver will write them before
+    //it's deleted.
+    m_playlistSaver->saveChangedPlaylists();
     //Check if it has been loaded.
     if(m_playlistListLoaded)
     {
@@ -160,25 +179,19 @@ void KNMusicPlaylistManager::onActionAddToPlaylist(const int &row,
     {
         KNMusicPlaylistListAssistant::buildPlaylist(playlistItem);
     }
-    //Add files to the item.
+    //Add files to the item, the saver will save the new rows.
     playlistItem->playlistModel()->addFiles(filePaths);
-    //Set the changed flag.
-    playlistItem->setChanged(true);
 }
 
 void KNMusicPlaylistManager::onActionRemovePlaylist(const QModelIndex &index)
 {
     int playlistItemRow=index.row();
     //Try to remove the item's file.
-    QFile playlistFile(m_playlistList->playlistItem(playlistItemRow)->playlistFilePath());
-    if(playlistFile.exists())
+    if(!m_playlistSaver->removePlaylistFile(
+                m_playlistList->playlistItem(playlistItemRow)))
     {
-        //Remove the playlist file.
-        if(!playlistFile.remove())
-        {
-            //!FIXME: We need to tell user that we cannot remove the file.
-            return;
-        }
+        //!FIXME: We need to tell user that we cannot remove the file.
+        return;
     }
     //Ask now playing to check the model.
     KNMusicGlobal::nowPlaying()->checkRemovedModel(
@@ -193,8 +206,17 @@ void KNMusicPlaylistManager::onActionImportPlaylist(QStringList playlistPaths)
     KNMusicPlaylistListItem *playlistItem=nullptr, *currentItem;
     while(!playlistPaths.isEmpty())
     {
+        QString currentPath=playlistPaths.takeFirst();
+        //The other playlist files could be very large, e.g. the iTunes
+        //library. They are parsed in the import thread of the loader.
+        if(QFileInfo(currentPath).suffix().toLower()!=
+                KNMusicPlaylistListAssistant::playlistSuffix())
+        {
+            m_playlistLoader->importPlaylist(currentPath);
+            continue;
+        }
         //Import the playlist.
-        currentItem=importPlaylistFromFile(playlistPaths.takeFirst());
+        currentItem=importPlaylistFromFile(currentPath);
         //If load it success, set to the last import item.
         if(currentItem!=nullptr)
         {
@@ -209,6 +231,36 @@ void KNMusicPlaylistManager::onActionImportPlaylist(QStringList playlistPaths)
     }
 }
 
+void KNMusicPlaylistManager::onActionPlaylistImported(QString filePath,
+                                                      QString playlistName,
+                                                      QStringList musicFiles,
+                                                      bool parsed)
+{
+    KNMusicPlaylistListItem *playlistItem;
+    if(parsed)
+    {
+        //Build the playlist with the file list.
+        playlistItem=KNMusicPlaylistListAssistant::generatePlaylist(playlistName);
+        playlistItem->setPlaylistFilePath(KNMusicPlaylistListAssistant::alloctPlaylistFilePath());
+        playlistItem->playlistModel()->addFiles(musicFiles);
+        playlistItem->setChanged(true);
+        //The rows are added to the model directly.
+        playlistItem->setBuilt(true);
+        m_playlistList->appendPlaylist(playlistItem);
+        m_playlistSaver->addPlaylist(playlistItem);
+    }
+    else
+    {
+        //Try the parsers which can only build the playlist in the GUI thread.
+        playlistItem=importPlaylistFromFile(filePath);
+    }
+    if(playlistItem!=nullptr)
+    {
+        //Set to current playlist.
+        m_playlistTab->setCurrentPlaylist(playlistItem->index());
+    }
+}
+
 void KNMusicPlaylistManager::onActionExportPlaylist(const QString &filePath,
                                                     const QModelIndex &index)
 {
@@ -220,7 +272,7 @@ void KNMusicPlaylistManager::onActionCopyPlaylist(const int &index)
     //Get the playlist item.
     KNMusicPlaylistListItem *playlistItem=m_playlistList->playlistItem(index);
     //Save that plalist item first
-    KNMusicPlaylistListAssistant::writePlaylist(playlistItem);
+    m_playlistSaver->writePlaylist(playlistItem);
     //Get a new file name.
     QString copiedFilePath=KNMusicPlaylistListAssistant::alloctPlaylistFilePath();
     //Copy the file in playlist item.
@@ -290,6 +342,74 @@ void KNMusicPlaylistManager::locateIndexInModel(KNMusicModel *model,
     }
 }
 
+void KNMusicPlaylistManager::onActionLibraryIdsAboutToBeRemoved(
+        QList<quint32> libraryIds)
+{
+    //The playlists which haven't been loaded still refer to the ids.
+    if(!m_playlistListLoaded)
+    {
+        loadPlaylistList();
+    }
+    //The snapshots are only generated for the removed songs which are in the
+    //playlists, most of the removed songs are not.
+    QSet<quint32> removedIds=libraryIds.toSet();
+    QHash<quint32, QJsonObject> songObjects;
+    KNMusicLibraryBase *library=KNMusicGlobal::library();
+    //Save the removed songs in the playlists with all the data instead of
+    //their ids.
+    for(int i=0; i<m_playlistList->rowCount(); ++i)
+    {
+        KNMusicPlaylistListItem *currentItem=m_playlistList->playlistItem(i);
+        if(currentItem->built())
+        {
+            //Clear the id of the rows, the saver will save the rows again.
+            KNMusicPlaylistModel *playlistModel=currentItem->playlistModel();
+            for(int row=0; row<playlistModel->rowCount(); ++row)
+            {
+                if(removedIds.contains(
+                       playlistModel->rowProperty(row, LibraryIdRole).toUInt()))
+                {
+                    playlistModel->setRowProperty(row, LibraryIdRole, 0);
+                }
+            }
+            continue;
+        }
+        //Replace the ids in the content of the playlist.
+        QJsonArray playlistContent=currentItem->playlistContent();
+        bool contentChanged=false;
+        for(int j=0; j<playlistContent.size(); ++j)
+        {
+            QJsonValue currentValue=playlistContent.at(j);
+            quint32 libraryId=(quint32)currentValue.toDouble();
+            if(!currentValue.isDouble() || !removedIds.contains(libraryId))
+            {
+                continue;
+            }
+            //Generate the snapshot of the song when it's first found.
+            if(!songObjects.contains(libraryId))
+            {
+                KNMusicDetailInfo detailInfo;
+                if(library==nullptr ||
+                        !library->detailInfoFromLibraryId(libraryId,
+                                                          detailInfo))
+                {
+                    continue;
+                }
+                songObjects.insert(
+                            libraryId,
+                            KNMusicPlaylistListAssistant::songObject(detailInfo));
+            }
+            playlistContent.replace(j, songObjects.value(libraryId));
+            contentChanged=true;
+        }
+        if(contentChanged)
+        {
+            currentItem->setPlaylistContent(playlistContent);
+            m_playlistSaver->recordChange(currentItem);
+        }
+    }
+}
+
 void KNMusicPlaylistManager::initialPlaylistLoader()
 {
     //Initial the loader.
@@ -302,21 +422,6 @@ void KNMusicPlaylistManager::initialPlaylistLoader()
     m_playlistLoader->installPlaylistParser(new KNMusicM3UParser);
 }
 
-void KNMusicPlaylistManager::saveChangedPlaylist()
-{
-    for(int i=0; i<m_playlistList->rowCount(); i++)
-    {
-        //Get the current item.
-        KNMusicPlaylistListItem *currentItem=m_playlistList->playlistItem(i);
-        //Check the item need to save or not, and the item's model must be builded,
-        //If the playlist model has never been built, how can it be changed?
-        if(currentItem->changed())
-        {
-            KNMusicPlaylistListAssistant::writePlaylist(currentItem);
-        }
-    }
-}
-
 KNMusicPlaylistListItem *KNMusicPlaylistManager::importPlaylistFromFile(const QString &filePath)
 {
     KNMusicPlaylistListItem *playlistItem=
@@ -328,6 +433,7 @@ KNMusicPlaylistListItem *KNMusicPlaylistManager::importPlaylistFromFile(const QS
         KNMusicPlaylistListAssistant::buildPlaylist(playlistItem);
         //If we can parse it, means it's a standard playlist.
         m_playlistList->appendPlaylist(playlistItem);
+        m_playlistSaver->addPlaylist(playlistItem);
         return playlistItem;
     }
     //Parse other type of the data.
@@ -335,8 +441,11 @@ KNMusicPlaylistListItem *KNMusicPlaylistManager::importPlaylistFromFile(const QS
     {
         //Set a file path for the item.
         playlistItem->setPlaylistFilePath(KNMusicPlaylistListAssistant::alloctPlaylistFilePath());
+        //The rows are added to the model directly.
+        playlistItem->setBuilt(true);
         //Add to playlist list.
         m_playlistList->appendPlaylist(playlistItem);
+        m_playlistSaver->addPlaylist(playlistItem);
         return playlistItem;
     }
     //Delete the no used item.
@@ -371,6 +480,7 @@ KNMusicPlaylistListItem *KNMusicPlaylistManager::recoverPlaylistFromFile(const Q
     {
         //If we can parse it, means it's a standard playlist, add to playlist.
         m_playlistList->appendPlaylist(playlistItem);
+        m_playlistSaver->addPlaylist(playlistItem);
         return playlistItem;
     }
     //Delete the no used item.
@@ -468,6 +578,9 @@ KNMusicPlaylistListItem *KNMusicPlaylistManager::createBlankPlaylist(const int &
     {
         m_playlistList->appendPlaylist(playlistItem);
     }
+    //Save the blank playlist, or it won't be recovered without any change.
+    playlistItem->setChanged(true);
+    m_playlistSaver->addPlaylist(playlistItem);
     //Set the new playlist to the current playlist.
     m_playlistTab->setCurrentPlaylist(playlistItem->index());
     //Let user rename it automatically.
@@ -22,9 +22,12 @@
 
 #include <QModelIndex>
 
+#include "knmusicglobal.h"
+
 #include "knmusicplaylistmanagerbase.h"
 
 class KNMusicPlaylistLoader;
+class KNMusicPlaylistSaver;
 class KNMusicPlaylistTab;
 class KNMusicPlaylistList;
 class KNMusicPlaylistListItem;
@@ -48,6 +51,10 @@ private slots:
                                const QStringList &filePaths);
     void onActionRemovePlaylist(const QModelIndex &index);
     void onActionImportPlaylist(QStringList playlistPaths);
+    void onActionPlaylistImported(QString filePath,
+                                  QString playlistName,
+                                  QStringList musicFiles,
+                                  bool parsed);
     void onActionExportPlaylist(const QString &filePath,
                                 const QModelIndex &index);
     void onActionCopyPlaylist(const int &index);
@@ -56,10 +63,10 @@ private slots:
     void onActionCurrentPlaylistChanged(const QModelIndex &current,
                                         const QModelIndex &previous);
     void locateIndexInModel(KNMusicModel *model, QModelIndex index);
+    void onActionLibraryIdsAboutToBeRemoved(QList<quint32> libraryIds);
 
 private:
     inline void initialPlaylistLoader();
-    inline void saveChangedPlaylist();
     QString generatePlaylistName(const QString &preferName="");
     KNMusicPlaylistListItem *createBlankPlaylist(const int &row=-1,
                                                  const QString &caption="");
@@ -70,6 +77,7 @@ private:
 
     QString m_playlistDatabasePath;
     KNMusicPlaylistLoader *m_playlistLoader;
+    KNMusicPlaylistSaver *m_playlistSaver;
     KNMusicPlaylistTab *m_playlistTab;
     KNMusicPlaylistList *m_playlistList;
     bool m_playlistListLoaded=false;
@@ -47,161 +47,78 @@ QString KNMusiciTunesXMLParser::playlistSuffix() const
 bool KNMusiciTunesXMLParser::parse(const QString &playlistFilePath,
                                    KNMusicPlaylistListItem *playlistItem)
 {
-    //Open the playlist file first.
-    QFile plistFile(playlistFilePath);
-    if(!plistFile.open(QIODevice::ReadOnly))
-    {
-        return false;
-    }
-    //Use QDomDocument to parse the file.
-    QDomDocument plistDocument;
-    if(!plistDocument.setContent(&plistFile, true))
-    {
-        //If there's any error, return false.
-        return false;
-    }
-    //Close the playlist file.
-    plistFile.close();
-    //Get the root of the document, check the root.
-    QDomElement plistRoot=plistDocument.documentElement();
-    if(plistRoot.nodeName()!="plist" ||
-            !plistRoot.hasAttribute("version") ||
-            plistRoot.attribute("version")!="1.0")
+    QString playlistName;
+    QStringList musicFileList;
+    if(!parseFileList(playlistFilePath, playlistName, musicFileList))
     {
         return false;
     }
-    //Get the dict elements.
-    QDomNodeList root=plistRoot.elementsByTagName("dict");
-    if(root.isEmpty())
+    playlistItem->setText(playlistName);
+    //Add to the playlist model;
+    playlistItem->playlistModel()->addFiles(musicFileList);
+    //Set the changed flag.
+    playlistItem->setChanged(true);
+    return true;
+}
+
+bool KNMusiciTunesXMLParser::parseFileList(const QString &playlistFilePath,
+                                           QString &playlistName,
+                                           QStringList &musicFiles)
+{
+    //Open the playlist file first.
+    QFile plistFile(playlistFilePath);
+    if(!plistFile.open(QIODevice::ReadOnly))
     {
         return false;
     }
-    QDomNodeList dictElement=root.at(0).toElement().childNodes();
-    //Check dict childe nodes size.
-    if(dictElement.isEmpty())
+    //The iTunes library could be hundreds of MB, read it as a stream instead
+    //of building the whole document.
+    QXmlStreamReader plistReader(&plistFile);
+    //Check the root.
+    if(!plistReader.readNextStartElement() ||
+            plistReader.name()!="plist" ||
+            plistReader.attributes().value("version")!="1.0" ||
+            !plistReader.readNextStartElement() ||
+            plistReader.name()!="dict")
     {
         return false;
     }
+    m_progress=0;
     //Initial the track info hash.
     QHash<QString, QString> musicLocateHash;
     QStringList playlistIndexList;
-    //Get the first node.
-    QDomElement keyNode=dictElement.at(0).toElement(),
-                valueNode=keyNode.nextSiblingElement();
-    while(!keyNode.isNull() && !keyNode.isNull())
+    //Read the keys of the root dict, the tracks are before the playlists.
+    QString key;
+    while(readKey(plistReader, key))
     {
-        if(keyNode.text()=="Tracks")
+        if(key=="Tracks" && plistReader.name()=="dict")
         {
-            if(!valueNode.childNodes().isEmpty())
-            {
-                //Get all the tracks information.
-                QDomElement trackKeyNode=valueNode.childNodes().at(0).toElement(),
-                            trackValueNode=trackKeyNode.nextSiblingElement();
-                while(!trackKeyNode.isNull() && !trackValueNode.isNull())
-                {
-                    //Parse the track dict information.
-                    QDomElement songKeyNode=trackValueNode.childNodes().at(0).toElement(),
-                                songValueNode=songKeyNode.nextSiblingElement();
-                    while(!songKeyNode.isNull() && !songValueNode.isNull())
-                    {
-                        if(songKeyNode.text()=="Location")
-                        {
-                            QString rawUrlText=QUrl::fromPercentEncoding(songValueNode.text().toUtf8());
-                            if(rawUrlText.length()>17 &&
-                                    rawUrlText.left(17)=="file://localhost/")
-                            {
-                                rawUrlText.remove(0, 17);
-                            }
-                            else
-                            {
-                                rawUrlText=QUrl(rawUrlText).path();
-                            }
-                            QFileInfo currentFileInfo(rawUrlText);
-                            //Set the hash.
-                            musicLocateHash.insert(trackKeyNode.text(), currentFileInfo.absoluteFilePath());
-                            break;
-                        }
-                        //Get the next elements.
-                        songKeyNode=songValueNode.nextSiblingElement();
-                        if(songKeyNode.isNull())
-                        {
-                            break;
-                        }
-                        songValueNode=songKeyNode.nextSiblingElement();
-                    }
-                    //Get the next elements.
-                    trackKeyNode=trackValueNode.nextSiblingElement();
-                    if(trackKeyNode.isNull())
-                    {
-                        break;
-                    }
-                    trackValueNode=trackKeyNode.nextSiblingElement();
-                }
-            }
+            parseTracks(plistReader, musicLocateHash);
         }
-        else if(keyNode.text()=="Playlists")
+        else if(key=="Playlists" && plistReader.name()=="array")
         {
-            if(valueNode.childNodes().size()!=0)
+            //Only the first playlist is imported, the rest of the file won't
+            //be used.
+            if(plistReader.readNextStartElement() &&
+                    plistReader.name()=="dict")
             {
-                QDomElement playlistDict=valueNode.childNodes().at(0).toElement();
-                if(playlistDict.childNodes().size()!=0)
-                {
-                    QDomElement playlistKey=playlistDict.childNodes().at(0).toElement(),
-                                playlistValue=playlistKey.nextSiblingElement();
-                    //Read the playlist information.
-                    while(!playlistKey.isNull() && !playlistValue.isNull())
-                    {
-                        if(playlistKey.text()=="Name")
-                        {
-                            playlistItem->setText(playlistValue.text());
-                        }
-                        else if(playlistKey.text()=="Playlist Items")
-                        {
-                            //Check the array is empty or not.
-                            QDomNodeList itemsArray=playlistValue.childNodes();
-                            if(!itemsArray.isEmpty())
-                            {
-                                for(int i=0; i<itemsArray.size(); i++)
-                                {
-                                    QDomElement currentTrack=itemsArray.at(i).toElement();
-                                    if(currentTrack.childNodes().size()==2)
-                                    {
-                                        QDomElement trackElement=currentTrack.childNodes().at(0).toElement(),
-                                                    trackIndex=trackElement.nextSiblingElement();
-                                        if(trackElement.text()=="Track ID")
-                                        {
-                                            //Insert the track.
-                                            playlistIndexList.append(trackIndex.text());
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        //Get the playlist key.
-                        playlistKey=playlistValue.nextSiblingElement();
-                        if(playlistKey.isNull())
-                        {
-                            break;
-                        }
-                        playlistValue=playlistKey.nextSiblingElement();
-                    }
-                }
+                parsePlaylist(plistReader, playlistName, playlistIndexList);
             }
+            break;
         }
-        //Get the next elements.
-        keyNode=valueNode.nextSiblingElement();
-        if(keyNode.isNull())
+        else
         {
-            break;
+            plistReader.skipCurrentElement();
         }
-        valueNode=keyNode.nextSiblingElement();
     }
+    //Close the playlist file.
+    plistFile.close();
     //Check the result.
-    if(musicLocateHash.isEmpty() || playlistIndexList.isEmpty())
+    if(plistReader.hasError() ||
+            musicLocateHash.isEmpty() || playlistIndexList.isEmpty())
     {
         return false;
     }
-    QStringList musicFileList;
     //Prepare the file list.
     while(!playlistIndexList.isEmpty())
     {
@@ -209,13 +126,9 @@ bool KNMusiciTunesXMLParser::parse(const QString &playlistFilePath,
                                                       QString());
         if(!currentFilePath.isEmpty())
         {
-            musicFileList.append(currentFilePath);
+            musicFiles.append(currentFilePath);
         }
     }
-    //Add to the playlist model;
-    playlistItem->playlistModel()->addFiles(musicFileList);
-    //Set the changed flag.
-    playlistItem->setChanged(true);
     return true;
 }
 
@@ -345,6 +258,114 @@ bool KNMusiciTunesXMLParser::write(const QString &playlistFilePath,
                                       plistDocument.toString(4));
 }
 
+inline bool KNMusiciTunesXMLParser::readKey(QXmlStreamReader &plistReader,
+                                            QString &key)
+{
+    //Read the key of a dict, the reader will stay at the start of the value.
+    if(!plistReader.readNextStartElement() || plistReader.name()!="key")
+    {
+        return false;
+    }
+    key=plistReader.readElementText();
+    return plistReader.readNextStartElement();
+}
+
+inline void KNMusiciTunesXMLParser::parseTracks(
+        QXmlStreamReader &plistReader,
+        QHash<QString, QString> &musicLocateHash)
+{
+    //Only the location of each track is kept.
+    QString trackId, songKey;
+    while(readKey(plistReader, trackId))
+    {
+        while(readKey(plistReader, songKey))
+        {
+            if(songKey=="Location")
+            {
+                musicLocateHash.insert(
+                            trackId,
+                            locationToFilePath(plistReader.readElementText()));
+            }
+            else
+            {
+                plistReader.skipCurrentElement();
+            }
+        }
+        reportProgress(plistReader);
+    }
+}
+
+inline void KNMusiciTunesXMLParser::parsePlaylist(
+        QXmlStreamReader &plistReader,
+        QString &playlistName,
+        QStringList &playlistIndexList)
+{
+    QString playlistKey, trackKey;
+    while(readKey(plistReader, playlistKey))
+    {
+        if(playlistKey=="Name")
+        {
+            playlistName=plistReader.readElementText();
+        }
+        else if(playlistKey=="Playlist Items" && plistReader.name()=="array")
+        {
+            //Each item is a dict with the track id.
+            while(plistReader.readNextStartElement())
+            {
+                while(readKey(plistReader, trackKey))
+                {
+                    if(trackKey=="Track ID")
+                    {
+                        playlistIndexList.append(plistReader.readElementText());
+                    }
+                    else
+                    {
+                        plistReader.skipCurrentElement();
+                    }
+                }
+                reportProgress(plistReader);
+            }
+        }
+        else
+        {
+            plistReader.skipCurrentElement();
+        }
+    }
+}
+
+inline QString KNMusiciTunesXMLParser::locationToFilePath(
+        const QString &location)
+{
+    QString rawUrlText=QUrl::fromPercentEncoding(location.toUtf8());
+    if(rawUrlText.length()>17 &&
+            rawUrlText.left(17)=="file://localhost/")
+    {
+        rawUrlText.remove(0, 17);
+    }
+    else
+    {
+        rawUrlText=QUrl(rawUrlText).path();
+    }
+    return QFileInfo(rawUrlText).absoluteFilePath();
+}
+
+inline void KNMusiciTunesXMLParser::reportProgress(
+        QXmlStreamReader &plistReader)
+{
+    //Report the progress of the file when it's changed by 1%.
+    QIODevice *plistDevice=plistReader.device();
+    if(plistDevice->size()==0)
+    {
+        return;
+    }
+    int progress=plistDevice->pos()*100/plistDevice->size();
+    if(progress!=m_progress)
+    {
+        m_progress=progress;
+        emit parseProgress(m_progress);
+    }
+}
+
 void KNMusiciTunesXMLParser::appendDictValue(QDomDocument &plistDocument,
                                              QDomElement &dict,
                                              const QString &key,
@@ -20,6 +20,7 @@
 
 #include <QHash>
 #include <QDomDocument>
+#include <QXmlStreamReader>
 
 #include <QHash>
 
@@ -33,14 +34,26 @@ public:
     QString playlistSuffix() const;
     bool parse(const QString &playlistFilePath,
                KNMusicPlaylistListItem *playlistItem);
+    bool parseFileList(const QString &playlistFilePath,
+                       QString &playlistName,
+                       QStringList &musicFiles);
     bool write(const QString &playlistFilePath,
                KNMusicPlaylistListItem *playlistItem);
 
 private:
+    inline bool readKey(QXmlStreamReader &plistReader, QString &key);
+    inline void parseTracks(QXmlStreamReader &plistReader,
+                            QHash<QString, QString> &musicLocateHash);
+    inline void parsePlaylist(QXmlStreamReader &plistReader,
+                              QString &playlistName,
+                              QStringList &playlistIndexList);
+    inline QString locationToFilePath(const QString &location);
+    inline void reportProgress(QXmlStreamReader &plistReader);
     inline void appendDictValue(QDomDocument &plistDocument,
                                 QDomElement &dict,
                                 const QString &key,
                                 const QVariant &value);
+    int m_progress=0;
 };
 
 #endif // KNMUSICITUNESXMLPARSER_H
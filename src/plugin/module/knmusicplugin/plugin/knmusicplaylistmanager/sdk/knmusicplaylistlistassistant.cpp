@@ -18,6 +18,7 @@
 #include <QDateTime>
 #include <QFileInfo>
 #include <QFile>
+#include <QSaveFile>
 #include <QDir>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -26,6 +27,7 @@
 #include "knglobal.h"
 
 #include "knmusicglobal.h"
+#include "knmusiclibrarybase.h"
 #include "knmusicmodelassist.h"
 #include "knmusicplaylistmodel.h"
 #include "knmusicplaylistlistitem.h"
@@ -39,7 +41,10 @@ using namespace KNMusic;
 QIcon KNMusicPlaylistListAssistant::m_playlistIcon=QIcon();
 QString KNMusicPlaylistListAssistant::m_playlistFolderPath=QString();
 QString KNMusicPlaylistListAssistant::m_playlistSuffix="mplst";
-int KNMusicPlaylistListAssistant::m_version=3;
+//Version 4 saves the songs in the library as their library ids, version 3
+//files are the same as the version 4 files without any id.
+int KNMusicPlaylistListAssistant::m_version=4;
+int KNMusicPlaylistListAssistant::m_minimumVersion=3;
 
 KNMusicPlaylistListAssistant::KNMusicPlaylistListAssistant(QObject *parent) :
     QObject(parent)
@@ -47,83 +52,183 @@ KNMusicPlaylistListAssistant::KNMusicPlaylistListAssistant(QObject *parent) :
 }
 
 bool KNMusicPlaylistListAssistant::writePlaylistToFile(const QString &filePath,
-                                                       KNMusicPlaylistListItem *item)
+                                                       KNMusicPlaylistListItem *item,
+                                                       bool referLibrary)
 {
-    //Try to open the file as write mode.
-    QFile playlistFile(filePath);
-    if(!playlistFile.open(QIODevice::WriteOnly))
-    {
-        return false;
-    }
     //Create the playlist content.
-    KNMusicPlaylistModel *playlistModel=item->playlistModel();
     QJsonArray playlistContent;
-    //Check if the playlist model null. If not, save data.
-    if(playlistModel!=nullptr)
+    //If the playlist hasn't been built, the content is still the same as the
+    //file. Or else the content is kept the same as the rows, only the changed
+    //rows need to be generated.
+    if(referLibrary || !item->built())
+    {
+        updatePlaylistContent(item);
+        playlistContent=item->playlistContent();
+    }
+    else
     {
+        KNMusicPlaylistModel *playlistModel=item->playlistModel();
         for(int row=0, songSize=playlistModel->rowCount();
             row<songSize;
             ++row)
         {
-            //Initial the music item.
-            QJsonObject musicItem;
-            //Save the text data.
-            QJsonArray textData;
-            for(int j=0; j<MusicDataCount; j++)
-            {
-                textData.append(playlistModel->itemText(row, j));
-            }
-            musicItem["Text"]=textData;
-            //Save appendix data.
-            musicItem["FilePath"]=
-                    playlistModel->rowProperty(row, FilePathRole).toString();
-            musicItem["FileName"]=
-                    playlistModel->rowProperty(row, FileNameRole).toString();
-            musicItem["TrackFilePath"]=
-                    playlistModel->rowProperty(row, TrackFileRole).toString();
-            musicItem["StartPosition"]=
-                    playlistModel->rowProperty(row, StartPositionRole).toInt();
-            musicItem["Size"]=
-                    playlistModel->roleData(row, Size, Qt::UserRole).toInt();
-            musicItem["DateModified"]=
-                    KNMusicModelAssist::dateTimeToDataString(
-                        playlistModel->roleData(row,
-                                                DateModified,
-                                                Qt::UserRole));
-            musicItem["DateAdded"]=
-                    KNMusicModelAssist::dateTimeToDataString(
-                        playlistModel->roleData(row,
-                                                DateAdded,
-                                                Qt::UserRole));
-            musicItem["LastPlayed"]=
-                    KNMusicModelAssist::dateTimeToDataString(
-                        playlistModel->roleData(row,
-                                                LastPlayed,
-                                                Qt::UserRole));
-            musicItem["Time"]=
-                    playlistModel->roleData(row, Time, Qt::UserRole).toInt();
-            musicItem["BitRate"]=
-                    playlistModel->roleData(row, BitRate, Qt::UserRole).toInt();
-            musicItem["SampleRate"]=
-                    playlistModel->roleData(row, SampleRate, Qt::UserRole).toInt();
-            //Add to playlist content.
-            playlistContent.append(musicItem);
+            playlistContent.append(songObject(playlistModel, row));
         }
     }
+    return writePlaylistContent(filePath,
+                                item->data(Qt::DisplayRole).toString(),
+                                playlistContent);
+}
+
+bool KNMusicPlaylistListAssistant::writePlaylistContent(const QString &filePath,
+                                                        const QString &name,
+                                                        const QJsonArray &content)
+{
+    //Write to a temporary file, and replace the playlist file when all the
+    //data has been written, the file won't be broken by a failed writing.
+    QSaveFile playlistFile(filePath);
+    if(!playlistFile.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    //Write document data to the file.
+    playlistFile.write(playlistFileData(name, content));
+    //Replace the playlist file.
+    return playlistFile.commit();
+}
+
+QByteArray KNMusicPlaylistListAssistant::playlistFileData(const QString &name,
+                                                          const QJsonArray &content)
+{
     //Create the playlist object.
     QJsonObject playlistObject;
     //Set the data of the playlist.
     playlistObject["Version"]=m_version;
-    playlistObject["Name"]=item->data(Qt::DisplayRole).toString();
-    playlistObject["Songs"]=playlistContent;
+    playlistObject["Name"]=name;
+    playlistObject["Songs"]=content;
     //Create playlist document
     QJsonDocument playlistDocument;
     playlistDocument.setObject(playlistObject);
-    //Write document data to the file.
-    playlistFile.write(playlistDocument.toJson());
-    //Close the file.
-    playlistFile.close();
-    return true;
+    return playlistDocument.toJson();
+}
+
+void KNMusicPlaylistListAssistant::updatePlaylistContent(
+        KNMusicPlaylistListItem *item)
+{
+    //Check whether there's any row need to be generated.
+    if(!item->built() || !item->contentOutdated())
+    {
+        return;
+    }
+    KNMusicPlaylistModel *playlistModel=item->playlistModel();
+    int songSize=playlistModel->rowCount();
+    //If the content is different from the rows, generate all the content.
+    if(item->playlistContent().size()!=songSize)
+    {
+        QJsonArray playlistContent;
+        for(int row=0; row<songSize; ++row)
+        {
+            playlistContent.append(songEntry(playlistModel, row));
+        }
+        item->setPlaylistContent(playlistContent);
+        item->setContentOutdated(false);
+        return;
+    }
+    //Generate the content of the new and changed rows.
+    for(int row=0; row<songSize; ++row)
+    {
+        if(item->playlistContent().at(row).isNull())
+        {
+            item->setContentRow(row, songEntry(playlistModel, row));
+        }
+    }
+    item->setContentOutdated(false);
+}
+
+QJsonValue KNMusicPlaylistListAssistant::songEntry(
+        KNMusicPlaylistModel *playlistModel,
+        const int &row)
+{
+    //The songs in the library are saved as their library ids, only the songs
+    //out of the library are saved with all the data.
+    quint32 libraryId=playlistModel->rowProperty(row, LibraryIdRole).toUInt();
+    KNMusicLibraryBase *library=KNMusicGlobal::library();
+    if(libraryId!=0 && library!=nullptr && library->hasLibraryId(libraryId))
+    {
+        return (qint64)libraryId;
+    }
+    return songObject(playlistModel, row);
+}
+
+QJsonObject KNMusicPlaylistListAssistant::songObject(
+        KNMusicPlaylistModel *playlistModel,
+        const int &row)
+{
+    return songObject(playlistModel->detailInfoFromRow(row));
+}
+
+QJsonObject KNMusicPlaylistListAssistant::songObject(
+        const KNMusicDetailInfo &detailInfo)
+{
+    //Initial the music item.
+    QJsonObject musicItem;
+    //Save the text data.
+    QJsonArray textData;
+    for(int j=0; j<MusicDataCount; j++)
+    {
+        textData.append(detailInfo.textLists[j]);
+    }
+    musicItem["Text"]=textData;
+    //Save appendix data.
+    musicItem["FilePath"]=detailInfo.filePath;
+    musicItem["FileName"]=detailInfo.fileName;
+    musicItem["TrackFilePath"]=detailInfo.trackFilePath;
+    musicItem["StartPosition"]=(int)detailInfo.startPosition;
+    musicItem["Size"]=(int)detailInfo.size;
+    musicItem["DateModified"]=
+            KNMusicModelAssist::dateTimeToDataString(detailInfo.dateModified);
+    musicItem["DateAdded"]=
+            KNMusicModelAssist::dateTimeToDataString(detailInfo.dateAdded);
+    musicItem["LastPlayed"]=
+            KNMusicModelAssist::dateTimeToDataString(detailInfo.lastPlayed);
+    musicItem["Time"]=(int)detailInfo.duration;
+    musicItem["BitRate"]=(int)detailInfo.bitRate;
+    musicItem["SampleRate"]=(int)detailInfo.samplingRate;
+    return musicItem;
+}
+
+void KNMusicPlaylistListAssistant::appendSongRow(
+        KNMusicPlaylistModel *playlistModel,
+        const QJsonObject &musicItem)
+{
+    //Prepare line data.
+    KNMusicDetailInfo currentInfo;
+    //Get the text data.
+    QJsonArray textData=musicItem["Text"].toArray();
+    for(int i=0; i<MusicDataCount; i++)
+    {
+        currentInfo.textLists[i]=textData.at(i).toString();
+    }
+    //Read appendix data.
+    currentInfo.filePath=musicItem["FilePath"].toString();
+    currentInfo.fileName=musicItem["FileName"].toString();
+    currentInfo.trackFilePath=musicItem["TrackFilePath"].toString();
+    currentInfo.startPosition=musicItem["StartPosition"].toInt();
+    currentInfo.size=musicItem["Size"].toInt();
+    currentInfo.dateModified=
+            KNMusicModelAssist::dataStringToDateTime(
+                musicItem["DateModified"].toString());
+    currentInfo.dateAdded=
+            KNMusicModelAssist::dataStringToDateTime(
+                musicItem["DateAdded"].toString());
+    currentInfo.lastPlayed=
+            KNMusicModelAssist::dataStringToDateTime(
+                musicItem["LastPlayed"].toString());
+    currentInfo.duration=musicItem["Time"].toInt();
+    currentInfo.bitRate=musicItem["BitRate"].toDouble();
+    currentInfo.samplingRate=musicItem["SampleRate"].toDouble();
+    //Insert the music row.
+    playlistModel->appendMusicRow(KNMusicModelAssist::generateRow(currentInfo));
 }
 
 QString KNMusicPlaylistListAssistant::playlistFolderPath()
@@ -155,8 +260,9 @@ void KNMusicPlaylistListAssistant::loadPlaylistDatabase(const QString &filePath,
     //CLose the file ASAP.
     playlistListFile.close();
     QJsonObject playlistListObject=playlistListData.object();
-    //Check the version, we can only load one version.
-    if(playlistListObject["Version"].toInt()!=m_version)
+    //Check the version.
+    int version=playlistListObject["Version"].toInt();
+    if(version<m_minimumVersion || version>m_version)
     {
         return;
     }
@@ -189,7 +295,8 @@ bool KNMusicPlaylistListAssistant::readPlaylist(const QString &filePath,
         return false;
     }
     //Check the playlist version.
-    if(playlistObject["Version"].toInt()!=m_version)
+    int version=playlistObject["Version"].toInt();
+    if(version<m_minimumVersion || version>m_version)
     {
         return false;
     }
@@ -207,51 +314,37 @@ bool KNMusicPlaylistListAssistant::readPlaylist(const QString &filePath,
 void KNMusicPlaylistListAssistant::buildPlaylist(KNMusicPlaylistListItem *item)
 {
     //Get the playlist content from the item.
-    QJsonArray playlistContent=item->playlistContent();
+    QJsonArray playlistContent=item->playlistContent(), builtContent;
     item->clearPlaylistContent();
+    KNMusicPlaylistModel *playlistModel=item->playlistModel();
+    KNMusicLibraryBase *library=KNMusicGlobal::library();
     //Initial the model from the content.
     for(auto i=playlistContent.begin();
         i!=playlistContent.end();
         ++i)
     {
-        //Prepare line data.
-        QJsonObject musicItem=(*i).toObject();
-        KNMusicDetailInfo currentInfo;
-        //Get the text data.
-        QJsonArray textData=musicItem["Text"].toArray();
-        for(int i=0; i<MusicDataCount; i++)
+        //The songs in the library are generated from the library rows. The
+        //songs removed from the library have been saved with all the data
+        //before their ids are released, an id which can't be found is skipped.
+        if((*i).isDouble())
         {
-            currentInfo.textLists[i]=textData.at(i).toString();
+            KNMusicDetailInfo currentInfo;
+            if(library!=nullptr &&
+                    library->detailInfoFromLibraryId((quint32)(*i).toDouble(),
+                                                     currentInfo))
+            {
+                playlistModel->appendMusicRow(
+                            KNMusicModelAssist::generateRow(currentInfo));
+                builtContent.append(*i);
+            }
+            continue;
         }
-        //Read appendix data.
-        currentInfo.filePath=musicItem["FilePath"].toString();
-        currentInfo.fileName=musicItem["FileName"].toString();
-        currentInfo.trackFilePath=musicItem["TrackFilePath"].toString();
-        currentInfo.startPosition=musicItem["StartPosition"].toInt();
-        currentInfo.size=musicItem["Size"].toInt();
-        currentInfo.dateModified=
-                KNMusicModelAssist::dataStringToDateTime(
-                    musicItem["DateModified"].toString());
-        currentInfo.dateAdded=
-                KNMusicModelAssist::dataStringToDateTime(
-                    musicItem["DateAdded"].toString());
-        currentInfo.lastPlayed=
-                KNMusicModelAssist::dataStringToDateTime(
-                    musicItem["LastPlayed"].toString());
-        currentInfo.duration=musicItem["Time"].toInt();
-        currentInfo.bitRate=musicItem["BitRate"].toDouble();
-        currentInfo.samplingRate=musicItem["SampleRate"].toDouble();
-        //Here we need to update some info for multi-locale.
-        currentInfo.textLists[DateModified]=
-                KNMusicModelAssist::dateTimeToString(currentInfo.dateModified);
-        currentInfo.textLists[DateAdded]=
-                KNMusicModelAssist::dateTimeToString(currentInfo.dateAdded);
-        currentInfo.textLists[LastPlayed]=
-                KNMusicModelAssist::dateTimeToString(currentInfo.lastPlayed);
-        //Insert the music row.
-        item->playlistModel()->appendMusicRow(
-                    KNMusicModelAssist::generateRow(currentInfo));
+        appendSongRow(playlistModel, (*i).toObject());
+        builtContent.append(*i);
     }
+    //Keep the content of the rows, the content will be changed with the rows.
+    item->setPlaylistContent(builtContent);
+    item->setContentOutdated(false);
     //Set builded flag.
     item->setBuilt(true);
 }
@@ -264,7 +357,7 @@ bool KNMusicPlaylistListAssistant::writePlaylist(KNMusicPlaylistListItem *item)
         return false;
     }
     //Write the playlist to the item's file.
-    return writePlaylistToFile(item->playlistFilePath(), item);
+    return writePlaylistToFile(item->playlistFilePath(), item, true);
 }
 
 bool KNMusicPlaylistListAssistant::exportPlaylist(const QString &filePath,
@@ -275,8 +368,13 @@ bool KNMusicPlaylistListAssistant::exportPlaylist(const QString &filePath,
     {
         return false;
     }
-    //Write the playlist to the item's file.
-    return writePlaylistToFile(filePath, item);
+    //Write all the data of the songs, the exported file could be used without
+    //the library.
+    if(!item->built())
+    {
+        buildPlaylist(item);
+    }
+    return writePlaylistToFile(filePath, item, false);
 }
 
 void KNMusicPlaylistListAssistant::savePlaylistDatabase(const QString &filePath,
@@ -346,6 +444,8 @@ KNMusicPlaylistListItem *KNMusicPlaylistListAssistant::generateBlankPlaylist(con
 {
     //Generate a default item first.
     KNMusicPlaylistListItem *playlistItem=generatePlaylist(caption);
+    //A blank playlist doesn't need to be built.
+    playlistItem->setBuilt(true);
     //Alloct a file path.
     playlistItem->setPlaylistFilePath(alloctPlaylistFilePath());
     //Return the item.
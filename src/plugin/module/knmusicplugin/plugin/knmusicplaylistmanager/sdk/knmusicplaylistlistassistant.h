@@ -19,8 +19,12 @@
 #define KNMUSICPLAYLISTLISTASSISTANT_H
 
 #include <QIcon>
+#include <QJsonArray>
+#include <QJsonObject>
 #include <QStringList>
 
+#include "knmusicglobal.h"
+
 #include <QObject>
 
 class KNMusicPlaylistModel;
@@ -45,6 +49,13 @@ public:
                              KNMusicPlaylistListItem *item);
     static void buildPlaylist(KNMusicPlaylistListItem *item);
     static bool writePlaylist(KNMusicPlaylistListItem *item);
+    static bool writePlaylistContent(const QString &filePath,
+                                     const QString &name,
+                                     const QJsonArray &content);
+    static QByteArray playlistFileData(const QString &name,
+                                       const QJsonArray &content);
+    static void updatePlaylistContent(KNMusicPlaylistListItem *item);
+    static QJsonObject songObject(const KNMusicDetailInfo &detailInfo);
     static bool exportPlaylist(const QString &filePath,
                                KNMusicPlaylistListItem *item);
     static void savePlaylistDatabase(const QString &filePath,
@@ -58,11 +69,18 @@ public slots:
 private:
     explicit KNMusicPlaylistListAssistant(QObject *parent = 0);
     static bool writePlaylistToFile(const QString &filePath,
-                                    KNMusicPlaylistListItem *item);
+                                    KNMusicPlaylistListItem *item,
+                                    bool referLibrary);
+    static QJsonValue songEntry(KNMusicPlaylistModel *playlistModel,
+                                const int &row);
+    static QJsonObject songObject(KNMusicPlaylistModel *playlistModel,
+                                  const int &row);
+    static void appendSongRow(KNMusicPlaylistModel *playlistModel,
+                              const QJsonObject &musicItem);
     static QIcon m_playlistIcon;
     static QString m_playlistFolderPath;
     static QString m_playlistSuffix;
-    static int m_version;
+    static int m_version, m_minimumVersion;
 };
 
 #endif // KNMUSICPLAYLISTLISTASSISTANT_H
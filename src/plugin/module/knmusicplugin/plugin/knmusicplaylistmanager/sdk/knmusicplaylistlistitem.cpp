@@ -69,6 +69,50 @@ void KNMusicPlaylistListItem::clearPlaylistContent()
 {
     m_playlistContent=QJsonArray();
 }
+
+void KNMusicPlaylistListItem::insertContentRows(int first, int last)
+{
+    //The content of the new rows will be generated when saving the playlist.
+    for(int row=first; row<=last; ++row)
+    {
+        m_playlistContent.insert(row, QJsonValue());
+    }
+    m_contentOutdated=true;
+}
+
+void KNMusicPlaylistListItem::removeContentRows(int first, int last)
+{
+    for(int row=qMin(last, m_playlistContent.size()-1); row>=first; --row)
+    {
+        m_playlistContent.removeAt(row);
+    }
+}
+
+void KNMusicPlaylistListItem::resetContentRow(int row)
+{
+    //Check the row is available.
+    if(row<0 || row>=m_playlistContent.size())
+    {
+        return;
+    }
+    m_playlistContent.replace(row, QJsonValue());
+    m_contentOutdated=true;
+}
+
+void KNMusicPlaylistListItem::setContentRow(int row, const QJsonValue &value)
+{
+    m_playlistContent.replace(row, value);
+}
+
+bool KNMusicPlaylistListItem::contentOutdated() const
+{
+    return m_contentOutdated;
+}
+
+void KNMusicPlaylistListItem::setContentOutdated(bool contentOutdated)
+{
+    m_contentOutdated = contentOutdated;
+}
 bool KNMusicPlaylistListItem::built() const
 {
     return m_builded;
@@ -36,6 +36,12 @@ public:
     QJsonArray playlistContent() const;
     void setPlaylistContent(const QJsonArray &playlistContent);
     void clearPlaylistContent();
+    void insertContentRows(int first, int last);
+    void removeContentRows(int first, int last);
+    void resetContentRow(int row);
+    void setContentRow(int row, const QJsonValue &value);
+    bool contentOutdated() const;
+    void setContentOutdated(bool contentOutdated);
     bool built() const;
     void setBuilt(bool built);
 
@@ -43,7 +49,7 @@ private:
     KNMusicPlaylistModel *m_playlistModel=nullptr;
     QString m_playlistFilePath;
     QJsonArray m_playlistContent;
-    bool m_changed=false, m_builded=false;
+    bool m_changed=false, m_builded=false, m_contentOutdated=false;
 };
 
 #endif // KNMUSICPLAYLISTLISTITEM_H
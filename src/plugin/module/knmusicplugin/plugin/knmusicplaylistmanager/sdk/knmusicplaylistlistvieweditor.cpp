@@ -17,6 +17,7 @@
  */
 #include <QFileDialog>
 #include <QBoxLayout>
+#include <QLabel>
 
 #include "knanimationmenu.h"
 #include "knopacityanimebutton.h"
@@ -59,6 +60,14 @@ KNMusicPlaylistListViewEditor::KNMusicPlaylistListViewEditor(QWidget *parent) :
             this, &KNMusicPlaylistListViewEditor::requireRemoveCurrentPlaylist);
     mainLayout->addWidget(m_removeCurrent, 0, Qt::AlignCenter);
 
+    //Initial the import progress, it's only shown when importing.
+    m_importProgress=new QLabel(this);
+    QPalette progressPal=m_importProgress->palette();
+    progressPal.setColor(QPalette::WindowText, QColor(0xA0, 0xA0, 0xA0));
+    m_importProgress->setPalette(progressPal);
+    m_importProgress->hide();
+    mainLayout->addWidget(m_importProgress, 0, Qt::AlignCenter);
+
     mainLayout->addStretch();
 
     //Initial the configure button.
@@ -119,6 +128,18 @@ void KNMusicPlaylistListViewEditor::showConfigureMenu()
     m_configureMenu->exec(QCursor::pos());
 }
 
+void KNMusicPlaylistListViewEditor::onActionImportProgress(int progress)
+{
+    //Hide the progress when the import is finished.
+    if(progress>=100)
+    {
+        m_importProgress->hide();
+        return;
+    }
+    m_importProgress->setText(tr("Importing %1%").arg(progress));
+    m_importProgress->show();
+}
+
 void KNMusicPlaylistListViewEditor::importPlaylists()
 {
     QFileDialog importFile(this);
@@ -219,6 +240,9 @@ void KNMusicPlaylistListViewEditor::setPlaylistListView(KNMusicPlaylistListView
 void KNMusicPlaylistListViewEditor::setPlaylistLoader(KNMusicPlaylistLoader *playlistLoader)
 {
     m_playlistLoader=playlistLoader;
+    //Show the progress of importing the large playlists.
+    connect(m_playlistLoader, &KNMusicPlaylistLoader::parseProgress,
+            this, &KNMusicPlaylistListViewEditor::onActionImportProgress);
     //Do Retranslate.
     retranslate();
 }
@@ -22,6 +22,7 @@
 
 #include "knlinearsensewidget.h"
 
+class QLabel;
 class KNAnimationMenu;
 class KNOpacityAnimeButton;
 class KNMusicPlaylistLoader;
@@ -50,6 +51,7 @@ public slots:
 private slots:
     void showAddMenu();
     void showConfigureMenu();
+    void onActionImportProgress(int progress);
 
 private:
     inline void initialMenu();
@@ -71,6 +73,7 @@ private:
             *m_configureActions[ConfigureMenuActionCount];
     KNAnimationMenu *m_addMenu, *m_configureMenu;
     KNOpacityAnimeButton *m_add, *m_removeCurrent, *m_configure;
+    QLabel *m_importProgress;
     KNMusicPlaylistLoader *m_playlistLoader;
     KNMusicPlaylistListView *m_playlistListView;
 };
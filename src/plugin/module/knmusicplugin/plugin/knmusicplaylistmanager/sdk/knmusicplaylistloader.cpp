@@ -18,18 +18,60 @@
 #include <QFile>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QRunnable>
+#include <QThreadPool>
 
 #include "knmusicplaylistloader.h"
 
 #include <QDebug>
 
+class KNMusicPlaylistImportTask : public QRunnable
+{
+public:
+    KNMusicPlaylistImportTask(KNMusicPlaylistLoader *loader,
+                              const QString &filePath) :
+        m_loader(loader),
+        m_filePath(filePath)
+    {
+    }
+
+    void run()
+    {
+        QString playlistName;
+        QStringList musicFiles;
+        bool parsed=m_loader->parseFileList(m_filePath,
+                                            playlistName,
+                                            musicFiles);
+        //Give the file list back to the GUI thread, the playlist is built
+        //there.
+        QMetaObject::invokeMethod(m_loader,
+                                  "onActionFileListParsed",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QString, m_filePath),
+                                  Q_ARG(QString, playlistName),
+                                  Q_ARG(QStringList, musicFiles),
+                                  Q_ARG(bool, parsed));
+    }
+
+private:
+    KNMusicPlaylistLoader *m_loader;
+    QString m_filePath;
+};
+
 KNMusicPlaylistLoader::KNMusicPlaylistLoader(QObject *parent) :
     QObject(parent)
 {
+    //The playlists are imported one by one, the progress is the progress of
+    //the current file.
+    m_importPool=new QThreadPool(this);
+    m_importPool->setMaxThreadCount(1);
 }
 
 KNMusicPlaylistLoader::~KNMusicPlaylistLoader()
 {
+    //Wait for the importing file, it's using the parsers.
+    m_importPool->clear();
+    m_importPool->waitForDone();
     //Delete all parsers.
     qDeleteAll(m_parsers);
     m_parsers.clear();
@@ -38,18 +80,44 @@ KNMusicPlaylistLoader::~KNMusicPlaylistLoader()
 void KNMusicPlaylistLoader::installPlaylistParser(KNMusicPlaylistParser *parser)
 {
     m_parsers.append(parser);
+    //Forward the progress of the parser.
+    connect(parser, &KNMusicPlaylistParser::parseProgress,
+            this, &KNMusicPlaylistLoader::parseProgress);
 }
 
 bool KNMusicPlaylistLoader::parsePlaylist(const QString &filePath,
                                           KNMusicPlaylistListItem *playlistItem)
 {
     //Try to parse the file using all parsers.
+    bool parsed=false;
     for(auto i=m_parsers.begin();
-        i!=m_parsers.end();
+        !parsed && i!=m_parsers.end();
         i++)
     {
         //If there's any one parser can parse this, that's it.
-        if((*i)->parse(filePath, playlistItem))
+        parsed=(*i)->parse(filePath, playlistItem);
+    }
+    //The parser may report the progress before it fails.
+    emit parseProgress(100);
+    return parsed;
+}
+
+void KNMusicPlaylistLoader::importPlaylist(const QString &filePath)
+{
+    emit parseProgress(0);
+    m_importPool->start(new KNMusicPlaylistImportTask(this, filePath));
+}
+
+bool KNMusicPlaylistLoader::parseFileList(const QString &filePath,
+                                          QString &playlistName,
+                                          QStringList &musicFiles)
+{
+    //Try all the parsers which could parse the file list.
+    for(auto i=m_parsers.begin();
+        i!=m_parsers.end();
+        i++)
+    {
+        if((*i)->parseFileList(filePath, playlistName, musicFiles))
         {
             return true;
         }
@@ -57,6 +125,16 @@ bool KNMusicPlaylistLoader::parsePlaylist(const QString &filePath,
     return false;
 }
 
+void KNMusicPlaylistLoader::onActionFileListParsed(QString filePath,
+                                                   QString playlistName,
+                                                   QStringList musicFiles,
+                                                   bool parsed)
+{
+    //The import of the file is finished.
+    emit parseProgress(100);
+    emit playlistImported(filePath, playlistName, musicFiles, parsed);
+}
+
 void KNMusicPlaylistLoader::getPlaylistTypeAndSuffix(QStringList &types,
                                                      QStringList &suffixs)
 {
@@ -27,6 +27,7 @@
 
 #include <QObject>
 
+class QThreadPool;
 class KNMusicPlaylistListItem;
 class KNMusicPlaylistLoader : public QObject
 {
@@ -37,6 +38,13 @@ public:
     void installPlaylistParser(KNMusicPlaylistParser *parser);
     bool parsePlaylist(const QString &filePath,
                        KNMusicPlaylistListItem *playlistItem);
+    //Parse the playlist to a file list in the import thread, the result is
+    //sent by playlistImported(). When no parser could read the file list,
+    //parsePlaylist() should be used instead.
+    void importPlaylist(const QString &filePath);
+    bool parseFileList(const QString &filePath,
+                       QString &playlistName,
+                       QStringList &musicFiles);
     void getPlaylistTypeAndSuffix(QStringList &types,
                                   QStringList &suffixs);
     bool writePlaylist(const QString &filePath,
@@ -44,11 +52,23 @@ public:
                        KNMusicPlaylistListItem *playlistItem);
 
 signals:
+    void parseProgress(int progress);
+    void playlistImported(QString filePath,
+                          QString playlistName,
+                          QStringList musicFiles,
+                          bool parsed);
 
 public slots:
 
+private slots:
+    void onActionFileListParsed(QString filePath,
+                                QString playlistName,
+                                QStringList musicFiles,
+                                bool parsed);
+
 private:
     QList<KNMusicPlaylistParser *> m_parsers;
+    QThreadPool *m_importPool;
 };
 
 #endif // KNMUSICPLAYLISTLOADER_H
@@ -26,8 +26,22 @@ public:
                        KNMusicPlaylistListItem *playlistItem)=0;
     virtual bool write(const QString &playlistFilePath,
                        KNMusicPlaylistListItem *playlistItem)=0;
+    //Parse the playlist to the name and the music files. It's called in the
+    //import thread, so it must not touch any item or model. The parser which
+    //doesn't implement it is used by parse() in the GUI thread.
+    virtual bool parseFileList(const QString &playlistFilePath,
+                               QString &playlistName,
+                               QStringList &musicFiles)
+    {
+        Q_UNUSED(playlistFilePath)
+        Q_UNUSED(playlistName)
+        Q_UNUSED(musicFiles)
+        return false;
+    }
 
 signals:
+    //The progress of parsing a large playlist file, from 0 to 100.
+    void parseProgress(int progress);
 
 public slots:
 
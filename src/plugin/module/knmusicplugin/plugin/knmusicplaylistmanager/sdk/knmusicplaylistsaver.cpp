@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include <QFile>
+#include <QTimer>
+
+#include "knmusicplaylistlistassistant.h"
+#include "knmusicplaylistlistitem.h"
+#include "knmusicplaylistmodel.h"
+#include "knmusicplaylistwriter.h"
+
+#include "knmusicplaylistsaver.h"
+
+#include <QDebug>
+
+//The changes are saved after there's no change for the save delay, but a
+//playlist which keeps changing is still saved after the maximum delay.
+#define SaveDelay 2000
+#define MaximumSaveDelay 10000
+
+KNMusicPlaylistSaver::KNMusicPlaylistSaver(QObject *parent) :
+    QObject(parent)
+{
+    //Initial the save timer.
+    m_saveTimer=new QTimer(this);
+    m_saveTimer->setSingleShot(true);
+    m_saveTimer->setInterval(SaveDelay);
+    connect(m_saveTimer, &QTimer::timeout,
+            this, &KNMusicPlaylistSaver::saveChangedPlaylists);
+    //Initial the writer, the files are written in the writer thread.
+    m_writer=new KNMusicPlaylistWriter;
+    m_writer->moveToThread(&m_writerThread);
+    connect(this, &KNMusicPlaylistSaver::requireWritePlaylists,
+            m_writer, &KNMusicPlaylistWriter::writePlaylists,
+            Qt::QueuedConnection);
+    m_writerThread.start();
+}
+
+KNMusicPlaylistSaver::~KNMusicPlaylistSaver()
+{
+    //Stop the writer thread.
+    m_writerThread.quit();
+    m_writerThread.wait();
+    //Write the playlists which haven't been written in the thread.
+    m_writer->writePlaylists();
+    delete m_writer;
+}
+
+void KNMusicPlaylistSaver::addPlaylist(KNMusicPlaylistListItem *item)
+{
+    KNMusicPlaylistModel *playlistModel=item->playlistModel();
+    //Record the changes of the rows to the playlist content. The content of a
+    //playlist which hasn't been built is the same as the file, the rows are
+    //appended by building the playlist.
+    connect(playlistModel, &KNMusicPlaylistModel::rowsInserted,
+            this,
+            [=](const QModelIndex &parent, int first, int last)
+            {
+                Q_UNUSED(parent)
+                if(item->built())
+                {
+                    item->insertContentRows(first, last);
+                    recordChange(item);
+                }
+            });
+    connect(playlistModel, &KNMusicPlaylistModel::rowsRemoved,
+            this,
+            [=](const QModelIndex &parent, int first, int last)
+            {
+                Q_UNUSED(parent)
+                if(item->built())
+                {
+                    item->removeContentRows(first, last);
+                    recordChange(item);
+                }
+            });
+    connect(playlistModel, &KNMusicPlaylistModel::dataChanged,
+            this,
+            [=](const QModelIndex &topLeft,
+                const QModelIndex &bottomRight,
+                const QVector<int> &roles)
+            {
+                if(item->built() && isSavedData(topLeft, bottomRight, roles))
+                {
+                    for(int row=topLeft.row(); row<=bottomRight.row(); ++row)
+                    {
+                        item->resetContentRow(row);
+                    }
+                    recordChange(item);
+                }
+            });
+    //Save the playlist which has been changed before.
+    if(item->changed())
+    {
+        recordChange(item);
+    }
+}
+
+bool KNMusicPlaylistSaver::removePlaylistFile(KNMusicPlaylistListItem *item)
+{
+    //Cancel the writing of the playlist, or the file will be written again.
+    m_writer->cancelPlaylist(item->playlistFilePath());
+    //Try to remove the item's file.
+    QFile playlistFile(item->playlistFilePath());
+    if(playlistFile.exists() && !playlistFile.remove())
+    {
+        return false;
+    }
+    //Don't save the removed playlist any more.
+    m_changedItems.removeAll(item);
+    return true;
+}
+
+bool KNMusicPlaylistSaver::writePlaylist(KNMusicPlaylistListItem *item)
+{
+    //Cancel the older content which is waiting to be written.
+    m_writer->cancelPlaylist(item->playlistFilePath());
+    m_changedItems.removeAll(item);
+    //Write the playlist right now.
+    if(!KNMusicPlaylistListAssistant::writePlaylist(item))
+    {
+        return false;
+    }
+    item->setChanged(false);
+    return true;
+}
+
+void KNMusicPlaylistSaver::saveChangedPlaylists()
+{
+    //Stop the timer, all the changes are saved here.
+    m_saveTimer->stop();
+    if(m_changedItems.isEmpty())
+    {
+        return;
+    }
+    while(!m_changedItems.isEmpty())
+    {
+        KNMusicPlaylistListItem *currentItem=m_changedItems.takeFirst();
+        //Generate the content of the changed rows only.
+        KNMusicPlaylistListAssistant::updatePlaylistContent(currentItem);
+        //Give the content to the writer.
+        m_writer->addPlaylist(currentItem->playlistFilePath(),
+                              currentItem->text(),
+                              currentItem->playlistContent());
+        currentItem->setChanged(false);
+    }
+    //Ask the writer to write the files.
+    emit requireWritePlaylists();
+}
+
+void KNMusicPlaylistSaver::onActionPlaylistItemChanged(QStandardItem *item)
+{
+    //The name of the playlist has been changed.
+    recordChange(static_cast<KNMusicPlaylistListItem *>(item));
+}
+
+inline bool KNMusicPlaylistSaver::isSavedData(const QModelIndex &topLeft,
+                                              const QModelIndex &bottomRight,
+                                              const QVector<int> &roles)
+{
+    //The playing icon is set to the blank data column by the now playing, it
+    //isn't saved.
+    if(topLeft.column()==BlankData && bottomRight.column()==BlankData)
+    {
+        return false;
+    }
+    //The decoration of the rows isn't saved.
+    for(QVector<int>::const_iterator i=roles.begin(); i!=roles.end(); ++i)
+    {
+        if((*i)!=Qt::DecorationRole)
+        {
+            return true;
+        }
+    }
+    //No role means all the data could be changed.
+    return roles.isEmpty();
+}
+
+void KNMusicPlaylistSaver::recordChange(KNMusicPlaylistListItem *item)
+{
+    //Set the changed flag.
+    item->setChanged(true);
+    if(!m_changedItems.contains(item))
+    {
+        m_changedItems.append(item);
+    }
+    //Restart the timer for every change, until the changes have been waiting
+    //for the maximum delay.
+    if(!m_saveTimer->isActive())
+    {
+        m_firstChange.start();
+        m_saveTimer->start();
+    }
+    else if(m_firstChange.elapsed()<MaximumSaveDelay-SaveDelay)
+    {
+        m_saveTimer->start();
+    }
+}
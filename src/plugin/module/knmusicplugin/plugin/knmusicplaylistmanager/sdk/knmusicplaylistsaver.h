@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef KNMUSICPLAYLISTSAVER_H
+#define KNMUSICPLAYLISTSAVER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QModelIndex>
+#include <QThread>
+#include <QVector>
+
+#include <QObject>
+
+class QStandardItem;
+class QTimer;
+class KNMusicPlaylistWriter;
+class KNMusicPlaylistListItem;
+class KNMusicPlaylistSaver : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KNMusicPlaylistSaver(QObject *parent = 0);
+    ~KNMusicPlaylistSaver();
+    void addPlaylist(KNMusicPlaylistListItem *item);
+    bool removePlaylistFile(KNMusicPlaylistListItem *item);
+    bool writePlaylist(KNMusicPlaylistListItem *item);
+    void recordChange(KNMusicPlaylistListItem *item);
+
+signals:
+    void requireWritePlaylists();
+
+public slots:
+    void saveChangedPlaylists();
+    void onActionPlaylistItemChanged(QStandardItem *item);
+
+private:
+    inline bool isSavedData(const QModelIndex &topLeft,
+                            const QModelIndex &bottomRight,
+                            const QVector<int> &roles);
+    QList<KNMusicPlaylistListItem *> m_changedItems;
+    QTimer *m_saveTimer;
+    QElapsedTimer m_firstChange;
+    QThread m_writerThread;
+    KNMusicPlaylistWriter *m_writer;
+};
+
+#endif // KNMUSICPLAYLISTSAVER_H
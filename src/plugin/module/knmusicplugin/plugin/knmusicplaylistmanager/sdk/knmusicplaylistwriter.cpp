@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include "knmusicplaylistlistassistant.h"
+
+#include "knmusicplaylistwriter.h"
+
+#include <QDebug>
+
+KNMusicPlaylistWriter::KNMusicPlaylistWriter(QObject *parent) :
+    QObject(parent)
+{
+}
+
+void KNMusicPlaylistWriter::addPlaylist(const QString &filePath,
+                                        const QString &name,
+                                        const QJsonArray &content)
+{
+    QMutexLocker playlistsLocker(&m_playlistsLock);
+    //Only the latest content of a playlist will be written, the older content
+    //which hasn't been written is replaced.
+    PlaylistData playlistData;
+    playlistData.name=name;
+    playlistData.content=content;
+    m_playlists.insert(filePath, playlistData);
+}
+
+void KNMusicPlaylistWriter::cancelPlaylist(const QString &filePath)
+{
+    QMutexLocker playlistsLocker(&m_playlistsLock);
+    m_playlists.remove(filePath);
+    //Don't wait for the playlist which is being written, mark it cancelled,
+    //the writer won't replace the file with it.
+    if(m_writingFilePath==filePath)
+    {
+        m_writingCancelled=true;
+    }
+}
+
+void KNMusicPlaylistWriter::writePlaylists()
+{
+    m_playlistsLock.lock();
+    while(!m_playlists.isEmpty())
+    {
+        //Take one playlist, the content could still be added while writing.
+        QHash<QString, PlaylistData>::iterator playlistIterator=
+                m_playlists.begin();
+        QString filePath=playlistIterator.key();
+        PlaylistData playlistData=playlistIterator.value();
+        m_playlists.erase(playlistIterator);
+        m_writingFilePath=filePath;
+        m_writingCancelled=false;
+        m_playlistsLock.unlock();
+        //Write the playlist to a temporary file.
+        QSaveFile playlistFile(filePath);
+        bool opened=playlistFile.open(QIODevice::WriteOnly);
+        if(opened)
+        {
+            playlistFile.write(
+                        KNMusicPlaylistListAssistant::playlistFileData(
+                            playlistData.name,
+                            playlistData.content));
+        }
+        m_playlistsLock.lock();
+        //Check the cancel flag and replace the file under the lock, so a
+        //cancelled playlist never replaces the file. The temporary file is
+        //discarded when it's not committed.
+        if(opened && !m_writingCancelled)
+        {
+            playlistFile.commit();
+        }
+        m_writingFilePath.clear();
+    }
+    m_playlistsLock.unlock();
+}
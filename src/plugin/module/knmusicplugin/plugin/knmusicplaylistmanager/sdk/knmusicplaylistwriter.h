@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) Kreogist Dev Team
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ */
+#ifndef KNMUSICPLAYLISTWRITER_H
+#define KNMUSICPLAYLISTWRITER_H
+
+#include <QHash>
+#include <QJsonArray>
+#include <QMutex>
+
+#include <QObject>
+
+class KNMusicPlaylistWriter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KNMusicPlaylistWriter(QObject *parent = 0);
+    void addPlaylist(const QString &filePath,
+                     const QString &name,
+                     const QJsonArray &content);
+    void cancelPlaylist(const QString &filePath);
+
+signals:
+
+public slots:
+    void writePlaylists();
+
+private:
+    struct PlaylistData
+    {
+        QString name;
+        QJsonArray content;
+    };
+    QHash<QString, PlaylistData> m_playlists;
+    //The playlist which is being written, it won't replace the file when it's
+    //cancelled.
+    QString m_writingFilePath;
+    bool m_writingCancelled=false;
+    QMutex m_playlistsLock;
+};
+
+#endif // KNMUSICPLAYLISTWRITER_H
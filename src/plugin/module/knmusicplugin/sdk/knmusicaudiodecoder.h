@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#ifndef KNMUSICAUDIODECODER_H
+#define KNMUSICAUDIODECODER_H
+
+#include <QString>
+#include <QVector>
+
+//An audio decoder decodes a file, or a section of it, to 32-bit float
+//interleaved PCM. It's used to analysis the music data without the playing
+//stream, so it could be used in any thread.
+class KNMusicAudioDecoder
+{
+public:
+    //The position of a channel, it decides how the channel is weighted when
+    //measuring the loudness.
+    enum ChannelPosition
+    {
+        FrontChannel,
+        SurroundChannel,
+        LowFrequencyChannel
+    };
+    KNMusicAudioDecoder(){}
+    virtual ~KNMusicAudioDecoder(){}
+    virtual bool open(const QString &filePath,
+                      const qint64 &start=-1,
+                      const qint64 &duration=-1)=0;
+    virtual int sampleRate() const=0;
+    virtual int channels() const=0;
+    //The positions of the channels, it's empty when the decoder doesn't know
+    //the layout.
+    virtual QVector<int> channelPositions() const
+    {
+        return QVector<int>();
+    }
+    //Decode at most frameCount frames to the buffer, return the frames which
+    //are decoded, 0 means the end of the section.
+    virtual int decode(float *buffer, const int &frameCount)=0;
+};
+
+#endif // KNMUSICAUDIODECODER_H
@@ -14,6 +14,9 @@
 
 using namespace KNMusic;
 
+class KNMusicAudioDecoder;
+class KNMusicSpectrumAnalyser;
+class KNMusicEqualizer;
 class KNMusicBackend : public QObject
 {
     Q_OBJECT
@@ -27,6 +30,17 @@ public:
     virtual void playSection(const QString &fileName,
                              const qint64 &start=-1,
                              const qint64 &duration=-1)=0;
+    virtual void prepareNextSection(const QString &fileName,
+                                    const qint64 &start=-1,
+                                    const qint64 &duration=-1)=0;
+    virtual void clearNextSection()=0;
+    virtual void setPositionUpdateInterval(const int &interval)=0;
+    virtual void setGain(const qreal &gain)=0;
+    virtual void setNextSectionGain(const qreal &gain)=0;
+    virtual void setNextSectionCrossfade(const int &mode,
+                                         const int &duration)=0;
+    virtual void setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser)=0;
+    virtual void setEqualizer(KNMusicEqualizer *equalizer)=0;
     virtual void play()=0;
     virtual void pause()=0;
     virtual void stop()=0;
@@ -51,6 +65,10 @@ public:
     virtual int volumeMinimal()=0;
     virtual int volumeMaximum()=0;
 
+    //Create a decoder which decodes the files without playing them, return
+    //nullptr if the backend can't do it.
+    virtual KNMusicAudioDecoder *createAudioDecoder()=0;
+
 signals:
     void cannotLoadFile();
     void filePathChanged(const QString &filePath);
@@ -58,6 +76,7 @@ signals:
     void durationChanged(qint64 duration);
     void muteStateChanged(bool mute);
     void finished();
+    void nextSectionStarted();
     void stopped();
     void playingStateChanged(int state);
 
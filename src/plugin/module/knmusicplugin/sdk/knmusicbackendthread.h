@@ -9,6 +9,8 @@
 
 #include <QObject>
 
+class KNMusicSpectrumAnalyser;
+class KNMusicEqualizer;
 class KNMusicBackendThread : public QObject
 {
     Q_OBJECT
@@ -27,6 +29,21 @@ public:
                                 const qint64 &sectionDuration=-1)=0;
     virtual void playSection(const qint64 &sectionStart=-1,
                              const qint64 &sectionDuration=-1)=0;
+    virtual void prepareNextSection(const QString &filePath,
+                                    const qint64 &sectionStart=-1,
+                                    const qint64 &sectionDuration=-1)=0;
+    virtual void clearNextSection()=0;
+    virtual void setPositionUpdateInterval(const int &interval)=0;
+    virtual void setGain(const qreal &gain)=0;
+    virtual void setNextSectionGain(const qreal &gain)=0;
+    //The crossfade from the current section to the next section, it should be
+    //set before the next section is prepared. The duration is in millisecond.
+    virtual void setNextSectionCrossfade(const int &mode,
+                                         const int &duration)=0;
+    //The analyser gets the samples which are played, nullptr to remove it.
+    virtual void setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser)=0;
+    //The equalizer processes the samples before they are played.
+    virtual void setEqualizer(KNMusicEqualizer *equalizer)=0;
 
 signals:
     void cannotLoadFile();
@@ -35,6 +52,7 @@ signals:
     void positionChanged(qint64 position);
     void stateChanged(int state);
     void finished();
+    void nextSectionStarted();
     void stopped();
 
 public slots:
@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#include <QMutexLocker>
+
+#include <cmath>
+
+#include "knmusicequalizer.h"
+
+//The frames which use the same coefficients, the gains are ramped between the
+//blocks.
+#define BlockFrames 32
+//The largest gain change of a block, unit: dB. A 12 dB change takes about
+//17ms at 44.1kHz.
+#define RampStep 0.5f
+//The bandwidth of the bands, one octave.
+#define BandQ 1.41
+//The range of the gains, unit: dB.
+#define MaximumGain 12.0
+
+namespace EqualizerPresets
+{
+    struct Preset
+    {
+        const char *name;
+        float gains[EqualizerBandCount];
+    };
+    static const Preset presets[]=
+    {
+        {"Flat",        { 0,  0,  0,  0,  0,  0,  0,  0,  0,  0}},
+        {"Bass Boost",  { 6,  5,  4,  2,  0,  0,  0,  0,  0,  0}},
+        {"Treble Boost",{ 0,  0,  0,  0,  0,  1,  2,  4,  5,  6}},
+        {"Vocal",       {-2, -2, -1,  1,  3,  3,  2,  1,  0, -1}},
+        {"Rock",        { 4,  3,  2,  0, -1, -1,  1,  2,  3,  4}},
+        {"Pop",         {-1,  1,  2,  3,  2,  0, -1, -1, -1, -1}},
+        {"Jazz",        { 3,  2,  1,  2, -1, -1,  0,  1,  2,  3}},
+        {"Classical",   { 4,  3,  2,  1, -1, -1,  0,  2,  3,  4}},
+        {"Electronic",  { 5,  4,  1,  0, -2,  1,  0,  1,  4,  5}}
+    };
+    static const int presetCount=sizeof(presets)/sizeof(Preset);
+}
+
+KNMusicEqualizer::KNMusicEqualizer()
+{
+    for(int i=0; i<EqualizerBandCount; i++)
+    {
+        m_gains[i]=0.0;
+    }
+}
+
+qreal KNMusicEqualizer::bandFrequency(const int &band)
+{
+    //The ISO octave bands: 31.25Hz, 62.5Hz, ..., 16kHz.
+    return 31.25*(qreal)(1<<band);
+}
+
+QStringList KNMusicEqualizer::presetNames()
+{
+    QStringList names;
+    for(int i=0; i<EqualizerPresets::presetCount; i++)
+    {
+        names.append(EqualizerPresets::presets[i].name);
+    }
+    return names;
+}
+
+QVector<qreal> KNMusicEqualizer::presetGains(const QString &presetName)
+{
+    for(int i=0; i<EqualizerPresets::presetCount; i++)
+    {
+        if(presetName==EqualizerPresets::presets[i].name)
+        {
+            QVector<qreal> gains(EqualizerBandCount);
+            for(int j=0; j<EqualizerBandCount; j++)
+            {
+                gains[j]=EqualizerPresets::presets[i].gains[j];
+            }
+            return gains;
+        }
+    }
+    return QVector<qreal>();
+}
+
+QString KNMusicEqualizer::gainsToString(const QVector<qreal> &gains)
+{
+    QStringList gainTexts;
+    for(int i=0; i<gains.size(); i++)
+    {
+        gainTexts.append(QString::number(gains.at(i), 'f', 1));
+    }
+    return gainTexts.join(',');
+}
+
+QVector<qreal> KNMusicEqualizer::gainsFromString(const QString &text)
+{
+    QStringList gainTexts=text.split(',');
+    //The text must have all the bands.
+    if(gainTexts.size()!=EqualizerBandCount)
+    {
+        return QVector<qreal>();
+    }
+    QVector<qreal> gains(EqualizerBandCount);
+    for(int i=0; i<EqualizerBandCount; i++)
+    {
+        bool ok;
+        gains[i]=gainTexts.at(i).toDouble(&ok);
+        if(!ok)
+        {
+            return QVector<qreal>();
+        }
+    }
+    return gains;
+}
+
+bool KNMusicEqualizer::isEnabled()
+{
+    QMutexLocker locker(&m_settingLock);
+    return m_enabled;
+}
+
+void KNMusicEqualizer::setEnabled(const bool &enabled)
+{
+    QMutexLocker locker(&m_settingLock);
+    m_enabled=enabled;
+}
+
+qreal KNMusicEqualizer::preamp()
+{
+    QMutexLocker locker(&m_settingLock);
+    return m_preamp;
+}
+
+void KNMusicEqualizer::setPreamp(const qreal &preamp)
+{
+    QMutexLocker locker(&m_settingLock);
+    m_preamp=qBound(-MaximumGain, preamp, MaximumGain);
+}
+
+QVector<qreal> KNMusicEqualizer::gains()
+{
+    QMutexLocker locker(&m_settingLock);
+    QVector<qreal> gains(EqualizerBandCount);
+    for(int i=0; i<EqualizerBandCount; i++)
+    {
+        gains[i]=m_gains[i];
+    }
+    return gains;
+}
+
+void KNMusicEqualizer::setGains(const QVector<qreal> &gains)
+{
+    QMutexLocker locker(&m_settingLock);
+    for(int i=0; i<EqualizerBandCount && i<gains.size(); i++)
+    {
+        m_gains[i]=qBound(-MaximumGain, gains.at(i), MaximumGain);
+    }
+}
+
+void KNMusicEqualizer::setBandGain(const int &band, const qreal &gain)
+{
+    Q_ASSERT(band>-1 && band<EqualizerBandCount);
+    QMutexLocker locker(&m_settingLock);
+    m_gains[band]=qBound(-MaximumGain, gain, MaximumGain);
+}
+
+void KNMusicEqualizer::process(float *samples,
+                               const int &frames,
+                               const int &channels,
+                               const int &sampleRate)
+{
+    if(channels<1 || channels>EqualizerMaximumChannels || sampleRate<1)
+    {
+        return;
+    }
+    if(channels!=m_channels || sampleRate!=m_sampleRate)
+    {
+        reset(channels, sampleRate);
+    }
+    syncTargets();
+    for(int i=0; i<frames; i+=BlockFrames)
+    {
+        processBlock(samples+i*channels, qMin(BlockFrames, frames-i), channels);
+    }
+}
+
+void KNMusicEqualizer::process(qint16 *samples,
+                               const int &frames,
+                               const int &channels,
+                               const int &sampleRate)
+{
+    if(channels<1 || channels>EqualizerMaximumChannels || sampleRate<1)
+    {
+        return;
+    }
+    if(channels!=m_channels || sampleRate!=m_sampleRate)
+    {
+        reset(channels, sampleRate);
+    }
+    syncTargets();
+    float block[BlockFrames*EqualizerMaximumChannels];
+    for(int i=0; i<frames; i+=BlockFrames)
+    {
+        int blockFrames=qMin(BlockFrames, frames-i),
+            blockSamples=blockFrames*channels;
+        qint16 *blockStart=samples+i*channels;
+        for(int j=0; j<blockSamples; j++)
+        {
+            block[j]=(float)blockStart[j]/32768.0f;
+        }
+        processBlock(block, blockFrames, channels);
+        for(int j=0; j<blockSamples; j++)
+        {
+            blockStart[j]=(qint16)qBound(-32768,
+                                         (int)lrintf(block[j]*32768.0f),
+                                         32767);
+        }
+    }
+}
+
+inline void KNMusicEqualizer::syncTargets()
+{
+    //Never wait for the settings in the audio thread, the changes will be got
+    //next time.
+    if(!m_settingLock.tryLock())
+    {
+        return;
+    }
+    //When it's disabled, all the gains go back to 0 dB, then the filters are
+    //skipped.
+    float maximumBoost=0.0;
+    for(int i=0; i<EqualizerBandCount; i++)
+    {
+        m_bands[i].targetGain=m_enabled?m_gains[i]:0.0;
+        maximumBoost=qMax(maximumBoost, m_bands[i].targetGain);
+    }
+    //A boosted band could push a full scale sample over the limit, and the
+    //16-bit samples are clipped. Lower the preamp by the largest boost to keep
+    //the headroom.
+    m_targetPreamp=m_enabled?pow(10.0, (m_preamp-maximumBoost)/20.0):1.0;
+    m_settingLock.unlock();
+}
+
+inline void KNMusicEqualizer::reset(const int &channels, const int &sampleRate)
+{
+    m_channels=channels;
+    m_sampleRate=sampleRate;
+    //Clear the filter state, and calculate the coefficients for the new rate.
+    for(int i=0; i<EqualizerBandCount; i++)
+    {
+        EqualizerBand &band=m_bands[i];
+        for(int j=0; j<EqualizerMaximumChannels; j++)
+        {
+            band.z1[j]=0.0;
+            band.z2[j]=0.0;
+        }
+        updateCoefficients(band, i);
+    }
+}
+
+inline void KNMusicEqualizer::updateCoefficients(EqualizerBand &band,
+                                                 const int &index)
+{
+    //The peaking filter of the Audio EQ Cookbook.
+    double frequency=bandFrequency(index);
+    if(band.gain==0.0 || frequency>=m_sampleRate/2)
+    {
+        //It's a bypass.
+        band.b0=1.0;
+        band.b1=0.0;
+        band.b2=0.0;
+        band.a1=0.0;
+        band.a2=0.0;
+        return;
+    }
+    double A=pow(10.0, band.gain/40.0),
+           omega=2.0*M_PI*frequency/m_sampleRate,
+           alpha=sin(omega)/(2.0*BandQ),
+           cosOmega=cos(omega),
+           a0=1.0+alpha/A;
+    band.b0=(1.0+alpha*A)/a0;
+    band.b1=(-2.0*cosOmega)/a0;
+    band.b2=(1.0-alpha*A)/a0;
+    band.a1=(-2.0*cosOmega)/a0;
+    band.a2=(1.0-alpha/A)/a0;
+}
+
+inline void KNMusicEqualizer::processBlock(float *samples,
+                                           const int &frames,
+                                           const int &channels)
+{
+    int sampleCount=frames*channels;
+    //Ramp the preamp linearly in the block.
+    if(m_currentPreamp!=1.0f || m_targetPreamp!=1.0f)
+    {
+        float preamp=m_currentPreamp,
+              preampStep=(m_targetPreamp-m_currentPreamp)/(float)frames;
+        for(int i=0; i<frames; i++)
+        {
+            preamp+=preampStep;
+            for(int j=0; j<channels; j++)
+            {
+                samples[i*channels+j]*=preamp;
+            }
+        }
+        m_currentPreamp=m_targetPreamp;
+    }
+    for(int i=0; i<EqualizerBandCount; i++)
+    {
+        EqualizerBand &band=m_bands[i];
+        //Move the gain to the target a step a block.
+        if(band.gain!=band.targetGain)
+        {
+            band.gain=(band.targetGain>band.gain)?
+                        qMin(band.gain+RampStep, band.targetGain):
+                        qMax(band.gain-RampStep, band.targetGain);
+            updateCoefficients(band, i);
+            if(band.gain==0.0f)
+            {
+                //The band is skipped from now on, start it clean next time.
+                for(int j=0; j<EqualizerMaximumChannels; j++)
+                {
+                    band.z1[j]=0.0;
+                    band.z2[j]=0.0;
+                }
+                continue;
+            }
+        }
+        if(band.gain==0.0f)
+        {
+            continue;
+        }
+        //The transposed direct form II. The channels of a frame are processed
+        //in the inner loop with their own states, which could be vectorized.
+        const float b0=band.b0, b1=band.b1, b2=band.b2,
+                    a1=band.a1, a2=band.a2;
+        float *z1=band.z1, *z2=band.z2;
+        for(int j=0; j<sampleCount; j+=channels)
+        {
+            float *frame=samples+j;
+            for(int k=0; k<channels; k++)
+            {
+                float input=frame[k],
+                      output=b0*input+z1[k];
+                z1[k]=b1*input-a1*output+z2[k];
+                z2[k]=b2*input-a2*output;
+                frame[k]=output;
+            }
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#ifndef KNMUSICEQUALIZER_H
+#define KNMUSICEQUALIZER_H
+
+#include <QMutex>
+#include <QStringList>
+#include <QVector>
+
+//The equalizer is a group of peaking biquad filters. It doesn't know anything
+//about the backends: the backends give it the samples which are going to be
+//played, in their audio threads, and the settings are changed in any other
+//thread. The gain changes are ramped, so changing the gains never clicks.
+#define EqualizerBandCount 10
+#define EqualizerMaximumChannels 8
+
+class KNMusicEqualizer
+{
+public:
+    KNMusicEqualizer();
+    static qreal bandFrequency(const int &band);
+    static QStringList presetNames();
+    static QVector<qreal> presetGains(const QString &presetName);
+    static QString gainsToString(const QVector<qreal> &gains);
+    static QVector<qreal> gainsFromString(const QString &text);
+    bool isEnabled();
+    void setEnabled(const bool &enabled);
+    qreal preamp();
+    void setPreamp(const qreal &preamp);
+    QVector<qreal> gains();
+    void setGains(const QVector<qreal> &gains);
+    void setBandGain(const int &band, const qreal &gain);
+    //Process the samples in place, they are interleaved.
+    void process(float *samples,
+                 const int &frames,
+                 const int &channels,
+                 const int &sampleRate);
+    void process(qint16 *samples,
+                 const int &frames,
+                 const int &channels,
+                 const int &sampleRate);
+
+private:
+    struct EqualizerBand
+    {
+        float gain=0.0, targetGain=0.0;     //Unit: dB.
+        float b0=1.0, b1=0.0, b2=0.0, a1=0.0, a2=0.0;
+        float z1[EqualizerMaximumChannels], z2[EqualizerMaximumChannels];
+    };
+    inline void syncTargets();
+    inline void reset(const int &channels, const int &sampleRate);
+    inline void updateCoefficients(EqualizerBand &band, const int &index);
+    inline void processBlock(float *samples,
+                             const int &frames,
+                             const int &channels);
+    //The settings, they are locked by the setting lock.
+    QMutex m_settingLock;
+    bool m_enabled=false;
+    float m_preamp=0.0;
+    float m_gains[EqualizerBandCount];
+    //The processing state, only used in the audio thread.
+    EqualizerBand m_bands[EqualizerBandCount];
+    float m_currentPreamp=1.0, m_targetPreamp=1.0;
+    int m_channels=0, m_sampleRate=0;
+};
+
+#endif // KNMUSICEQUALIZER_H
@@ -26,6 +26,7 @@ KNMusicGlobal *KNMusicGlobal::m_instance=nullptr;
 KNMusicParser *KNMusicGlobal::m_parser=nullptr;
 KNMusicNowPlayingBase *KNMusicGlobal::m_nowPlaying=nullptr;
 KNMusicSoloMenuBase *KNMusicGlobal::m_soloMenu=nullptr;
+KNMusicLibraryBase *KNMusicGlobal::m_library=nullptr;
 KNMusicMultiMenuBase *KNMusicGlobal::m_multiMenu=nullptr;
 KNMusicSearchBase *KNMusicGlobal::m_musicSearch=nullptr;
 KNMusicDetailTooltipBase *KNMusicGlobal::m_detailTooltip=nullptr;
@@ -128,6 +129,9 @@ void KNMusicGlobal::retranslate()
     m_treeViewHeaderText[TrackCount]=tr("Track Count");
     m_treeViewHeaderText[TrackNumber]=tr("Track Number");
     m_treeViewHeaderText[Year]=tr("Year");
+    m_treeViewHeaderText[Loudness]=tr("Loudness");
+    m_treeViewHeaderText[TruePeak]=tr("True Peak");
+    m_treeViewHeaderText[AlbumGain]=tr("Album Gain");
 }
 
 void KNMusicGlobal::onActionLibraryMoved(const QString &originalPath,
@@ -558,6 +562,16 @@ void KNMusicGlobal::setSoloMenu(KNMusicSoloMenuBase *soloMenu)
     m_soloMenu = soloMenu;
 }
 
+KNMusicLibraryBase *KNMusicGlobal::library()
+{
+    return m_library;
+}
+
+void KNMusicGlobal::setLibrary(KNMusicLibraryBase *library)
+{
+    m_library = library;
+}
+
 KNMusicGlobal::KNMusicGlobal(QObject *parent) :
     QObject(parent)
 {
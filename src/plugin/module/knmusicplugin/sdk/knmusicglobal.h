@@ -13,6 +13,8 @@
 #include <QDateTime>
 #include <QVariant>
 #include <QStringList>
+#include <QSet>
+#include <QSharedPointer>
 #include <QStandardItem>
 
 #include "preference/knpreferenceitemglobal.h"
@@ -49,6 +51,11 @@ enum MusicDatas
     TrackCount,
     TrackNumber,
     Year,
+    //The loudness columns are added after the others, the column indexes are
+    //saved in the playlists.
+    Loudness,
+    TruePeak,
+    AlbumGain,
     MusicDataCount
 };
 enum MusicDisplayData
@@ -62,7 +69,9 @@ enum KNMusicModelRole
     FileNameRole,
     StartPositionRole,
     ArtworkKeyRole,
-    TrackFileRole
+    TrackFileRole,
+    LibraryIdRole,
+    LoudnessFailedRole
 };
 enum KNMusicCategoryRole
 {
@@ -83,6 +92,18 @@ enum KNMusicPlayingState
     PlayingState,
     PausedState
 };
+enum KNMusicNormalizationMode
+{
+    NormalizationOff,
+    NormalizationTrack,
+    NormalizationAlbum
+};
+enum KNMusicCrossfadeMode
+{
+    CrossfadeOff,
+    CrossfadeTime,
+    CrossfadeSilence
+};
 enum KNMusicSortFlag
 {
     SortByInt,
@@ -116,6 +137,8 @@ struct KNMusicDetailInfo
     QString fileName;
     QString filePath;
     QString trackFilePath;
+    //The id of the row in the library, 0 when it's not in the library.
+    quint32 libraryId=0;
     quint64 size;
     QDateTime dateModified;
     QDateTime lastPlayed;
@@ -130,6 +153,15 @@ struct KNMusicDetailInfo
     //Tag datas.
     QString textLists[MusicDataCount];
     int rating=0;
+    //Loudness data, it's only available after the loudness scanner measures
+    //the file.
+    bool loudnessMeasured=false;
+    qreal loudness=0.0;     //Unit: LUFS
+    qreal truePeak=0.0;     //Unit: dBTP
+    bool albumGainMeasured=false;
+    qreal albumGain=0.0;    //Unit: dB
+    //The file can't be decoded by the scanner, don't measure it again.
+    bool loudnessFailed=false;
 };
 struct KNMusicAnalysisItem
 {
@@ -138,6 +170,9 @@ struct KNMusicAnalysisItem
     QImage coverImage;
     QMap<QString, QList<QByteArray>> imageData;
 };
+//The posting list of a category, stores the first item of all the rows which
+//belongs to the category. The first item of a row is used as the row id.
+typedef QSharedPointer<QSet<QStandardItem *>> KNMusicCategoryRows;
 }
 
 using namespace KNMusic;
@@ -154,6 +189,7 @@ class KNMusicDetailDialogBase;
 class KNMusicSoloMenuBase;
 class KNMusicMultiMenuBase;
 class KNMusicSearchBase;
+class KNMusicLibraryBase;
 class KNMusicGlobal : public QObject
 {
     Q_OBJECT
@@ -171,6 +207,8 @@ public:
     static void setNowPlaying(KNMusicNowPlayingBase *nowPlaying);
     static KNMusicSoloMenuBase *soloMenu();
     static void setSoloMenu(KNMusicSoloMenuBase *soloMenu);
+    static KNMusicLibraryBase *library();
+    static void setLibrary(KNMusicLibraryBase *library);
     static KNMusicMultiMenuBase *multiMenu();
     static void setMultiMenu(KNMusicMultiMenuBase *multiMenu);
     static QString musicLibraryPath();
@@ -229,6 +267,7 @@ private:
     static KNMusicParser *m_parser;
     static KNMusicNowPlayingBase *m_nowPlaying;
     static KNMusicSoloMenuBase *m_soloMenu;
+    static KNMusicLibraryBase *m_library;
     static KNMusicMultiMenuBase *m_multiMenu;
     static KNMusicSearchBase *m_musicSearch;
     static KNMusicDetailTooltipBase *m_detailTooltip;
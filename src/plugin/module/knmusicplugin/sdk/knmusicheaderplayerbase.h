@@ -36,6 +36,7 @@ signals:
     void requireShowInGenres();
     void requireCheckCursor();
     void requireLoadLyrics(KNMusicDetailInfo detailInfo);
+    void requirePrefetchLyrics(KNMusicDetailInfo detailInfo);
     void playerReset();
     void finished();
     void positionChanged(qint64 position);
@@ -7,8 +7,11 @@
 #ifndef KNMUSICLIBRARYBASE_H
 #define KNMUSICLIBRARYBASE_H
 
+#include "knmusicglobal.h"
+
 #include <QObject>
 
+class KNMusicBackend;
 class KNMusicHeaderPlayerBase;
 class KNMusicTab;
 class KNMusicLibraryBase : public QObject
@@ -21,9 +24,20 @@ public:
     virtual KNMusicTab *albumTab()=0;
     virtual KNMusicTab *genreTab()=0;
     virtual void setHeaderPlayer(KNMusicHeaderPlayerBase *player)=0;
+    virtual void setBackend(KNMusicBackend *backend)=0;
+    //The rows of the library have stable ids, the playlists refer to the songs
+    //in the library with the ids. The library will be loaded if it hasn't been
+    //loaded.
+    virtual bool hasLibraryId(const quint32 &libraryId)=0;
+    virtual bool detailInfoFromLibraryId(const quint32 &libraryId,
+                                         KNMusicDetailInfo &detailInfo)=0;
 
 signals:
     void requireShowTab();
+    //The songs are going to be removed from the library, their ids won't be
+    //available any more. The songs could still be found by the ids until the
+    //signal returns.
+    void libraryIdsAboutToBeRemoved(QList<quint32> libraryIds);
 
 public slots:
 
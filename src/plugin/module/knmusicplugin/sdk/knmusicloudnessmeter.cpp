@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#include <cmath>
+
+#include "knmusicaudiodecoder.h"
+
+#include "knmusicloudnessmeter.h"
+
+//The taps of each phase of the oversampling filter.
+#define PhaseTaps 12
+#define Oversampling 4
+//The absolute gate is -70 LUFS, the relative gate is 10 LU below the loudness
+//of the blocks over the absolute gate.
+#define AbsoluteGate -70.0
+#define RelativeGate -10.0
+//The loudness which all the songs are adjusted to, it's the reference level of
+//ReplayGain 2.0.
+#define ReferenceLoudness -18.0
+
+KNMusicLoudnessMeter::KNMusicLoudnessMeter(const int &sampleRate,
+                                           const int &channels,
+                                           const QVector<int> &channelPositions) :
+    m_subBlockSize(qMax(sampleRate/10, 1)),
+    m_channels(channels)
+{
+    //Calculate the K-weighting filters for the sample rate, the high shelving
+    //filter for the head, and the high pass filter.
+    double K=tan(M_PI*1681.974450955533/sampleRate),
+           Q=0.7071752369554196,
+           Vh=pow(10.0, 3.999843853973347/20.0),
+           Vb=pow(Vh, 0.4996667741545416),
+           a0=1.0+K/Q+K*K;
+    m_shelving.b0=(Vh+Vb*K/Q+K*K)/a0;
+    m_shelving.b1=2.0*(K*K-Vh)/a0;
+    m_shelving.b2=(Vh-Vb*K/Q+K*K)/a0;
+    m_shelving.a1=2.0*(K*K-1.0)/a0;
+    m_shelving.a2=(1.0-K/Q+K*K)/a0;
+    K=tan(M_PI*38.13547087602444/sampleRate);
+    Q=0.5003270373238773;
+    a0=1.0+K/Q+K*K;
+    m_highPass.b0=1.0;
+    m_highPass.b1=-2.0;
+    m_highPass.b2=1.0;
+    m_highPass.a1=2.0*(K*K-1.0)/a0;
+    m_highPass.a2=(1.0-K/Q+K*K)/a0;
+    m_filterStates.fill(0.0, m_channels*4);
+    //The surround channels are weighted, the LFE is ignored. When the layout
+    //is unknown, treat 6 channels as 5.1.
+    m_channelWeights.fill(1.0, m_channels);
+    if(channelPositions.size()==m_channels)
+    {
+        for(int i=0; i<m_channels; i++)
+        {
+            switch(channelPositions.at(i))
+            {
+            case KNMusicAudioDecoder::SurroundChannel:
+                m_channelWeights[i]=1.41;
+                break;
+            case KNMusicAudioDecoder::LowFrequencyChannel:
+                m_channelWeights[i]=0.0;
+                break;
+            }
+        }
+    }
+    else if(m_channels==6)
+    {
+        m_channelWeights[3]=0.0;
+        m_channelWeights[4]=1.41;
+        m_channelWeights[5]=1.41;
+    }
+    //Generate the oversampling filter, a windowed sinc.
+    int taps=PhaseTaps*Oversampling;
+    m_oversampleFilter.resize(taps);
+    for(int i=0; i<taps; i++)
+    {
+        double t=((double)i-(taps-1)/2.0)/Oversampling,
+               sinc=t==0.0?1.0:sin(M_PI*t)/(M_PI*t),
+               window=0.5-0.5*cos(2.0*M_PI*(i+0.5)/taps);
+        m_oversampleFilter[i]=sinc*window;
+    }
+    m_peakHistory.fill(0.0, m_channels*PhaseTaps);
+}
+
+qreal KNMusicLoudnessMeter::gain(const qreal &loudness)
+{
+    return ReferenceLoudness-loudness;
+}
+
+void KNMusicLoudnessMeter::addFrames(const float *frames,
+                                     const int &frameCount)
+{
+    for(int i=0; i<frameCount; i++)
+    {
+        double energy=0.0;
+        for(int j=0; j<m_channels; j++)
+        {
+            float sample=frames[j];
+            checkPeak(j, sample);
+            //K-weight the sample.
+            double *state=m_filterStates.data()+j*4,
+                   shelved=m_shelving.b0*sample+state[0];
+            state[0]=m_shelving.b1*sample-m_shelving.a1*shelved+state[1];
+            state[1]=m_shelving.b2*sample-m_shelving.a2*shelved;
+            double weighted=m_highPass.b0*shelved+state[2];
+            state[2]=m_highPass.b1*shelved-m_highPass.a1*weighted+state[3];
+            state[3]=m_highPass.b2*shelved-m_highPass.a2*weighted;
+            energy+=m_channelWeights.at(j)*weighted*weighted;
+        }
+        //Move to the next frame.
+        m_historyPosition=(m_historyPosition+1)%PhaseTaps;
+        frames+=m_channels;
+        m_subBlockEnergy+=energy;
+        if(++m_subBlockFrames==m_subBlockSize)
+        {
+            finishSubBlock();
+        }
+    }
+}
+
+bool KNMusicLoudnessMeter::isMeasured() const
+{
+    return !m_blocks.isEmpty();
+}
+
+qreal KNMusicLoudnessMeter::integratedLoudness() const
+{
+    //Find the blocks over the absolute gate.
+    double absoluteGate=pow(10.0, (AbsoluteGate+0.691)/10.0),
+           energy=0.0;
+    int blockCount=0;
+    for(double block : m_blocks)
+    {
+        if(block>absoluteGate)
+        {
+            energy+=block;
+            blockCount++;
+        }
+    }
+    if(blockCount==0)
+    {
+        return AbsoluteGate;
+    }
+    //Use the blocks over the relative gate.
+    double relativeGate=qMax(energy/blockCount*pow(10.0, RelativeGate/10.0),
+                             absoluteGate);
+    energy=0.0;
+    blockCount=0;
+    for(double block : m_blocks)
+    {
+        if(block>relativeGate)
+        {
+            energy+=block;
+            blockCount++;
+        }
+    }
+    return blockCount==0?
+                AbsoluteGate:-0.691+10.0*log10(energy/blockCount);
+}
+
+qreal KNMusicLoudnessMeter::truePeak() const
+{
+    //Treat the silence as -120 dBTP.
+    return 20.0*log10(qMax((double)m_peak, 1e-6));
+}
+
+inline void KNMusicLoudnessMeter::finishSubBlock()
+{
+    //Save the sub-block, a gating block is 4 sub-blocks.
+    m_subBlocks[m_subBlockCount%4]=m_subBlockEnergy;
+    m_subBlockCount++;
+    m_subBlockEnergy=0.0;
+    m_subBlockFrames=0;
+    if(m_subBlockCount>=4)
+    {
+        m_blocks.append((m_subBlocks[0]+m_subBlocks[1]+
+                         m_subBlocks[2]+m_subBlocks[3])/(4.0*m_subBlockSize));
+    }
+}
+
+inline void KNMusicLoudnessMeter::checkPeak(const int &channel,
+                                            const float &sample)
+{
+    float *history=m_peakHistory.data()+channel*PhaseTaps;
+    history[m_historyPosition]=sample;
+    float peak=fabs(sample);
+    //Calculate the oversampled samples between the samples.
+    for(int phase=0; phase<Oversampling; phase++)
+    {
+        float value=0.0;
+        for(int i=0; i<PhaseTaps; i++)
+        {
+            value+=m_oversampleFilter.at(phase+i*Oversampling)*
+                    history[(m_historyPosition-i+PhaseTaps)%PhaseTaps];
+        }
+        peak=qMax(peak, (float)fabs(value));
+    }
+    m_peak=qMax(m_peak, peak);
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#ifndef KNMUSICLOUDNESSMETER_H
+#define KNMUSICLOUDNESSMETER_H
+
+#include <QVector>
+
+//The loudness meter measures the integrated loudness and the true peak of the
+//audio data in the way of EBU R128 (ITU-R BS.1770). The data is K-weighted,
+//and the loudness is gated by 400ms blocks which overlap 75%. The true peak is
+//checked on the data which is 4 times oversampled.
+class KNMusicLoudnessMeter
+{
+public:
+    KNMusicLoudnessMeter(const int &sampleRate,
+                         const int &channels,
+                         const QVector<int> &channelPositions=QVector<int>());
+    static qreal gain(const qreal &loudness);
+    void addFrames(const float *frames, const int &frameCount);
+    bool isMeasured() const;
+    qreal integratedLoudness() const;
+    qreal truePeak() const;
+
+private:
+    struct KNMusicBiquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+    inline void finishSubBlock();
+    inline void checkPeak(const int &channel, const float &sample);
+    KNMusicBiquad m_shelving, m_highPass;
+    //Filter states, 4 values for each channel.
+    QVector<double> m_filterStates;
+    QVector<double> m_channelWeights;
+    //The oversampling filter and the history of each channel.
+    QVector<float> m_oversampleFilter, m_peakHistory;
+    //The mean square of the gating blocks.
+    QVector<double> m_blocks;
+    double m_subBlocks[4];
+    double m_subBlockEnergy=0.0;
+    int m_subBlockFrames=0, m_subBlockSize, m_subBlockCount=0;
+    int m_channels, m_historyPosition=0;
+    float m_peak=0.0;
+};
+
+#endif // KNMUSICLOUDNESSMETER_H
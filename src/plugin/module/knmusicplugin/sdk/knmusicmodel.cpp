@@ -4,23 +4,32 @@
  * terms of the Do What The Fuck You Want To Public License, Version 2,
  * as published by Sam Hocevar. See the COPYING file for more details.
  */
+#include <algorithm>
+
 #include <QMimeData>
 
 #include "knglobal.h"
+#include "knlocalemanager.h"
 #include "knmusicsearcher.h"
 #include "knmusicanalysiscache.h"
 #include "knmusicanalysisextend.h"
+#include "knmusicmodelassist.h"
 #include "knmusicratingdelegate.h"
+#include "knmusicstringpool.h"
 
 #include "knmusicmodel.h"
 
 #include <QDebug>
 
+#define MAX_DERIVED_CACHE 4096
+
 KNMusicModel::KNMusicModel(QObject *parent) :
     QStandardItemModel(parent)
 {
     //Initial music global.
     m_musicGlobal=KNMusicGlobal::instance();
+    //Every cached text costs 1.
+    m_derivedTextCache.setMaxCost(MAX_DERIVED_CACHE);
     //Linked the signal.
     connect(m_musicGlobal, &KNMusicGlobal::musicFilePathChanged,
             this, &KNMusicModel::onActionFileNameChanged);
@@ -41,6 +50,14 @@ KNMusicModel::KNMusicModel(QObject *parent) :
 
     //Initial a default analysis extend.
     setAnalysisExtend(new KNMusicAnalysisExtend);
+
+    //The formatted texts depend on the language.
+    connect(KNLocaleManager::instance(), &KNLocaleManager::requireRetranslate,
+            this, &KNMusicModel::clearDerivedTextCache);
+    //The items of the removed rows will be deleted, drop their texts before
+    //the pointers are recycled by other items.
+    connect(this, &KNMusicModel::rowsAboutToBeRemoved,
+            this, &KNMusicModel::onActionRowsAboutToBeRemoved);
 }
 
 KNMusicModel::~KNMusicModel()
@@ -72,6 +89,41 @@ Qt::ItemFlags KNMusicModel::flags(const QModelIndex &index) const
     return Qt::ItemIsDropEnabled;
 }
 
+QVariant KNMusicModel::data(const QModelIndex &index, int role) const
+{
+    //The display text of size, time, rate and date columns is not stored, it
+    //is formatted from the native value in the user role when it's required.
+    if(role==Qt::DisplayRole &&
+            KNMusicModelAssist::isDerivedColumn(index.column()))
+    {
+        QStandardItem *derivedItem=itemFromIndex(index);
+        if(derivedItem==nullptr)
+        {
+            return QVariant();
+        }
+        QVariant nativeValue=derivedItem->data(Qt::UserRole);
+        //Only the visible items will be asked for the text, keep the text we
+        //formatted until the native value is changed.
+        DerivedTextItem *cachedText=m_derivedTextCache.object(derivedItem);
+        if(cachedText!=nullptr &&
+                cachedText->column==index.column() &&
+                cachedText->value==nativeValue)
+        {
+            return cachedText->text;
+        }
+        //The cache drops the least recently used text when it's full.
+        DerivedTextItem *derivedText=new DerivedTextItem;
+        derivedText->column=index.column();
+        derivedText->value=nativeValue;
+        derivedText->text=KNMusicModelAssist::derivedText(index.column(),
+                                                          nativeValue);
+        QString text=derivedText->text;
+        m_derivedTextCache.insert(derivedItem, derivedText);
+        return text;
+    }
+    return QStandardItemModel::data(index, role);
+}
+
 QStringList KNMusicModel::mimeTypes() const
 {
     //Add url list to mimetypes, but I don't know why should add uri.
@@ -100,6 +152,18 @@ bool KNMusicModel::dropMimeData(const QMimeData *data,
     return QStandardItemModel::dropMimeData(data, action, row, column, parent);
 }
 
+void KNMusicModel::setItemText(const int &row,
+                               const int &column,
+                               const QString &text)
+{
+    Q_ASSERT(row>-1 && row<rowCount() && column>-1 && column<columnCount());
+    //Share the repeated tag texts with the other rows.
+    setData(index(row, column),
+            KNMusicStringPool::isPooledColumn(column)?
+                KNMusicStringPool::instance()->intern(text):text,
+            Qt::DisplayRole);
+}
+
 qint64 KNMusicModel::totalDuration() const
 {
     return m_totalDuration;
@@ -119,6 +183,7 @@ KNMusicDetailInfo KNMusicModel::detailInfoFromRow(const int &row)
     detailInfo.trackFilePath=rowProperty(row, TrackFileRole).toString();
     detailInfo.coverImageHash=rowProperty(row, ArtworkKeyRole).toString();
     detailInfo.startPosition=rowProperty(row, StartPositionRole).toLongLong();
+    detailInfo.libraryId=rowProperty(row, LibraryIdRole).toUInt();
     detailInfo.size=roleData(row, Size, Qt::UserRole).toLongLong();
     detailInfo.dateModified=roleData(row, DateModified, Qt::UserRole).toDateTime();
     detailInfo.dateAdded=roleData(row, DateAdded, Qt::UserRole).toDateTime();
@@ -127,6 +192,14 @@ KNMusicDetailInfo KNMusicModel::detailInfoFromRow(const int &row)
     detailInfo.bitRate=roleData(row, BitRate, Qt::UserRole).toLongLong();
     detailInfo.samplingRate=roleData(row, SampleRate, Qt::UserRole).toLongLong();
     detailInfo.rating=roleData(row, Size, Qt::DisplayRole).toInt();
+    QVariant loudness=roleData(row, Loudness, Qt::UserRole),
+             albumGain=roleData(row, AlbumGain, Qt::UserRole);
+    detailInfo.loudnessMeasured=loudness.isValid();
+    detailInfo.loudness=loudness.toDouble();
+    detailInfo.truePeak=roleData(row, TruePeak, Qt::UserRole).toDouble();
+    detailInfo.albumGainMeasured=albumGain.isValid();
+    detailInfo.albumGain=albumGain.toDouble();
+    detailInfo.loudnessFailed=rowProperty(row, LoudnessFailedRole).toBool();
     //Return the detail info.
     return detailInfo;
 }
@@ -177,8 +250,19 @@ void KNMusicModel::updateMusicRow(const int &row,
         {
         case Rating:
         case AlbumRating:
-        case DateAdded:
         case Plays:
+        //The texts of these columns are formatted from the user role data.
+        case Size:
+        case Time:
+        case BitRate:
+        case SampleRate:
+        case DateAdded:
+        case DateModified:
+        case LastPlayed:
+        //The loudness is measured by the scanner, not the parser.
+        case Loudness:
+        case TruePeak:
+        case AlbumGain:
             break;
         default:
             setItemText(row, i, detailInfo.textLists[i]);
@@ -208,16 +292,60 @@ void KNMusicModel::removeMusicRow(const int &row)
     emit rowCountChanged();
 }
 
+void KNMusicModel::removeMusicRows(const QList<int> &rows)
+{
+    //Sort the rows, and remove the duplicate rows.
+    QList<int> sortedRows=sortedUniqueRows(rows);
+    if(sortedRows.isEmpty())
+    {
+        return;
+    }
+    //Coalesce the rows to continuous ranges, remove them from the last range
+    //to the first one, so the rows in front won't be moved.
+    int i=sortedRows.size()-1;
+    while(i>-1)
+    {
+        int lastRow=sortedRows.at(i), firstRow=lastRow;
+        //Find the first row of the range.
+        while(--i>-1 && sortedRows.at(i)==firstRow-1)
+        {
+            firstRow--;
+        }
+        //We need to do sth before remove the range.
+        for(int row=firstRow; row<=lastRow; row++)
+        {
+            m_totalDuration-=data(index(row, Time), Qt::UserRole).toInt();
+        }
+        //Remove the range in one operation.
+        removeRows(firstRow, lastRow-firstRow+1);
+    }
+    //Tell other's to update.
+    emit rowCountChanged();
+}
+
 void KNMusicModel::clearMusicRow()
 {
     //Clear the duration.
     m_totalDuration=0;
+    //Clear the formatted texts.
+    clearDerivedTextCache();
     //Remove all the rows.
     removeRows(0, rowCount());
     //Tell other's to update.
     emit rowCountChanged();
 }
 
+QList<int> KNMusicModel::sortedUniqueRows(const QList<int> &rows)
+{
+    //Sort the rows in ascending order.
+    QList<int> sortedRows=rows;
+    std::sort(sortedRows.begin(), sortedRows.end());
+    //Remove the duplicate rows.
+    sortedRows.erase(std::unique(sortedRows.begin(), sortedRows.end()),
+                     sortedRows.end());
+    return sortedRows;
+}
+
 void KNMusicModel::blockAddFile(const QString &filePath)
 {
     //WARNING: This function is working in a block way to adding file, may cause
@@ -237,9 +365,13 @@ void KNMusicModel::setHeaderSortFlag()
     setHeaderData(TrackCount, Qt::Horizontal, SortByInt, Qt::UserRole);
     setHeaderData(Size, Qt::Horizontal, SortUserByInt, Qt::UserRole);
     setHeaderData(BitRate, Qt::Horizontal, SortUserByFloat, Qt::UserRole);
+    setHeaderData(SampleRate, Qt::Horizontal, SortUserByInt, Qt::UserRole);
     setHeaderData(DateAdded, Qt::Horizontal, SortUserByDate, Qt::UserRole);
     setHeaderData(DateModified, Qt::Horizontal, SortUserByDate, Qt::UserRole);
     setHeaderData(LastPlayed, Qt::Horizontal, SortUserByDate, Qt::UserRole);
+    setHeaderData(Loudness, Qt::Horizontal, SortUserByFloat, Qt::UserRole);
+    setHeaderData(TruePeak, Qt::Horizontal, SortUserByFloat, Qt::UserRole);
+    setHeaderData(AlbumGain, Qt::Horizontal, SortUserByFloat, Qt::UserRole);
 }
 
 KNMusicAnalysisExtend *KNMusicModel::analysisExtend() const
@@ -293,3 +425,30 @@ void KNMusicModel::onActionFileNameChanged(const QString &originalPath,
         setRowProperty(currentRow, FileNameRole, currentFileName);
     }
 }
+
+void KNMusicModel::clearDerivedTextCache()
+{
+    m_derivedTextCache.clear();
+}
+
+void KNMusicModel::onActionRowsAboutToBeRemoved(const QModelIndex &parent,
+                                                int first,
+                                                int last)
+{
+    Q_UNUSED(parent)
+    if(m_derivedTextCache.isEmpty())
+    {
+        return;
+    }
+    //Remove the formatted texts of the derived columns in the removed rows.
+    for(int row=first; row<=last; ++row)
+    {
+        for(int column=0; column<columnCount(); ++column)
+        {
+            if(KNMusicModelAssist::isDerivedColumn(column))
+            {
+                m_derivedTextCache.remove(item(row, column));
+            }
+        }
+    }
+}
@@ -7,6 +7,7 @@
 #ifndef KNMUSICMODEL_H
 #define KNMUSICMODEL_H
 
+#include <QCache>
 #include <QPixmap>
 #include <QStringList>
 
@@ -27,6 +28,7 @@ public:
     ~KNMusicModel();
     Qt::DropActions supportedDropActions() const;
     Qt::ItemFlags flags(const QModelIndex &index) const;
+    QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const;
     QStringList mimeTypes() const;
     bool dropMimeData(const QMimeData *data,
                       Qt::DropAction action,
@@ -47,12 +49,9 @@ public:
         //Only for text easy access.
         return data(index(row, column), Qt::DisplayRole).toString();
     }
-    virtual void setItemText(const int &row, const int &column, const QString &text)
-    {
-        Q_ASSERT(row>-1 && row<rowCount() && column>-1 && column<columnCount());
-        //Only for text easy access.
-        setData(index(row, column), text, Qt::DisplayRole);
-    }
+    virtual void setItemText(const int &row,
+                             const int &column,
+                             const QString &text);
     inline QVariant roleData(int row, int column, int role) const
     {
         Q_ASSERT(row>-1 && row<rowCount() && column>-1 && column<columnCount());
@@ -109,9 +108,11 @@ public slots:
     virtual void updateMusicRow(const int &row,
                                 const KNMusicDetailInfo &detailInfo);
     virtual void removeMusicRow(const int &row);
+    virtual void removeMusicRows(const QList<int> &rows);
     virtual void clearMusicRow();
 
 protected:
+    static QList<int> sortedUniqueRows(const QList<int> &rows);
     virtual void blockAddFile(const QString &filePath);
     virtual void setHeaderSortFlag();
     KNMusicAnalysisExtend *analysisExtend() const;
@@ -121,8 +122,19 @@ private slots:
     void onActionFileNameChanged(const QString &originalPath,
                                  const QString &currentPath,
                                  const QString &currentFileName);
+    void clearDerivedTextCache();
+    void onActionRowsAboutToBeRemoved(const QModelIndex &parent,
+                                      int first,
+                                      int last);
 
 private:
+    struct DerivedTextItem
+    {
+        int column;
+        QVariant value;
+        QString text;
+    };
+    mutable QCache<QStandardItem *, DerivedTextItem> m_derivedTextCache;
     KNMusicSearcher *m_searcher;
     KNMusicAnalysisCache *m_analysisCache;
     KNMusicAnalysisExtend *m_analysisExtend=nullptr;
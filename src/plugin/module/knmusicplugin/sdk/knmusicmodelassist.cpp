@@ -4,8 +4,10 @@
  * terms of the Do What The Fuck You Want To Public License, Version 2,
  * as published by Sam Hocevar. See the COPYING file for more details.
  */
+#include "knglobal.h"
 #include "knmusicparser.h"
 #include "knmusicmodel.h"
+#include "knmusicstringpool.h"
 
 #include "knmusicmodelassist.h"
 
@@ -27,9 +29,13 @@ QList<QStandardItem *> KNMusicModelAssist::generateRow(const KNMusicDetailInfo &
 {
     QList<QStandardItem *> musicRow;
     QStandardItem *item;
+    KNMusicStringPool *stringPool=KNMusicStringPool::instance();
     for(int i=0; i<MusicDataCount; i++)
     {
-        item=new QStandardItem(detailInfo.textLists[i]);
+        //The repeated tag texts are shared with the other rows.
+        item=new QStandardItem(KNMusicStringPool::isPooledColumn(i)?
+                                   stringPool->intern(detailInfo.textLists[i]):
+                                   detailInfo.textLists[i]);
         item->setEditable(false);
         musicRow.append(item);
     }
@@ -39,6 +45,14 @@ QList<QStandardItem *> KNMusicModelAssist::generateRow(const KNMusicDetailInfo &
     item->setData(detailInfo.trackFilePath, TrackFileRole);
     item->setData(detailInfo.coverImageHash, ArtworkKeyRole);
     item->setData(detailInfo.startPosition, StartPositionRole);
+    if(detailInfo.libraryId!=0)
+    {
+        item->setData(detailInfo.libraryId, LibraryIdRole);
+    }
+    if(detailInfo.loudnessFailed)
+    {
+        item->setData(true, LoudnessFailedRole);
+    }
     item=musicRow.at(Size);
     item->setData(detailInfo.size, Qt::UserRole);
     item->setData(QVariant(Qt::AlignRight | Qt::AlignVCenter), Qt::TextAlignmentRole);
@@ -60,6 +74,16 @@ QList<QStandardItem *> KNMusicModelAssist::generateRow(const KNMusicDetailInfo &
     item->setEditable(true);
     item=musicRow.at(AlbumRating);
     item->setEditable(true);
+    //The loudness columns are empty until the file is measured.
+    if(detailInfo.loudnessMeasured)
+    {
+        musicRow.at(Loudness)->setData(detailInfo.loudness, Qt::UserRole);
+        musicRow.at(TruePeak)->setData(detailInfo.truePeak, Qt::UserRole);
+    }
+    if(detailInfo.albumGainMeasured)
+    {
+        musicRow.at(AlbumGain)->setData(detailInfo.albumGain, Qt::UserRole);
+    }
     return musicRow;
 }
 
@@ -138,3 +162,59 @@ QDateTime KNMusicModelAssist::dataStringToDateTime(const QString &text)
 {
     return QDateTime::fromString(text, "yyyyMMddHHmmss");
 }
+
+bool KNMusicModelAssist::isDerivedColumn(const int &column)
+{
+    switch(column)
+    {
+    case Size:
+    case Time:
+    case BitRate:
+    case SampleRate:
+    case DateAdded:
+    case DateModified:
+    case LastPlayed:
+    case Loudness:
+    case TruePeak:
+    case AlbumGain:
+        return true;
+    default:
+        return false;
+    }
+}
+
+QString KNMusicModelAssist::derivedText(const int &column,
+                                        const QVariant &value)
+{
+    //The display text of these columns is only a format of the native value
+    //which is saved in the user role.
+    switch(column)
+    {
+    case Size:
+        return KNGlobal::instance()->byteToHigherUnit(value.toLongLong());
+    case Time:
+        return KNMusicGlobal::msecondToString(value.toLongLong());
+    case BitRate:
+        return KNMusicParser::bitRateText(value.toLongLong());
+    case SampleRate:
+        return KNMusicParser::sampleRateText(value.toLongLong());
+    case DateAdded:
+    case DateModified:
+    case LastPlayed:
+        return dateTimeToString(value.toDateTime());
+    case Loudness:
+        return value.isValid()?
+                    QString::number(value.toDouble(), 'f', 1)+" LUFS":
+                    QString();
+    case TruePeak:
+        return value.isValid()?
+                    QString::number(value.toDouble(), 'f', 1)+" dBTP":
+                    QString();
+    case AlbumGain:
+        return value.isValid()?
+                    QString::number(value.toDouble(), 'f', 2)+" dB":
+                    QString();
+    default:
+        return QString();
+    }
+}
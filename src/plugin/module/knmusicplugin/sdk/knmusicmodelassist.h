@@ -27,6 +27,8 @@ public:
     static QString dateTimeToDataString(const QDateTime &dateTime);
     static QString dateTimeToDataString(const QVariant &dateTime);
     static QDateTime dataStringToDateTime(const QString &text);
+    static bool isDerivedColumn(const int &column);
+    static QString derivedText(const int &column, const QVariant &value);
     static QList<QStandardItem *> generateRow(const KNMusicDetailInfo &detailInfo);
     static bool reanalysisRow(KNMusicModel *musicModel,
                               const QPersistentModelIndex &index,
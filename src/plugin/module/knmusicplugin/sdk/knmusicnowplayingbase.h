@@ -32,6 +32,7 @@ public:
 signals:
     void requireResetPlayer();
     void requireUpdatePlayerInfo(KNMusicAnalysisItem analysisItem);
+    void nextSongPrepared(KNMusicAnalysisItem analysisItem);
     void loopStateChanged(int state);
 
 public slots:
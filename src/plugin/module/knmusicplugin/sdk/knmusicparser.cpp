@@ -7,7 +7,8 @@
 #include <QFile>
 #include <QDataStream>
 
-#include "knglobal.h"
+#include "knmusicstringpool.h"
+#include "knmusicseekindex.h"
 
 #include "knmusicparser.h"
 
@@ -16,8 +17,9 @@
 KNMusicParser::KNMusicParser(QObject *parent) :
     QObject(parent)
 {
-    m_global=KNGlobal::instance();
     m_musicGlobal=KNMusicGlobal::instance();
+    m_stringPool=KNMusicStringPool::instance();
+    m_seekIndex=KNMusicSeekIndex::instance();
 }
 
 KNMusicParser::~KNMusicParser()
@@ -47,15 +49,10 @@ void KNMusicParser::parseFile(QString filePath,
     detailInfo.size=fileInfo.size();
     detailInfo.lastPlayed=fileInfo.lastRead();
     detailInfo.dateModified=fileInfo.lastModified();
-    //Generate basic info.
+    //Generate basic info. The size, date, time and rate texts are not
+    //generated here, the model formats them from the native value when they
+    //are displayed.
     detailInfo.textLists[Name]=detailInfo.fileName;
-    detailInfo.textLists[Size]=m_global->byteToHigherUnit(detailInfo.size);
-    detailInfo.textLists[DateAdded]=
-            KNMusicGlobal::dateTimeToString(detailInfo.dateAdded);
-    detailInfo.textLists[DateModified]=
-            KNMusicGlobal::dateTimeToString(detailInfo.dateModified);
-    detailInfo.textLists[LastPlayed]=
-            KNMusicGlobal::dateTimeToString(detailInfo.lastPlayed);
     detailInfo.textLists[Kind]=
             m_musicGlobal->typeDescription(fileInfo.suffix());
     //Analysis Music.
@@ -66,10 +63,11 @@ void KNMusicParser::parseFile(QString filePath,
     {
         detailInfo.duration=0;
     }
-    //Generate analysis info.
-    detailInfo.textLists[Time]=KNMusicGlobal::msecondToString(detailInfo.duration);
-    detailInfo.textLists[BitRate]=bitRateText(detailInfo.bitRate);
-    detailInfo.textLists[SampleRate]=sampleRateText(detailInfo.samplingRate);
+    //Share the repeated tag texts with the other rows.
+    m_stringPool->internDetailInfo(detailInfo);
+    //Queue the seek index of the frames, the backends use it to seek the VBR
+    //files accurately when it's built.
+    m_seekIndex->buildIndex(detailInfo.filePath);
 }
 
 void KNMusicParser::installAnalysiser(KNMusicAnalysiser *analysiser)
@@ -216,8 +214,8 @@ void KNMusicParser::parseTrackList(const QString &filePath,
                     {
                         currentInfo.duration=0;
                     }
-                    currentInfo.textLists[Time]=
-                            KNMusicGlobal::msecondToString(currentInfo.duration);
+                    //The list may change the tag texts, share them again.
+                    m_stringPool->internDetailInfo(currentInfo);
                     trackDetailList.append(currentTrackItem);
                 }
                 break;
@@ -22,7 +22,8 @@
 
 using namespace KNMusic;
 
-class KNGlobal;
+class KNMusicStringPool;
+class KNMusicSeekIndex;
 class KNMusicParser : public QObject
 {
     Q_OBJECT
@@ -53,8 +54,9 @@ private:
                               KNMusicAnalysisItem &analysisItem);
     inline bool checkImageFile(const QString &imageFileInfo,
                                KNMusicAnalysisItem &analysisItem);
-    KNGlobal *m_global;
     KNMusicGlobal *m_musicGlobal;
+    KNMusicStringPool *m_stringPool;
+    KNMusicSeekIndex *m_seekIndex;
     QList<KNMusicAnalysiser *> m_analysisers;
     QList<KNMusicTagParser *> m_tagParsers;
     QList<KNMusicListParser *> m_listParsers;
@@ -32,6 +32,47 @@ KNMusicDetailInfo KNMusicProxyModel::detailInfoFromRow(const int &row)
     return musicModel()->detailInfoFromRow(sourceRow(row));
 }
 
+void KNMusicProxyModel::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    //Disconnect the previous source model.
+    if(this->sourceModel()!=nullptr)
+    {
+        disconnect(this->sourceModel(), 0, this, SLOT(onActionSourceRowsChanged()));
+    }
+    //The accepted rows are built from the rows of the new model.
+    m_acceptedRowCount=-1;
+    QSortFilterProxyModel::setSourceModel(sourceModel);
+    if(sourceModel!=nullptr)
+    {
+        //The rows are moved before the proxy model maps them, the accepted
+        //rows must be built again.
+        connect(sourceModel, SIGNAL(rowsAboutToBeInserted(QModelIndex,int,int)),
+                this, SLOT(onActionSourceRowsChanged()));
+        connect(sourceModel, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+                this, SLOT(onActionSourceRowsChanged()));
+        connect(sourceModel, SIGNAL(rowsAboutToBeMoved(QModelIndex,int,int,QModelIndex,int)),
+                this, SLOT(onActionSourceRowsChanged()));
+        connect(sourceModel, SIGNAL(layoutAboutToBeChanged()),
+                this, SLOT(onActionSourceRowsChanged()));
+        connect(sourceModel, SIGNAL(modelAboutToBeReset()),
+                this, SLOT(onActionSourceRowsChanged()));
+    }
+}
+
+KNMusicCategoryRows KNMusicProxyModel::categoryRows() const
+{
+    return m_categoryRows;
+}
+
+void KNMusicProxyModel::setCategoryRows(const KNMusicCategoryRows &categoryRows)
+{
+    //Save the posting list, a null pointer means accept all the rows.
+    m_categoryRows=categoryRows;
+    m_acceptedRowCount=-1;
+    //Update the filter.
+    invalidateFilter();
+}
+
 inline int KNMusicProxyModel::sourceRow(const int &proxyRow) const
 {
     Q_ASSERT(proxyRow>-1 && proxyRow<rowCount());
@@ -65,6 +106,52 @@ bool KNMusicProxyModel::lessThan(const QModelIndex &left,
     return QSortFilterProxyModel::lessThan(left, right);
 }
 
+bool KNMusicProxyModel::filterAcceptsRow(int source_row,
+                                         const QModelIndex &source_parent) const
+{
+    //Check the category posting list first. The rows of the list are marked
+    //once, the proxy model only checks a bit of each row, and the searching
+    //only runs on the rows in the list.
+    if(!m_categoryRows.isNull())
+    {
+        //The size of the list is changed when the library adds a row to it or
+        //removes a row from it.
+        if(m_acceptedRowCount!=m_categoryRows->size())
+        {
+            updateAcceptedRows();
+        }
+        if(source_row>=m_acceptedRows.size() ||
+                !m_acceptedRows.testBit(source_row))
+        {
+            return false;
+        }
+    }
+    return QSortFilterProxyModel::filterAcceptsRow(source_row, source_parent);
+}
+
+void KNMusicProxyModel::onActionSourceRowsChanged()
+{
+    //The rows will be moved, build the accepted rows when they are checked.
+    m_acceptedRowCount=-1;
+}
+
+inline void KNMusicProxyModel::updateAcceptedRows() const
+{
+    m_acceptedRows.fill(false, sourceModel()->rowCount());
+    //Mark the rows of the items in the posting list.
+    for(QSet<QStandardItem *>::const_iterator i=m_categoryRows->constBegin();
+        i!=m_categoryRows->constEnd();
+        ++i)
+    {
+        int row=(*i)->row();
+        if(row>-1 && row<m_acceptedRows.size())
+        {
+            m_acceptedRows.setBit(row);
+        }
+    }
+    m_acceptedRowCount=m_categoryRows->size();
+}
+
 void KNMusicProxyModel::updateMusicRow(const int &row,
                                        const KNMusicDetailInfo &detailInfo)
 {
@@ -81,3 +168,8 @@ void KNMusicProxyModel::removeSourceMusicRow(const int &row)
 {
     musicModel()->removeMusicRow(row);
 }
+
+void KNMusicProxyModel::removeSourceMusicRows(const QList<int> &rows)
+{
+    musicModel()->removeMusicRows(rows);
+}
@@ -7,6 +7,7 @@
 #ifndef KNMUSICPROXYMODEL_H
 #define KNMUSICPROXYMODEL_H
 
+#include <QBitArray>
 #include <QSortFilterProxyModel>
 
 #include "knmusicglobal.h"
@@ -20,8 +21,11 @@ class KNMusicProxyModel : public QSortFilterProxyModel
 public:
     explicit KNMusicProxyModel(QObject *parent = 0);
     KNMusicModel *musicModel();
+    void setSourceModel(QAbstractItemModel *sourceModel);
     int playingItemColumn();
     KNMusicDetailInfo detailInfoFromRow(const int &row);
+    KNMusicCategoryRows categoryRows() const;
+    void setCategoryRows(const KNMusicCategoryRows &categoryRows);
     inline int sourceRow(const int &proxyRow) const;
     inline QString itemText(const int &row, const int &column) const
     {
@@ -67,12 +71,26 @@ signals:
 
 protected:
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const;
+    bool filterAcceptsRow(int source_row,
+                          const QModelIndex &source_parent) const;
 
 public slots:
     void updateMusicRow(const int &row,
                         const KNMusicDetailInfo &detailInfo);
     void removeMusicRow(const int &row);
     void removeSourceMusicRow(const int &row);
+    void removeSourceMusicRows(const QList<int> &rows);
+
+private slots:
+    void onActionSourceRowsChanged();
+
+private:
+    inline void updateAcceptedRows() const;
+    KNMusicCategoryRows m_categoryRows;
+    //The source rows in the posting list, the bits are built from the posting
+    //list again when the source rows are moved or the list is changed.
+    mutable QBitArray m_acceptedRows;
+    mutable int m_acceptedRowCount=-1;
 };
 
 #endif // KNMUSICPROXYMODEL_H
@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QReadLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QWriteLocker>
+
+#include "knmusicseekindex.h"
+
+#include <QDebug>
+
+//The decoder delay of the mp3 decoders, in samples.
+#define DecoderDelay 529
+#define CacheVersion 1
+//The size of a seek point in the cache file: the offset and the sample.
+#define CachePointSize 8
+
+class KNMusicSeekIndexTask : public QRunnable
+{
+public:
+    KNMusicSeekIndexTask(KNMusicSeekIndex *seekIndex,
+                         const QString &filePath) :
+        m_seekIndex(seekIndex),
+        m_filePath(filePath)
+    {
+    }
+
+    void run()
+    {
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+        //The task without a file path loads the cache file.
+        if(m_filePath.isEmpty())
+        {
+            m_seekIndex->loadCache();
+            return;
+        }
+        m_seekIndex->updateIndex(m_filePath);
+    }
+
+private:
+    KNMusicSeekIndex *m_seekIndex;
+    QString m_filePath;
+};
+
+KNMusicSeekIndex *KNMusicSeekIndex::m_instance=nullptr;
+
+KNMusicSeekIndex *KNMusicSeekIndex::instance()
+{
+    return m_instance==nullptr?m_instance=new KNMusicSeekIndex:m_instance;
+}
+
+KNMusicSeekIndex::KNMusicSeekIndex(QObject *parent) :
+    QObject(parent)
+{
+    //Only one file is parsed at the same time, the frames are read from the
+    //disk, more threads won't make it faster.
+    m_indexPool=new QThreadPool(this);
+    m_indexPool->setMaxThreadCount(1);
+}
+
+bool KNMusicSeekIndex::isIndexedSuffix(const QString &suffix)
+{
+    QString lowerSuffix=suffix.toLower();
+    return lowerSuffix=="mp3" || lowerSuffix=="mp2" || lowerSuffix=="mpga";
+}
+
+void KNMusicSeekIndex::buildIndex(const QString &filePath)
+{
+    if(!isIndexedSuffix(QFileInfo(filePath).suffix()))
+    {
+        return;
+    }
+    //Queue the file only once, the frames are parsed in the index thread.
+    {
+        QWriteLocker locker(&m_lock);
+        if(m_pendingFiles.contains(filePath))
+        {
+            return;
+        }
+        m_pendingFiles.insert(filePath);
+    }
+    m_indexPool->start(new KNMusicSeekIndexTask(this, filePath));
+}
+
+void KNMusicSeekIndex::updateIndex(const QString &filePath)
+{
+    //Check whether the index of the file is still available.
+    QFileInfo fileInfo(filePath);
+    qint64 lastModified=fileInfo.lastModified().toMSecsSinceEpoch();
+    bool indexed;
+    {
+        QReadLocker locker(&m_lock);
+        QHash<QString, KNMusicSeekTable>::const_iterator tableIterator=
+                m_tables.constFind(filePath);
+        indexed=tableIterator!=m_tables.constEnd() &&
+                tableIterator.value().size==fileInfo.size() &&
+                tableIterator.value().lastModified==lastModified;
+    }
+    //Parse the frames.
+    KNMusicSeekTable table;
+    table.size=fileInfo.size();
+    table.lastModified=lastModified;
+    bool parsed=!indexed && parseTable(filePath, table);
+    QWriteLocker locker(&m_lock);
+    m_pendingFiles.remove(filePath);
+    if(parsed)
+    {
+        m_tables.insert(filePath, table);
+        m_changed=true;
+    }
+}
+
+bool KNMusicSeekIndex::findPoint(const QString &filePath,
+                                 const qint64 &position,
+                                 quint32 &offset,
+                                 double &pointSecond)
+{
+    //The offsets are useless when the file is changed, e.g. the tag is
+    //rewritten and the audio data is moved.
+    QFileInfo fileInfo(filePath);
+    qint64 lastModified=fileInfo.lastModified().toMSecsSinceEpoch();
+    QReadLocker locker(&m_lock);
+    QHash<QString, KNMusicSeekTable>::const_iterator tableIterator=
+            m_tables.constFind(filePath);
+    if(tableIterator==m_tables.constEnd())
+    {
+        return false;
+    }
+    const KNMusicSeekTable &table=tableIterator.value();
+    if(table.size!=fileInfo.size() || table.lastModified!=lastModified)
+    {
+        //Drop the table and build it again.
+        locker.unlock();
+        {
+            QWriteLocker writeLocker(&m_lock);
+            m_tables.remove(filePath);
+            m_changed=true;
+        }
+        buildIndex(filePath);
+        return false;
+    }
+    //Start one second before the position, the frame before the position may
+    //need the data of the previous frames (the bit reservoir).
+    int pointIndex=position/1000-1;
+    if(pointIndex<1 || table.points.isEmpty())
+    {
+        //Seeking near the start is accurate enough.
+        return false;
+    }
+    if(pointIndex>=table.points.size())
+    {
+        pointIndex=table.points.size()-1;
+    }
+    const KNMusicSeekPoint &point=table.points.at(pointIndex);
+    offset=point.offset;
+    pointSecond=(double)point.sample/table.sampleRate;
+    return true;
+}
+
+void KNMusicSeekIndex::setCacheFilePath(const QString &cacheFilePath)
+{
+    m_cacheFilePath=cacheFilePath;
+    //Load the cache in the index thread before any file is indexed.
+    m_indexPool->start(new KNMusicSeekIndexTask(this, QString()));
+}
+
+void KNMusicSeekIndex::loadCache()
+{
+    QFile cacheFile(m_cacheFilePath);
+    if(!cacheFile.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+    QDataStream cacheStream(&cacheFile);
+    qint32 version, tableCount;
+    cacheStream >> version >> tableCount;
+    if(cacheStream.status()!=QDataStream::Ok || version!=CacheVersion)
+    {
+        return;
+    }
+    //Read the tables without the lock, the files are checked on the disk.
+    QHash<QString, KNMusicSeekTable> tables;
+    bool pruned=false;
+    for(qint32 i=0; i<tableCount && !cacheStream.atEnd(); i++)
+    {
+        QString filePath;
+        KNMusicSeekTable table;
+        qint32 sampleRate, pointCount;
+        cacheStream >> filePath >> table.size >> table.lastModified
+                    >> sampleRate >> pointCount;
+        //A broken cache file may ask for any size of the points, check the
+        //count with the rest of the file before allocating them.
+        if(cacheStream.status()!=QDataStream::Ok || sampleRate<1 ||
+                pointCount<0 ||
+                (qint64)pointCount*CachePointSize>
+                    cacheFile.size()-cacheFile.pos())
+        {
+            break;
+        }
+        table.sampleRate=sampleRate;
+        table.points.resize(pointCount);
+        for(qint32 j=0; j<pointCount; j++)
+        {
+            cacheStream >> table.points[j].offset >> table.points[j].sample;
+        }
+        if(cacheStream.status()!=QDataStream::Ok)
+        {
+            break;
+        }
+        //Remove the tables of the deleted and changed files.
+        QFileInfo fileInfo(filePath);
+        if(!fileInfo.exists() || fileInfo.size()!=table.size ||
+                fileInfo.lastModified().toMSecsSinceEpoch()!=
+                    table.lastModified)
+        {
+            pruned=true;
+            continue;
+        }
+        tables.insert(filePath, table);
+    }
+    //Keep the tables which are built in this session.
+    QWriteLocker locker(&m_lock);
+    for(QHash<QString, KNMusicSeekTable>::const_iterator i=tables.constBegin();
+        i!=tables.constEnd();
+        ++i)
+    {
+        if(!m_tables.contains(i.key()))
+        {
+            m_tables.insert(i.key(), i.value());
+        }
+    }
+    m_changed=m_changed || pruned;
+}
+
+void KNMusicSeekIndex::saveCache()
+{
+    //Drop the queued files, and wait for the file which is being parsed.
+    m_indexPool->clear();
+    m_indexPool->waitForDone();
+    QWriteLocker locker(&m_lock);
+    if(!m_changed || m_cacheFilePath.isEmpty())
+    {
+        return;
+    }
+    QFile cacheFile(m_cacheFilePath);
+    if(!cacheFile.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+    QDataStream cacheStream(&cacheFile);
+    cacheStream << (qint32)CacheVersion << (qint32)m_tables.size();
+    for(QHash<QString, KNMusicSeekTable>::const_iterator i=m_tables.constBegin();
+        i!=m_tables.constEnd();
+        ++i)
+    {
+        const KNMusicSeekTable &table=i.value();
+        cacheStream << i.key() << table.size << table.lastModified
+                    << (qint32)table.sampleRate
+                    << (qint32)table.points.size();
+        for(const KNMusicSeekPoint &point : table.points)
+        {
+            cacheStream << point.offset << point.sample;
+        }
+    }
+    m_changed=false;
+}
+
+bool KNMusicSeekIndex::parseTable(const QString &filePath,
+                                  KNMusicSeekTable &table)
+{
+    QFile musicFile(filePath);
+    if(!musicFile.open(QIODevice::ReadOnly) || musicFile.size()<10)
+    {
+        return false;
+    }
+    //Map the file, only the headers of the frames are read.
+    qint64 fileSize=musicFile.size();
+    const uchar *data=musicFile.map(0, fileSize);
+    if(data==nullptr)
+    {
+        return false;
+    }
+    qint64 position=0;
+    //Skip the ID3v2 tag.
+    if(data[0]=='I' && data[1]=='D' && data[2]=='3')
+    {
+        position=10+(((data[6]&0x7F)<<21) | ((data[7]&0x7F)<<14) |
+                     ((data[8]&0x7F)<<7) | (data[9]&0x7F));
+        if(data[5] & 0x10)
+        {
+            position+=10;
+        }
+    }
+    qint64 rawSample=0, delay=DecoderDelay;
+    int second=0;
+    bool firstFrame=true;
+    while(position+4<=fileSize)
+    {
+        int sampleRate, sampleCount, sideInfoSize,
+            size=frameSize(data+position, sampleRate, sampleCount, sideInfoSize);
+        //Find the next frame, all the frames should have the same sample
+        //rate.
+        if(size==0 || position+size>fileSize ||
+                (table.sampleRate!=0 && sampleRate!=table.sampleRate))
+        {
+            position++;
+            continue;
+        }
+        if(firstFrame)
+        {
+            firstFrame=false;
+            table.sampleRate=sampleRate;
+            //The first frame may be the Xing/Info frame without audio, the
+            //LAME tag in it saves the encoder delay.
+            const uchar *tag=data+position+4+sideInfoSize;
+            if(position+4+sideInfoSize+4<=fileSize &&
+                    (memcmp(tag, "Xing", 4)==0 || memcmp(tag, "Info", 4)==0))
+            {
+                if(position+4+sideInfoSize+144<=fileSize)
+                {
+                    const uchar *lameTag=tag+120;
+                    delay+=(lameTag[21]<<4) | (lameTag[22]>>4);
+                }
+                position+=size;
+                continue;
+            }
+        }
+        //Record the first frame of each second.
+        if(rawSample-delay>=(qint64)second*sampleRate)
+        {
+            KNMusicSeekPoint point;
+            point.offset=position;
+            point.sample=rawSample-delay;
+            table.points.append(point);
+            second++;
+        }
+        rawSample+=sampleCount;
+        position+=size;
+    }
+    musicFile.unmap((uchar *)data);
+    table.points.squeeze();
+    return !table.points.isEmpty();
+}
+
+inline int KNMusicSeekIndex::frameSize(const uchar *header,
+                                       int &sampleRate,
+                                       int &sampleCount,
+                                       int &sideInfoSize)
+{
+    static const int bitRates[2][3][16]=
+    {
+        //MPEG 1, layer I, II, III.
+        {
+            {0,32,64,96,128,160,192,224,256,288,320,352,384,416,448,0},
+            {0,32,48,56,64,80,96,112,128,160,192,224,256,320,384,0},
+            {0,32,40,48,56,64,80,96,112,128,160,192,224,256,320,0}
+        },
+        //MPEG 2 and 2.5, layer I, II, III.
+        {
+            {0,32,48,56,64,80,96,112,128,144,160,176,192,224,256,0},
+            {0,8,16,24,32,40,48,56,64,80,96,112,128,144,160,0},
+            {0,8,16,24,32,40,48,56,64,80,96,112,128,144,160,0}
+        }
+    };
+    static const int sampleRates[3]={44100, 48000, 32000};
+    //Check the sync word.
+    if(header[0]!=0xFF || (header[1]&0xE0)!=0xE0)
+    {
+        return 0;
+    }
+    int version=(header[1]>>3)&0x03,        //0: 2.5, 2: 2, 3: 1
+        layer=4-((header[1]>>1)&0x03),      //1, 2, 3
+        bitRateIndex=header[2]>>4,
+        sampleRateIndex=(header[2]>>2)&0x03,
+        padding=(header[2]>>1)&0x01,
+        mono=((header[3]>>6)&0x03)==3;
+    if(version==1 || layer==4 || bitRateIndex==0 || bitRateIndex==15 ||
+            sampleRateIndex==3)
+    {
+        return 0;
+    }
+    bool mpeg1=(version==3);
+    int bitRate=bitRates[mpeg1?0:1][layer-1][bitRateIndex]*1000;
+    sampleRate=sampleRates[sampleRateIndex]>>(version==3?0:(version==2?1:2));
+    if(layer==1)
+    {
+        sampleCount=384;
+        sideInfoSize=0;
+        return (12*bitRate/sampleRate+padding)*4;
+    }
+    sampleCount=(layer==3 && !mpeg1)?576:1152;
+    sideInfoSize=mpeg1?(mono?17:32):(mono?9:17);
+    return sampleCount/8*bitRate/sampleRate+padding;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#ifndef KNMUSICSEEKINDEX_H
+#define KNMUSICSEEKINDEX_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QVector>
+
+#include <QObject>
+
+//The seek index keeps the frame offset of about every second of the MPEG audio
+//files. The VBR files without a table of contents can't be seeked accurately,
+//with the index the backends can start decoding from the frame right before
+//the position, which takes the same time for any position in any file.
+struct KNMusicSeekPoint
+{
+    quint32 offset;     //The file offset of the frame.
+    qint32 sample;      //The first sample of the frame, encoder delay removed.
+};
+struct KNMusicSeekTable
+{
+    qint64 size=0;
+    qint64 lastModified=0;
+    int sampleRate=0;
+    QVector<KNMusicSeekPoint> points;
+};
+
+class QThreadPool;
+class KNMusicSeekIndex : public QObject
+{
+    Q_OBJECT
+public:
+    static KNMusicSeekIndex *instance();
+    static bool isIndexedSuffix(const QString &suffix);
+    //The index is built in the index thread, this returns immediately. The
+    //file could be seeked in the normal way until the index is built.
+    void buildIndex(const QString &filePath);
+    //These are called in the index thread.
+    void updateIndex(const QString &filePath);
+    void loadCache();
+    bool findPoint(const QString &filePath,
+                   const qint64 &position,
+                   quint32 &offset,
+                   double &pointSecond);
+    void setCacheFilePath(const QString &cacheFilePath);
+    void saveCache();
+
+signals:
+
+public slots:
+
+private:
+    static KNMusicSeekIndex *m_instance;
+    explicit KNMusicSeekIndex(QObject *parent = 0);
+    static bool parseTable(const QString &filePath, KNMusicSeekTable &table);
+    static inline int frameSize(const uchar *header,
+                                int &sampleRate,
+                                int &sampleCount,
+                                int &sideInfoSize);
+    QReadWriteLock m_lock;
+    QHash<QString, KNMusicSeekTable> m_tables;
+    QSet<QString> m_pendingFiles;
+    QThreadPool *m_indexPool;
+    QString m_cacheFilePath;
+    bool m_changed=false;
+};
+
+#endif // KNMUSICSEEKINDEX_H
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#include <QMutexLocker>
+#include <QTimer>
+
+#include <algorithm>
+#include <cmath>
+
+#include "knmusicspectrumanalyser.h"
+
+#include <QDebug>
+
+//The frames of a FFT, it must be a power of 2.
+#define FFTBits 11
+#define FFTSize (1<<FFTBits)
+//The ring keeps more than a second, the samples could be heard a long time
+//after they are written. It must be a power of 2.
+#define RingSize 65536
+#define RingMask (RingSize-1)
+//The bands are spaced logarithmically between the frequencies.
+#define BandCount 32
+#define MinimumFrequency 40.0
+#define MaximumFrequency 16000.0
+//The displayed range of the bands and the level, unit: dB.
+#define SpectrumRange 72.0f
+#define LevelRange 60.0f
+//The falling speed of the bars, unit: full scale per second.
+#define DecaySpeed 1.5f
+//When nothing is written for a while after the latency, it's paused.
+#define SilenceTimeout 250
+
+KNMusicSpectrumAnalyser::KNMusicSpectrumAnalyser(QObject *parent) :
+    QObject(parent),
+    m_ring(RingSize, 0.0f),
+    m_window(FFTSize),
+    m_real(FFTSize),
+    m_imag(FFTSize),
+    m_twiddleReal(FFTSize),
+    m_twiddleImag(FFTSize),
+    m_bitReverse(FFTSize),
+    m_bands(BandCount, 0.0f)
+{
+    qRegisterMetaType<QVector<float>>("QVector<float>");
+    //Prepare the Hann window, the twiddle factors and the bit reverse table.
+    for(int i=0; i<FFTSize; i++)
+    {
+        m_window[i]=0.5f-0.5f*cos(2.0*M_PI*i/(FFTSize-1));
+        int reversed=0;
+        for(int bit=0; bit<FFTBits; bit++)
+        {
+            reversed|=((i>>bit)&1)<<(FFTBits-1-bit);
+        }
+        m_bitReverse[i]=reversed;
+    }
+    //The twiddle factors of a stage are saved together, the stage of the size
+    //2*half starts at half, so the butterflies read them one by one.
+    for(int half=1; half<FFTSize; half<<=1)
+    {
+        for(int k=0; k<half; k++)
+        {
+            m_twiddleReal[half+k]=cos(M_PI*k/half);
+            m_twiddleImag[half+k]=-sin(M_PI*k/half);
+        }
+    }
+    //The timer lives in the analysing thread, so does the analysing.
+    m_timer=new QTimer;
+    m_timer->moveToThread(&m_analysisThread);
+    connect(m_timer, &QTimer::timeout,
+            [=]{analysis();});
+    m_analysisThread.start(QThread::LowPriority);
+}
+
+KNMusicSpectrumAnalyser::~KNMusicSpectrumAnalyser()
+{
+    //Stop the timer in its own thread, it could be deleted here after the
+    //thread is finished.
+    QMetaObject::invokeMethod(m_timer, "stop", Qt::BlockingQueuedConnection);
+    m_analysisThread.quit();
+    m_analysisThread.wait();
+    delete m_timer;
+}
+
+void KNMusicSpectrumAnalyser::writeSamples(const float *samples,
+                                           const int &frames,
+                                           const int &channels,
+                                           const int &sampleRate)
+{
+    QMutexLocker locker(&m_sampleLock);
+    m_sampleRate=sampleRate;
+    m_writeClock.start();
+    float scale=1.0f/(float)channels;
+    for(int i=0; i<frames; i++)
+    {
+        //Downmix the frame to mono.
+        float sample=0.0f;
+        for(int j=0; j<channels; j++)
+        {
+            sample+=*samples++;
+        }
+        m_ring[(m_writtenFrames++)&RingMask]=sample*scale;
+    }
+}
+
+void KNMusicSpectrumAnalyser::writeSamples(const qint16 *samples,
+                                           const int &frames,
+                                           const int &channels,
+                                           const int &sampleRate)
+{
+    QMutexLocker locker(&m_sampleLock);
+    m_sampleRate=sampleRate;
+    m_writeClock.start();
+    float scale=1.0f/(32768.0f*(float)channels);
+    for(int i=0; i<frames; i++)
+    {
+        int sample=0;
+        for(int j=0; j<channels; j++)
+        {
+            sample+=*samples++;
+        }
+        m_ring[(m_writtenFrames++)&RingMask]=(float)sample*scale;
+    }
+}
+
+void KNMusicSpectrumAnalyser::setLatency(const int &latency)
+{
+    QMutexLocker locker(&m_sampleLock);
+    m_latency=latency;
+}
+
+void KNMusicSpectrumAnalyser::setEnabled(const bool &enabled,
+                                         const int &interval)
+{
+    //The timer could only be started and stopped in its own thread.
+    if(enabled)
+    {
+        m_sampleLock.lock();
+        m_decay=DecaySpeed*(float)interval/1000.0f;
+        m_sampleLock.unlock();
+        QMetaObject::invokeMethod(m_timer,
+                                  "start",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(int, interval));
+        return;
+    }
+    QMetaObject::invokeMethod(m_timer, "stop", Qt::QueuedConnection);
+}
+
+void KNMusicSpectrumAnalyser::analysis()
+{
+    int sampleRate;
+    float level=0.0f, peak=0.0f, decay;
+    {
+        QMutexLocker locker(&m_sampleLock);
+        sampleRate=m_sampleRate;
+        decay=m_decay;
+        //The backends write the samples in blocks, the samples which are heard
+        //now are found by the time passed since the last writing.
+        qint64 latencyFrames=(qint64)m_latency*sampleRate/1000,
+               passedTime=m_writeClock.isValid()?m_writeClock.elapsed():0,
+               endFrame=m_writtenFrames-latencyFrames+
+                        qMin(passedTime*sampleRate/1000, latencyFrames);
+        if(endFrame<FFTSize || passedTime>m_latency+SilenceTimeout)
+        {
+            //Nothing is played, let the bars fall down.
+            std::fill(m_real.begin(), m_real.end(), 0.0f);
+        }
+        else
+        {
+            qint64 startFrame=endFrame-FFTSize;
+            double energy=0.0;
+            for(int i=0; i<FFTSize; i++)
+            {
+                float sample=m_ring.at((startFrame+i)&RingMask);
+                energy+=sample*sample;
+                peak=qMax(peak, qAbs(sample));
+                m_real[i]=sample*m_window.at(i);
+            }
+            level=sqrt(energy/FFTSize);
+        }
+    }
+    //Skip the frames when all the bars are down.
+    if(level==0.0f && m_level==0.0f && m_peak==0.0f &&
+            *std::max_element(m_bands.constBegin(), m_bands.constEnd())==0.0f)
+    {
+        return;
+    }
+    std::fill(m_imag.begin(), m_imag.end(), 0.0f);
+    if(sampleRate>0)
+    {
+        updateBands(sampleRate);
+        fft();
+    }
+    //A full scale sine gets the magnitude of a quarter of the FFT size with
+    //the Hann window.
+    float normalize=4.0f/(float)FFTSize;
+    for(int i=0; i<BandCount; i++)
+    {
+        float power=0.0f;
+        for(int j=m_bandStart.value(i); j<m_bandEnd.value(i); j++)
+        {
+            power=qMax(power, m_real.at(j)*m_real.at(j)+
+                                m_imag.at(j)*m_imag.at(j));
+        }
+        float value=toScale(10.0f*log10(power*normalize*normalize+1e-12f),
+                            SpectrumRange);
+        m_bands[i]=qMax(value, m_bands.at(i)-decay);
+    }
+    m_level=qMax(toScale(20.0f*log10(level+1e-9f), LevelRange),
+                 m_level-decay);
+    m_peak=qMax(toScale(20.0f*log10(peak+1e-9f), LevelRange),
+                m_peak-decay);
+    emit spectrumUpdated(m_bands, m_level, m_peak);
+}
+
+inline void KNMusicSpectrumAnalyser::updateBands(const int &sampleRate)
+{
+    if(sampleRate==m_bandRate)
+    {
+        return;
+    }
+    m_bandRate=sampleRate;
+    m_bandStart.resize(BandCount);
+    m_bandEnd.resize(BandCount);
+    //Find the FFT bins of each band, every band has at least one bin.
+    int halfSize=FFTSize>>1;
+    for(int i=0; i<BandCount; i++)
+    {
+        double startFrequency=MinimumFrequency*
+                pow(MaximumFrequency/MinimumFrequency, (double)i/BandCount),
+               endFrequency=MinimumFrequency*
+                pow(MaximumFrequency/MinimumFrequency, (double)(i+1)/BandCount);
+        int startBin=qBound(1,
+                            (int)(startFrequency*FFTSize/sampleRate),
+                            halfSize-1);
+        m_bandStart[i]=startBin;
+        m_bandEnd[i]=qBound(startBin+1,
+                            (int)(endFrequency*FFTSize/sampleRate),
+                            halfSize);
+    }
+}
+
+inline void KNMusicSpectrumAnalyser::fft()
+{
+    //Put the samples in the bit reversed order.
+    for(int i=0; i<FFTSize; i++)
+    {
+        int j=m_bitReverse.at(i);
+        if(i<j)
+        {
+            qSwap(m_real[i], m_real[j]);
+        }
+    }
+    //The iterative radix-2 FFT. The real and the imaginary parts are saved in
+    //separate arrays, and the twiddle factors of each stage are contiguous, the
+    //inner loop only reads and writes the arrays one by one, so the compiler
+    //could vectorize it.
+    float *real=m_real.data(), *imag=m_imag.data();
+    for(int size=2; size<=FFTSize; size<<=1)
+    {
+        int half=size>>1;
+        const float *stageReal=m_twiddleReal.constData()+half,
+                    *stageImag=m_twiddleImag.constData()+half;
+        for(int start=0; start<FFTSize; start+=size)
+        {
+            float *evenReal=real+start, *evenImag=imag+start,
+                  *oddReal=evenReal+half, *oddImag=evenImag+half;
+            for(int k=0; k<half; k++)
+            {
+                float twiddleReal=stageReal[k],
+                      twiddleImag=stageImag[k],
+                      productReal=oddReal[k]*twiddleReal-
+                                  oddImag[k]*twiddleImag,
+                      productImag=oddReal[k]*twiddleImag+
+                                  oddImag[k]*twiddleReal;
+                oddReal[k]=evenReal[k]-productReal;
+                oddImag[k]=evenImag[k]-productImag;
+                evenReal[k]+=productReal;
+                evenImag[k]+=productImag;
+            }
+        }
+    }
+}
+
+inline float KNMusicSpectrumAnalyser::toScale(const float &decibel,
+                                              const float &range)
+{
+    return qBound(0.0f, (decibel+range)/range, 1.0f);
+}
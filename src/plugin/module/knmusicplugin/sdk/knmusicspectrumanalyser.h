@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#ifndef KNMUSICSPECTRUMANALYSER_H
+#define KNMUSICSPECTRUMANALYSER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QThread>
+#include <QVector>
+
+#include <QObject>
+
+//The spectrum analyser gets the playing samples from the backend, and
+//calculates the spectrum and the level of them in its own thread. The backends
+//write the samples in their audio threads, so the writing only copies the
+//downmixed samples to a ring. The analysing happens once per frame of the
+//screen when it's enabled, and it costs nothing when it's disabled.
+class QTimer;
+class KNMusicSpectrumAnalyser : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KNMusicSpectrumAnalyser(QObject *parent = 0);
+    ~KNMusicSpectrumAnalyser();
+    void writeSamples(const float *samples,
+                      const int &frames,
+                      const int &channels,
+                      const int &sampleRate);
+    void writeSamples(const qint16 *samples,
+                      const int &frames,
+                      const int &channels,
+                      const int &sampleRate);
+    void setLatency(const int &latency);
+    void setEnabled(const bool &enabled, const int &interval=16);
+
+signals:
+    void spectrumUpdated(QVector<float> bands, float level, float peak);
+
+public slots:
+
+private:
+    void analysis();
+    inline void updateBands(const int &sampleRate);
+    inline void fft();
+    static inline float toScale(const float &decibel, const float &range);
+    //The audio thread data, they are locked by the sample lock.
+    QMutex m_sampleLock;
+    QVector<float> m_ring;
+    QElapsedTimer m_writeClock;
+    qint64 m_writtenFrames=0;
+    int m_sampleRate=0, m_latency=0;
+    float m_decay=0.0;
+    //The analysing data, they are only used in the analysing thread.
+    QThread m_analysisThread;
+    QTimer *m_timer;
+    QVector<float> m_window, m_real, m_imag, m_twiddleReal, m_twiddleImag;
+    QVector<int> m_bitReverse, m_bandStart, m_bandEnd;
+    QVector<float> m_bands;
+    float m_level=0.0, m_peak=0.0;
+    int m_bandRate=0;
+};
+
+#endif // KNMUSICSPECTRUMANALYSER_H
@@ -47,6 +47,53 @@ void KNMusicStandardBackend::playSection(const QString &fileName,
     m_main->playSection(start, duration);
 }
 
+void KNMusicStandardBackend::prepareNextSection(const QString &fileName,
+                                                const qint64 &start,
+                                                const qint64 &duration)
+{
+    //Let the main thread open the file before the current section finished.
+    m_main->prepareNextSection(fileName, start, duration);
+}
+
+void KNMusicStandardBackend::clearNextSection()
+{
+    m_main->clearNextSection();
+}
+
+void KNMusicStandardBackend::setPositionUpdateInterval(const int &interval)
+{
+    m_main->setPositionUpdateInterval(interval);
+}
+
+void KNMusicStandardBackend::setGain(const qreal &gain)
+{
+    //The gain is only used for the main thread, the preview is not
+    //normalized.
+    m_main->setGain(gain);
+}
+
+void KNMusicStandardBackend::setNextSectionGain(const qreal &gain)
+{
+    m_main->setNextSectionGain(gain);
+}
+
+void KNMusicStandardBackend::setNextSectionCrossfade(const int &mode,
+                                                     const int &duration)
+{
+    m_main->setNextSectionCrossfade(mode, duration);
+}
+
+void KNMusicStandardBackend::setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser)
+{
+    m_main->setSpectrumAnalyser(analyser);
+}
+
+void KNMusicStandardBackend::setEqualizer(KNMusicEqualizer *equalizer)
+{
+    //The preview plays the original sound.
+    m_main->setEqualizer(equalizer);
+}
+
 void KNMusicStandardBackend::play()
 {
     m_main->play();
@@ -191,6 +238,8 @@ void KNMusicStandardBackend::setMainThread(KNMusicBackendThread *thread)
                 this, &KNMusicStandardBackend::durationChanged);
         connect(m_main, &KNMusicBackendThread::finished,
                 this, &KNMusicStandardBackend::finished);
+        connect(m_main, &KNMusicBackendThread::nextSectionStarted,
+                this, &KNMusicStandardBackend::nextSectionStarted);
         connect(m_main, &KNMusicBackendThread::stopped,
                 this, &KNMusicStandardBackend::stopped);
         connect(m_main, &KNMusicBackendThread::stateChanged,
@@ -22,6 +22,16 @@ public:
     void playSection(const QString &fileName,
                      const qint64 &start=-1,
                      const qint64 &duration=-1);
+    void prepareNextSection(const QString &fileName,
+                            const qint64 &start=-1,
+                            const qint64 &duration=-1);
+    void clearNextSection();
+    void setPositionUpdateInterval(const int &interval);
+    void setGain(const qreal &gain);
+    void setNextSectionGain(const qreal &gain);
+    void setNextSectionCrossfade(const int &mode, const int &duration);
+    void setSpectrumAnalyser(KNMusicSpectrumAnalyser *analyser);
+    void setEqualizer(KNMusicEqualizer *equalizer);
     void play();
     void pause();
     void stop();
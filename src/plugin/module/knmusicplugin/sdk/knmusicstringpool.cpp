@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#include <QReadLocker>
+#include <QWriteLocker>
+
+#include "knmusicstringpool.h"
+
+#include <QDebug>
+
+KNMusicStringPool *KNMusicStringPool::m_instance=nullptr;
+
+KNMusicStringPool *KNMusicStringPool::instance()
+{
+    return m_instance==nullptr?m_instance=new KNMusicStringPool:m_instance;
+}
+
+KNMusicStringPool::KNMusicStringPool(QObject *parent) :
+    QObject(parent)
+{
+    //Add the empty text as id 0.
+    m_ids.insert(QString(), 0);
+    m_texts.append(QString());
+}
+
+bool KNMusicStringPool::isPooledColumn(const int &column)
+{
+    switch(column)
+    {
+    case Artist:
+    case AlbumArtist:
+    case Album:
+    case Genre:
+    case Composer:
+    case Kind:
+    case Year:
+        return true;
+    default:
+        return false;
+    }
+}
+
+int KNMusicStringPool::id(const QString &text)
+{
+    //Most of the texts are already in the pool, check it with the read lock.
+    int textId=findId(text);
+    if(textId!=-1)
+    {
+        return textId;
+    }
+    QWriteLocker locker(&m_lock);
+    return addText(text);
+}
+
+int KNMusicStringPool::findId(const QString &text) const
+{
+    //The null text and the empty text are the same.
+    if(text.isEmpty())
+    {
+        return 0;
+    }
+    QReadLocker locker(&m_lock);
+    return m_ids.value(text, -1);
+}
+
+QString KNMusicStringPool::text(const int &id) const
+{
+    QReadLocker locker(&m_lock);
+    return (id>-1 && id<m_texts.size())?m_texts.at(id):QString();
+}
+
+QString KNMusicStringPool::intern(const QString &text)
+{
+    //The returned string shares the data with the one in the pool. Find the
+    //text under one lock, or it could be released between getting the id and
+    //the text.
+    if(text.isEmpty())
+    {
+        return QString();
+    }
+    {
+        QReadLocker locker(&m_lock);
+        QHash<QString, int>::const_iterator idIterator=m_ids.constFind(text);
+        if(idIterator!=m_ids.constEnd())
+        {
+            return m_texts.at(idIterator.value());
+        }
+    }
+    QWriteLocker locker(&m_lock);
+    return m_texts.at(addText(text));
+}
+
+void KNMusicStringPool::internDetailInfo(KNMusicDetailInfo &detailInfo)
+{
+    for(int i=0; i<MusicDataCount; i++)
+    {
+        if(isPooledColumn(i))
+        {
+            detailInfo.textLists[i]=intern(detailInfo.textLists[i]);
+        }
+    }
+}
+
+void KNMusicStringPool::compact(const QSet<int> &usedIds)
+{
+    QWriteLocker locker(&m_lock);
+    //Release the texts which are not used as a key by anyone, and which are
+    //not shared with any item. The shared ones are kept, or the same text
+    //added later would be copied again.
+    for(int i=1; i<m_texts.size(); i++)
+    {
+        QString &text=m_texts[i];
+        if(text.isNull() || usedIds.contains(i))
+        {
+            continue;
+        }
+        //The key of the hash shares the data with the text, remove it before
+        //checking whether anyone else still holds the text.
+        m_ids.remove(text);
+        if(text.isDetached())
+        {
+            //Keep the slot, so the id won't be given to another text.
+            text=QString();
+            continue;
+        }
+        m_ids.insert(text, i);
+    }
+}
+
+inline int KNMusicStringPool::addText(const QString &text)
+{
+    //The text may be added by other thread before we get the write lock.
+    QHash<QString, int>::const_iterator idIterator=m_ids.constFind(text);
+    if(idIterator!=m_ids.constEnd())
+    {
+        return idIterator.value();
+    }
+    int textId=m_texts.size();
+    m_texts.append(text);
+    m_ids.insert(text, textId);
+    return textId;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#ifndef KNMUSICSTRINGPOOL_H
+#define KNMUSICSTRINGPOOL_H
+
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QStringList>
+
+#include "knmusicglobal.h"
+
+#include <QObject>
+
+using namespace KNMusic;
+
+//The string pool keeps only one copy of the tag texts which are repeated in
+//the library, like artist, album and genre. Every text in the pool has an id,
+//the ids are never reused, so they can be used as the key of the text.
+//The id of the empty text is always 0.
+//The texts which are not used any more are released by compact(), the id of a
+//released text is never given to another text.
+class KNMusicStringPool : public QObject
+{
+    Q_OBJECT
+public:
+    static KNMusicStringPool *instance();
+    static bool isPooledColumn(const int &column);
+    int id(const QString &text);
+    int findId(const QString &text) const;
+    QString text(const int &id) const;
+    QString intern(const QString &text);
+    void internDetailInfo(KNMusicDetailInfo &detailInfo);
+    void compact(const QSet<int> &usedIds);
+
+signals:
+
+public slots:
+
+private:
+    static KNMusicStringPool *m_instance;
+    explicit KNMusicStringPool(QObject *parent = 0);
+    inline int addText(const QString &text);
+    mutable QReadWriteLock m_lock;
+    QHash<QString, int> m_ids;
+    QStringList m_texts;
+};
+
+#endif // KNMUSICSTRINGPOOL_H
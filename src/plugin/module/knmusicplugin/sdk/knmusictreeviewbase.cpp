@@ -601,19 +601,12 @@ void KNMusicTreeViewBase::removeSelections()
     }
     //Get the current indexes.
     QModelIndexList selectionList=selectionModel()->selectedRows(m_proxyModel->playingItemColumn());
-    //Change the model index list to persistent index.
-    QList<QPersistentModelIndex> persistentList;
+    //Change the model index list to source rows.
+    QList<int> sourceRows;
     while(!selectionList.isEmpty())
     {
-        persistentList.append(m_proxyModel->mapToSource(selectionList.takeLast()));
-    }
-    //Remove all the indexes.
-    while(!persistentList.isEmpty())
-    {
-        QPersistentModelIndex currentRemovedIndex=persistentList.takeLast();
-        if(currentRemovedIndex.isValid())
-        {
-            m_proxyModel->removeSourceMusicRow(currentRemovedIndex.row());
-        }
+        sourceRows.append(m_proxyModel->mapToSource(selectionList.takeLast()).row());
     }
+    //Remove all the rows in one operation.
+    m_proxyModel->removeSourceMusicRows(sourceRows);
 }
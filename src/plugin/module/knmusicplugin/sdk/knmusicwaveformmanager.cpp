@@ -0,0 +1,451 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#include <algorithm>
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+#include "knmusicbackend.h"
+#include "knmusicaudiodecoder.h"
+
+#include "knmusicwaveformmanager.h"
+
+#include <QDebug>
+
+//The bucket count of an overview, it's enough for a slider on any screen.
+#define WaveformBuckets 2000
+#define ChunkFrames 4096
+#define CacheSuffix ".peaks"
+//The overviews kept in memory, only the playing and the next song is used.
+#define MemoryCacheSize 8
+//The overviews kept in the cache folder, the ones which are not read for the
+//longest time are removed. An overview is 4KB.
+#define MaximumCacheFiles 4096
+//The generation starts a while after the request, when the song is opened and
+//the user doesn't skip it.
+#define DeferInterval 2000
+
+class KNMusicWaveformTask : public QRunnable
+{
+public:
+    KNMusicWaveformTask(KNMusicWaveformManager *manager,
+                        KNMusicAudioDecoder *decoder,
+                        const int &taskId,
+                        const QString &key,
+                        const KNMusicDetailInfo &detailInfo) :
+        m_manager(manager),
+        m_decoder(decoder),
+        m_key(key),
+        m_cacheFolderPath(manager->cacheFolderPath()),
+        m_filePath(detailInfo.filePath),
+        m_taskId(taskId),
+        m_start(detailInfo.startPosition),
+        m_duration(detailInfo.duration)
+    {
+    }
+
+    ~KNMusicWaveformTask()
+    {
+        delete m_decoder;
+    }
+
+    void run()
+    {
+        QThread::currentThread()->setPriority(QThread::LowPriority);
+        QByteArray peaks;
+        //The modified time is part of the name of the cache file, a changed
+        //file won't use the old overview.
+        QString cacheFilePath;
+        if(!m_cacheFolderPath.isEmpty())
+        {
+            QString keySource=m_key+"\n"+
+                    QString::number(QFileInfo(m_filePath).lastModified()
+                                        .toMSecsSinceEpoch());
+            cacheFilePath=m_cacheFolderPath+"/"+
+                    QCryptographicHash::hash(keySource.toUtf8(),
+                                             QCryptographicHash::Md5).toHex()+
+                    CacheSuffix;
+            QFile cacheFile(cacheFilePath);
+            if(cacheFile.open(QIODevice::ReadOnly))
+            {
+                peaks=cacheFile.readAll();
+                cacheFile.close();
+                if(peaks.size()!=(WaveformBuckets<<1))
+                {
+                    peaks.clear();
+                }
+            }
+        }
+        //Without a decoder, the task only looks up the cache file.
+        if(peaks.isEmpty() && m_decoder!=nullptr &&
+                generatePeaks(peaks) && !cacheFilePath.isEmpty())
+        {
+            //Save the overview, the next time it's only a file read.
+            QFile cacheFile(cacheFilePath);
+            if(cacheFile.open(QIODevice::WriteOnly))
+            {
+                cacheFile.write(peaks);
+                cacheFile.close();
+            }
+            removeExpiredFiles();
+        }
+        if(m_manager->isCancelled(0))
+        {
+            return;
+        }
+        //An empty overview means the cache file is not found, or the file
+        //can't be decoded.
+        QMetaObject::invokeMethod(m_manager,
+                                  "onActionTaskFinished",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(int, m_taskId),
+                                  Q_ARG(QString, m_key),
+                                  Q_ARG(QByteArray, peaks));
+    }
+
+private:
+    bool generatePeaks(QByteArray &peaks)
+    {
+        if(!m_decoder->open(m_filePath,
+                            m_start,
+                            m_start==-1?-1:m_duration))
+        {
+            return false;
+        }
+        int channels=m_decoder->channels();
+        qint64 totalFrames=m_duration*m_decoder->sampleRate()/1000;
+        if(channels<1 || totalFrames<1)
+        {
+            return false;
+        }
+        //The frames of a bucket, the last bucket takes the rest frames.
+        qint64 bucketFrames=qMax(totalFrames/WaveformBuckets, (qint64)1);
+        QVector<float> minimums(WaveformBuckets, 0.0f),
+                       maximums(WaveformBuckets, 0.0f);
+        QVector<float> buffer(ChunkFrames*channels);
+        int bucket=0;
+        qint64 bucketUsed=0;
+        int frames;
+        while(bucket<WaveformBuckets &&
+              (frames=m_decoder->decode(buffer.data(), ChunkFrames))>0)
+        {
+            if(m_manager->isCancelled(m_taskId))
+            {
+                return false;
+            }
+            const float *samples=buffer.constData();
+            while(frames>0 && bucket<WaveformBuckets)
+            {
+                //Scan the samples of this bucket in the chunk. All the channels
+                //are scanned as one plain array, the compiler could vectorize
+                //this loop.
+                int count=(bucket==WaveformBuckets-1)?
+                            frames:
+                            (int)qMin((qint64)frames,
+                                      bucketFrames-bucketUsed);
+                const float *end=samples+count*channels;
+                float minimum=minimums[bucket], maximum=maximums[bucket];
+                for(const float *i=samples; i<end; ++i)
+                {
+                    minimum=(*i<minimum)?*i:minimum;
+                    maximum=(*i>maximum)?*i:maximum;
+                }
+                minimums[bucket]=minimum;
+                maximums[bucket]=maximum;
+                samples=end;
+                frames-=count;
+                bucketUsed+=count;
+                if(bucketUsed>=bucketFrames && bucket<WaveformBuckets-1)
+                {
+                    bucket++;
+                    bucketUsed=0;
+                }
+            }
+        }
+        //Quantize the peaks to signed bytes.
+        peaks.resize(WaveformBuckets<<1);
+        for(int i=0; i<WaveformBuckets; i++)
+        {
+            peaks[i<<1]=(char)qBound(-127,
+                                     qRound(minimums.at(i)*127.0f),
+                                     127);
+            peaks[(i<<1)+1]=(char)qBound(-127,
+                                         qRound(maximums.at(i)*127.0f),
+                                         127);
+        }
+        return true;
+    }
+
+    inline void removeExpiredFiles()
+    {
+        QFileInfoList cacheFiles=
+                QDir(m_cacheFolderPath).entryInfoList(
+                    QStringList(QString("*")+CacheSuffix),
+                    QDir::Files);
+        if(cacheFiles.size()<=MaximumCacheFiles)
+        {
+            return;
+        }
+        //Sort the files by the last read time, the oldest ones are removed.
+        std::sort(cacheFiles.begin(), cacheFiles.end(),
+                  [](const QFileInfo &left, const QFileInfo &right)
+                  {
+                      return left.lastRead()<right.lastRead();
+                  });
+        for(int i=0, count=cacheFiles.size()-MaximumCacheFiles; i<count; i++)
+        {
+            QFile::remove(cacheFiles.at(i).absoluteFilePath());
+        }
+    }
+
+    KNMusicWaveformManager *m_manager;
+    KNMusicAudioDecoder *m_decoder;
+    QString m_key, m_cacheFolderPath, m_filePath;
+    int m_taskId;
+    qint64 m_start, m_duration;
+};
+
+KNMusicWaveformManager *KNMusicWaveformManager::m_instance=nullptr;
+
+KNMusicWaveformManager *KNMusicWaveformManager::instance()
+{
+    return m_instance==nullptr?
+                m_instance=new KNMusicWaveformManager:m_instance;
+}
+
+QString KNMusicWaveformManager::waveformKey(const KNMusicDetailInfo &detailInfo)
+{
+    //The tracks of a cue image have their own overviews. The key never touches
+    //the file, the task checks the modified time of the file.
+    return detailInfo.filePath+"\n"+
+            QString::number(detailInfo.startPosition)+"\n"+
+            QString::number(detailInfo.duration);
+}
+
+void KNMusicWaveformManager::setBackend(KNMusicBackend *backend)
+{
+    m_backend=backend;
+}
+
+void KNMusicWaveformManager::setCacheFolderPath(const QString &cacheFolderPath)
+{
+    m_cacheFolderPath=cacheFolderPath;
+}
+
+QString KNMusicWaveformManager::cacheFolderPath() const
+{
+    return m_cacheFolderPath;
+}
+
+bool KNMusicWaveformManager::isCancelled(const int &taskId) const
+{
+    return m_cancelled.load() ||
+            (taskId!=0 && m_cancelledTaskId.load()==taskId);
+}
+
+void KNMusicWaveformManager::requireWaveform(const KNMusicDetailInfo &detailInfo,
+                                             const int &priority)
+{
+    if(m_cancelled.load() || detailInfo.duration<1)
+    {
+        return;
+    }
+    QString key=waveformKey(detailInfo);
+    //Check the memory cache first.
+    QByteArray *cachedPeaks=m_peaksCache.object(key);
+    if(cachedPeaks!=nullptr)
+    {
+        emit waveformReady(key, *cachedPeaks);
+        return;
+    }
+    if(m_backend==nullptr)
+    {
+        return;
+    }
+    WaveformRequest request;
+    request.key=key;
+    request.detailInfo=detailInfo;
+    request.priority=priority;
+    request.cacheChecked=false;
+    if(priority==PlayingPriority)
+    {
+        //The song which was playing is not interesting any more, but the next
+        //songs are still required.
+        for(QList<WaveformRequest>::iterator i=m_pendingRequests.begin();
+            i!=m_pendingRequests.end();)
+        {
+            if((*i).priority==PlayingPriority || (*i).key==key)
+            {
+                //Keep the cache check result of the same song.
+                if((*i).key==key)
+                {
+                    request.cacheChecked=(*i).cacheChecked;
+                }
+                i=m_pendingRequests.erase(i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        //Cancel the running task of the other song, it's required again after
+        //the playing song.
+        if(m_runningTaskId!=0 && m_runningRequest.key!=key &&
+                m_cancelledTaskId.load()!=m_runningTaskId)
+        {
+            m_cancelledTaskId.store(m_runningTaskId);
+            if(m_runningRequest.priority==NextPriority)
+            {
+                m_pendingRequests.append(m_runningRequest);
+            }
+        }
+        if(m_runningTaskId==0 || m_runningRequest.key!=key ||
+                m_cancelledTaskId.load()==m_runningTaskId)
+        {
+            m_pendingRequests.prepend(request);
+        }
+    }
+    else if(!isRequested(key))
+    {
+        m_pendingRequests.append(request);
+    }
+    startNextTask();
+}
+
+void KNMusicWaveformManager::stop()
+{
+    //The decoders must be freed before the backend.
+    m_cancelled.store(1);
+    m_deferTimer->stop();
+    m_pendingRequests.clear();
+    m_threadPool->clear();
+    m_threadPool->waitForDone();
+    m_runningTaskId=0;
+}
+
+void KNMusicWaveformManager::onActionTaskFinished(int taskId,
+                                                  QString key,
+                                                  QByteArray peaks)
+{
+    if(taskId!=m_runningTaskId)
+    {
+        return;
+    }
+    m_runningTaskId=0;
+    //The result of a cancelled task is dropped, the request has been queued
+    //again if it's still required.
+    if(m_cancelledTaskId.load()==taskId)
+    {
+        startNextTask();
+        return;
+    }
+    if(!peaks.isEmpty())
+    {
+        m_peaksCache.insert(key, new QByteArray(peaks));
+        emit waveformReady(key, peaks);
+    }
+    else if(!m_runningRequest.cacheChecked)
+    {
+        //The cache file is not found, decode the song later, when the song is
+        //opened and the user doesn't skip it.
+        m_runningRequest.cacheChecked=true;
+        m_pendingRequests.prepend(m_runningRequest);
+        m_deferTimer->start();
+    }
+    startNextTask();
+}
+
+void KNMusicWaveformManager::startNextTask()
+{
+    if(m_runningTaskId!=0 || m_cancelled.load())
+    {
+        return;
+    }
+    //The cache files could be looked up at any time, but the songs are only
+    //decoded when the defer timer is not running.
+    for(QList<WaveformRequest>::iterator i=m_pendingRequests.begin();
+        i!=m_pendingRequests.end();
+        ++i)
+    {
+        if((*i).cacheChecked && m_deferTimer->isActive())
+        {
+            continue;
+        }
+        KNMusicAudioDecoder *decoder=nullptr;
+        if((*i).cacheChecked)
+        {
+            decoder=m_backend->createAudioDecoder();
+            if(decoder==nullptr)
+            {
+                //The backend can't decode the files.
+                m_pendingRequests.erase(i);
+                startNextTask();
+                return;
+            }
+        }
+        m_runningRequest=*i;
+        m_pendingRequests.erase(i);
+        //The task id is never 0.
+        if(++m_taskId==0)
+        {
+            m_taskId=1;
+        }
+        m_runningTaskId=m_taskId;
+        m_threadPool->start(new KNMusicWaveformTask(this,
+                                                    decoder,
+                                                    m_runningTaskId,
+                                                    m_runningRequest.key,
+                                                    m_runningRequest.detailInfo));
+        return;
+    }
+}
+
+KNMusicWaveformManager::KNMusicWaveformManager(QObject *parent) :
+    QObject(parent),
+    m_peaksCache(MemoryCacheSize),
+    m_cancelled(0),
+    m_cancelledTaskId(0)
+{
+    //Generate one overview at a time, it should never slow down the playing.
+    m_threadPool=new QThreadPool(this);
+    m_threadPool->setMaxThreadCount(1);
+    m_deferTimer=new QTimer(this);
+    m_deferTimer->setSingleShot(true);
+    m_deferTimer->setInterval(DeferInterval);
+    connect(m_deferTimer, &QTimer::timeout,
+            this, &KNMusicWaveformManager::startNextTask);
+    connect(qApp, &QCoreApplication::aboutToQuit,
+            this, &KNMusicWaveformManager::stop);
+}
+
+inline bool KNMusicWaveformManager::isRequested(const QString &key) const
+{
+    if(m_runningTaskId!=0 && m_runningRequest.key==key &&
+            m_cancelledTaskId.load()!=m_runningTaskId)
+    {
+        return true;
+    }
+    for(QList<WaveformRequest>::const_iterator i=m_pendingRequests.constBegin();
+        i!=m_pendingRequests.constEnd();
+        ++i)
+    {
+        if((*i).key==key)
+        {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) Kreogist Dev Team <kreogistdevteam@126.com>
+ * This work is free. You can redistribute it and/or modify it under the
+ * terms of the Do What The Fuck You Want To Public License, Version 2,
+ * as published by Sam Hocevar. See the COPYING file for more details.
+ */
+#ifndef KNMUSICWAVEFORMMANAGER_H
+#define KNMUSICWAVEFORMMANAGER_H
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QCache>
+#include <QList>
+
+#include "knmusicglobal.h"
+
+#include <QObject>
+
+//The waveform overview is the minimum and the maximum sample of each bucket of
+//a song, it's saved as signed bytes: min0, max0, min1, max1, ... The overview
+//is generated once by decoding the whole song, and it's cached in the
+//waveform folder, so the slider never decodes anything when it's painting.
+//The manager runs one task at a time, the cache file is looked up by the task
+//first, and the song is only decoded a while after it's required. The request
+//of the playing song cancels the task of any other song, which is required
+//again after it.
+class QThreadPool;
+class QTimer;
+class KNMusicBackend;
+class KNMusicWaveformManager : public QObject
+{
+    Q_OBJECT
+public:
+    enum WaveformPriority
+    {
+        NextPriority,
+        PlayingPriority
+    };
+    static KNMusicWaveformManager *instance();
+    static QString waveformKey(const KNMusicDetailInfo &detailInfo);
+    void setBackend(KNMusicBackend *backend);
+    void setCacheFolderPath(const QString &cacheFolderPath);
+    QString cacheFolderPath() const;
+    bool isCancelled(const int &taskId) const;
+
+signals:
+    void waveformReady(QString key, QByteArray peaks);
+
+public slots:
+    void requireWaveform(const KNMusicDetailInfo &detailInfo,
+                         const int &priority);
+    void stop();
+
+private slots:
+    void onActionTaskFinished(int taskId, QString key, QByteArray peaks);
+    void startNextTask();
+
+private:
+    static KNMusicWaveformManager *m_instance;
+    explicit KNMusicWaveformManager(QObject *parent = 0);
+    struct WaveformRequest
+    {
+        QString key;
+        KNMusicDetailInfo detailInfo;
+        int priority;
+        //The cache file has been looked up, the song needs to be decoded.
+        bool cacheChecked;
+    };
+    inline bool isRequested(const QString &key) const;
+    QList<WaveformRequest> m_pendingRequests;
+    WaveformRequest m_runningRequest;
+    QTimer *m_deferTimer;
+    QCache<QString, QByteArray> m_peaksCache;
+    QString m_cacheFolderPath;
+    QThreadPool *m_threadPool;
+    KNMusicBackend *m_backend=nullptr;
+    int m_taskId=0, m_runningTaskId=0;
+    QAtomicInt m_cancelled, m_cancelledTaskId;
+};
+
+#endif // KNMUSICWAVEFORMMANAGER_H
@@ -79,8 +79,9 @@ void KNJSONDatabase::read()
     {
         m_dataField.append(*i);
     }
-    //Clear the content object.
-    m_contentObject=QJsonObject();
+    //Clear the data field in the content object, the other properties of the
+    //database are kept.
+    m_contentObject.remove("Database");
 }
 
 void KNJSONDatabase::write()
@@ -105,8 +106,12 @@ void KNJSONDatabase::write()
         m_databaseFile->write(m_document.toJson());
         m_databaseFile->close();
     }
+    //Clear the document and the data field in the content object.
+    m_document=QJsonDocument();
+    m_contentObject.remove("Database");
     //Clear count.
     m_batchCount=0;
+    emit written();
 }
 
 void KNJSONDatabase::append(QJsonObject value)
@@ -130,11 +135,45 @@ void KNJSONDatabase::removeAt(int i)
     addBatchCount();
 }
 
+void KNJSONDatabase::removeAll(const QList<int> &sortedIndexes)
+{
+    //Compact the data field in one pass, removing the items one by one will
+    //move the rest of the array every time.
+    QJsonArray compactedField;
+    int removeIndex=0;
+    for(int i=0; i<m_dataField.size(); i++)
+    {
+        //Skip the item which is going to be removed.
+        if(removeIndex<sortedIndexes.size() && sortedIndexes.at(removeIndex)==i)
+        {
+            removeIndex++;
+            continue;
+        }
+        compactedField.append(m_dataField.at(i));
+    }
+    m_dataField=compactedField;
+    //Count a operate.
+    addBatchCount();
+}
+
 QJsonValue KNJSONDatabase::at(int i)
 {
     return m_dataField.at(i);
 }
 
+QJsonValue KNJSONDatabase::databaseProperty(const QString &key) const
+{
+    return m_contentObject.value(key);
+}
+
+void KNJSONDatabase::setDatabaseProperty(const QString &key,
+                                         const QJsonValue &value)
+{
+    m_contentObject.insert(key, value);
+    //Count a operate.
+    addBatchCount();
+}
+
 QJsonArray::iterator KNJSONDatabase::begin()
 {
     return m_dataField.begin();
@@ -25,6 +25,7 @@ public:
     void write();
 
 signals:
+    void written();
 
 public slots:
 
@@ -32,7 +33,10 @@ protected:
     void append(QJsonObject value);
     void replace(int i, QJsonObject value);
     void removeAt(int i);
+    void removeAll(const QList<int> &sortedIndexes);
     QJsonValue at(int i);
+    QJsonValue databaseProperty(const QString &key) const;
+    void setDatabaseProperty(const QString &key, const QJsonValue &value);
     QJsonArray::iterator begin();
     QJsonArray::iterator end();
 
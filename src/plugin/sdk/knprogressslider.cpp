@@ -8,6 +8,7 @@
 #include <QSizePolicy>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QPainterPath>
 #include <QRadialGradient>
 
 #include "knprogressslider.h"
@@ -76,12 +77,34 @@ void KNProgressSlider::paintEvent(QPaintEvent *event)
     //Set no pen
     painter.setPen(Qt::NoPen);
 
-    //Draw central rects.
-    painter.fillRect(QRect(m_glowWidth,
-                           m_glowWidth+m_spacing,
-                           width()-(m_glowWidth<<1),
-                           m_sliderHeight),
-                     m_rectColor);
+    //Get the current position.
+    int positionLeft=0;
+    if(range()>0)
+    {
+        positionLeft=qMax((int)(percentage()*(qreal)(width()-m_buttonSize)),
+                          0);
+    }
+
+    //Draw the waveform or the central rects. The waveform on the right of the
+    //played part is drawn only.
+    if(m_waveformPixmap.isNull())
+    {
+        painter.fillRect(QRect(m_glowWidth,
+                               m_glowWidth+m_spacing,
+                               width()-(m_glowWidth<<1),
+                               m_sliderHeight),
+                         m_rectColor);
+    }
+    else
+    {
+        int playedRight=range()>0?m_glowWidth+positionLeft+2:0;
+        painter.setClipRect(QRect(playedRight,
+                                  0,
+                                  width()-playedRight,
+                                  height()));
+        painter.drawPixmap(0, 0, m_waveformPixmap);
+        painter.setClipping(false);
+    }
 
     //If range is not 0, draw the button.
     if(range()>0)
@@ -89,18 +112,24 @@ void KNProgressSlider::paintEvent(QPaintEvent *event)
         //Restore the opacity.
         painter.setOpacity(1.0);
 
-        //Get the current position.
-        int positionLeft=percentage()*(qreal)(width()-m_buttonSize);
-        if(positionLeft<0)
+        //Paint the rect, or the played part of the waveform.
+        if(m_playedWaveformPixmap.isNull())
         {
-            positionLeft=0;
+            painter.fillRect(QRect(m_glowWidth,
+                                   m_glowWidth+m_spacing,
+                                   positionLeft+2,
+                                   m_sliderHeight),
+                             m_buttonColor);
+        }
+        else
+        {
+            painter.setClipRect(QRect(m_glowWidth,
+                                      0,
+                                      positionLeft+2,
+                                      height()));
+            painter.drawPixmap(0, 0, m_playedWaveformPixmap);
+            painter.setClipping(false);
         }
-        //Paint the rect.
-        painter.fillRect(QRect(m_glowWidth,
-                               m_glowWidth+m_spacing,
-                               positionLeft+2,
-                               m_sliderHeight),
-                         m_buttonColor);
 
         //Draw the circle button.
         //Calculate position.
@@ -124,6 +153,13 @@ void KNProgressSlider::paintEvent(QPaintEvent *event)
     }
 }
 
+void KNProgressSlider::resizeEvent(QResizeEvent *event)
+{
+    KNAbstractSlider::resizeEvent(event);
+    //The waveform is scaled to the new width.
+    updateWaveformPixmaps();
+}
+
 void KNProgressSlider::mousePressEvent(QMouseEvent *event)
 {
     //Set pressed flag.
@@ -156,6 +192,20 @@ void KNProgressSlider::mouseReleaseEvent(QMouseEvent *event)
     KNAbstractSlider::mouseReleaseEvent(event);
 }
 
+void KNProgressSlider::setWaveform(const QByteArray &peaks)
+{
+    m_waveformPeaks=peaks;
+    updateWaveformPixmaps();
+}
+
+void KNProgressSlider::clearWaveform()
+{
+    m_waveformPeaks.clear();
+    m_waveformPixmap=QPixmap();
+    m_playedWaveformPixmap=QPixmap();
+    update();
+}
+
 void KNProgressSlider::onActionMouseInOut(const int &frame)
 {
     m_backOpacity=(qreal)frame/100;
@@ -180,6 +230,64 @@ void KNProgressSlider::updateButtonSize()
     update();
 }
 
+void KNProgressSlider::updateWaveformPixmaps()
+{
+    m_waveformPixmap=QPixmap();
+    m_playedWaveformPixmap=QPixmap();
+    int bucketCount=m_waveformPeaks.size()>>1,
+        waveformWidth=width()-(m_glowWidth<<1);
+    if(bucketCount==0 || waveformWidth<1)
+    {
+        update();
+        return;
+    }
+    //The waveform is centered at the slider, and it could use the whole height
+    //of the widget.
+    qreal center=m_glowWidth+m_spacing+(qreal)m_sliderHeight/2.0,
+          amplitude=(qreal)(height()>>1)/127.0;
+    const char *peaks=m_waveformPeaks.constData();
+    QPainterPath waveformPath;
+    for(int x=0; x<waveformWidth; x++)
+    {
+        //Combine the buckets of this pixel column.
+        int bucketStart=(qint64)x*bucketCount/waveformWidth,
+            bucketEnd=qMax((int)((qint64)(x+1)*bucketCount/waveformWidth),
+                           bucketStart+1);
+        int minimum=0, maximum=0;
+        for(int i=bucketStart; i<bucketEnd; i++)
+        {
+            minimum=qMin(minimum, (int)(signed char)peaks[i<<1]);
+            maximum=qMax(maximum, (int)(signed char)peaks[(i<<1)+1]);
+        }
+        qreal top=center-(qreal)maximum*amplitude,
+              bottom=center-(qreal)minimum*amplitude;
+        //Keep at least one pixel, the silent part looks like the slider.
+        if(bottom-top<1.0)
+        {
+            top=center-0.5;
+            bottom=center+0.5;
+        }
+        waveformPath.addRect(QRectF(m_glowWidth+x, top, 1.0, bottom-top));
+    }
+    m_waveformPixmap=renderWaveform(waveformPath, m_rectColor);
+    m_playedWaveformPixmap=renderWaveform(waveformPath, m_buttonColor);
+    update();
+}
+
+inline QPixmap KNProgressSlider::renderWaveform(const QPainterPath &path,
+                                                const QColor &color)
+{
+    //Render the waveform in the resolution of the screen.
+    qreal ratio=devicePixelRatio();
+    QPixmap waveform(size()*ratio);
+    waveform.setDevicePixelRatio(ratio);
+    waveform.fill(Qt::transparent);
+    QPainter painter(&waveform);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    painter.fillPath(path, color);
+    return waveform;
+}
+
 qint64 KNProgressSlider::posToValue(int position)
 {
     if(position<m_glowWidth)
@@ -7,8 +7,11 @@
 #ifndef KNPROGRESSSLIDER_H
 #define KNPROGRESSSLIDER_H
 
+#include <QPixmap>
+
 #include "knabstractslider.h"
 
+class QPainterPath;
 class QTimeLine;
 class KNProgressSlider : public KNAbstractSlider
 {
@@ -19,11 +22,14 @@ public:
 signals:
 
 public slots:
+    void setWaveform(const QByteArray &peaks);
+    void clearWaveform();
 
 protected:
     void enterEvent(QEvent *event);
     void leaveEvent(QEvent *event);
     void paintEvent(QPaintEvent *event);
+    void resizeEvent(QResizeEvent *event);
     void mousePressEvent(QMouseEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
     void mouseReleaseEvent(QMouseEvent *event);
@@ -34,6 +40,9 @@ private slots:
 private:
     void configureTimeLine(QTimeLine *timeLine);
     void updateButtonSize();
+    void updateWaveformPixmaps();
+    inline QPixmap renderWaveform(const QPainterPath &path,
+                                  const QColor &color);
     qint64 posToValue(int position);
     int m_sliderHeight=4, m_glowWidth=5, m_buttonSize=14,
         m_spacing=2;
@@ -43,6 +52,11 @@ private:
            m_buttonColor=QColor(255,255,255,110);
     QRadialGradient m_buttonGradient;
     QTimeLine *m_mouseIn, *m_mouseOut;
+    //The waveform peaks are pairs of signed bytes: minimum and maximum. The
+    //waveform is rendered in the unplayed and the played color only when the
+    //peaks or the size changed, painting is only blitting the two pixmaps.
+    QByteArray m_waveformPeaks;
+    QPixmap m_waveformPixmap, m_playedWaveformPixmap;
     qreal m_mouseOutOpacity=0.65,
           m_backOpacity=m_mouseOutOpacity;
 };